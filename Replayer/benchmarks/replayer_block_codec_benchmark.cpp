@@ -0,0 +1,384 @@
+/* API Interceptor (c) 2024 Dominik Witczak
+ *
+ * This code is licensed under MIT license (see LICENSE.txt for details)
+ */
+
+/* Compresses and decompresses synthetic GLQuake-like data with ReplayerBlockCodec, block by block, the same way
+ * ReplayerSnapshotFile stores its sections, and reports the compression ratio and encode/decode throughput for:
+ *
+ * - world and alias model vertices, as stored in the VERTICES section.
+ * - lightmaps: smooth light falloff over 128x128 RGBA pages, which is what most sub-image uploads carry.
+ * - diffuse textures: 8-bit palette indices expanded to RGBA, like GLQuake does before uploading them.
+ *
+ * Decoded data is compared against the input, so the benchmark doubles as a round-trip check.
+ *
+ * Usage: ReplayerBlockCodecBenchmark [number of timed iterations per data set]
+ */
+#include "replayer_block_codec.h"
+#include "replayer_snapshot.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+
+class ReplayerBlockCodecBenchmark
+{
+public:
+    /* Public funcs */
+    static int run(const uint32_t& in_n_timed_iterations);
+
+private:
+    /* Private consts */
+    static const uint32_t LIGHTMAP_PAGE_SIZE        = 128;
+    static const uint32_t N_ALIAS_MODEL_VERTICES    = 24 * 32 * 8;
+    static const uint32_t N_LIGHTMAP_PAGES          = 64;
+    static const uint32_t N_PALETTE_RAMPS           = 16;
+    static const uint32_t N_TEXTURES                = 48;
+    static const uint32_t N_WORLD_SURFACE_VERTICES  = 5;
+    static const uint32_t N_WORLD_SURFACES          = 12000;
+    static const uint32_t TEXTURE_SIZE              = 64;
+
+    /* Private funcs */
+    ReplayerBlockCodecBenchmark();
+
+    void build_lightmap_data();
+    void build_texture_data ();
+    void build_vertex_data  ();
+    bool run_data_set       (const char*                 in_name_ptr,
+                             const std::vector<uint8_t>& in_data_u8_vec,
+                             const uint32_t&             in_n_timed_iterations) const;
+
+    uint32_t get_random_u32();
+
+    /* Private vars */
+    std::vector<uint8_t> m_lightmap_data_u8_vec;
+    uint32_t             m_random_state;
+    std::vector<uint8_t> m_texture_data_u8_vec;
+    std::vector<uint8_t> m_vertex_data_u8_vec;
+};
+
+
+ReplayerBlockCodecBenchmark::ReplayerBlockCodecBenchmark()
+    :m_random_state(0x1234567u)
+{
+    /* Stub */
+}
+
+void ReplayerBlockCodecBenchmark::build_lightmap_data()
+{
+    /* Each page is filled with surface lightmaps, a few luxels across each, lit by a couple of point lights. GLQuake
+     * stores 255 - light in the color channels, and the alpha channel is left at 255. */
+    m_lightmap_data_u8_vec.resize(N_LIGHTMAP_PAGES * LIGHTMAP_PAGE_SIZE * LIGHTMAP_PAGE_SIZE * 4);
+
+    for (uint32_t n_page = 0;
+                  n_page < N_LIGHTMAP_PAGES;
+                ++n_page)
+    {
+        uint8_t* page_data_ptr = m_lightmap_data_u8_vec.data() + n_page * LIGHTMAP_PAGE_SIZE * LIGHTMAP_PAGE_SIZE * 4;
+
+        for (uint32_t n_block_y = 0;
+                      n_block_y < LIGHTMAP_PAGE_SIZE;
+                      n_block_y += 16)
+        {
+            for (uint32_t n_block_x = 0;
+                          n_block_x < LIGHTMAP_PAGE_SIZE;
+                          n_block_x += 16)
+            {
+                const float ambient   = static_cast<float>(get_random_u32() % 64);
+                const float light_x   = static_cast<float>(get_random_u32() % 16);
+                const float light_y   = static_cast<float>(get_random_u32() % 16);
+                const float intensity = static_cast<float>(64 + get_random_u32() % 160);
+
+                for (uint32_t n_y = 0;
+                              n_y < 16;
+                            ++n_y)
+                {
+                    for (uint32_t n_x = 0;
+                                  n_x < 16;
+                                ++n_x)
+                    {
+                        const float    delta_x     = static_cast<float>(n_x) - light_x;
+                        const float    delta_y     = static_cast<float>(n_y) - light_y;
+                        const float    light       = ambient + intensity / (1.0f + 0.05f * (delta_x * delta_x + delta_y * delta_y) );
+                        const uint8_t  light_u8    = static_cast<uint8_t>( (light < 255.0f) ? light : 255.0f);
+                        uint8_t*       texel_ptr   = page_data_ptr + ( (n_block_y + n_y) * LIGHTMAP_PAGE_SIZE + n_block_x + n_x) * 4;
+
+                        texel_ptr[0] = 255 - light_u8;
+                        texel_ptr[1] = 255 - light_u8;
+                        texel_ptr[2] = 255 - light_u8;
+                        texel_ptr[3] = 255;
+                    }
+                }
+            }
+        }
+    }
+}
+
+void ReplayerBlockCodecBenchmark::build_texture_data()
+{
+    /* The palette is made of ramps, each going from dark to bright shades of a single color. Textures mostly stick to
+     * a couple of neighbouring shades of one or two ramps, with some noise on top. */
+    uint8_t palette[N_PALETTE_RAMPS * 16][3];
+
+    for (uint32_t n_ramp = 0;
+                  n_ramp < N_PALETTE_RAMPS;
+                ++n_ramp)
+    {
+        const uint32_t base_color[3] =
+        {
+            64 + get_random_u32() % 192,
+            64 + get_random_u32() % 192,
+            64 + get_random_u32() % 192
+        };
+
+        for (uint32_t n_shade = 0;
+                      n_shade < 16;
+                    ++n_shade)
+        {
+            for (uint32_t n_channel = 0;
+                          n_channel < 3;
+                        ++n_channel)
+            {
+                palette[n_ramp * 16 + n_shade][n_channel] = static_cast<uint8_t>(base_color[n_channel] * (n_shade + 1) / 16);
+            }
+        }
+    }
+
+    m_texture_data_u8_vec.resize(N_TEXTURES * TEXTURE_SIZE * TEXTURE_SIZE * 4);
+
+    for (uint32_t n_texture = 0;
+                  n_texture < N_TEXTURES;
+                ++n_texture)
+    {
+        const uint32_t n_ramps[2]    = {get_random_u32() % N_PALETTE_RAMPS, get_random_u32() % N_PALETTE_RAMPS};
+        uint8_t*       texel_ptr     = m_texture_data_u8_vec.data() + n_texture * TEXTURE_SIZE * TEXTURE_SIZE * 4;
+
+        for (uint32_t n_texel = 0;
+                      n_texel < TEXTURE_SIZE * TEXTURE_SIZE;
+                    ++n_texel, texel_ptr += 4)
+        {
+            const uint32_t n_x           = n_texel % TEXTURE_SIZE;
+            const uint32_t n_y           = n_texel / TEXTURE_SIZE;
+            const uint32_t n_ramp        = n_ramps[( (n_x / 16) + (n_y / 8) ) % 2]; // bricks
+            const uint32_t n_shade       = 6 + (get_random_u32() % 4);
+            const uint8_t* palette_color = palette[n_ramp * 16 + n_shade];
+
+            texel_ptr[0] = palette_color[0];
+            texel_ptr[1] = palette_color[1];
+            texel_ptr[2] = palette_color[2];
+            texel_ptr[3] = 255;
+        }
+    }
+}
+
+void ReplayerBlockCodecBenchmark::build_vertex_data()
+{
+    std::vector<ReplayerVertexBatchVertex> vertex_vec;
+
+    vertex_vec.reserve(N_WORLD_SURFACES * N_WORLD_SURFACE_VERTICES + N_ALIAS_MODEL_VERTICES);
+
+    /* World polygons lie on axis-aligned planes, snapped to the map grid. Texture coordinates follow from positions. */
+    for (uint32_t n_surface = 0;
+                  n_surface < N_WORLD_SURFACES;
+                ++n_surface)
+    {
+        const float origin[3] =
+        {
+            static_cast<float>(get_random_u32() % 128) * 16.0f - 1024.0f,
+            static_cast<float>(get_random_u32() % 128) * 16.0f - 1024.0f,
+            static_cast<float>(get_random_u32() % 32)  * 16.0f
+        };
+
+        for (uint32_t n_vertex = 0;
+                      n_vertex < N_WORLD_SURFACE_VERTICES;
+                    ++n_vertex)
+        {
+            ReplayerVertexBatchVertex vertex = {};
+
+            vertex.position[0]    = origin[0] + static_cast<float>(n_vertex)     * 16.0f;
+            vertex.position[1]    = origin[1] + static_cast<float>(n_vertex % 2) * 32.0f;
+            vertex.position[2]    = origin[2];
+            vertex.position[3]    = 1.0f;
+            vertex.texcoord[0]    = vertex.position[0] / 64.0f;
+            vertex.texcoord[1]    = vertex.position[1] / 64.0f;
+            vertex.attribute_mask = ReplayerVertexBatchVertex::ATTRIBUTE_POSITION_3F | ReplayerVertexBatchVertex::ATTRIBUTE_TEXCOORD_2F;
+
+            vertex_vec.push_back(vertex);
+        }
+    }
+
+    /* Alias models come with per-vertex shading and arbitrary positions. */
+    for (uint32_t n_vertex = 0;
+                  n_vertex < N_ALIAS_MODEL_VERTICES;
+                ++n_vertex)
+    {
+        ReplayerVertexBatchVertex vertex = {};
+        const float               shade  = static_cast<float>(get_random_u32() % 256) / 255.0f;
+
+        vertex.position[0]    = static_cast<float>(get_random_u32() % 4096) / 64.0f;
+        vertex.position[1]    = static_cast<float>(get_random_u32() % 4096) / 64.0f;
+        vertex.position[2]    = static_cast<float>(get_random_u32() % 4096) / 64.0f;
+        vertex.position[3]    = 1.0f;
+        vertex.texcoord[0]    = static_cast<float>(n_vertex % 8)  / 8.0f;
+        vertex.texcoord[1]    = static_cast<float>(n_vertex % 32) / 32.0f;
+        vertex.color[0]       = shade;
+        vertex.color[1]       = shade;
+        vertex.color[2]       = shade;
+        vertex.color[3]       = 1.0f;
+        vertex.attribute_mask = ReplayerVertexBatchVertex::ATTRIBUTE_POSITION_3F | ReplayerVertexBatchVertex::ATTRIBUTE_TEXCOORD_2F | ReplayerVertexBatchVertex::ATTRIBUTE_COLOR_3F;
+
+        vertex_vec.push_back(vertex);
+    }
+
+    m_vertex_data_u8_vec.resize(vertex_vec.size() * sizeof(ReplayerVertexBatchVertex) );
+
+    memcpy(m_vertex_data_u8_vec.data(),
+           vertex_vec.data          (),
+           m_vertex_data_u8_vec.size() );
+}
+
+uint32_t ReplayerBlockCodecBenchmark::get_random_u32()
+{
+    /* xorshift32. Deterministic, so that results can be compared between runs. */
+    m_random_state ^= m_random_state << 13;
+    m_random_state ^= m_random_state >> 17;
+    m_random_state ^= m_random_state << 5;
+
+    return m_random_state;
+}
+
+int ReplayerBlockCodecBenchmark::run(const uint32_t& in_n_timed_iterations)
+{
+    ReplayerBlockCodecBenchmark benchmark;
+    bool                        result = true;
+
+    benchmark.build_lightmap_data();
+    benchmark.build_texture_data ();
+    benchmark.build_vertex_data  ();
+
+    printf("%u KB blocks, %u timed iterations per data set\n\n",
+           ReplayerBlockCodec::BLOCK_SIZE / 1024,
+           in_n_timed_iterations);
+
+    result &= benchmark.run_data_set("Vertices",
+                                     benchmark.m_vertex_data_u8_vec,
+                                     in_n_timed_iterations);
+    result &= benchmark.run_data_set("Lightmaps",
+                                     benchmark.m_lightmap_data_u8_vec,
+                                     in_n_timed_iterations);
+    result &= benchmark.run_data_set("Palettized textures",
+                                     benchmark.m_texture_data_u8_vec,
+                                     in_n_timed_iterations);
+
+    return (result) ? EXIT_SUCCESS
+                    : EXIT_FAILURE;
+}
+
+bool ReplayerBlockCodecBenchmark::run_data_set(const char*                 in_name_ptr,
+                                               const std::vector<uint8_t>& in_data_u8_vec,
+                                               const uint32_t&             in_n_timed_iterations) const
+{
+    const uint32_t        n_data_bytes          = static_cast<uint32_t>(in_data_u8_vec.size() );
+    const uint32_t        n_blocks              = (n_data_bytes + ReplayerBlockCodec::BLOCK_SIZE - 1) / ReplayerBlockCodec::BLOCK_SIZE;
+    std::vector<uint32_t> block_n_bytes_vec     (n_blocks);
+    std::vector<uint8_t>  compressed_data_u8_vec(static_cast<size_t>(n_blocks) * ReplayerBlockCodec::get_max_n_compressed_bytes(ReplayerBlockCodec::BLOCK_SIZE) );
+    std::vector<uint8_t>  decompressed_data_u8_vec(n_data_bytes);
+    LARGE_INTEGER         decode_end_qpc        = {};
+    LARGE_INTEGER         decode_start_qpc      = {};
+    LARGE_INTEGER         encode_end_qpc        = {};
+    LARGE_INTEGER         encode_start_qpc      = {};
+    uint64_t              n_compressed_bytes    = 0;
+    LARGE_INTEGER         qpc_frequency         = {};
+    bool                  result                = true;
+
+    /* Each block is compressed into a slot of its own, so that decoding does not need a block table. */
+    const uint32_t n_max_compressed_block_bytes = ReplayerBlockCodec::get_max_n_compressed_bytes(ReplayerBlockCodec::BLOCK_SIZE);
+
+    ::QueryPerformanceCounter(&encode_start_qpc);
+    {
+        for (uint32_t n_iteration = 0;
+                      n_iteration < in_n_timed_iterations;
+                    ++n_iteration)
+        {
+            n_compressed_bytes = 0;
+
+            for (uint32_t n_block = 0;
+                          n_block < n_blocks;
+                        ++n_block)
+            {
+                const uint32_t n_block_first_byte = n_block * ReplayerBlockCodec::BLOCK_SIZE;
+                const uint32_t n_block_bytes      = (n_data_bytes - n_block_first_byte < ReplayerBlockCodec::BLOCK_SIZE) ? n_data_bytes - n_block_first_byte
+                                                                                                                           : ReplayerBlockCodec::BLOCK_SIZE;
+
+                block_n_bytes_vec.at(n_block) = ReplayerBlockCodec::compress(in_data_u8_vec.data()         + n_block_first_byte,
+                                                                             n_block_bytes,
+                                                                             compressed_data_u8_vec.data() + static_cast<size_t>(n_block) * n_max_compressed_block_bytes);
+                n_compressed_bytes           += block_n_bytes_vec.at(n_block);
+            }
+        }
+    }
+    ::QueryPerformanceCounter(&encode_end_qpc);
+
+    ::QueryPerformanceCounter(&decode_start_qpc);
+    {
+        for (uint32_t n_iteration = 0;
+                      n_iteration < in_n_timed_iterations && result;
+                    ++n_iteration)
+        {
+            for (uint32_t n_block = 0;
+                          n_block < n_blocks;
+                        ++n_block)
+            {
+                const uint32_t n_block_first_byte = n_block * ReplayerBlockCodec::BLOCK_SIZE;
+                const uint32_t n_block_bytes      = (n_data_bytes - n_block_first_byte < ReplayerBlockCodec::BLOCK_SIZE) ? n_data_bytes - n_block_first_byte
+                                                                                                                           : ReplayerBlockCodec::BLOCK_SIZE;
+
+                result &= ReplayerBlockCodec::decompress(compressed_data_u8_vec.data()   + static_cast<size_t>(n_block) * n_max_compressed_block_bytes,
+                                                         block_n_bytes_vec.at(n_block),
+                                                         decompressed_data_u8_vec.data() + n_block_first_byte,
+                                                         n_block_bytes);
+            }
+        }
+    }
+    ::QueryPerformanceCounter  (&decode_end_qpc);
+    ::QueryPerformanceFrequency(&qpc_frequency);
+
+    result &= (memcmp(decompressed_data_u8_vec.data(),
+                      in_data_u8_vec.data          (),
+                      n_data_bytes) == 0);
+
+    if (!result)
+    {
+        printf("%-20s round trip FAILED\n",
+               in_name_ptr);
+
+        return false;
+    }
+
+    {
+        const double n_total_gb          = static_cast<double>(n_data_bytes) * static_cast<double>(in_n_timed_iterations) / 1e9;
+        const double decode_time_seconds = static_cast<double>(decode_end_qpc.QuadPart - decode_start_qpc.QuadPart) / static_cast<double>(qpc_frequency.QuadPart);
+        const double encode_time_seconds = static_cast<double>(encode_end_qpc.QuadPart - encode_start_qpc.QuadPart) / static_cast<double>(qpc_frequency.QuadPart);
+
+        printf("%-20s %7.2f MB -> %7.2f MB (%5.2f:1), encode %6.3f GB/s, decode %6.3f GB/s\n",
+               in_name_ptr,
+               static_cast<double>(n_data_bytes)       / (1024.0 * 1024.0),
+               static_cast<double>(n_compressed_bytes) / (1024.0 * 1024.0),
+               static_cast<double>(n_data_bytes)       / static_cast<double>(n_compressed_bytes),
+               n_total_gb / encode_time_seconds,
+               n_total_gb / decode_time_seconds);
+    }
+
+    return true;
+}
+
+
+int main(int   argc,
+         char* argv[])
+{
+    const uint32_t n_timed_iterations = (argc > 1) ? static_cast<uint32_t>(atoi(argv[1]) )
+                                                   : 20;
+
+    return ReplayerBlockCodecBenchmark::run( (n_timed_iterations > 0) ? n_timed_iterations : 1);
+}
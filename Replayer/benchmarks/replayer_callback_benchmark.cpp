@@ -0,0 +1,733 @@
+/* API Interceptor (c) 2024 Dominik Witczak
+ *
+ * This code is licensed under MIT license (see LICENSE.txt for details)
+ */
+
+/* Feeds a synthetic, GLQuake-sized frame through ReplayerSnapshotter's GL callback and reports how many calls per
+ * second make it through:
+ *
+ * - with the snapshotter only tracking state, which is what every frame costs while no capture is armed.
+ * - with every frame being recorded into the flight recorder, as is the case with auto-capture or the journal enabled.
+ * - with every frame being recorded under the STATE_ONLY capture profile, where most calls take the handler table's
+ *   fast path and are only counted.
+ * - with a copy of the callback as it was before calls got dispatched through the handler table. It records every
+ *   frame, so it is the baseline the FULL profile is compared against. Note that the FULL profile also pays for
+ *   everything recording has gained since, most notably feeding each command to the segment analyzer.
+ *
+ * Once the recording buffers have warmed up, a series of captures is also taken and handed back, to check that
+ * snapshots stop allocating memory (see ReplayerSnapshot::get_n_total_heap_allocations() ). The benchmark fails if
+ * they do not.
+ *
+ * No GL context is needed. The few GL functions the snapshotter calls on its own are replaced with no-ops.
+ *
+ * Usage: ReplayerCallbackBenchmark [number of timed frames per configuration]
+ */
+#include "Common/callbacks.h"
+#include "OpenGL/globals.h"
+#include "replayer_snapshotter.h"
+#include <cstdio>
+#include <cstdlib>
+#include <unordered_map>
+#include <vector>
+
+
+/* ReplayerSnapshotter's GL callback as it was before calls got dispatched through the handler table: one if/else chain,
+ * with every frame recorded. Texture uploads, parameters and deletions are not part of the synthetic frame, so their
+ * bodies are left out. They keep their place in the chain though, so that the calls tested after them pay for the same
+ * number of comparisons as they used to. */
+class ReplayerCallbackBenchmarkBaseline
+{
+public:
+    /* Public funcs */
+    ReplayerCallbackBenchmarkBaseline();
+
+    static void on_api_func_callback(APIInterceptor::APIFunction                in_api_func,
+                                     uint32_t                                   in_n_args,
+                                     const APIInterceptor::APIFunctionArgument* in_args_ptr,
+                                     void*                                      in_user_arg_ptr);
+
+private:
+    /* Private vars */
+    GLContextState                                      m_current_context_state;
+    bool                                                m_is_glbegin_active;
+    ReplayerSnapshotUniquePtr                           m_recording_snapshot_ptr;
+    GLContextStateUniquePtr                             m_start_gl_context_state_ptr;
+    std::unordered_map<uint32_t /* GLenum */, uint32_t> m_texture_target_to_bound_texture_id_map;
+};
+
+class ReplayerCallbackBenchmark
+{
+public:
+    /* Public funcs */
+    static int run(const uint32_t& in_n_timed_frames);
+
+private:
+    /* Private type defs */
+    typedef void (*CallbackFunc)(APIInterceptor::APIFunction                in_api_func,
+                                 uint32_t                                   in_n_args,
+                                 const APIInterceptor::APIFunctionArgument* in_args_ptr,
+                                 void*                                      in_user_arg_ptr);
+
+    struct Call
+    {
+        APIInterceptor::APIFunction api_func;
+        uint32_t                    n_args;
+        uint32_t                    n_first_arg;
+    };
+
+    /* Private consts */
+    static const uint32_t N_CAPTURES              = 64;
+    static const uint32_t N_ENTITIES              = 24;
+    static const uint32_t N_ENTITY_STRIPS         = 32;
+    static const uint32_t N_ENTITY_STRIP_VERTICES = 8;
+    static const uint32_t N_HUD_GLYPHS            = 200;
+    static const uint32_t N_SURFACES_PER_TEXTURE  = 16;
+    static const uint32_t N_SURFACE_VERTICES      = 5;
+    static const uint32_t N_WARMUP_FRAMES         = 16;
+    static const uint32_t N_WORLD_SURFACES        = 1200;
+
+    /* Private funcs */
+    ReplayerCallbackBenchmark();
+
+    void   add_call         (const APIInterceptor::APIFunction&                         in_api_func,
+                             std::initializer_list<APIInterceptor::APIFunctionArgument> in_args);
+    void   build_frame      ();
+    void   dispatch_frame   (CallbackFunc                                               in_callback_func_ptr,
+                             void*                                                      in_user_arg_ptr) const;
+    bool   run_capture_loop (ReplayerSnapshotter*                                       in_snapshotter_ptr) const;
+    double run_configuration(const char*                                                in_name_ptr,
+                             const uint32_t&                                            in_n_timed_frames,
+                             CallbackFunc                                               in_callback_func_ptr,
+                             void*                                                      in_user_arg_ptr) const;
+
+    static void   APIENTRY benchmark_gl_get_doublev (GLenum    in_pname,
+                                                     GLdouble* out_data_ptr);
+    static GLenum APIENTRY benchmark_gl_get_error   ();
+    static void   APIENTRY benchmark_gl_pixel_storei(GLenum    in_pname,
+                                                     GLint     in_param);
+
+    /* Private vars */
+    std::vector<APIInterceptor::APIFunctionArgument> m_arg_vec;
+    std::vector<Call>                                m_call_vec;
+};
+
+
+ReplayerCallbackBenchmarkBaseline::ReplayerCallbackBenchmarkBaseline()
+    :m_current_context_state (640,  /* in_q1_window_width  */
+                              480), /* in_q1_window_height */
+     m_is_glbegin_active     (false),
+     m_recording_snapshot_ptr(ReplayerSnapshot::create() )
+{
+    m_recording_snapshot_ptr->set_vertex_batching_enabled(true);
+}
+
+void ReplayerCallbackBenchmarkBaseline::on_api_func_callback(APIInterceptor::APIFunction                in_api_func,
+                                                             uint32_t                                   in_n_args,
+                                                             const APIInterceptor::APIFunctionArgument* in_args_ptr,
+                                                             void*                                      in_user_arg_ptr)
+{
+    auto this_ptr(reinterpret_cast<ReplayerCallbackBenchmarkBaseline*>(in_user_arg_ptr) );
+
+    if (this_ptr->m_start_gl_context_state_ptr == nullptr)
+    {
+        this_ptr->m_start_gl_context_state_ptr.reset(new GLContextState(this_ptr->m_current_context_state) );
+
+        assert(this_ptr->m_start_gl_context_state_ptr != nullptr);
+
+        /* Query & store matrix state */
+        reinterpret_cast<PFNGLGETDOUBLEVPROC>(OpenGL::g_cached_gl_get_doublev)(GL_MODELVIEW_MATRIX,
+                                                                               this_ptr->m_start_gl_context_state_ptr->modelview_matrix);
+        reinterpret_cast<PFNGLGETDOUBLEVPROC>(OpenGL::g_cached_gl_get_doublev)(GL_PROJECTION_MATRIX,
+                                                                               this_ptr->m_start_gl_context_state_ptr->projection_matrix);
+    }
+
+    assert(this_ptr->m_recording_snapshot_ptr != nullptr);
+
+    if (in_api_func != APIInterceptor::APIFUNCTION_GDI32_SWAPBUFFERS)
+    {
+        bool should_record_api_call = (this_ptr->m_current_context_state.draw_buffer_mode == GL_BACK);
+
+        if ( (in_api_func == APIInterceptor::APIFUNCTION_GL_GLDISABLE) ||
+             (in_api_func == APIInterceptor::APIFUNCTION_GL_GLENABLE)   )
+        {
+            const bool should_enable = (in_api_func == APIInterceptor::APIFUNCTION_GL_GLENABLE);
+
+            switch (in_args_ptr[0].get_u32() )
+            {
+                case GL_ALPHA_TEST:   this_ptr->m_current_context_state.alpha_test_enabled   = should_enable; break;
+                case GL_BLEND:        this_ptr->m_current_context_state.blend_enabled        = should_enable; break;
+                case GL_CULL_FACE:    this_ptr->m_current_context_state.cull_face_enabled    = should_enable; break;
+                case GL_DEPTH_TEST:   this_ptr->m_current_context_state.depth_test_enabled   = should_enable; break;
+                case GL_SCISSOR_TEST: this_ptr->m_current_context_state.scissor_test_enabled = should_enable; break;
+                case GL_TEXTURE_2D:   this_ptr->m_current_context_state.texture_2d_enabled   = should_enable; break;
+
+                default:
+                {
+                    assert(false);
+                }
+            }
+        }
+        else
+        if (in_api_func == APIInterceptor::APIFUNCTION_GL_GLALPHAFUNC)
+        {
+            this_ptr->m_current_context_state.alpha_func_func = in_args_ptr[0].get_u32 ();
+            this_ptr->m_current_context_state.alpha_func_ref  = in_args_ptr[1].get_fp32();
+        }
+        else
+        if (in_api_func == APIInterceptor::APIFUNCTION_GL_GLBLENDFUNC)
+        {
+            this_ptr->m_current_context_state.blend_func_sfactor = in_args_ptr[0].get_u32();
+            this_ptr->m_current_context_state.blend_func_dfactor = in_args_ptr[1].get_u32();
+        }
+        else
+        if (in_api_func == APIInterceptor::APIFUNCTION_GL_GLCLEARCOLOR)
+        {
+            this_ptr->m_current_context_state.clear_color[0] = in_args_ptr[0].get_fp32();
+            this_ptr->m_current_context_state.clear_color[1] = in_args_ptr[1].get_fp32();
+            this_ptr->m_current_context_state.clear_color[2] = in_args_ptr[2].get_fp32();
+            this_ptr->m_current_context_state.clear_color[3] = in_args_ptr[3].get_fp32();
+        }
+        else
+        if (in_api_func == APIInterceptor::APIFUNCTION_GL_GLCLEARDEPTH)
+        {
+            this_ptr->m_current_context_state.clear_depth = in_args_ptr[0].get_fp64();
+        }
+        else
+        if (in_api_func == APIInterceptor::APIFUNCTION_GL_GLCULLFACE)
+        {
+            this_ptr->m_current_context_state.cull_face_mode = in_args_ptr[0].get_u32();
+        }
+        else
+        if (in_api_func == APIInterceptor::APIFUNCTION_GL_GLDEPTHFUNC)
+        {
+            this_ptr->m_current_context_state.depth_func = in_args_ptr[0].get_u32();
+        }
+        else
+        if (in_api_func == APIInterceptor::APIFUNCTION_GL_GLDEPTHMASK)
+        {
+            this_ptr->m_current_context_state.depth_mask = (in_args_ptr[0].get_u32() != 0);
+        }
+        else
+        if (in_api_func == APIInterceptor::APIFUNCTION_GL_GLDEPTHRANGE)
+        {
+            this_ptr->m_current_context_state.depth_range[0] = in_args_ptr[0].get_fp64();
+            this_ptr->m_current_context_state.depth_range[1] = in_args_ptr[1].get_fp64();
+        }
+        else
+        if (in_api_func == APIInterceptor::APIFUNCTION_GL_GLDRAWBUFFER)
+        {
+            const auto mode = in_args_ptr[0].get_u32();
+
+            should_record_api_call                             = (mode == GL_BACK);
+            this_ptr->m_current_context_state.draw_buffer_mode = mode;
+        }
+        else
+        if (in_api_func == APIInterceptor::APIFUNCTION_GL_GLFRONTFACE)
+        {
+            this_ptr->m_current_context_state.front_face_mode = in_args_ptr[0].get_u32();
+        }
+        else
+        if (in_api_func == APIInterceptor::APIFUNCTION_GL_GLMATRIXMODE)
+        {
+            this_ptr->m_current_context_state.matrix_mode = in_args_ptr[0].get_u32();
+        }
+        else
+        if (in_api_func == APIInterceptor::APIFUNCTION_GL_GLSHADEMODEL)
+        {
+            this_ptr->m_current_context_state.shade_model = in_args_ptr[0].get_u32();
+        }
+        else
+        if (in_api_func == APIInterceptor::APIFUNCTION_GL_GLTEXENVF)
+        {
+            AI_ASSERT(in_n_args == 3);
+
+            this_ptr->m_current_context_state.texture_env_mode = static_cast<uint32_t>(in_args_ptr[2].get_fp32() );
+        }
+        else
+        if (in_api_func == APIInterceptor::APIFUNCTION_GL_GLVIEWPORT)
+        {
+            AI_ASSERT(in_n_args == 4);
+
+            this_ptr->m_current_context_state.viewport_x1y1   [0] = in_args_ptr[0].get_i32();
+            this_ptr->m_current_context_state.viewport_x1y1   [1] = in_args_ptr[1].get_i32();
+            this_ptr->m_current_context_state.viewport_extents[0] = in_args_ptr[2].get_i32();
+            this_ptr->m_current_context_state.viewport_extents[1] = in_args_ptr[3].get_i32();
+        }
+        else
+        if (in_api_func == APIInterceptor::APIFUNCTION_GL_GLBINDTEXTURE)
+        {
+            AI_ASSERT(in_n_args == 2);
+
+            const auto target     = in_args_ptr[0].get_u32();
+            const auto texture_id = in_args_ptr[1].get_u32();
+
+            AI_ASSERT(target == GL_TEXTURE_2D);
+
+            this_ptr->m_current_context_state.bound_2d_texture_gl_id   = texture_id;
+            this_ptr->m_texture_target_to_bound_texture_id_map[target] = texture_id;
+        }
+        else
+        if (in_api_func == APIInterceptor::APIFUNCTION_GL_GLDELETETEXTURES ||
+            in_api_func == APIInterceptor::APIFUNCTION_GL_GLTEXIMAGE2D     ||
+            in_api_func == APIInterceptor::APIFUNCTION_GL_GLTEXPARAMETERF)
+        {
+            should_record_api_call = false;
+        }
+
+        if (should_record_api_call)
+        {
+            if (in_api_func == APIInterceptor::APIFUNCTION_GL_GLCOLOR3UBV)
+            {
+                const auto                                               color_data_ptr = reinterpret_cast<const unsigned char*>(in_args_ptr[0].get_u8_ptr() );
+                const std::array<APIInterceptor::APIFunctionArgument, 3> api_arg_vec    =
+                {
+                    APIInterceptor::APIFunctionArgument::create_u8(color_data_ptr[0]),
+                    APIInterceptor::APIFunctionArgument::create_u8(color_data_ptr[1]),
+                    APIInterceptor::APIFunctionArgument::create_u8(color_data_ptr[2]),
+                };
+
+                this_ptr->m_recording_snapshot_ptr->record_api_call(APIInterceptor::APIFUNCTION_GL_GLCOLOR3UB,
+                                                                    static_cast<uint32_t>(api_arg_vec.size() ),
+                                                                    api_arg_vec.data     () );
+            }
+            else
+            if (in_api_func == APIInterceptor::APIFUNCTION_GL_GLCOLOR4FV)
+            {
+                const auto                                               color_data_ptr = in_args_ptr[0].get_fp32_ptr();
+                const std::array<APIInterceptor::APIFunctionArgument, 4> api_arg_vec    =
+                {
+                    APIInterceptor::APIFunctionArgument::create_fp32(color_data_ptr[0]),
+                    APIInterceptor::APIFunctionArgument::create_fp32(color_data_ptr[1]),
+                    APIInterceptor::APIFunctionArgument::create_fp32(color_data_ptr[2]),
+                    APIInterceptor::APIFunctionArgument::create_fp32(color_data_ptr[3])
+                };
+
+                this_ptr->m_recording_snapshot_ptr->record_api_call(APIInterceptor::APIFUNCTION_GL_GLCOLOR4F,
+                                                                    static_cast<uint32_t>(api_arg_vec.size() ),
+                                                                    api_arg_vec.data     () );
+            }
+            else
+            if (in_api_func == APIInterceptor::APIFUNCTION_GL_GLVERTEX3FV)
+            {
+                const auto                                               vertex_data_ptr = in_args_ptr[0].get_fp32_ptr();
+                const std::array<APIInterceptor::APIFunctionArgument, 3> api_arg_vec     =
+                {
+                    APIInterceptor::APIFunctionArgument::create_fp32(vertex_data_ptr[0]),
+                    APIInterceptor::APIFunctionArgument::create_fp32(vertex_data_ptr[1]),
+                    APIInterceptor::APIFunctionArgument::create_fp32(vertex_data_ptr[2])
+                };
+
+                this_ptr->m_recording_snapshot_ptr->record_api_call(APIInterceptor::APIFUNCTION_GL_GLVERTEX3F,
+                                                                    static_cast<uint32_t>(api_arg_vec.size() ),
+                                                                    api_arg_vec.data     () );
+            }
+            else
+            {
+                this_ptr->m_recording_snapshot_ptr->record_api_call(in_api_func,
+                                                                    in_n_args,
+                                                                    in_args_ptr);
+            }
+        }
+    }
+    else
+    {
+        this_ptr->m_recording_snapshot_ptr->reset                      ();
+        this_ptr->m_recording_snapshot_ptr->set_vertex_batching_enabled(true);
+        this_ptr->m_start_gl_context_state_ptr.reset                   ();
+
+        reinterpret_cast<PFNGLPIXELSTOREIPROC>(OpenGL::g_cached_gl_pixel_storei)(GL_PACK_ALIGNMENT,   1);
+        reinterpret_cast<PFNGLPIXELSTOREIPROC>(OpenGL::g_cached_gl_pixel_storei)(GL_UNPACK_ALIGNMENT, 1);
+    }
+
+    if (in_api_func == APIInterceptor::APIFUNCTION_GL_GLBEGIN)
+    {
+        this_ptr->m_is_glbegin_active = true;
+    }
+    else
+    if (in_api_func == APIInterceptor::APIFUNCTION_GL_GLEND)
+    {
+        AI_ASSERT(this_ptr->m_is_glbegin_active);
+
+        this_ptr->m_is_glbegin_active = false;
+    }
+    else
+    {
+        if (!this_ptr->m_is_glbegin_active)
+        {
+            AI_ASSERT(reinterpret_cast<PFNGLGETERRORPROC>(OpenGL::g_cached_gl_get_error)() == GL_NO_ERROR);
+        }
+    }
+}
+
+
+ReplayerCallbackBenchmark::ReplayerCallbackBenchmark()
+{
+    /* Stub */
+}
+
+void ReplayerCallbackBenchmark::add_call(const APIInterceptor::APIFunction&                           in_api_func,
+                                         std::initializer_list<APIInterceptor::APIFunctionArgument> in_args)
+{
+    Call call;
+
+    call.api_func    = in_api_func;
+    call.n_args      = static_cast<uint32_t>(in_args.size() );
+    call.n_first_arg = static_cast<uint32_t>(m_arg_vec.size() );
+
+    m_arg_vec.insert (m_arg_vec.end(),
+                      in_args.begin(),
+                      in_args.end  () );
+    m_call_vec.push_back(call);
+}
+
+void APIENTRY ReplayerCallbackBenchmark::benchmark_gl_get_doublev(GLenum    in_pname,
+                                                                  GLdouble* out_data_ptr)
+{
+    /* Only used by debug builds to cross-check shadowed matrices. Every frame ends with both matrices reset. */
+    for (uint32_t n_element = 0;
+                  n_element < 16;
+                ++n_element)
+    {
+        out_data_ptr[n_element] = (n_element % 5 == 0) ? 1.0 : 0.0;
+    }
+}
+
+GLenum APIENTRY ReplayerCallbackBenchmark::benchmark_gl_get_error()
+{
+    return GL_NO_ERROR;
+}
+
+void APIENTRY ReplayerCallbackBenchmark::benchmark_gl_pixel_storei(GLenum in_pname,
+                                                                   GLint  in_param)
+{
+    /* Stub */
+}
+
+void ReplayerCallbackBenchmark::build_frame()
+{
+    typedef APIInterceptor::APIFunctionArgument Arg;
+
+    /* 3D view setup */
+    add_call(APIInterceptor::APIFUNCTION_GL_GLDRAWBUFFER,   {Arg::create_u32(GL_BACK)});
+    add_call(APIInterceptor::APIFUNCTION_GL_GLCLEAR,        {Arg::create_u32(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT)});
+    add_call(APIInterceptor::APIFUNCTION_GL_GLMATRIXMODE,   {Arg::create_u32(GL_PROJECTION)});
+    add_call(APIInterceptor::APIFUNCTION_GL_GLLOADIDENTITY, {});
+    add_call(APIInterceptor::APIFUNCTION_GL_GLSCALEF,       {Arg::create_fp32(1.0f), Arg::create_fp32(1.333f), Arg::create_fp32(-1.0f)});
+    add_call(APIInterceptor::APIFUNCTION_GL_GLMATRIXMODE,   {Arg::create_u32(GL_MODELVIEW)});
+    add_call(APIInterceptor::APIFUNCTION_GL_GLLOADIDENTITY, {});
+    add_call(APIInterceptor::APIFUNCTION_GL_GLROTATEF,      {Arg::create_fp32(-90.0f), Arg::create_fp32(1.0f), Arg::create_fp32(0.0f), Arg::create_fp32(0.0f)});
+    add_call(APIInterceptor::APIFUNCTION_GL_GLROTATEF,      {Arg::create_fp32( 90.0f), Arg::create_fp32(0.0f), Arg::create_fp32(0.0f), Arg::create_fp32(1.0f)});
+    add_call(APIInterceptor::APIFUNCTION_GL_GLTRANSLATEF,   {Arg::create_fp32(-544.0f), Arg::create_fp32(-288.0f), Arg::create_fp32(-56.0f)});
+    add_call(APIInterceptor::APIFUNCTION_GL_GLCULLFACE,     {Arg::create_u32(GL_FRONT)});
+    add_call(APIInterceptor::APIFUNCTION_GL_GLENABLE,       {Arg::create_u32(GL_CULL_FACE)});
+    add_call(APIInterceptor::APIFUNCTION_GL_GLENABLE,       {Arg::create_u32(GL_DEPTH_TEST)});
+    add_call(APIInterceptor::APIFUNCTION_GL_GLDISABLE,      {Arg::create_u32(GL_BLEND)});
+
+    /* World surfaces, followed by the lightmap pass which blends the same polygons over them. */
+    for (uint32_t n_pass = 0;
+                  n_pass < 2;
+                ++n_pass)
+    {
+        const bool is_lightmap_pass = (n_pass == 1);
+
+        if (is_lightmap_pass)
+        {
+            add_call(APIInterceptor::APIFUNCTION_GL_GLDEPTHMASK, {Arg::create_u32(GL_FALSE)});
+            add_call(APIInterceptor::APIFUNCTION_GL_GLENABLE,    {Arg::create_u32(GL_BLEND)});
+            add_call(APIInterceptor::APIFUNCTION_GL_GLBLENDFUNC, {Arg::create_u32(GL_ZERO), Arg::create_u32(GL_ONE_MINUS_SRC_COLOR)});
+        }
+
+        for (uint32_t n_surface = 0;
+                      n_surface < N_WORLD_SURFACES;
+                    ++n_surface)
+        {
+            if (n_surface % N_SURFACES_PER_TEXTURE == 0)
+            {
+                add_call(APIInterceptor::APIFUNCTION_GL_GLBINDTEXTURE, {Arg::create_u32(GL_TEXTURE_2D), Arg::create_u32(1 + n_pass * 1000 + n_surface / N_SURFACES_PER_TEXTURE)});
+            }
+
+            add_call(APIInterceptor::APIFUNCTION_GL_GLBEGIN, {Arg::create_u32(GL_POLYGON)});
+
+            for (uint32_t n_vertex = 0;
+                          n_vertex < N_SURFACE_VERTICES;
+                        ++n_vertex)
+            {
+                const float x = static_cast<float>(n_surface % 64) * 64.0f + static_cast<float>(n_vertex) * 12.0f;
+                const float y = static_cast<float>(n_surface / 64) * 64.0f + static_cast<float>(n_vertex % 2) * 48.0f;
+
+                add_call(APIInterceptor::APIFUNCTION_GL_GLTEXCOORD2F, {Arg::create_fp32(x / 64.0f), Arg::create_fp32(y / 64.0f)});
+                add_call(APIInterceptor::APIFUNCTION_GL_GLVERTEX3F,   {Arg::create_fp32(x),         Arg::create_fp32(y),         Arg::create_fp32(0.0f)});
+            }
+
+            add_call(APIInterceptor::APIFUNCTION_GL_GLEND, {});
+        }
+
+        if (is_lightmap_pass)
+        {
+            add_call(APIInterceptor::APIFUNCTION_GL_GLDISABLE,   {Arg::create_u32(GL_BLEND)});
+            add_call(APIInterceptor::APIFUNCTION_GL_GLDEPTHMASK, {Arg::create_u32(GL_TRUE)});
+        }
+    }
+
+    /* Alias models: per-vertex lighting, drawn as triangle strips. */
+    add_call(APIInterceptor::APIFUNCTION_GL_GLSHADEMODEL, {Arg::create_u32(GL_SMOOTH)});
+    add_call(APIInterceptor::APIFUNCTION_GL_GLTEXENVF,    {Arg::create_u32(GL_TEXTURE_ENV), Arg::create_u32(GL_TEXTURE_ENV_MODE), Arg::create_fp32(static_cast<float>(GL_MODULATE) )});
+
+    for (uint32_t n_entity = 0;
+                  n_entity < N_ENTITIES;
+                ++n_entity)
+    {
+        add_call(APIInterceptor::APIFUNCTION_GL_GLPUSHMATRIX,  {});
+        add_call(APIInterceptor::APIFUNCTION_GL_GLTRANSLATEF,  {Arg::create_fp32(static_cast<float>(n_entity) * 32.0f), Arg::create_fp32(128.0f), Arg::create_fp32(24.0f)});
+        add_call(APIInterceptor::APIFUNCTION_GL_GLROTATEF,     {Arg::create_fp32(static_cast<float>(n_entity) * 15.0f), Arg::create_fp32(0.0f),   Arg::create_fp32(0.0f), Arg::create_fp32(1.0f)});
+        add_call(APIInterceptor::APIFUNCTION_GL_GLBINDTEXTURE, {Arg::create_u32(GL_TEXTURE_2D), Arg::create_u32(2000 + n_entity)});
+
+        for (uint32_t n_strip = 0;
+                      n_strip < N_ENTITY_STRIPS;
+                    ++n_strip)
+        {
+            add_call(APIInterceptor::APIFUNCTION_GL_GLBEGIN, {Arg::create_u32(GL_TRIANGLE_STRIP)});
+
+            for (uint32_t n_vertex = 0;
+                          n_vertex < N_ENTITY_STRIP_VERTICES;
+                        ++n_vertex)
+            {
+                const float shade = static_cast<float>((n_strip + n_vertex) % 16) / 16.0f;
+
+                add_call(APIInterceptor::APIFUNCTION_GL_GLTEXCOORD2F, {Arg::create_fp32(static_cast<float>(n_vertex) / 8.0f), Arg::create_fp32(static_cast<float>(n_strip) / 32.0f)});
+                add_call(APIInterceptor::APIFUNCTION_GL_GLCOLOR3F,    {Arg::create_fp32(shade),                               Arg::create_fp32(shade),                               Arg::create_fp32(shade)});
+                add_call(APIInterceptor::APIFUNCTION_GL_GLVERTEX3F,   {Arg::create_fp32(static_cast<float>(n_vertex) * 4.0f), Arg::create_fp32(static_cast<float>(n_strip) * 2.0f), Arg::create_fp32(static_cast<float>(n_vertex % 2) * 3.0f)});
+            }
+
+            add_call(APIInterceptor::APIFUNCTION_GL_GLEND, {});
+        }
+
+        add_call(APIInterceptor::APIFUNCTION_GL_GLPOPMATRIX, {});
+    }
+
+    add_call(APIInterceptor::APIFUNCTION_GL_GLSHADEMODEL, {Arg::create_u32(GL_FLAT)});
+
+    /* 2D overlay: status bar & console text. Both matrices end up reset, which is what debug builds expect to read
+     * back at the start of the next frame. */
+    add_call(APIInterceptor::APIFUNCTION_GL_GLMATRIXMODE,   {Arg::create_u32(GL_PROJECTION)});
+    add_call(APIInterceptor::APIFUNCTION_GL_GLLOADIDENTITY, {});
+    add_call(APIInterceptor::APIFUNCTION_GL_GLMATRIXMODE,   {Arg::create_u32(GL_MODELVIEW)});
+    add_call(APIInterceptor::APIFUNCTION_GL_GLLOADIDENTITY, {});
+    add_call(APIInterceptor::APIFUNCTION_GL_GLDISABLE,      {Arg::create_u32(GL_DEPTH_TEST)});
+    add_call(APIInterceptor::APIFUNCTION_GL_GLDISABLE,      {Arg::create_u32(GL_CULL_FACE)});
+    add_call(APIInterceptor::APIFUNCTION_GL_GLENABLE,       {Arg::create_u32(GL_ALPHA_TEST)});
+    add_call(APIInterceptor::APIFUNCTION_GL_GLBINDTEXTURE,  {Arg::create_u32(GL_TEXTURE_2D), Arg::create_u32(3000)});
+
+    for (uint32_t n_glyph = 0;
+                  n_glyph < N_HUD_GLYPHS;
+                ++n_glyph)
+    {
+        const float x = static_cast<float>(n_glyph % 80) * 8.0f;
+        const float y = static_cast<float>(n_glyph / 80) * 8.0f;
+
+        add_call(APIInterceptor::APIFUNCTION_GL_GLBEGIN,      {Arg::create_u32(GL_QUADS)});
+        add_call(APIInterceptor::APIFUNCTION_GL_GLTEXCOORD2F, {Arg::create_fp32(0.0f),      Arg::create_fp32(0.0f)});
+        add_call(APIInterceptor::APIFUNCTION_GL_GLVERTEX2F,   {Arg::create_fp32(x),         Arg::create_fp32(y)});
+        add_call(APIInterceptor::APIFUNCTION_GL_GLTEXCOORD2F, {Arg::create_fp32(0.0625f),   Arg::create_fp32(0.0f)});
+        add_call(APIInterceptor::APIFUNCTION_GL_GLVERTEX2F,   {Arg::create_fp32(x + 8.0f),  Arg::create_fp32(y)});
+        add_call(APIInterceptor::APIFUNCTION_GL_GLTEXCOORD2F, {Arg::create_fp32(0.0625f),   Arg::create_fp32(0.0625f)});
+        add_call(APIInterceptor::APIFUNCTION_GL_GLVERTEX2F,   {Arg::create_fp32(x + 8.0f),  Arg::create_fp32(y + 8.0f)});
+        add_call(APIInterceptor::APIFUNCTION_GL_GLTEXCOORD2F, {Arg::create_fp32(0.0f),      Arg::create_fp32(0.0625f)});
+        add_call(APIInterceptor::APIFUNCTION_GL_GLVERTEX2F,   {Arg::create_fp32(x),         Arg::create_fp32(y + 8.0f)});
+        add_call(APIInterceptor::APIFUNCTION_GL_GLEND,        {});
+    }
+
+    add_call(APIInterceptor::APIFUNCTION_GL_GLDISABLE, {Arg::create_u32(GL_ALPHA_TEST)});
+}
+
+void ReplayerCallbackBenchmark::dispatch_frame(CallbackFunc in_callback_func_ptr,
+                                               void*        in_user_arg_ptr) const
+{
+    const auto args_ptr = m_arg_vec.data();
+
+    for (const auto& current_call : m_call_vec)
+    {
+        in_callback_func_ptr(current_call.api_func,
+                             current_call.n_args,
+                             args_ptr + current_call.n_first_arg,
+                             in_user_arg_ptr);
+    }
+
+    in_callback_func_ptr(APIInterceptor::APIFUNCTION_GDI32_SWAPBUFFERS,
+                         0,       /* in_n_args   */
+                         nullptr, /* in_args_ptr */
+                         in_user_arg_ptr);
+}
+
+int ReplayerCallbackBenchmark::run(const uint32_t& in_n_timed_frames)
+{
+    ReplayerCallbackBenchmark    benchmark;
+    double                       baseline_n_calls_per_second = 0.0;
+    double                       full_n_calls_per_second     = 0.0;
+    int                          result                      = EXIT_SUCCESS;
+    ReplayerSnapshotterUniquePtr snapshotter_ptr;
+
+    OpenGL::g_cached_gl_get_doublev  = reinterpret_cast<decltype(OpenGL::g_cached_gl_get_doublev)> (&ReplayerCallbackBenchmark::benchmark_gl_get_doublev);
+    OpenGL::g_cached_gl_get_error    = reinterpret_cast<decltype(OpenGL::g_cached_gl_get_error)>   (&ReplayerCallbackBenchmark::benchmark_gl_get_error);
+    OpenGL::g_cached_gl_pixel_storei = reinterpret_cast<decltype(OpenGL::g_cached_gl_pixel_storei)>(&ReplayerCallbackBenchmark::benchmark_gl_pixel_storei);
+
+    snapshotter_ptr = ReplayerSnapshotter::create(nullptr); /* in_replayer_ptr */
+
+    if (snapshotter_ptr == nullptr)
+    {
+        printf("Could not create the snapshotter.\n");
+
+        return EXIT_FAILURE;
+    }
+
+    benchmark.build_frame();
+
+    printf("%u GL calls per frame, %u timed frames per configuration\n\n",
+           static_cast<uint32_t>(benchmark.m_call_vec.size() ),
+           in_n_timed_frames);
+
+    {
+        ReplayerCallbackBenchmarkBaseline baseline;
+
+        baseline_n_calls_per_second = benchmark.run_configuration("Baseline: pre-table callback",
+                                                                  in_n_timed_frames,
+                                                                  &ReplayerCallbackBenchmarkBaseline::on_api_func_callback,
+                                                                  &baseline);
+    }
+
+    benchmark.run_configuration("Idle (state tracking only)",
+                                in_n_timed_frames,
+                                &ReplayerSnapshotter::on_api_func_callback,
+                                snapshotter_ptr.get() );
+
+    snapshotter_ptr->set_flight_recorder_config(1,                   /* in_n_max_frames */
+                                                128 * 1024 * 1024); /* in_max_n_bytes  */
+
+    full_n_calls_per_second = benchmark.run_configuration("Recording, FULL profile",
+                                                          in_n_timed_frames,
+                                                          &ReplayerSnapshotter::on_api_func_callback,
+                                                          snapshotter_ptr.get() );
+
+    if (!benchmark.run_capture_loop(snapshotter_ptr.get() ) )
+    {
+        result = EXIT_FAILURE;
+    }
+
+    snapshotter_ptr->set_capture_profile(CaptureProfile::STATE_ONLY);
+
+    benchmark.run_configuration("Recording, STATE_ONLY profile",
+                                in_n_timed_frames,
+                                &ReplayerSnapshotter::on_api_func_callback,
+                                snapshotter_ptr.get() );
+
+    printf("\nRecording, FULL profile vs baseline: %.2f M calls/s vs %.2f M calls/s (%.2fx)\n",
+           full_n_calls_per_second     / 1e6,
+           baseline_n_calls_per_second / 1e6,
+           full_n_calls_per_second     / baseline_n_calls_per_second);
+
+    return result;
+}
+
+bool ReplayerCallbackBenchmark::run_capture_loop(ReplayerSnapshotter* in_snapshotter_ptr) const
+{
+    uint32_t n_heap_allocations_after_warmup = 0;
+
+    for (uint32_t n_capture = 0;
+                  n_capture < N_WARMUP_FRAMES + N_CAPTURES;
+                ++n_capture)
+    {
+        ReplayerCapturedSnapshotUniquePtr captured_snapshot_ptr;
+
+        if (n_capture == N_WARMUP_FRAMES)
+        {
+            n_heap_allocations_after_warmup = ReplayerSnapshot::get_n_total_heap_allocations();
+        }
+
+        in_snapshotter_ptr->cache_snapshot();
+
+        dispatch_frame(&ReplayerSnapshotter::on_api_func_callback,
+                       in_snapshotter_ptr);
+
+        captured_snapshot_ptr = in_snapshotter_ptr->pop_snapshot();
+
+        if (captured_snapshot_ptr == nullptr)
+        {
+            printf("Capture %u was not handed over.\n",
+                   n_capture);
+
+            return false;
+        }
+
+        in_snapshotter_ptr->recycle_snapshot(std::move(captured_snapshot_ptr->snapshot_ptr) );
+    }
+
+    {
+        const uint32_t n_new_heap_allocations = ReplayerSnapshot::get_n_total_heap_allocations() - n_heap_allocations_after_warmup;
+
+        printf("%-32s %u snapshot heap allocations over %u captures%s\n",
+               "Capture loop, FULL profile",
+               n_new_heap_allocations,
+               N_CAPTURES,
+               (n_new_heap_allocations != 0) ? " (FAILED: expected none after warm-up)" : "");
+
+        return (n_new_heap_allocations == 0);
+    }
+}
+
+double ReplayerCallbackBenchmark::run_configuration(const char*     in_name_ptr,
+                                                    const uint32_t& in_n_timed_frames,
+                                                    CallbackFunc    in_callback_func_ptr,
+                                                    void*           in_user_arg_ptr) const
+{
+    LARGE_INTEGER end_qpc       = {};
+    LARGE_INTEGER qpc_frequency = {};
+    double        result        = 0.0;
+    LARGE_INTEGER start_qpc     = {};
+
+    /* Configuration changes take effect at frame boundaries. Let the recording buffers grow to their final size, too. */
+    for (uint32_t n_frame = 0;
+                  n_frame < N_WARMUP_FRAMES;
+                ++n_frame)
+    {
+        dispatch_frame(in_callback_func_ptr,
+                       in_user_arg_ptr);
+    }
+
+    ::QueryPerformanceCounter(&start_qpc);
+    {
+        for (uint32_t n_frame = 0;
+                      n_frame < in_n_timed_frames;
+                    ++n_frame)
+        {
+            dispatch_frame(in_callback_func_ptr,
+                       in_user_arg_ptr);
+        }
+    }
+    ::QueryPerformanceCounter  (&end_qpc);
+    ::QueryPerformanceFrequency(&qpc_frequency);
+
+    {
+        const double n_calls      = static_cast<double>(m_call_vec.size() + 1) * static_cast<double>(in_n_timed_frames); // SwapBuffers() included
+        const double time_seconds = static_cast<double>(end_qpc.QuadPart - start_qpc.QuadPart) / static_cast<double>(qpc_frequency.QuadPart);
+
+        printf("%-32s %8.2f M calls/s, %6.1f ns/call, %7.3f ms/frame\n",
+               in_name_ptr,
+               n_calls / time_seconds / 1e6,
+               time_seconds * 1e9 / n_calls,
+               time_seconds * 1e3 / static_cast<double>(in_n_timed_frames) );
+
+        result = n_calls / time_seconds;
+    }
+
+    return result;
+}
+
+
+int main(int   argc,
+         char* argv[])
+{
+    const uint32_t n_timed_frames = (argc > 1) ? static_cast<uint32_t>(atoi(argv[1]) )
+                                               : 200;
+
+    return ReplayerCallbackBenchmark::run( (n_timed_frames > 0) ? n_timed_frames : 1);
+}
@@ -0,0 +1,659 @@
+/* API Interceptor (c) 2024 Dominik Witczak
+ *
+ * This code is licensed under MIT license (see LICENSE.txt for details)
+ */
+
+/* Saves a synthetic, GLQuake-sized snapshot with ReplayerSnapshotFile, maps the file back, and checks that it holds
+ * what has been saved:
+ *
+ * - the command stream: opcodes, arguments, vertex batches and CPU ticks of each command.
+ * - the blobs texture upload commands refer to.
+ * - mip records, and the data of each mip.
+ *
+ * This is done with and without compression. For both, the time it takes to save the file, open it, access the command
+ * stream for the first time and access all mip data is reported. The benchmark fails if anything read back does not
+ * match.
+ *
+ * Usage: ReplayerSnapshotFileBenchmark [file to save the snapshot to, removed afterwards]
+ */
+#include "OpenGL/globals.h"
+#include "replayer_snapshot_file.h"
+#include "replayer_texture_store.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+
+class ReplayerSnapshotFileBenchmark
+{
+public:
+    /* Public funcs */
+    static int run(const std::string& in_filename);
+
+private:
+    /* Private consts */
+    static const uint32_t FIRST_LIGHTMAP_GL_ID     = 1000;
+    static const uint32_t LIGHTMAP_PAGE_SIZE       = 128;
+    static const uint32_t N_LIGHTMAP_PAGES         = 16;
+    static const uint32_t N_LIGHTMAP_UPDATES       = 32;
+    static const uint32_t N_SURFACES_PER_TEXTURE   = 16;
+    static const uint32_t N_SURFACE_VERTICES       = 5;
+    static const uint32_t N_TEXTURES               = 48;
+    static const uint32_t N_TEXTURES_PER_SHARED    = 8;    // every n-th texture reuses the first one's data, so that blobs get shared
+    static const uint32_t N_WORLD_SURFACES         = 4000;
+    static const uint32_t TEXTURE_SIZE             = 64;
+    static const uint32_t UNDEFINED_TEXTURE_GL_ID  = 2000; // generated, but never given any mips
+
+    /* Private funcs */
+    ReplayerSnapshotFileBenchmark();
+
+    void     build_snapshot                ();
+    bool     compare_command_stream        (const ReplayerSnapshotFile*                                in_file_ptr) const;
+    bool     compare_start_gl_context_state(const ReplayerSnapshotFile*                                in_file_ptr) const;
+    bool     compare_texture_props         (const ReplayerSnapshotFile*                                in_file_ptr) const;
+    uint32_t get_random_u32                ();
+    void     record_api_call               (const APIInterceptor::APIFunction&                         in_api_func,
+                                            std::initializer_list<APIInterceptor::APIFunctionArgument> in_args);
+    bool     run_configuration             (const std::string&                                         in_filename,
+                                            const bool&                                                in_should_compress) const;
+
+    /* Private vars */
+    GLIDToTexturePropsMap     m_gl_id_to_texture_props_map;
+    uint32_t                  m_random_state;
+    ReplayerSnapshotUniquePtr m_snapshot_ptr;
+    GLContextStateUniquePtr   m_start_gl_context_state_ptr;
+};
+
+
+ReplayerSnapshotFileBenchmark::ReplayerSnapshotFileBenchmark()
+    :m_random_state(0x1234567u)
+{
+    /* Stub */
+}
+
+void ReplayerSnapshotFileBenchmark::build_snapshot()
+{
+    m_snapshot_ptr               = ReplayerSnapshot::create();
+    m_start_gl_context_state_ptr = GLContextStateUniquePtr(new GLContextState(640, 480) );
+
+    m_snapshot_ptr->set_cpu_timing_enabled     (true);
+    m_snapshot_ptr->set_vertex_batching_enabled(true);
+
+    m_start_gl_context_state_ptr->bound_2d_texture_gl_id = FIRST_LIGHTMAP_GL_ID;
+    m_start_gl_context_state_ptr->clear_color[0]         = 0.25f;
+    m_start_gl_context_state_ptr->clear_color[1]         = 0.5f;
+    m_start_gl_context_state_ptr->clear_color[2]         = 0.75f;
+    m_start_gl_context_state_ptr->clear_color[3]         = 1.0f;
+
+    /* Diffuse textures come with a full mip chain. A few of them share their data with the first one, the same way mips
+     * with identical contents do in the snapshotter. */
+    for (uint32_t n_texture = 0;
+                  n_texture < N_TEXTURES;
+                ++n_texture)
+    {
+        const uint32_t gl_id             = 1 + n_texture;
+        auto           texture_props_ptr = m_gl_id_to_texture_props_map.get_for_write(gl_id);
+
+        texture_props_ptr->type = TextureType::_2D;
+
+        for (uint32_t mip_size = TEXTURE_SIZE;
+                      mip_size > 0;
+                      mip_size /= 2)
+        {
+            U8VecSharedPtr data_u8_vec_ptr;
+
+            if (n_texture                         >  0 &&
+                n_texture % N_TEXTURES_PER_SHARED == 0)
+            {
+                data_u8_vec_ptr = m_gl_id_to_texture_props_map.find(1)->mip_props_vec.at(texture_props_ptr->mip_props_vec.size() ).data_u8_vec_ptr;
+            }
+            else
+            {
+                auto new_data_u8_vec_ptr = std::make_shared<std::vector<uint8_t> >(mip_size * mip_size * 4);
+
+                for (uint32_t n_byte = 0;
+                              n_byte < static_cast<uint32_t>(new_data_u8_vec_ptr->size() );
+                            ++n_byte)
+                {
+                    (*new_data_u8_vec_ptr)[n_byte] = static_cast<uint8_t>( (n_byte / 64) % 8 * 24 + get_random_u32() % 8);
+                }
+
+                data_u8_vec_ptr = new_data_u8_vec_ptr;
+            }
+
+            texture_props_ptr->mip_props_vec.push_back(MipProps(std::array<uint32_t, 3>{mip_size, mip_size, 1},
+                                                                GL_RGBA,
+                                                                GL_RGBA,
+                                                                GL_UNSIGNED_BYTE,
+                                                                data_u8_vec_ptr) );
+
+            texture_props_ptr->mip_props_vec.back().data_hash = ReplayerTextureStore::hash(data_u8_vec_ptr->data(),
+                                                                                           static_cast<uint32_t>(data_u8_vec_ptr->size() ) );
+        }
+    }
+
+    m_gl_id_to_texture_props_map.get_for_write(static_cast<uint32_t>(UNDEFINED_TEXTURE_GL_ID) )->type = TextureType::_2D;
+
+    for (uint32_t n_lightmap_page = 0;
+                  n_lightmap_page < N_LIGHTMAP_PAGES;
+                ++n_lightmap_page)
+    {
+        auto texture_props_ptr = m_gl_id_to_texture_props_map.get_for_write(FIRST_LIGHTMAP_GL_ID + n_lightmap_page);
+        auto data_u8_vec_ptr   = std::make_shared<std::vector<uint8_t> >(LIGHTMAP_PAGE_SIZE * LIGHTMAP_PAGE_SIZE * 4,
+                                                                         static_cast<uint8_t>(get_random_u32() % 256) );
+
+        texture_props_ptr->type = TextureType::_2D;
+
+        texture_props_ptr->mip_props_vec.push_back(MipProps(std::array<uint32_t, 3>{LIGHTMAP_PAGE_SIZE, LIGHTMAP_PAGE_SIZE, 1},
+                                                            GL_RGBA,
+                                                            GL_RGBA,
+                                                            GL_UNSIGNED_BYTE,
+                                                            data_u8_vec_ptr) );
+
+        texture_props_ptr->mip_props_vec.back().data_hash = ReplayerTextureStore::hash(data_u8_vec_ptr->data(),
+                                                                                       static_cast<uint32_t>(data_u8_vec_ptr->size() ) );
+    }
+
+    /* Frame set-up */
+    record_api_call(APIInterceptor::APIFUNCTION_GL_GLVIEWPORT,
+                    {APIInterceptor::APIFunctionArgument::create_i32(0),
+                     APIInterceptor::APIFunctionArgument::create_i32(0),
+                     APIInterceptor::APIFunctionArgument::create_i32(640),
+                     APIInterceptor::APIFunctionArgument::create_i32(480)});
+    record_api_call(APIInterceptor::APIFUNCTION_GL_GLCLEAR,
+                    {APIInterceptor::APIFunctionArgument::create_u32(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT)});
+    record_api_call(APIInterceptor::APIFUNCTION_GL_GLENABLE,
+                    {APIInterceptor::APIFunctionArgument::create_u32(GL_DEPTH_TEST)});
+
+    /* The first texture gets redefined. Its upload shares the blob with the mip record. */
+    {
+        const auto& mip_props        = m_gl_id_to_texture_props_map.find(1)->mip_props_vec.at(0);
+        auto        pending_data_ptr = std::make_shared<PendingMipData>();
+
+        pending_data_ptr->data_hash       = mip_props.data_hash;
+        pending_data_ptr->data_u8_vec_ptr = mip_props.data_u8_vec_ptr;
+        pending_data_ptr->is_ready        = true;
+
+        record_api_call(APIInterceptor::APIFUNCTION_GL_GLBINDTEXTURE,
+                        {APIInterceptor::APIFunctionArgument::create_u32(GL_TEXTURE_2D),
+                         APIInterceptor::APIFunctionArgument::create_u32(1)});
+
+        {
+            const APIInterceptor::APIFunctionArgument arg_vec[] =
+            {
+                APIInterceptor::APIFunctionArgument::create_u32     (GL_TEXTURE_2D),
+                APIInterceptor::APIFunctionArgument::create_i32     (0),
+                APIInterceptor::APIFunctionArgument::create_i32     (GL_RGBA),
+                APIInterceptor::APIFunctionArgument::create_i32     (static_cast<int32_t>(TEXTURE_SIZE) ),
+                APIInterceptor::APIFunctionArgument::create_i32     (static_cast<int32_t>(TEXTURE_SIZE) ),
+                APIInterceptor::APIFunctionArgument::create_i32     (0),
+                APIInterceptor::APIFunctionArgument::create_u32     (GL_RGBA),
+                APIInterceptor::APIFunctionArgument::create_u32     (GL_UNSIGNED_BYTE),
+                APIInterceptor::APIFunctionArgument::create_void_ptr(nullptr)
+            };
+
+            m_snapshot_ptr->record_texture_upload(APIInterceptor::APIFUNCTION_GL_GLTEXIMAGE2D,
+                                                  sizeof(arg_vec) / sizeof(arg_vec[0]),
+                                                  arg_vec,
+                                                  pending_data_ptr,
+                                                  static_cast<uint32_t>(TEXTURE_SIZE) );
+        }
+    }
+
+    /* Dynamic lights update small rectangles of lightmap pages. Each update produces a new copy of the whole page. */
+    for (uint32_t n_update = 0;
+                  n_update < N_LIGHTMAP_UPDATES;
+                ++n_update)
+    {
+        const uint32_t gl_id            = FIRST_LIGHTMAP_GL_ID + get_random_u32() % N_LIGHTMAP_PAGES;
+        auto&          mip_props        = m_gl_id_to_texture_props_map.get_for_write(gl_id)->mip_props_vec.at(0);
+        auto           data_u8_vec_ptr  = std::make_shared<std::vector<uint8_t> >(*mip_props.data_u8_vec_ptr);
+        auto           pending_data_ptr = std::make_shared<PendingMipData>();
+        const uint32_t rect_x1          = get_random_u32() % (LIGHTMAP_PAGE_SIZE - 16);
+        const uint32_t rect_y1          = get_random_u32() % (LIGHTMAP_PAGE_SIZE - 16);
+
+        for (uint32_t n_row = rect_y1;
+                      n_row < rect_y1 + 16;
+                    ++n_row)
+        {
+            memset(data_u8_vec_ptr->data() + (n_row * LIGHTMAP_PAGE_SIZE + rect_x1) * 4,
+                   static_cast<int>(get_random_u32() % 256),
+                   16 * 4);
+        }
+
+        mip_props.data_u8_vec_ptr = data_u8_vec_ptr;
+        mip_props.data_hash       = ReplayerTextureStore::hash(data_u8_vec_ptr->data(),
+                                                               static_cast<uint32_t>(data_u8_vec_ptr->size() ) );
+
+        pending_data_ptr->data_hash       = mip_props.data_hash;
+        pending_data_ptr->data_u8_vec_ptr = data_u8_vec_ptr;
+        pending_data_ptr->is_ready        = true;
+
+        record_api_call(APIInterceptor::APIFUNCTION_GL_GLBINDTEXTURE,
+                        {APIInterceptor::APIFunctionArgument::create_u32(GL_TEXTURE_2D),
+                         APIInterceptor::APIFunctionArgument::create_u32(gl_id)});
+
+        {
+            const APIInterceptor::APIFunctionArgument arg_vec[] =
+            {
+                APIInterceptor::APIFunctionArgument::create_u32     (GL_TEXTURE_2D),
+                APIInterceptor::APIFunctionArgument::create_i32     (0),
+                APIInterceptor::APIFunctionArgument::create_i32     (rect_x1),
+                APIInterceptor::APIFunctionArgument::create_i32     (rect_y1),
+                APIInterceptor::APIFunctionArgument::create_i32     (16),
+                APIInterceptor::APIFunctionArgument::create_i32     (16),
+                APIInterceptor::APIFunctionArgument::create_u32     (GL_RGBA),
+                APIInterceptor::APIFunctionArgument::create_u32     (GL_UNSIGNED_BYTE),
+                APIInterceptor::APIFunctionArgument::create_void_ptr(nullptr)
+            };
+
+            m_snapshot_ptr->record_texture_upload(APIInterceptor::APIFUNCTION_GL_GLTEXSUBIMAGE2D,
+                                                  sizeof(arg_vec) / sizeof(arg_vec[0]),
+                                                  arg_vec,
+                                                  pending_data_ptr,
+                                                  static_cast<uint32_t>(LIGHTMAP_PAGE_SIZE) );
+        }
+    }
+
+    /* World surfaces, which get folded into vertex batches */
+    for (uint32_t n_surface = 0;
+                  n_surface < N_WORLD_SURFACES;
+                ++n_surface)
+    {
+        if (n_surface % N_SURFACES_PER_TEXTURE == 0)
+        {
+            record_api_call(APIInterceptor::APIFUNCTION_GL_GLBINDTEXTURE,
+                            {APIInterceptor::APIFunctionArgument::create_u32(GL_TEXTURE_2D),
+                             APIInterceptor::APIFunctionArgument::create_u32(1 + (n_surface / N_SURFACES_PER_TEXTURE) % N_TEXTURES)});
+        }
+
+        record_api_call(APIInterceptor::APIFUNCTION_GL_GLBEGIN,
+                        {APIInterceptor::APIFunctionArgument::create_u32(GL_POLYGON)});
+
+        for (uint32_t n_vertex = 0;
+                      n_vertex < N_SURFACE_VERTICES;
+                    ++n_vertex)
+        {
+            const float x = static_cast<float>(get_random_u32() % 4096) / 8.0f;
+            const float y = static_cast<float>(get_random_u32() % 4096) / 8.0f;
+            const float z = static_cast<float>(get_random_u32() % 512)  / 8.0f;
+
+            record_api_call(APIInterceptor::APIFUNCTION_GL_GLTEXCOORD2F,
+                            {APIInterceptor::APIFunctionArgument::create_fp32(x / 64.0f),
+                             APIInterceptor::APIFunctionArgument::create_fp32(y / 64.0f)});
+            record_api_call(APIInterceptor::APIFUNCTION_GL_GLVERTEX3F,
+                            {APIInterceptor::APIFunctionArgument::create_fp32(x),
+                             APIInterceptor::APIFunctionArgument::create_fp32(y),
+                             APIInterceptor::APIFunctionArgument::create_fp32(z)});
+        }
+
+        record_api_call(APIInterceptor::APIFUNCTION_GL_GLEND,
+                        {});
+    }
+
+    m_snapshot_ptr->finish_cpu_timing(3.0e9, /* in_n_cpu_ticks_per_second     */
+                                      0);    /* in_n_timestamp_overhead_ticks */
+}
+
+bool ReplayerSnapshotFileBenchmark::compare_command_stream(const ReplayerSnapshotFile* in_file_ptr) const
+{
+    const uint32_t n_api_commands = m_snapshot_ptr->get_n_api_commands();
+
+    if (in_file_ptr->get_n_api_commands() != n_api_commands)
+    {
+        printf("    Number of commands differs: %u vs %u\n",
+               in_file_ptr->get_n_api_commands(),
+               n_api_commands);
+
+        return false;
+    }
+
+    if (!in_file_ptr->has_cpu_ticks() )
+    {
+        printf("    CPU ticks are missing\n");
+
+        return false;
+    }
+
+    for (uint32_t n_api_command = 0;
+                  n_api_command < n_api_commands;
+                ++n_api_command)
+    {
+        const auto  loaded_command = in_file_ptr->get_api_command_ptr   (n_api_command);
+        const auto  saved_command  = m_snapshot_ptr->get_api_command_ptr(n_api_command);
+        const char* error_ptr      = nullptr;
+
+        if (loaded_command.api_func != saved_command.api_func)
+        {
+            error_ptr = "opcode";
+        }
+        else
+        if (loaded_command.api_arg_vec.size() != saved_command.api_arg_vec.size()                                  ||
+            memcmp(loaded_command.api_arg_vec.data(),
+                   saved_command.api_arg_vec.data (),
+                   saved_command.api_arg_vec.size() * sizeof(APIInterceptor::APIFunctionArgument) ) != 0)
+        {
+            error_ptr = "arguments";
+        }
+        else
+        if (in_file_ptr->get_cpu_ticks(n_api_command) != m_snapshot_ptr->get_cpu_ticks(n_api_command) )
+        {
+            error_ptr = "CPU ticks";
+        }
+        else
+        if (loaded_command.vertex_batch.is_valid() != saved_command.vertex_batch.is_valid() ||
+            loaded_command.vertex_batch.size    () != saved_command.vertex_batch.size    () )
+        {
+            error_ptr = "vertex batch";
+        }
+        else
+        {
+            for (uint32_t n_vertex = 0;
+                          n_vertex < saved_command.vertex_batch.size() && error_ptr == nullptr;
+                        ++n_vertex)
+            {
+                if (memcmp(&loaded_command.vertex_batch.at(n_vertex),
+                           &saved_command.vertex_batch.at (n_vertex),
+                           sizeof(ReplayerVertexBatchVertex) ) != 0)
+                {
+                    error_ptr = "vertex batch";
+                }
+            }
+        }
+
+        if (error_ptr == nullptr)
+        {
+            uint32_t       n_loaded_data_bytes = 0;
+            const auto     loaded_data_ptr     = in_file_ptr->get_texture_upload_data(n_api_command,
+                                                                                     &n_loaded_data_bytes);
+            U8VecSharedPtr saved_data_u8_vec_ptr;
+
+            if (saved_command.texture_upload_data_ptr != nullptr)
+            {
+                saved_data_u8_vec_ptr = saved_command.texture_upload_data_ptr->get_data_u8_vec_ptr();
+            }
+
+            if ( (loaded_data_ptr != nullptr) != (saved_data_u8_vec_ptr != nullptr) )
+            {
+                error_ptr = "texture upload blob";
+            }
+            else
+            if (saved_data_u8_vec_ptr != nullptr)
+            {
+                if (n_loaded_data_bytes                         != saved_data_u8_vec_ptr->size()                      ||
+                    loaded_command.texture_upload_n_row_pixels != saved_command.texture_upload_n_row_pixels          ||
+                    memcmp(loaded_data_ptr,
+                           saved_data_u8_vec_ptr->data(),
+                           n_loaded_data_bytes) != 0)
+                {
+                    error_ptr = "texture upload blob";
+                }
+            }
+        }
+
+        if (error_ptr != nullptr)
+        {
+            printf("    Command %u: %s differs\n",
+                   n_api_command,
+                   error_ptr);
+
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool ReplayerSnapshotFileBenchmark::compare_start_gl_context_state(const ReplayerSnapshotFile* in_file_ptr) const
+{
+    GLContextState loaded_state(640, 480);
+
+    if (!in_file_ptr->get_start_gl_context_state(&loaded_state)                                                                  ||
+        loaded_state.bound_2d_texture_gl_id != m_start_gl_context_state_ptr->bound_2d_texture_gl_id                             ||
+        memcmp(loaded_state.clear_color,
+               m_start_gl_context_state_ptr->clear_color,
+               sizeof(loaded_state.clear_color) )                                                                        != 0)
+    {
+        printf("    Start context state differs\n");
+
+        return false;
+    }
+
+    return true;
+}
+
+bool ReplayerSnapshotFileBenchmark::compare_texture_props(const ReplayerSnapshotFile* in_file_ptr) const
+{
+    GLIDToTexturePropsMap loaded_map;
+    bool                  result = true;
+
+    if (!in_file_ptr->get_gl_id_to_texture_props_map(&loaded_map)   ||
+        loaded_map.size() != m_gl_id_to_texture_props_map.size() )
+    {
+        printf("    Number of textures differs\n");
+
+        return false;
+    }
+
+    m_gl_id_to_texture_props_map.for_each(
+        [&](const uint32_t&     in_gl_id,
+            const TextureProps& in_texture_props)
+    {
+        const auto loaded_texture_props_ptr = loaded_map.find(in_gl_id);
+
+        if (!result)
+        {
+            return;
+        }
+
+        if (loaded_texture_props_ptr                        == nullptr                               ||
+            loaded_texture_props_ptr->border                != in_texture_props.border               ||
+            loaded_texture_props_ptr->type                  != in_texture_props.type                 ||
+            loaded_texture_props_ptr->mip_props_vec.size() != in_texture_props.mip_props_vec.size() )
+        {
+            printf("    Texture %u: props differ\n",
+                   in_gl_id);
+
+            result = false;
+            return;
+        }
+
+        for (uint32_t n_mip = 0;
+                      n_mip < static_cast<uint32_t>(in_texture_props.mip_props_vec.size() ) && result;
+                    ++n_mip)
+        {
+            const auto& loaded_mip_props      = loaded_texture_props_ptr->mip_props_vec.at(n_mip);
+            uint32_t    n_loaded_data_bytes   = 0;
+            const auto  loaded_data_ptr       = in_file_ptr->get_mip_data(in_gl_id,
+                                                                          n_mip,
+                                                                         &n_loaded_data_bytes);
+            const auto& saved_mip_props       = in_texture_props.mip_props_vec.at(n_mip);
+            const auto  saved_data_u8_vec_ptr = saved_mip_props.get_data_u8_vec_ptr();
+
+            if (loaded_mip_props.data_hash        != saved_mip_props.get_data_hash()  ||
+                loaded_mip_props.format           != saved_mip_props.format           ||
+                loaded_mip_props.internal_format  != saved_mip_props.internal_format  ||
+                loaded_mip_props.mip_size_u32vec3 != saved_mip_props.mip_size_u32vec3 ||
+                loaded_mip_props.type             != saved_mip_props.type)
+            {
+                printf("    Texture %u, mip %u: mip record differs\n",
+                       in_gl_id,
+                       n_mip);
+
+                result = false;
+            }
+            else
+            if ( (loaded_data_ptr != nullptr) != (saved_data_u8_vec_ptr != nullptr) ||
+                 (saved_data_u8_vec_ptr != nullptr                                      &&
+                  (n_loaded_data_bytes != saved_data_u8_vec_ptr->size()             ||
+                   memcmp(loaded_data_ptr,
+                          saved_data_u8_vec_ptr->data(),
+                          n_loaded_data_bytes) != 0) ) )
+            {
+                printf("    Texture %u, mip %u: mip data differs\n",
+                       in_gl_id,
+                       n_mip);
+
+                result = false;
+            }
+        }
+    });
+
+    return result;
+}
+
+uint32_t ReplayerSnapshotFileBenchmark::get_random_u32()
+{
+    /* xorshift32. Deterministic, so that results can be compared between runs. */
+    m_random_state ^= m_random_state << 13;
+    m_random_state ^= m_random_state >> 17;
+    m_random_state ^= m_random_state << 5;
+
+    return m_random_state;
+}
+
+void ReplayerSnapshotFileBenchmark::record_api_call(const APIInterceptor::APIFunction&                         in_api_func,
+                                                    std::initializer_list<APIInterceptor::APIFunctionArgument> in_args)
+{
+    const std::vector<APIInterceptor::APIFunctionArgument> arg_vec(in_args);
+
+    m_snapshot_ptr->add_cpu_ticks  (1000 + get_random_u32() % 1000);
+    m_snapshot_ptr->record_api_call(in_api_func,
+                                    static_cast<uint32_t>(arg_vec.size() ),
+                                    arg_vec.data() );
+}
+
+int ReplayerSnapshotFileBenchmark::run(const std::string& in_filename)
+{
+    ReplayerSnapshotFileBenchmark benchmark;
+    bool                          result = true;
+
+    benchmark.build_snapshot();
+
+    printf("%u commands, %u vertices, %u textures\n\n",
+           benchmark.m_snapshot_ptr->get_n_api_commands(),
+           benchmark.m_snapshot_ptr->get_n_vertices    (),
+           benchmark.m_gl_id_to_texture_props_map.size () );
+
+    result &= benchmark.run_configuration(in_filename,
+                                          false); /* in_should_compress */
+    result &= benchmark.run_configuration(in_filename,
+                                          true);  /* in_should_compress */
+
+    return (result) ? EXIT_SUCCESS
+                    : EXIT_FAILURE;
+}
+
+bool ReplayerSnapshotFileBenchmark::run_configuration(const std::string& in_filename,
+                                                      const bool&        in_should_compress) const
+{
+    LARGE_INTEGER                 command_stream_end_qpc = {};
+    ReplayerSnapshotFileUniquePtr file_ptr;
+    LARGE_INTEGER                 mip_data_end_qpc       = {};
+    const char*                   name_ptr               = (in_should_compress) ? "Compressed"
+                                                                                : "Uncompressed";
+    LARGE_INTEGER                 open_end_qpc           = {};
+    LARGE_INTEGER                 qpc_frequency          = {};
+    bool                          result                 = true;
+    LARGE_INTEGER                 save_end_qpc           = {};
+    LARGE_INTEGER                 save_start_qpc         = {};
+    ReplayerSnapshotFileSaveStats save_stats;
+
+    ::QueryPerformanceCounter(&save_start_qpc);
+    {
+        if (!ReplayerSnapshotFile::save(in_filename,
+                                        m_start_gl_context_state_ptr.get(),
+                                        m_snapshot_ptr.get              (),
+                                       &m_gl_id_to_texture_props_map,
+                                        in_should_compress,
+                                       &save_stats) )
+        {
+            printf("%-14s could not save to %s\n",
+                   name_ptr,
+                   in_filename.c_str() );
+
+            return false;
+        }
+    }
+    ::QueryPerformanceCounter(&save_end_qpc);
+
+    file_ptr = ReplayerSnapshotFile::create(in_filename);
+
+    ::QueryPerformanceCounter(&open_end_qpc);
+
+    if (file_ptr == nullptr)
+    {
+        printf("%-14s could not open %s\n",
+               name_ptr,
+               in_filename.c_str() );
+
+        remove(in_filename.c_str() );
+
+        return false;
+    }
+
+    /* First access verifies, and possibly decodes, the whole command stream. */
+    file_ptr->get_n_api_commands();
+
+    ::QueryPerformanceCounter(&command_stream_end_qpc);
+    {
+        m_gl_id_to_texture_props_map.for_each(
+            [&](const uint32_t&     in_gl_id,
+                const TextureProps& in_texture_props)
+        {
+            for (uint32_t n_mip = 0;
+                          n_mip < static_cast<uint32_t>(in_texture_props.mip_props_vec.size() );
+                        ++n_mip)
+            {
+                uint32_t n_data_bytes = 0;
+
+                file_ptr->get_mip_data(in_gl_id,
+                                       n_mip,
+                                      &n_data_bytes);
+            }
+        });
+    }
+    ::QueryPerformanceCounter  (&mip_data_end_qpc);
+    ::QueryPerformanceFrequency(&qpc_frequency);
+
+    result &= compare_command_stream        (file_ptr.get() );
+    result &= compare_start_gl_context_state(file_ptr.get() );
+    result &= compare_texture_props         (file_ptr.get() );
+
+    if (!result)
+    {
+        printf("%-14s round trip FAILED\n",
+               name_ptr);
+    }
+    else
+    {
+        const double qpc_ticks_per_ms = static_cast<double>(qpc_frequency.QuadPart) / 1000.0;
+
+        printf("%-14s %6.2f MB -> %6.2f MB, save %7.2f ms, open %6.3f ms, command stream %6.2f ms, mip data %6.2f ms\n",
+               name_ptr,
+               static_cast<double>(save_stats.n_raw_bytes)    / (1024.0 * 1024.0),
+               static_cast<double>(save_stats.n_stored_bytes) / (1024.0 * 1024.0),
+               static_cast<double>(save_end_qpc.QuadPart           - save_start_qpc.QuadPart)         / qpc_ticks_per_ms,
+               static_cast<double>(open_end_qpc.QuadPart           - save_end_qpc.QuadPart)           / qpc_ticks_per_ms,
+               static_cast<double>(command_stream_end_qpc.QuadPart - open_end_qpc.QuadPart)           / qpc_ticks_per_ms,
+               static_cast<double>(mip_data_end_qpc.QuadPart       - command_stream_end_qpc.QuadPart) / qpc_ticks_per_ms);
+    }
+
+    /* The file needs to be unmapped before it can be removed. */
+    file_ptr.reset();
+
+    remove(in_filename.c_str() );
+
+    return result;
+}
+
+
+int main(int   argc,
+         char* argv[])
+{
+    const std::string filename = (argc > 1) ? argv[1]
+                                            : "replayer_snapshot_file_benchmark.q1snap";
+
+    return ReplayerSnapshotFileBenchmark::run(filename);
+}
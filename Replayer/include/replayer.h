@@ -7,10 +7,12 @@
 
 #include "replayer_types.h"
 #include "replayer_apicall_window.h"
+#include "replayer_snapshot_file.h"
 #include "replayer_snapshot_logger.h"
 #include "replayer_snapshot_player.h"
 #include "replayer_snapshotter.h"
 #include "replayer_window.h"
+#include <condition_variable>
 
 /* Global mutexes */
 extern std::mutex g_imgui_mutex;
@@ -25,26 +27,63 @@ public:
     /* Public funcs */
     static ReplayerUniquePtr create();
 
+    static std::array<uint32_t, 2> get_q1_window_extents();
+
     ~Replayer();
 
-    void get_current_snapshot(const GLIDToTexturePropsMap** out_snapshot_gl_id_to_texture_props_map_ptr_ptr,
-                              const ReplayerSnapshot**      out_snapshot_ptr_ptr,
-                              const GLContextState**        out_snapshot_start_gl_context_state_ptr_ptr) const;
+    /* Returns the most recently loaded snapshot, or null if none has been captured yet. Never blocks. The snapshot stays
+     * valid for as long as the caller holds on to it, even if a newer one is loaded in the meantime. */
+    std::shared_ptr<const ReplayerCapturedSnapshot> get_current_snapshot() const;
+
+    bool                        get_burst_capture_stats       (ReplayerCaptureWriterStats*        out_stats_ptr)  const;
+    bool                        get_capture_journal_stats     (ReplayerCaptureJournalStats*       out_stats_ptr)  const;
+    ReplayerCaptureStallStats   get_capture_stall_stats       ()                                                  const;
+    bool                        get_frame_counter_export_stats(ReplayerFrameCounterExporterStats* out_stats_ptr)  const;
+    bool                        get_last_auto_capture_report  (AutoCaptureReport*                 out_report_ptr) const;
+    bool                        get_last_gl_error_report      (GLErrorReport*                     out_report_ptr) const;
+    const ReplayerTextureStore* get_texture_store             ()                                                  const;
+    bool                        has_capture_journal_failed    ()                                                  const;
 
     std::vector<uint8_t>* get_current_snapshot_command_enabled_bool_as_u8_vec_ptr() const;
     const uint32_t&       get_n_current_snapshot                                 () const;
 
-    std::array<uint32_t, 2> get_q1_window_extents () const;
-    void                    on_snapshot_available () const;
-    void                    on_snapshot_requested ();
-    void                    refresh_windows       ();
+    void                    on_auto_capture_toggled    ();
+    void                    on_burst_capture_requested ();
+    void                    on_flight_recorder_toggled ();
+    void                    on_snapshot_requested      ();
+    void                    refresh_windows            ();
+    bool                    save_current_snapshot      (const std::string&             in_filename,
+                                                        ReplayerSnapshotFileSaveStats* out_opt_stats_ptr) const; // see ReplayerSnapshotFile
+    void                    set_capture_journal_enabled(const bool&           in_enabled);
+    void                    set_capture_profile        (const CaptureProfile& in_profile);
+    void                    set_cpu_timing_enabled     (const bool&           in_enabled);
+    void                    set_vertex_batching_enabled(const bool&           in_enabled);
+
+    /* Called from the application's rendering thread when a captured snapshot can be popped from the snapshotter. Only
+     * wakes up the snapshot loader thread, which does the actual work. */
+    void on_snapshot_available() const;
 
 private:
+    /* Private consts */
+    static const uint32_t AUTO_CAPTURE_COOLDOWN_MS                = 10000;
+    static const uint32_t AUTO_CAPTURE_MAX_FRAME_TIME_MS          = 50;
+    static const uint32_t AUTO_CAPTURE_MAX_N_API_CALLS            = 100000;
+    static const uint32_t AUTO_CAPTURE_MAX_N_TEXTURE_UPLOAD_BYTES = 16 * 1024 * 1024;
+    static const char*    CAPTURE_JOURNAL_FILENAME;
+    static const uint32_t CAPTURE_JOURNAL_N_MAX_BYTES             = 64 * 1024 * 1024; // mapped as a whole, and we're a 32-bit process
+    static const uint32_t MAX_N_FLIGHT_RECORDER_BYTES = 128 * 1024 * 1024; // we're a 32-bit process. Frames are held uncompressed, see FlightRecorderFrame
+    static const uint32_t N_BURST_CAPTURE_FRAMES      = 32;
+    static const uint32_t N_FLIGHT_RECORDER_FRAMES    = 8;
+
     /* Private funcs */
     Replayer();
 
-    bool init              ();
-    void reposition_windows();
+    void apply_flight_recorder_config();
+    bool init                        ();
+    void load_snapshot               ();
+    void reposition_windows          ();
+
+    void execute_snapshot_loader();
 
     // Q1 API call interceptors -->
     static void on_q1_wglmakecurrent(APIInterceptor::APIFunction                in_api_func,
@@ -54,11 +93,14 @@ private:
     // <--
 
     /* Private vars */
-    uint32_t                       m_n_snapshot;
-    std::vector<uint8_t>           m_snapshot_command_enabled_bool_as_u8_vec;
-    GLIDToTexturePropsMapUniquePtr m_snapshot_gl_id_to_texture_props_map_ptr;
-    ReplayerSnapshotUniquePtr      m_snapshot_ptr;
-    GLContextStateUniquePtr        m_snapshot_start_gl_context_state_ptr;
+    std::atomic<bool>                               m_is_auto_capture_enabled;    // toggled from the keyboard hook, which runs on the game thread
+    std::atomic<bool>                               m_is_capture_journal_enabled; // set from the UI thread
+    std::atomic<bool>                               m_is_flight_recorder_enabled; // toggled from the keyboard hook, which runs on the game thread
+    std::mutex                                      m_flight_recorder_config_mutex;
+    uint32_t                                        m_n_burst_captures;
+    uint32_t                                        m_n_snapshot;
+    std::vector<uint8_t>                            m_snapshot_command_enabled_bool_as_u8_vec;
+    std::shared_ptr<const ReplayerCapturedSnapshot> m_snapshot_ptr; // only accessed via std::atomic_load() and std::atomic_store()
 
     ReplayerAPICallWindowUniquePtr  m_replayer_apicall_window_ptr;
     ReplayerSnapshotLoggerUniquePtr m_replayer_snapshot_logger_ptr;
@@ -67,6 +109,12 @@ private:
     ReplayerWindowUniquePtr         m_replayer_window_ptr;
 
     HWND m_q1_hwnd;
+
+    mutable std::condition_variable m_snapshot_available_cv;
+    mutable std::mutex              m_snapshot_loader_mutex;
+    mutable bool                    m_is_snapshot_available;
+    std::thread                     m_snapshot_loader_thread;
+    volatile bool                   m_snapshot_loader_thread_must_die;
 };
 
 #endif /* REPLAYER_H */
\ No newline at end of file
@@ -5,6 +5,7 @@
 #if !defined(REPLAYER_APICALL_WINDOW_H)
 #define REPLAYER_APICALL_WINDOW_H
 
+#include "replayer_snapshot.h"
 #include "replayer_types.h"
 
 
@@ -13,7 +14,6 @@ struct                                         GLFWwindow;
 class                                          Replayer;
 class                                          ReplayerAPICallWindow;
 typedef std::unique_ptr<ReplayerAPICallWindow> ReplayerAPICallWindowUniquePtr;
-class                                          ReplayerSnapshot;
 
 class ReplayerAPICallWindow : public IUISettings
 {
@@ -23,7 +23,7 @@ public:
     /* Public funcs */
     ~ReplayerAPICallWindow();
 
-    void load_snapshot             (ReplayerSnapshot* in_snapshot_ptr);
+    void load_snapshot             (const ReplayerSnapshot* in_snapshot_ptr);
     void lock_for_snapshot_access  ();
     void unlock_for_snapshot_access();
 
@@ -75,10 +75,15 @@ private:
     std::array<uint32_t, 2> m_window_extents;
     std::array<uint32_t, 2> m_window_x1y1;
 
+    int   m_capture_profile; // CaptureProfile, as an int for ImGui's sake
     float m_eye_translation;
+    bool  m_is_capture_journal_enabled;
+    bool  m_is_cpu_timing_enabled;
+    bool  m_is_vertex_batching_enabled;
     bool  m_should_disable_lightmaps;
     bool  m_should_draw_screenspace_geometry;
     bool  m_should_draw_weapon;
+    bool  m_should_expand_vertex_batches;
     bool  m_should_hide_draw_calls;
     bool  m_should_shade_3d_models;
 
@@ -86,7 +91,12 @@ private:
     std::map<uint32_t, uint32_t> m_listed_api_command_to_n_api_command_map;
     std::mutex                   m_mutex;
     Replayer*                    m_replayer_ptr;
-    ReplayerSnapshot*            m_snapshot_ptr;
+    const ReplayerSnapshot*      m_snapshot_ptr;
+
+    bool                    m_has_segment_cpu_times;
+    ReplayerSegmentCPUTimes m_segment_cpu_times;
+
+    std::string m_snapshot_save_status_string; // result of the last "Save snapshot" click
 
     GLFWwindow*     m_window_ptr;
     std::thread     m_worker_thread;
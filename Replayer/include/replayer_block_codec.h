@@ -0,0 +1,59 @@
+/* API Interceptor (c) 2024 Dominik Witczak
+ *
+ * This code is licensed under MIT license (see LICENSE.txt for details)
+ */
+#if !defined(REPLAYER_BLOCK_CODEC_H)
+#define REPLAYER_BLOCK_CODEC_H
+
+#include <cstdint>
+
+/* Small LZ77-family codec used to compress snapshot file sections.
+ *
+ * Data is compressed in blocks of up to BLOCK_SIZE bytes, each of which can be decompressed on its own. A compressed
+ * block is a sequence of (token, literals, match) triples, LZ4-style:
+ *
+ * - u8 token:  high nibble holds the number of literals, low nibble holds the match length minus MIN_MATCH_LENGTH.
+ *              15 means the value continues in the following bytes, each of which is added to it. A byte other than
+ *              255 ends the value.
+ * - literals:  copied to the output as-is.
+ * - match:     u16 offset back into the output, followed by the match length's continuation bytes, if any.
+ *
+ * The last triple has no match. Decompression never reads or writes out of bounds, no matter what it is fed with.
+ */
+class ReplayerBlockCodec
+{
+public:
+    /* Public consts */
+    static const uint32_t BLOCK_SIZE = 64 * 1024; // offsets need to fit in 16 bits
+
+    /* Public funcs */
+
+    /* Compresses @param in_n_bytes bytes, which must not exceed BLOCK_SIZE, into @param out_data_ptr, which must be
+     * able to hold get_max_n_compressed_bytes(in_n_bytes) bytes. Returns the number of bytes written. */
+    static uint32_t compress(const void*     in_data_ptr,
+                             const uint32_t& in_n_bytes,
+                             void*           out_data_ptr);
+
+    /* Decompresses a block which should hold exactly @param in_n_decompressed_bytes bytes of data. Returns false if the
+     * block is malformed. */
+    static bool decompress(const void*     in_data_ptr,
+                           const uint32_t& in_n_bytes,
+                           void*           out_data_ptr,
+                           const uint32_t& in_n_decompressed_bytes);
+
+    static uint32_t get_max_n_compressed_bytes(const uint32_t& in_n_bytes)
+    {
+        return in_n_bytes + in_n_bytes / 255 + 16;
+    }
+
+private:
+    /* Private consts */
+    static const uint32_t HASH_TABLE_SIZE_LOG2 = 14;
+    static const uint32_t MAX_MATCH_OFFSET     = 65535;
+    static const uint32_t MIN_MATCH_LENGTH     = 4;
+
+    /* Private funcs */
+    ReplayerBlockCodec();
+};
+
+#endif /* REPLAYER_BLOCK_CODEC_H */
@@ -0,0 +1,158 @@
+/* API Interceptor (c) 2024 Dominik Witczak
+ *
+ * This code is licensed under MIT license (see LICENSE.txt for details)
+ */
+#if !defined(REPLAYER_CAPTURE_JOURNAL_H)
+#define REPLAYER_CAPTURE_JOURNAL_H
+
+#include "replayer_snapshot.h"
+#include <mutex>
+#include <string>
+
+/* Forward decls */
+class                                           ReplayerCaptureJournal;
+typedef std::unique_ptr<ReplayerCaptureJournal> ReplayerCaptureJournalUniquePtr;
+
+/* Describes a frame which has been committed to a journal file. */
+struct ReplayerCaptureJournalFrame
+{
+    uint32_t n_api_commands = 0;
+    uint64_t n_bytes        = 0; // frame record, commit marker included
+    uint32_t n_frame        = 0;
+    uint64_t n_start_byte   = 0; // offset of the frame record within the file
+};
+
+struct ReplayerCaptureJournalStats
+{
+    uint64_t n_bytes_committed  = 0; // total, across all laps
+    uint32_t n_frames_committed = 0;
+    uint32_t n_frames_dropped   = 0; // did not fit in the journal at all
+    uint32_t n_laps             = 0; // times the journal wrapped around
+};
+
+/* Crash-safe journal of recorded frames.
+ *
+ * The journal is a fixed-size file which is mapped into the process. Commands are appended to the mapping as soon as
+ * they are recorded, with no intermediate buffer and no write calls, and each frame is sealed with a commit marker at
+ * SwapBuffers() time. Pages of a file mapping belong to the OS, so whatever has been appended survives the application
+ * crashing: all frames committed before the crash can be found in the file, and are listed by get_committed_frames().
+ * Flushing dirty pages to the disk is left to the OS.
+ *
+ * Once the end of the file is reached, the journal wraps around and overwrites the oldest frames.
+ *
+ * Journal file layout (all values are stored in native byte order):
+ *
+ * - File header:   see Header. Offsets stored in the header are only updated once the bytes they refer to are in place.
+ * - Each frame:    u32 FRAME_MAGIC, u32 frame index, commands, commit marker.
+ * - Commands:      u32 API function, u32 number of args, args, u32 number of batch vertices, vertices. glTexImage2D()
+ *                  and glTexSubImage2D() are followed by u32 number of bytes and the texels they upload.
+ * - Commit marker: u32 COMMIT_MAGIC, u32 frame index, u32 number of commands, u32 reserved, u64 number of bytes taken
+ *                  by the frame, commit marker included. Lets frames be walked backward from the last commit.
+ *
+ * NOTE: Pointer arguments are stored as-is. Texture objects defined before a frame are not journaled.
+ */
+class ReplayerCaptureJournal
+{
+public:
+    /* Public consts */
+    static const uint32_t FILE_MAGIC   = 0x4A433151; // "Q1CJ"
+    static const uint32_t FILE_VERSION = 1;
+    static const uint32_t FRAME_MAGIC  = 0x4D524646; // "FFRM"
+    static const uint32_t COMMIT_MAGIC = 0x54494D43; // "CMIT"
+
+    /* Public funcs */
+    static ReplayerCaptureJournalUniquePtr create(const std::string& in_filename,
+                                                  const uint64_t&    in_n_max_bytes);
+
+    ~ReplayerCaptureJournal();
+
+    /* Starts a new frame record. Any frame which has not been committed is discarded. */
+    void begin_frame(const uint32_t& in_n_frame);
+
+    /* Appends all commands of @param in_snapshot which have been completed since the last call. Texels are read through
+     * the pixels argument of upload commands, so those need to be appended from within the callback which recorded them.
+     *
+     * Does nothing if no frame has been begun. */
+    void consume(const ReplayerSnapshot& in_snapshot);
+
+    /* Appends the remaining commands of @param in_snapshot, which must be complete, and seals the frame. Does nothing if
+     * no frame has been begun. */
+    void commit_frame(const ReplayerSnapshot& in_snapshot);
+
+    ReplayerCaptureJournalStats get_stats() const;
+
+    /* Lists frames committed to journal file @param in_filename, oldest first. May be used on a journal left behind by
+     * a crashed process. Returns false if the file could not be opened, or is not a journal. */
+    static bool get_committed_frames(const std::string&                        in_filename,
+                                     std::vector<ReplayerCaptureJournalFrame>* out_frame_vec_ptr);
+
+private:
+    /* Private type defs */
+
+    /* Stored at the start of the file. */
+    struct Header
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t n_file_bytes;
+        uint64_t n_last_commit_end_byte; // end of the most recent frame, or DATA_START_BYTE if none
+        uint64_t n_lap_end_byte;         // end of the last frame committed before the journal wrapped, or 0
+        uint64_t n_overwritten_end_byte; // bytes of the previous lap before this offset are no longer valid
+    };
+
+    struct CommitMarker
+    {
+        uint32_t magic;
+        uint32_t n_frame;
+        uint32_t n_api_commands;
+        uint32_t reserved;
+        uint64_t n_frame_bytes;
+    };
+
+    /* Private consts */
+    static const uint64_t DATA_START_BYTE             = 64;        // sizeof(Header), rounded up
+    static const uint64_t OVERWRITTEN_END_GRANULARITY = 64 * 1024; // limits how often the header is touched
+
+    /* Private funcs */
+    ReplayerCaptureJournal(const std::string& in_filename,
+                           const uint64_t&    in_n_max_bytes);
+
+    bool init();
+
+    void append(const void*     in_data_ptr,
+                const uint32_t& in_n_bytes);
+
+    template<typename T>
+    void append(const T& in_value)
+    {
+        append(&in_value,
+               sizeof(T) );
+    }
+
+    void append_command(const ReplayerSnapshotCommandView& in_command);
+
+    static void walk_frames(const uint8_t*                            in_file_data_ptr,
+                            const uint64_t&                           in_n_end_byte,
+                            const uint64_t&                           in_n_min_start_byte,
+                            std::vector<ReplayerCaptureJournalFrame>* out_frame_vec_ptr);
+
+    /* Private vars */
+    HANDLE      m_file_handle;
+    HANDLE      m_file_mapping_handle;
+    std::string m_filename;
+    Header*     m_header_ptr;
+    uint8_t*    m_mapped_data_ptr;
+    uint64_t    m_n_max_bytes;
+
+    bool     m_is_frame_dropped; // current frame does not fit in the journal
+    bool     m_is_frame_open;
+    uint32_t m_n_frame;
+    uint32_t m_n_next_command;
+    uint64_t m_n_frame_start_byte;
+    uint64_t m_n_write_byte;
+
+    ReplayerCaptureJournalStats m_stats;
+    mutable std::mutex          m_stats_mutex;
+};
+
+#endif /* REPLAYER_CAPTURE_JOURNAL_H */
@@ -0,0 +1,142 @@
+/* API Interceptor (c) 2024 Dominik Witczak
+ *
+ * This code is licensed under MIT license (see LICENSE.txt for details)
+ */
+#if !defined(REPLAYER_CAPTURE_WRITER_H)
+#define REPLAYER_CAPTURE_WRITER_H
+
+#include "replayer_types.h"
+#include "replayer_snapshot.h"
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <string>
+
+/* Forward decls */
+class                                          ReplayerCaptureWriter;
+typedef std::unique_ptr<ReplayerCaptureWriter> ReplayerCaptureWriterUniquePtr;
+class                                          ReplayerSnapshotter;
+
+/* A single frame handed over to the writer. */
+struct ReplayerCaptureFrame
+{
+    std::shared_ptr<const GLIDToTexturePropsMap> gl_id_to_texture_props_map_ptr;
+    uint32_t                                     n_frame;
+    ReplayerSnapshotUniquePtr                    snapshot_ptr;
+    GLContextStateUniquePtr                      start_gl_context_state_ptr;
+
+    ReplayerCaptureFrame()
+        :n_frame(0)
+    {
+        /* Stub */
+    }
+};
+
+/* Progress of a burst capture, as seen at the time of the query. */
+struct ReplayerCaptureWriterStats
+{
+    uint64_t n_bytes_written     = 0;
+    uint32_t n_frames            = 0; // requested
+    uint32_t n_frames_dropped    = 0; // queue was full when the frame was handed over
+    uint32_t n_frames_queued     = 0;
+    uint32_t n_frames_written    = 0;
+    uint32_t n_max_frames_queued = 0;
+    uint64_t write_time_ns       = 0; // time spent serializing and writing, excluding waits for new frames
+};
+
+/* Streams a burst of consecutive frames to a capture file.
+ *
+ * Frames are handed over to a bounded queue, which is drained by a background thread. Handing a frame over never
+ * blocks on I/O: if the queue is full, the frame is dropped instead, so that the application's frame time stays flat.
+ *
+ * Capture file layout (all values are stored in native byte order):
+ *
+ * - File header:  u32 magic ("Q1CP"), u32 version, u32 number of frames requested.
+ * - Each frame:   u32 frame index, u32 flags, [texture props map], start context state, commands.
+ *
+ * The texture props map is only stored if it differs from the one stored for the previous frame. Each mip data
+ * buffer is stored once per file and referred to by its index afterward.
+ *
+ * - Mip data:     u32 blob index. If equal to the number of blobs stored so far, it is followed by u32 size and
+ *                 u32 base blob index. If the latter is UINT32_MAX, the data follows. Otherwise, the blob is a copy
+ *                 of the base blob with a sub-rectangle modified: u32 x1, y1, x2, y2 (x2, y2 exclusive), followed by
+ *                 the sub-rectangle's texels, tightly packed.
+ * - Commands:     u32 API function, u32 number of args, args, u32 number of batch vertices, vertices. glTexImage2D()
+ *                 is followed by the mip data it uploads. glTexSubImage2D() is followed by the texels of the updated
+ *                 sub-rectangle, tightly packed.
+ */
+class ReplayerCaptureWriter
+{
+public:
+    /* Public consts */
+    static const uint32_t FILE_MAGIC   = 0x50433151; // "Q1CP"
+    static const uint32_t FILE_VERSION = 3;
+
+    static const uint32_t FRAME_FLAG_HAS_TEXTURE_PROPS_MAP = 1 << 0;
+
+    /* Public funcs */
+    static ReplayerCaptureWriterUniquePtr create(const std::string&   in_filename,
+                                                 const uint32_t&      in_n_frames,
+                                                 const uint32_t&      in_max_n_queued_frames,
+                                                 ReplayerSnapshotter* in_snapshotter_ptr);
+
+    ~ReplayerCaptureWriter();
+
+    /* Hands a frame over to the writer thread. Returns false if the queue is full, in which case the frame is dropped
+     * and its snapshot is returned to the snapshotter. */
+    bool enqueue_frame(ReplayerCaptureFrame in_frame);
+
+    ReplayerCaptureWriterStats get_stats() const;
+
+    /* Tells whether all requested frames have been either written or dropped. */
+    bool is_done() const;
+
+private:
+    /* Private funcs */
+    ReplayerCaptureWriter(const std::string&   in_filename,
+                          const uint32_t&      in_n_frames,
+                          const uint32_t&      in_max_n_queued_frames,
+                          ReplayerSnapshotter* in_snapshotter_ptr);
+
+    void execute    ();
+    bool init       ();
+    void write_frame(const ReplayerCaptureFrame& in_frame);
+
+    void serialize_commands         (const ReplayerSnapshot*      in_snapshot_ptr);
+    void serialize_gl_context_state (const GLContextState*        in_gl_context_state_ptr);
+    void serialize_mip_data         (const U8VecSharedPtr&        in_data_u8_vec_ptr,
+                                     const MipProps*              in_opt_mip_props_ptr);
+    void serialize_texture_props_map(const GLIDToTexturePropsMap* in_gl_id_to_texture_props_map_ptr);
+
+    template<typename T>
+    void serialize(const T& in_value)
+    {
+        serialize(&in_value,
+                  sizeof(T) );
+    }
+
+    void serialize(const void*     in_data_ptr,
+                   const uint32_t& in_n_bytes);
+
+    /* Private vars */
+    FILE*                m_file_ptr;
+    std::string          m_filename;
+    std::vector<uint8_t> m_frame_data_u8_vec; // reused between frames
+    ReplayerSnapshotter* m_snapshotter_ptr;
+
+    std::shared_ptr<const GLIDToTexturePropsMap>              m_last_gl_id_to_texture_props_map_ptr;
+    std::vector<U8VecSharedPtr>                               m_mip_data_blob_vec; // keeps stored buffers alive
+    std::unordered_map<const std::vector<uint8_t>*, uint32_t> m_mip_data_ptr_to_n_blob_map;
+    std::unordered_map<uint64_t, uint32_t>                    m_mip_data_version_to_n_blob_map; // see MipProps::data_version
+
+    std::condition_variable           m_frame_queued_cv;
+    std::vector<ReplayerCaptureFrame> m_frame_queue_vec; // ring
+    mutable std::mutex                m_mutex;
+    uint32_t                          m_n_first_queued_frame;
+    ReplayerCaptureWriterStats        m_stats;
+
+    std::thread   m_worker_thread;
+    volatile bool m_worker_thread_must_die;
+};
+
+#endif /* REPLAYER_CAPTURE_WRITER_H */
@@ -0,0 +1,91 @@
+/* API Interceptor (c) 2024 Dominik Witczak
+ *
+ * This code is licensed under MIT license (see LICENSE.txt for details)
+ */
+#if !defined(REPLAYER_FRAME_COUNTER_EXPORTER_H)
+#define REPLAYER_FRAME_COUNTER_EXPORTER_H
+
+#include "replayer_gl_functions.h"
+#include "replayer_types.h"
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <string>
+
+/* Forward decls */
+class                                                 ReplayerFrameCounterExporter;
+typedef std::unique_ptr<ReplayerFrameCounterExporter> ReplayerFrameCounterExporterUniquePtr;
+
+/* Rendering counters gathered for a single frame. */
+struct FrameCounters
+{
+    static const uint32_t N_PRIMITIVE_TYPES = 10; // GL_POINTS .. GL_POLYGON
+
+    uint32_t n_frame;
+    uint32_t frame_time_us;
+    uint32_t n_texture_binds;        // glBindTexture() calls which actually changed the binding
+    uint64_t n_texture_upload_bytes;
+
+    uint32_t n_api_calls_per_func        [GLFunctionInfoTable::N_ENTRIES]; // indexed with (api_func - APIFUNCTION_GL_FIRST)
+    uint32_t n_vertices_per_primitive_type[N_PRIMITIVE_TYPES];             // indexed with glBegin() mode
+};
+
+struct ReplayerFrameCounterExporterStats
+{
+    uint32_t n_frames_dropped  = 0; // ring was full when the frame was handed over
+    uint32_t n_frames_exported = 0;
+};
+
+/* Appends per-frame counters to a CSV file, one row per frame, so that long sessions can be charted.
+ *
+ * The game thread copies each frame's counters into a fixed-size ring, which takes a few hundred bytes and never
+ * blocks. A background thread wakes up every EXPORT_PERIOD_MS, formats whatever has piled up in the meantime and
+ * appends it to the file. If it falls behind by more than the ring's size, new frames are dropped instead.
+ *
+ * NOTE: push() must always be called from the same thread.
+ */
+class ReplayerFrameCounterExporter
+{
+public:
+    /* Public funcs */
+    static ReplayerFrameCounterExporterUniquePtr create(const std::string& in_filename,
+                                                        const uint32_t&    in_n_ring_frames);
+
+    ~ReplayerFrameCounterExporter();
+
+    ReplayerFrameCounterExporterStats get_stats() const;
+
+    /* Hands a frame's counters over to the export thread. Returns false if the ring is full. */
+    bool push(const FrameCounters& in_frame_counters);
+
+private:
+    /* Private consts */
+    static const uint32_t EXPORT_PERIOD_MS = 1000;
+
+    /* Private funcs */
+    ReplayerFrameCounterExporter(const std::string& in_filename,
+                                 const uint32_t&    in_n_ring_frames);
+
+    void execute     ();
+    bool init        ();
+    void write_frame (const FrameCounters& in_frame_counters);
+    void write_header();
+
+    /* Private vars */
+    FILE*                      m_file_ptr;
+    std::string                m_filename;
+    std::string                m_row_string; // reused between rows
+    std::vector<FrameCounters> m_ring_vec;
+
+    std::atomic<uint32_t> m_n_frames_dropped;
+    std::atomic<uint32_t> m_n_frames_exported; // written by the export thread
+    std::atomic<uint32_t> m_n_frames_pushed;   // written by the game thread
+
+    std::condition_variable m_must_die_cv;
+    std::mutex              m_mutex;
+
+    std::thread   m_worker_thread;
+    volatile bool m_worker_thread_must_die;
+};
+
+#endif /* REPLAYER_FRAME_COUNTER_EXPORTER_H */
@@ -0,0 +1,264 @@
+/* API Interceptor (c) 2024 Dominik Witczak
+ *
+ * This code is licensed under MIT license (see LICENSE.txt for details)
+ */
+#if !defined(REPLAYER_GL_FUNCTIONS_H)
+#define REPLAYER_GL_FUNCTIONS_H
+
+#include "APIInterceptor/include/Common/types.h"
+#include <cassert>
+#include <cstdint>
+
+/* Compile-time registry of GL entrypoints used by GLQuake.
+ *
+ * Each entrypoint is described once, in REPLAYER_GL_FUNCTION_LIST below. The list is used to generate:
+ *
+ * 1) GLFunctionTraits<> specializations, which CommandView<> relies on to access arguments with no run-time type
+ *    dispatch or bounds checking.
+ * 2) A constexpr table which can be queried at run-time with get_gl_function_info().
+ */
+enum class GLArgType : uint8_t
+{
+    BITFIELD,
+    ENUM,
+    FP32,
+    FP32_PTR,
+    FP64,
+    I32,
+    PTR,
+    U32,
+    U32_PTR,
+    U8,
+    U8_PTR,
+};
+
+enum class GLFunctionClass : uint8_t
+{
+    DRAW,         // glBegin(), glEnd() and everything that can be called in-between
+    MATRIX,       // matrix stack manipulation
+    OTHER,        // framebuffer ops, synchronization
+    STATE_SETTER, // global context state
+    TEXTURE,      // texture object state and contents
+
+    UNKNOWN
+};
+
+/* Maps GLArgType to the C++ type & APIFunctionArgument getter used to retrieve the value. */
+template<GLArgType ArgType>
+struct GLArgTypeTraits;
+
+template<> struct GLArgTypeTraits<GLArgType::BITFIELD> { typedef uint32_t        value_type; static value_type get(const APIInterceptor::APIFunctionArgument& in_arg) { return in_arg.get_u32     (); } };
+template<> struct GLArgTypeTraits<GLArgType::ENUM>     { typedef uint32_t        value_type; static value_type get(const APIInterceptor::APIFunctionArgument& in_arg) { return in_arg.get_u32     (); } };
+template<> struct GLArgTypeTraits<GLArgType::FP32>     { typedef float           value_type; static value_type get(const APIInterceptor::APIFunctionArgument& in_arg) { return in_arg.get_fp32    (); } };
+template<> struct GLArgTypeTraits<GLArgType::FP32_PTR> { typedef const float*    value_type; static value_type get(const APIInterceptor::APIFunctionArgument& in_arg) { return in_arg.get_fp32_ptr(); } };
+template<> struct GLArgTypeTraits<GLArgType::FP64>     { typedef double          value_type; static value_type get(const APIInterceptor::APIFunctionArgument& in_arg) { return in_arg.get_fp64    (); } };
+template<> struct GLArgTypeTraits<GLArgType::I32>      { typedef int32_t         value_type; static value_type get(const APIInterceptor::APIFunctionArgument& in_arg) { return in_arg.get_i32     (); } };
+template<> struct GLArgTypeTraits<GLArgType::PTR>      { typedef const void*     value_type; static value_type get(const APIInterceptor::APIFunctionArgument& in_arg) { return in_arg.get_ptr     (); } };
+template<> struct GLArgTypeTraits<GLArgType::U32>      { typedef uint32_t        value_type; static value_type get(const APIInterceptor::APIFunctionArgument& in_arg) { return in_arg.get_u32     (); } };
+template<> struct GLArgTypeTraits<GLArgType::U32_PTR>  { typedef const uint32_t* value_type; static value_type get(const APIInterceptor::APIFunctionArgument& in_arg) { return in_arg.get_u32_ptr (); } };
+template<> struct GLArgTypeTraits<GLArgType::U8>       { typedef uint8_t         value_type; static value_type get(const APIInterceptor::APIFunctionArgument& in_arg) { return in_arg.get_u8      (); } };
+template<> struct GLArgTypeTraits<GLArgType::U8_PTR>   { typedef const uint8_t*  value_type; static value_type get(const APIInterceptor::APIFunctionArgument& in_arg) { return reinterpret_cast<const uint8_t*>(in_arg.get_u8_ptr() ); } };
+
+/* Run-time description of a GL entrypoint. */
+struct GLFunctionInfo
+{
+    static const uint32_t MAX_N_ARGS = 9;
+
+    const char*     name;
+    GLFunctionClass function_class;
+    uint32_t        n_args;
+    GLArgType       arg_type_vec[MAX_N_ARGS];
+};
+
+/* Picks N-th type from a GLArgType pack. */
+template<uint32_t N, GLArgType... ArgTypes>
+struct GLArgTypeAt;
+
+template<GLArgType First, GLArgType... Rest>
+struct GLArgTypeAt<0, First, Rest...>
+{
+    static const GLArgType value = First;
+};
+
+template<uint32_t N, GLArgType First, GLArgType... Rest>
+struct GLArgTypeAt<N, First, Rest...>
+{
+    static const GLArgType value = GLArgTypeAt<N - 1, Rest...>::value;
+};
+
+template<GLFunctionClass FunctionClass, GLArgType... ArgTypes>
+struct GLFunctionSignature
+{
+    static const GLFunctionClass function_class = FunctionClass;
+    static const uint32_t        n_args         = sizeof...(ArgTypes);
+
+    template<uint32_t N>
+    struct Arg
+    {
+        static const GLArgType type = GLArgTypeAt<N, ArgTypes...>::value;
+
+        typedef typename GLArgTypeTraits<type>::value_type value_type;
+    };
+
+    static constexpr GLFunctionInfo get_info(const char* in_name)
+    {
+        static_assert(sizeof...(ArgTypes) <= GLFunctionInfo::MAX_N_ARGS, "Too many arguments");
+
+        return GLFunctionInfo{in_name,
+                              FunctionClass,
+                              static_cast<uint32_t>(sizeof...(ArgTypes) ),
+                              {ArgTypes...} };
+    }
+};
+
+/* NOTE: Argument types must match what APIInterceptor stores for each of the entrypoints. */
+#define REPLAYER_GL_FUNCTION_LIST(X)                                                                                                                                                                               \
+    X(GLALPHAFUNC,      GLFunctionClass::STATE_SETTER, GLArgType::ENUM, GLArgType::FP32)                                                                                                                              \
+    X(GLBEGIN,          GLFunctionClass::DRAW,         GLArgType::ENUM)                                                                                                                                               \
+    X(GLBINDTEXTURE,    GLFunctionClass::TEXTURE,      GLArgType::ENUM, GLArgType::U32)                                                                                                                               \
+    X(GLBLENDFUNC,      GLFunctionClass::STATE_SETTER, GLArgType::ENUM, GLArgType::ENUM)                                                                                                                              \
+    X(GLCLEAR,          GLFunctionClass::OTHER,        GLArgType::BITFIELD)                                                                                                                                           \
+    X(GLCLEARCOLOR,     GLFunctionClass::STATE_SETTER, GLArgType::FP32, GLArgType::FP32, GLArgType::FP32, GLArgType::FP32)                                                                                            \
+    X(GLCLEARDEPTH,     GLFunctionClass::STATE_SETTER, GLArgType::FP64)                                                                                                                                               \
+    X(GLCOLOR3F,        GLFunctionClass::DRAW,         GLArgType::FP32, GLArgType::FP32, GLArgType::FP32)                                                                                                             \
+    X(GLCOLOR3UB,       GLFunctionClass::DRAW,         GLArgType::U8,   GLArgType::U8,   GLArgType::U8)                                                                                                               \
+    X(GLCOLOR3UBV,      GLFunctionClass::DRAW,         GLArgType::U8_PTR)                                                                                                                                             \
+    X(GLCOLOR4F,        GLFunctionClass::DRAW,         GLArgType::FP32, GLArgType::FP32, GLArgType::FP32, GLArgType::FP32)                                                                                            \
+    X(GLCOLOR4FV,       GLFunctionClass::DRAW,         GLArgType::FP32_PTR)                                                                                                                                           \
+    X(GLCULLFACE,       GLFunctionClass::STATE_SETTER, GLArgType::ENUM)                                                                                                                                               \
+    X(GLDELETETEXTURES, GLFunctionClass::TEXTURE,      GLArgType::I32,  GLArgType::U32_PTR)                                                                                                                           \
+    X(GLDEPTHFUNC,      GLFunctionClass::STATE_SETTER, GLArgType::ENUM)                                                                                                                                               \
+    X(GLDEPTHMASK,      GLFunctionClass::STATE_SETTER, GLArgType::U32)                                                                                                                                                \
+    X(GLDEPTHRANGE,     GLFunctionClass::STATE_SETTER, GLArgType::FP64, GLArgType::FP64)                                                                                                                              \
+    X(GLDISABLE,        GLFunctionClass::STATE_SETTER, GLArgType::ENUM)                                                                                                                                               \
+    X(GLDRAWBUFFER,     GLFunctionClass::STATE_SETTER, GLArgType::ENUM)                                                                                                                                               \
+    X(GLENABLE,         GLFunctionClass::STATE_SETTER, GLArgType::ENUM)                                                                                                                                               \
+    X(GLEND,            GLFunctionClass::DRAW)                                                                                                                                                                        \
+    X(GLFINISH,         GLFunctionClass::OTHER)                                                                                                                                                                       \
+    X(GLFLUSH,          GLFunctionClass::OTHER)                                                                                                                                                                       \
+    X(GLFRONTFACE,      GLFunctionClass::STATE_SETTER, GLArgType::ENUM)                                                                                                                                               \
+    X(GLFRUSTUM,        GLFunctionClass::MATRIX,       GLArgType::FP64, GLArgType::FP64, GLArgType::FP64, GLArgType::FP64, GLArgType::FP64, GLArgType::FP64)                                                          \
+    X(GLLOADIDENTITY,   GLFunctionClass::MATRIX)                                                                                                                                                                      \
+    X(GLMATRIXMODE,     GLFunctionClass::MATRIX,       GLArgType::ENUM)                                                                                                                                               \
+    X(GLORTHO,          GLFunctionClass::MATRIX,       GLArgType::FP64, GLArgType::FP64, GLArgType::FP64, GLArgType::FP64, GLArgType::FP64, GLArgType::FP64)                                                          \
+    X(GLPOPMATRIX,      GLFunctionClass::MATRIX)                                                                                                                                                                      \
+    X(GLPUSHMATRIX,     GLFunctionClass::MATRIX)                                                                                                                                                                      \
+    X(GLREADPIXELS,     GLFunctionClass::OTHER,        GLArgType::I32,  GLArgType::I32,  GLArgType::I32,  GLArgType::I32,  GLArgType::ENUM, GLArgType::ENUM, GLArgType::PTR)                                           \
+    X(GLROTATEF,        GLFunctionClass::MATRIX,       GLArgType::FP32, GLArgType::FP32, GLArgType::FP32, GLArgType::FP32)                                                                                            \
+    X(GLSCALEF,         GLFunctionClass::MATRIX,       GLArgType::FP32, GLArgType::FP32, GLArgType::FP32)                                                                                                             \
+    X(GLSHADEMODEL,     GLFunctionClass::STATE_SETTER, GLArgType::ENUM)                                                                                                                                               \
+    X(GLTEXCOORD2F,     GLFunctionClass::DRAW,         GLArgType::FP32, GLArgType::FP32)                                                                                                                              \
+    X(GLTEXENVF,        GLFunctionClass::STATE_SETTER, GLArgType::ENUM, GLArgType::ENUM, GLArgType::FP32)                                                                                                             \
+    X(GLTEXIMAGE2D,     GLFunctionClass::TEXTURE,      GLArgType::ENUM, GLArgType::I32,  GLArgType::I32,  GLArgType::I32,  GLArgType::I32,  GLArgType::I32,  GLArgType::ENUM, GLArgType::ENUM, GLArgType::PTR)  \
+    X(GLTEXPARAMETERF,  GLFunctionClass::TEXTURE,      GLArgType::ENUM, GLArgType::ENUM, GLArgType::FP32)                                                                                                             \
+    X(GLTEXSUBIMAGE2D,  GLFunctionClass::TEXTURE,      GLArgType::ENUM, GLArgType::I32,  GLArgType::I32,  GLArgType::I32,  GLArgType::I32,  GLArgType::I32,  GLArgType::ENUM, GLArgType::ENUM, GLArgType::PTR)  \
+    X(GLTRANSLATEF,     GLFunctionClass::MATRIX,       GLArgType::FP32, GLArgType::FP32, GLArgType::FP32)                                                                                                             \
+    X(GLVERTEX2F,       GLFunctionClass::DRAW,         GLArgType::FP32, GLArgType::FP32)                                                                                                                              \
+    X(GLVERTEX3F,       GLFunctionClass::DRAW,         GLArgType::FP32, GLArgType::FP32, GLArgType::FP32)                                                                                                             \
+    X(GLVERTEX3FV,      GLFunctionClass::DRAW,         GLArgType::FP32_PTR)                                                                                                                                           \
+    X(GLVERTEX4F,       GLFunctionClass::DRAW,         GLArgType::FP32, GLArgType::FP32, GLArgType::FP32, GLArgType::FP32)                                                                                            \
+    X(GLVIEWPORT,       GLFunctionClass::STATE_SETTER, GLArgType::I32,  GLArgType::I32,  GLArgType::I32,  GLArgType::I32)
+
+/* Compile-time traits of a GL entrypoint. Only defined for entrypoints listed in REPLAYER_GL_FUNCTION_LIST. */
+template<APIInterceptor::APIFunction Func>
+struct GLFunctionTraits;
+
+#define REPLAYER_DEFINE_GL_FUNCTION_TRAITS(name, ...)                                                     \
+    template<>                                                                                            \
+    struct GLFunctionTraits<APIInterceptor::APIFUNCTION_GL_##name> : GLFunctionSignature<__VA_ARGS__>     \
+    {                                                                                                     \
+    };
+
+REPLAYER_GL_FUNCTION_LIST(REPLAYER_DEFINE_GL_FUNCTION_TRAITS)
+
+#undef REPLAYER_DEFINE_GL_FUNCTION_TRAITS
+
+/* Run-time lookup table, indexed with (api_func - APIFUNCTION_GL_FIRST). */
+struct GLFunctionInfoTable
+{
+    static const uint32_t N_ENTRIES = APIInterceptor::APIFUNCTION_GL_LAST - APIInterceptor::APIFUNCTION_GL_FIRST + 1;
+
+    GLFunctionInfo info_vec[N_ENTRIES];
+};
+
+constexpr GLFunctionInfoTable create_gl_function_info_table()
+{
+    GLFunctionInfoTable result = {};
+
+    for (uint32_t n_entry = 0;
+                  n_entry < GLFunctionInfoTable::N_ENTRIES;
+                ++n_entry)
+    {
+        result.info_vec[n_entry] = GLFunctionInfo{nullptr,
+                                                  GLFunctionClass::UNKNOWN,
+                                                  0,
+                                                  {} };
+    }
+
+    #define REPLAYER_FILL_GL_FUNCTION_INFO(name, ...) \
+        result.info_vec[APIInterceptor::APIFUNCTION_GL_##name - APIInterceptor::APIFUNCTION_GL_FIRST] = GLFunctionSignature<__VA_ARGS__>::get_info(#name);
+
+    REPLAYER_GL_FUNCTION_LIST(REPLAYER_FILL_GL_FUNCTION_INFO)
+
+    #undef REPLAYER_FILL_GL_FUNCTION_INFO
+
+    return result;
+}
+
+constexpr GLFunctionInfoTable g_gl_function_info_table = create_gl_function_info_table();
+
+/* Returns info on the specified entrypoint. Entrypoints not used by GLQuake (and non-GL functions) are reported as
+ * GLFunctionClass::UNKNOWN. */
+inline const GLFunctionInfo& get_gl_function_info(const APIInterceptor::APIFunction& in_api_func)
+{
+    static const GLFunctionInfo unknown_function_info = {nullptr, GLFunctionClass::UNKNOWN, 0, {} };
+
+    if (static_cast<uint32_t>(in_api_func) <  static_cast<uint32_t>(APIInterceptor::APIFUNCTION_GL_FIRST) ||
+        static_cast<uint32_t>(in_api_func) >  static_cast<uint32_t>(APIInterceptor::APIFUNCTION_GL_LAST) )
+    {
+        return unknown_function_info;
+    }
+
+    return g_gl_function_info_table.info_vec[in_api_func - APIInterceptor::APIFUNCTION_GL_FIRST];
+}
+
+/* Typed, zero-cost view of a recorded command's arguments.
+ *
+ * Argument types are resolved at compile time from GLFunctionTraits<>, so get<N>() boils down to a direct load of
+ * the right union member. Works with both APIInterceptor::APICommand and ReplayerSnapshotCommandView. */
+template<APIInterceptor::APIFunction Func>
+class CommandView
+{
+public:
+    /* Public type defs */
+    typedef GLFunctionTraits<Func> Traits;
+
+    /* Public funcs */
+    explicit CommandView(const APIInterceptor::APIFunctionArgument* in_args_ptr)
+        :m_args_ptr(in_args_ptr)
+    {
+        /* Stub */
+    }
+
+    template<typename CommandType>
+    explicit CommandView(const CommandType& in_command)
+        :m_args_ptr(in_command.api_arg_vec.data() )
+    {
+        assert(in_command.api_func          == Func);
+        assert(in_command.api_arg_vec.size() >= Traits::n_args);
+    }
+
+    template<uint32_t N>
+    typename Traits::template Arg<N>::value_type get() const
+    {
+        static_assert(N < Traits::n_args, "Argument index out of range");
+
+        return GLArgTypeTraits<Traits::template Arg<N>::type>::get(m_args_ptr[N]);
+    }
+
+private:
+    /* Private vars */
+    const APIInterceptor::APIFunctionArgument* m_args_ptr;
+};
+
+#endif /* REPLAYER_GL_FUNCTIONS_H */
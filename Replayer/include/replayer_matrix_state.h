@@ -0,0 +1,81 @@
+/* API Interceptor (c) 2024 Dominik Witczak
+ *
+ * This code is licensed under MIT license (see LICENSE.txt for details)
+ */
+#if !defined(REPLAYER_MATRIX_STATE_H)
+#define REPLAYER_MATRIX_STATE_H
+
+#include "APIInterceptor/include/Common/types.h"
+#include "replayer_types.h"
+
+/* Forward decls */
+class ReplayerSnapshot;
+
+/* Modelview-projection matrix in effect for a single draw call recorded in a snapshot. */
+struct ReplayerDrawMVP
+{
+    std::array<double, 16> mvp_matrix;
+    uint32_t               n_api_command;
+};
+
+/* CPU-side shadow of GL's fixed-function matrix stacks.
+ *
+ * Follows glMatrixMode(), glLoadIdentity(), glPushMatrix(), glPopMatrix(), glRotatef(), glScalef(), glTranslatef(),
+ * glFrustum() and glOrtho() calls, so that current matrices can be retrieved without querying the driver. Matrices
+ * are stored in column-major order, as GL does.
+ */
+class ReplayerMatrixState
+{
+public:
+    /* Public funcs */
+    ReplayerMatrixState();
+
+    /* Applies a matrix command. Returns false if @param in_api_func does not affect matrix state. */
+    bool apply(const APIInterceptor::APIFunction&         in_api_func,
+               const APIInterceptor::APIFunctionArgument* in_args_ptr);
+
+    void          get_modelview_projection_matrix(double* out_mvp_matrix_ptr) const;
+    const double* get_modelview_matrix           ()                           const;
+    const double* get_projection_matrix          ()                           const;
+
+    /* Resets the stacks, so that they only hold the specified matrices. */
+    void reset(const uint32_t& in_matrix_mode,
+               const double*   in_modelview_matrix_ptr,
+               const double*   in_projection_matrix_ptr);
+
+    /* Walks the snapshot's commands, starting from the snapshot's start state, and stores the MVP matrix in effect for
+     * each glBegin() command.
+     *
+     * NOTE: Start state only holds the top of each stack. Pops past it leave the bottom matrix intact. */
+    static void get_draw_mvp_matrices(const GLContextState*         in_start_gl_context_state_ptr,
+                                      const ReplayerSnapshot*       in_snapshot_ptr,
+                                      std::vector<ReplayerDrawMVP>* out_draw_mvp_vec_ptr);
+
+private:
+    /* Private consts */
+    static const uint32_t MAX_STACK_DEPTH = 32; // minimum modelview stack depth required by GL
+
+    /* Private type defs */
+    struct MatrixStack
+    {
+        std::array<std::array<double, 16>, MAX_STACK_DEPTH> matrix_vec;
+        uint32_t                                             n_top_matrix;
+    };
+
+    /* Private funcs */
+    MatrixStack* get_current_stack();
+
+    void multiply(const double* in_matrix_ptr);
+
+    static void multiply_matrices(const double* in_a_ptr,
+                                  const double* in_b_ptr,
+                                  double*       out_result_ptr);
+
+    /* Private vars */
+    uint32_t    m_matrix_mode;
+    MatrixStack m_modelview_stack;
+    MatrixStack m_projection_stack;
+    MatrixStack m_texture_stack;
+};
+
+#endif /* REPLAYER_MATRIX_STATE_H */
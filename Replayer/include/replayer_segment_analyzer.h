@@ -0,0 +1,61 @@
+/* API Interceptor (c) 2024 Dominik Witczak
+ *
+ * This code is licensed under MIT license (see LICENSE.txt for details)
+ */
+#if !defined(REPLAYER_SEGMENT_ANALYZER_H)
+#define REPLAYER_SEGMENT_ANALYZER_H
+
+#include "replayer_snapshot.h"
+
+/* Forward decls */
+class                                            ReplayerSegmentAnalyzer;
+typedef std::unique_ptr<ReplayerSegmentAnalyzer> ReplayerSegmentAnalyzerUniquePtr;
+
+/* Identifies segments of a Q1 frame which the snapshot player treats specially: lightmap passes, 3D model shading,
+ * the weapon, screen-space geometry and the first glRotatef() call.
+ *
+ * Commands are fed in recording order and each of them is only looked at once, so the analysis can run alongside
+ * recording. By the time a frame is complete, all that is left to do is to resolve the model & weapon ranges, which
+ * only depend on a handful of ranges collected on the way.
+ */
+class ReplayerSegmentAnalyzer
+{
+public:
+    /* Public funcs */
+    static ReplayerSegmentAnalyzerUniquePtr create(const std::array<uint32_t, 2>& in_q1_window_extents);
+
+    /* Feeds all commands of @param in_snapshot which have been completed since the last call. */
+    void consume(const ReplayerSnapshot& in_snapshot);
+
+    /* Feeds the remaining commands of @param in_snapshot, which must be complete, and stores the resulting segments
+     * in @param out_segment_table_ptr. The analyzer is reset afterward. */
+    void finish(const ReplayerSnapshot& in_snapshot,
+                ReplayerSegmentTable*   out_segment_table_ptr);
+
+    /* Prepares the analyzer for a new snapshot. */
+    void reset();
+
+private:
+    /* Private funcs */
+    ReplayerSegmentAnalyzer(const std::array<uint32_t, 2>& in_q1_window_extents);
+
+    void on_command(const uint32_t&                    in_n_command,
+                    const ReplayerSnapshotCommandView& in_command);
+
+    /* Private vars */
+    const std::array<uint32_t, 2> m_q1_window_extents;
+
+    bool     m_is_blending_enabled;
+    bool     m_is_modulate_env_mode_enabled;
+    bool     m_is_screen_space_geom_reached; // nothing of interest follows
+    uint32_t m_n_ao_segment_candidate_command;  // glBlendFunc() which starts an AO segment if followed by glEnable()
+    uint32_t m_n_ao_segment_start_command;
+    uint32_t m_n_next_command;
+    uint32_t m_n_weapon_draw_segment_start_command;
+
+    std::vector<std::array<uint32_t, 2> > m_draws_with_env_mode_modulate_command_range_vec;
+    std::vector<std::array<uint32_t, 2> > m_env_mode_modulate_command_range_vec;
+    ReplayerSegmentTable                  m_segment_table;
+};
+
+#endif /* REPLAYER_SEGMENT_ANALYZER_H */
@@ -7,33 +7,387 @@
 
 #include "APIInterceptor/include/Common/types.h"
 #include "replayer_types.h"
+#include <atomic>
 
 /* Forward decls */
 class                                     ReplayerSnapshot;
 typedef std::unique_ptr<ReplayerSnapshot> ReplayerSnapshotUniquePtr;
 
+/* Non-owning view of arguments of a single recorded API command.
+ *
+ * Arguments of a command always live in a single arena chunk, so this boils down to a pointer + count pair.
+ */
+class ReplayerSnapshotArgView
+{
+public:
+    /* Public funcs */
+    ReplayerSnapshotArgView(const APIInterceptor::APIFunctionArgument* in_arg_ptr,
+                            const uint32_t&                            in_n_args)
+        :m_arg_ptr(in_arg_ptr),
+         m_n_args (in_n_args)
+    {
+        /* Stub */
+    }
+
+    const APIInterceptor::APIFunctionArgument& at(const uint32_t& in_n_arg) const
+    {
+        assert(in_n_arg < m_n_args);
+
+        return m_arg_ptr[in_n_arg];
+    }
+
+    const APIInterceptor::APIFunctionArgument& operator[](const uint32_t& in_n_arg) const
+    {
+        return m_arg_ptr[in_n_arg];
+    }
+
+    const APIInterceptor::APIFunctionArgument* begin() const { return m_arg_ptr;            }
+    const APIInterceptor::APIFunctionArgument* data () const { return m_arg_ptr;            }
+    const APIInterceptor::APIFunctionArgument* end  () const { return m_arg_ptr + m_n_args; }
+    uint32_t                                   size () const { return m_n_args;             }
+
+private:
+    /* Private vars */
+    const APIInterceptor::APIFunctionArgument* m_arg_ptr;
+    uint32_t                                   m_n_args;
+};
+
+/* A single element of a vertex batch. Holds the attributes specified by the application since the previous glVertex*()
+ * call, followed by the vertex position itself.
+ *
+ * NOTE: Attribute-only elements (ones without any of the POSITION bits set) may only appear at the end of a batch.
+ */
+struct ReplayerVertexBatchVertex
+{
+    enum : uint32_t
+    {
+        ATTRIBUTE_COLOR_3F    = 1 << 0,
+        ATTRIBUTE_COLOR_3UB   = 1 << 1, // color[] holds raw, non-normalized 0..255 values
+        ATTRIBUTE_COLOR_4F    = 1 << 2,
+        ATTRIBUTE_TEXCOORD_2F = 1 << 3,
+        ATTRIBUTE_POSITION_2F = 1 << 4,
+        ATTRIBUTE_POSITION_3F = 1 << 5,
+        ATTRIBUTE_POSITION_4F = 1 << 6,
+
+        ATTRIBUTE_COLOR_MASK    = ATTRIBUTE_COLOR_3F    | ATTRIBUTE_COLOR_3UB   | ATTRIBUTE_COLOR_4F,
+        ATTRIBUTE_POSITION_MASK = ATTRIBUTE_POSITION_2F | ATTRIBUTE_POSITION_3F | ATTRIBUTE_POSITION_4F,
+    };
+
+    float    position[4];
+    float    texcoord[2];
+    float    color   [4];
+    uint32_t attribute_mask;
+};
+
+/* An API call reconstructed from a vertex batch element. */
+struct ReplayerExpandedAPICommand
+{
+    APIInterceptor::APIFunction                        api_func;
+    std::array<APIInterceptor::APIFunctionArgument, 4> api_arg_vec;
+    uint32_t                                           n_api_args;
+};
+
+/* Non-owning view of a vertex batch recorded in a snapshot. */
+class ReplayerVertexBatchView
+{
+public:
+    /* Public consts */
+    static const uint32_t CHUNK_SIZE_LOG2 = 14;
+    static const uint32_t CHUNK_SIZE      = 1u << CHUNK_SIZE_LOG2;
+
+    /* Public type defs */
+    typedef std::vector<std::vector<ReplayerVertexBatchVertex> > ChunkVector;
+
+    /* Public funcs */
+    ReplayerVertexBatchView()
+        :m_chunk_vec_ptr(nullptr),
+         m_n_first_vertex(0),
+         m_n_vertices   (0),
+         m_vertex_ptr   (nullptr)
+    {
+        /* Stub */
+    }
+
+    ReplayerVertexBatchView(const ChunkVector* in_chunk_vec_ptr,
+                            const uint32_t&    in_n_first_vertex,
+                            const uint32_t&    in_n_vertices)
+        :m_chunk_vec_ptr (in_chunk_vec_ptr),
+         m_n_first_vertex(in_n_first_vertex),
+         m_n_vertices    (in_n_vertices),
+         m_vertex_ptr    (nullptr)
+    {
+        /* Stub */
+    }
+
+    /* Views a batch stored in contiguous memory, eg. a mapped snapshot file. */
+    ReplayerVertexBatchView(const ReplayerVertexBatchVertex* in_vertex_ptr,
+                            const uint32_t&                  in_n_vertices)
+        :m_chunk_vec_ptr (nullptr),
+         m_n_first_vertex(0),
+         m_n_vertices    (in_n_vertices),
+         m_vertex_ptr    (in_vertex_ptr)
+    {
+        /* Stub */
+    }
+
+    const ReplayerVertexBatchVertex& at(const uint32_t& in_n_vertex) const
+    {
+        assert(in_n_vertex < m_n_vertices);
+
+        if (m_vertex_ptr != nullptr)
+        {
+            return m_vertex_ptr[in_n_vertex];
+        }
+
+        const auto n_vertex = m_n_first_vertex + in_n_vertex;
+
+        return (*m_chunk_vec_ptr)[n_vertex >> CHUNK_SIZE_LOG2][n_vertex & (CHUNK_SIZE - 1)];
+    }
+
+    bool     is_valid() const { return (m_chunk_vec_ptr != nullptr || m_vertex_ptr != nullptr); }
+    uint32_t size    () const { return m_n_vertices;                 }
+
+    /* Converts a single batch element back into the individual API calls it was built from. Returns the number of
+     * commands written to @param out_api_command_ptr, which must be able to hold up to 3 items. */
+    static uint32_t expand(const ReplayerVertexBatchVertex& in_vertex,
+                           ReplayerExpandedAPICommand*      out_api_command_ptr);
+
+private:
+    /* Private vars */
+    const ChunkVector*               m_chunk_vec_ptr;
+    uint32_t                         m_n_first_vertex;
+    uint32_t                         m_n_vertices;
+    const ReplayerVertexBatchVertex* m_vertex_ptr; // only set for contiguous batches
+};
+
+/* Lightweight view of a single recorded API command.
+ *
+ * Exposes the same api_func / api_arg_vec members APIInterceptor::APICommand does, and can be dereferenced with ->,
+ * so that code which used to work on APICommand pointers keeps working unchanged.
+ *
+ * If vertex batching is enabled, a whole glBegin() .. glEnd() run is recorded as a single glBegin() command with a
+ * valid vertex_batch. No separate glEnd() command is recorded in that case.
+ *
+ * glTexImage2D() and glTexSubImage2D() commands recorded with record_texture_upload() come with
+ * texture_upload_data_ptr set. Their pixels pointer argument refers to the application's memory and must not be
+ * dereferenced - use the former instead. It holds the whole mip, as it looks after the command, so sub-image updates
+ * need to be uploaded with GL_UNPACK_ROW_LENGTH set to texture_upload_n_row_pixels.
+ */
+struct ReplayerSnapshotCommandView
+{
+    APIInterceptor::APIFunction api_func;
+    ReplayerSnapshotArgView     api_arg_vec;
+    ReplayerVertexBatchView     vertex_batch;
+    const PendingMipData*       texture_upload_data_ptr     = nullptr; // owned by the snapshot
+    uint32_t                    texture_upload_n_row_pixels = 0;
+
+    const ReplayerSnapshotCommandView* operator->() const
+    {
+        return this;
+    }
+
+    /* Only meant for slow paths (logging, UI) which need a real APICommand instance. */
+    void to_api_command(APIInterceptor::APICommand* out_api_command_ptr) const;
+};
+
+/* Command ranges of a Q1 frame which the snapshot player treats specially. Ranges are inclusive. Segments which have
+ * not been found are set to UINT32_MAX. See ReplayerSegmentAnalyzer. */
+struct ReplayerSegmentTable
+{
+    std::vector<std::array<uint32_t, 2> > ao_command_range_vec;          // lightmap passes
+    std::vector<std::array<uint32_t, 2> > shade_model_command_range_vec; // draws of monsters & other 3D models
+
+    uint32_t n_first_glrotate_command              = UINT32_MAX;
+    uint32_t n_screen_space_geom_api_first_command = UINT32_MAX;
+    uint32_t n_screen_space_geom_api_last_command  = UINT32_MAX;
+    uint32_t n_weapon_draw_first_command           = UINT32_MAX;
+    uint32_t n_weapon_draw_last_command            = UINT32_MAX;
+
+    /* Forgets all segments. Retains vector storage. */
+    void reset()
+    {
+        ao_command_range_vec.clear         ();
+        shade_model_command_range_vec.clear();
+
+        n_first_glrotate_command              = UINT32_MAX;
+        n_screen_space_geom_api_first_command = UINT32_MAX;
+        n_screen_space_geom_api_last_command  = UINT32_MAX;
+        n_weapon_draw_first_command           = UINT32_MAX;
+        n_weapon_draw_last_command            = UINT32_MAX;
+    }
+};
+
+/* CPU time the application spent between submissions, summed up per segment of a Q1 frame. Time spent in our own
+ * callbacks is not included. */
+struct ReplayerSegmentCPUTimes
+{
+    uint64_t frame_start_ns = 0; // from the previous SwapBuffers() callback up to the first command, so includes the driver's SwapBuffers()
+    uint64_t hud_ns         = 0;
+    uint64_t lightmaps_ns   = 0;
+    uint64_t models_ns      = 0;
+    uint64_t trailing_ns    = 0; // from the last recorded command up to SwapBuffers()
+    uint64_t weapon_ns      = 0;
+    uint64_t world_ns       = 0; // everything else
+
+    uint64_t timestamp_overhead_ns = 0; // estimated cost of taking the timestamps themselves
+};
+
+/* Snapshot of a single frame's worth of API commands.
+ *
+ * Commands are stored as a packed opcode stream. Their arguments live in a separate argument arena. Both are
+ * allocated in fixed-size chunks which are never reallocated, so recording a command never moves data recorded
+ * earlier and costs no heap allocations unless a new chunk needs to be created.
+ */
 class ReplayerSnapshot
 {
 public:
     /* Public funcs */
     ~ReplayerSnapshot();
 
-    uint32_t                          get_n_api_commands ()                                 const;
-    const APIInterceptor::APICommand* get_api_command_ptr(const uint32_t& in_n_api_command) const;
+    uint32_t                    get_n_api_args       ()                                 const;
+    uint32_t                    get_n_api_commands   ()                                 const;
+    ReplayerSnapshotCommandView get_api_command_ptr  (const uint32_t& in_n_api_command) const;
+    uint64_t                    get_n_allocated_bytes()                                 const; // arena chunks, used or not
+    uint32_t                    get_n_vertices       ()                                 const;
+
+    /* Returns the number of commands which are final. Differs from get_n_api_commands() while a vertex batch is being
+     * recorded, as the batch may still grow, or be spilled into individual commands. */
+    uint32_t get_n_completed_api_commands() const;
+
+    /* CPU time the application spent before submitting each command, in TSC ticks. Only available if the snapshot has
+     * been recorded with CPU timing enabled. Calls which have not been recorded, or have been folded into a vertex
+     * batch, are accounted for in the next recorded command, or the batch. */
+    uint32_t get_cpu_ticks           (const uint32_t& in_n_api_command) const;
+    double   get_n_cpu_ticks_per_second()                               const;
+    bool     has_cpu_ticks             ()                               const;
+
+    /* Sums CPU time up per segment. Returns false if the snapshot carries no CPU timing info or no segment table. */
+    bool get_segment_cpu_times(ReplayerSegmentCPUTimes* out_cpu_times_ptr) const;
+
+    /* Adds @param in_n_ticks to the CPU time attributed to the next recorded command. Must only be called if CPU timing
+     * has been enabled. */
+    void add_cpu_ticks(const uint64_t& in_n_ticks)
+    {
+        m_n_pending_cpu_ticks += in_n_ticks;
+    }
+
+    /* Stores TSC frequency and the estimated cost of the timestamps, once recording is done. Ticks added since the
+     * last recorded command are kept as trailing time. */
+    void finish_cpu_timing(const double&   in_n_cpu_ticks_per_second,
+                           const uint64_t& in_n_timestamp_overhead_ticks);
+
+    /* When enabled, each recorded command comes with the CPU time which preceded it. May only be changed while the
+     * snapshot is empty. */
+    void set_cpu_timing_enabled(const bool& in_enabled);
+
+    /* Segment table built while the snapshot was being recorded, or null if the snapshot has not been analyzed. */
+    const ReplayerSegmentTable* get_segment_table          () const;
+    ReplayerSegmentTable*       get_segment_table_for_write(); // marks the snapshot as analyzed
 
     void record_api_call(const APIInterceptor::APIFunction&         in_api_func,
                          const uint32_t&                            in_n_args,
                          const APIInterceptor::APIFunctionArgument* in_args_ptr);
+
+    /* Records a glTexImage2D() or glTexSubImage2D() call whose pixels have been handed over to the texture store.
+     * The snapshot keeps a reference to @param in_data_ptr, which holds the whole mip, so that the data stays around
+     * for as long as the command does, and replaying the command never touches the application's memory.
+     *
+     * @param in_n_row_pixels Width of the mip. */
+    void record_texture_upload(const APIInterceptor::APIFunction&            in_api_func,
+                               const uint32_t&                               in_n_args,
+                               const APIInterceptor::APIFunctionArgument*    in_args_ptr,
+                               const std::shared_ptr<const PendingMipData>& in_data_ptr,
+                               const uint32_t&                               in_n_row_pixels);
+    void reserve        (const uint32_t&                            in_n_api_commands,
+                         const uint32_t&                            in_n_api_args,
+                         const uint32_t&                            in_n_vertices);
     void reset          ();
 
-    static ReplayerSnapshotUniquePtr create();
+    /* When enabled, glBegin() .. glEnd() runs are folded into packed vertex batches. Only takes effect for runs
+     * started after the call. */
+    void set_vertex_batching_enabled(const bool& in_enabled);
+
+    static ReplayerSnapshotUniquePtr create(const uint32_t& in_n_api_commands_to_reserve = 0,
+                                            const uint32_t& in_n_api_args_to_reserve     = 0,
+                                            const uint32_t& in_n_vertices_to_reserve     = 0);
+
+    /* Returns the number of heap allocations made by all snapshot instances so far. Includes creation of snapshot
+     * instances, as well as any arena chunks they allocate. Once recording reaches steady state, this value is
+     * expected to stop changing. */
+    static uint32_t get_n_total_heap_allocations();
 
 private:
+    /* Private type defs */
+    struct Command
+    {
+        APIInterceptor::APIFunction api_func;
+        uint16_t                    n_args;
+        uint16_t                    flags;
+        uint32_t                    n_first_arg; // index into the argument arena
+    };
+
+    enum : uint16_t
+    {
+        /* glBegin() command with a vertex batch attached. The batch's first vertex index and vertex count are stored
+         * in the argument arena, right after the command's visible arguments. */
+        COMMAND_FLAG_VERTEX_BATCH = 1 << 0,
+
+        /* glTexImage2D() / glTexSubImage2D() command with snapshot-owned pixel data. Index of the data in
+         * m_texture_upload_data_vec and the mip's width are stored in the argument arena, right after the command's
+         * visible arguments. */
+        COMMAND_FLAG_TEXTURE_UPLOAD = 1 << 1,
+    };
+
+    /* Private consts */
+    static const uint32_t ARG_CHUNK_SIZE_LOG2     = 16;
+    static const uint32_t ARG_CHUNK_SIZE          = 1u << ARG_CHUNK_SIZE_LOG2;
+    static const uint32_t COMMAND_CHUNK_SIZE_LOG2 = 14;
+    static const uint32_t COMMAND_CHUNK_SIZE      = 1u << COMMAND_CHUNK_SIZE_LOG2;
+
     /* Private funcs */
     ReplayerSnapshot();
 
+    void allocate_arg_chunk         ();
+    void allocate_command_chunk     ();
+    void allocate_cpu_ticks_chunk   ();
+    void allocate_vertex_chunk      ();
+    bool record_batched_api_call    (const APIInterceptor::APIFunction&         in_api_func,
+                                     const APIInterceptor::APIFunctionArgument* in_args_ptr);
+    void record_command             (const APIInterceptor::APIFunction&         in_api_func,
+                                     const uint32_t&                            in_n_visible_args,
+                                     const uint32_t&                            in_n_args,
+                                     const APIInterceptor::APIFunctionArgument* in_args_ptr,
+                                     const uint16_t&                            in_flags);
+    void record_vertex              (const ReplayerVertexBatchVertex&           in_vertex);
+    void spill_active_vertex_batch  ();
+
     /* Private vars */
-    std::vector<APIInterceptor::APICommand> m_api_command_vec;
+    std::vector<std::vector<APIInterceptor::APIFunctionArgument> > m_arg_chunk_vec;
+    std::vector<std::vector<Command> >                              m_command_chunk_vec;
+    ReplayerVertexBatchView::ChunkVector                            m_vertex_chunk_vec;
+
+    uint32_t m_n_api_args;
+    uint32_t m_n_api_commands;
+    uint32_t m_n_current_arg_chunk;
+    uint32_t m_n_vertices;
+
+    bool                      m_is_vertex_batching_enabled;
+    uint32_t                  m_n_active_vertex_batch_command;
+    ReplayerVertexBatchVertex m_pending_vertex;
+
+    bool                 m_has_segment_table;
+    ReplayerSegmentTable m_segment_table;
+
+    std::vector<std::shared_ptr<const PendingMipData> > m_texture_upload_data_vec;
+
+    std::vector<std::vector<uint32_t> > m_cpu_ticks_chunk_vec; // parallel to m_command_chunk_vec
+    bool                                m_is_cpu_timing_enabled;
+    double                              m_n_cpu_ticks_per_second;
+    uint64_t                            m_n_cpu_timestamp_overhead_ticks;
+    uint64_t                            m_n_pending_cpu_ticks;
+    uint64_t                            m_n_trailing_cpu_ticks;
+
+    static std::atomic<uint32_t> m_n_total_heap_allocations;
 };
 
 #endif /* REPLAYER_SNAPSHOT_H */
\ No newline at end of file
@@ -0,0 +1,344 @@
+/* API Interceptor (c) 2024 Dominik Witczak
+ *
+ * This code is licensed under MIT license (see LICENSE.txt for details)
+ */
+#if !defined(REPLAYER_SNAPSHOT_FILE_H)
+#define REPLAYER_SNAPSHOT_FILE_H
+
+#include "replayer_snapshot.h"
+#include <mutex>
+#include <string>
+
+/* Forward decls */
+class                                         ReplayerSnapshotFile;
+typedef std::unique_ptr<ReplayerSnapshotFile> ReplayerSnapshotFileUniquePtr;
+
+/* Block decompression work done by a snapshot file instance so far. */
+struct ReplayerSnapshotFileStats
+{
+    uint32_t n_blocks_decoded       = 0;
+    uint64_t n_decoded_bytes        = 0;
+    uint64_t n_decoded_stored_bytes = 0; // compressed size of the decoded blocks
+    uint64_t decode_time_ns         = 0; // wall time, so blocks decoded in parallel are not counted twice
+};
+
+/* Describes the outcome of ReplayerSnapshotFile::save(). Only sections which are eligible for compression are
+ * accounted for. */
+struct ReplayerSnapshotFileSaveStats
+{
+    uint64_t encode_time_ns = 0;
+    uint64_t n_raw_bytes    = 0;
+    uint64_t n_stored_bytes = 0;
+};
+
+/* Snapshot saved to a .q1snap file, and mapped back into the process.
+ *
+ * Opening a file only maps it and checks its header. Commands, their arguments, vertex batches and texture data are
+ * then read in place, straight from the mapping, so nothing gets parsed or copied up-front no matter how large the
+ * file is. Checksums are verified lazily, the first time a section is accessed. Mip data blobs carry their own
+ * checksums, so that only the blobs which are actually used get verified.
+ *
+ * COMMANDS, ARGS, VERTICES and BLOB_DATA sections may be stored compressed with ReplayerBlockCodec, in which case they
+ * are decoded into memory owned by the instance instead of being read in place. Blocks are decoded on demand: the
+ * command stream as a whole, the first time it is accessed, and mip data one blob at a time, so only the blocks the
+ * blob overlaps get decoded. Large ranges of blocks are decoded on multiple threads.
+ *
+ * File layout (all values are stored in native byte order, sections start at SECTION_ALIGNMENT-aligned offsets):
+ *
+ * - File header:         see Header.
+ * - START_CONTEXT_STATE: GLContextState fields, u32 number of textures, (u32 GL ID, GLContextTextureState) pairs.
+ * - COMMANDS:            one Command per API command.
+ * - ARGS:                arguments of all commands.
+ * - VERTICES:            vertices of all vertex batches.
+ * - TEXTURE_PROPS:       one MipRecord per mip of the texture props map, sorted by GL ID and mip index.
+ * - BLOBS:               one Blob per mip data blob. Blobs are shared between mips and texture uploads.
+ * - BLOB_DATA:           contents of the blobs. Not checksummed as a whole - see Blob.
+ * - ANALYSIS:            see Analysis, followed by AO and 3D model command ranges of the segment table.
+ *
+ * A compressed section holds one BlockInfo per ReplayerBlockCodec::BLOCK_SIZE bytes of decoded data, followed by the
+ * blocks. Blocks which did not compress are stored as-is. Section checksums cover the stored bytes.
+ *
+ * NOTE: Pointer arguments are stored as-is. Texture upload commands come with their data, which supersedes the pixels
+ *       argument - see get_texture_upload_data().
+ */
+class ReplayerSnapshotFile
+{
+public:
+    /* Public consts */
+    static const uint32_t FILE_MAGIC   = 0x4E533151; // "Q1SN"
+    static const uint32_t FILE_VERSION = 2;
+
+    /* Public funcs */
+
+    /* Maps snapshot file @param in_filename. Returns null if the file could not be opened, is not a snapshot file, or
+     * has been saved with a different version of the format. */
+    static ReplayerSnapshotFileUniquePtr create(const std::string& in_filename);
+
+    ~ReplayerSnapshotFile();
+
+    ReplayerSnapshotFileStats get_stats() const;
+
+    /* Writes a snapshot to file @param in_filename. If @param in_should_compress is true, sections which are eligible
+     * for compression are stored compressed, unless that does not make them any smaller. Returns false if the file
+     * could not be written to. */
+    static bool save(const std::string&             in_filename,
+                     const GLContextState*          in_start_context_state_ptr,
+                     const ReplayerSnapshot*        in_snapshot_ptr,
+                     const GLIDToTexturePropsMap*   in_gl_id_to_texture_props_map_ptr,
+                     const bool&                    in_should_compress,
+                     ReplayerSnapshotFileSaveStats* out_opt_stats_ptr);
+
+    /* Verifies the command stream when first called. Returns 0 if it is corrupt. Commands may only be accessed after
+     * this function has returned a non-zero value. */
+    uint32_t                    get_n_api_commands () const;
+    ReplayerSnapshotCommandView get_api_command_ptr(const uint32_t& in_n_api_command) const;
+
+    /* Same as ReplayerSnapshot's counterparts. */
+    uint32_t get_cpu_ticks        (const uint32_t&          in_n_api_command)  const;
+    double   get_n_cpu_ticks_per_second()                                      const;
+    bool     get_segment_cpu_times(ReplayerSegmentCPUTimes* out_cpu_times_ptr) const;
+    bool     has_cpu_ticks        ()                                           const;
+
+    /* Returns false if the file carries no segment table, or the section is corrupt. */
+    bool get_segment_table(ReplayerSegmentTable* out_segment_table_ptr) const;
+
+    /* Returns false if the section is corrupt. */
+    bool get_start_gl_context_state(GLContextState* out_gl_context_state_ptr) const;
+
+    /* Fills @param out_gl_id_to_texture_props_map_ptr with texture and mip properties. Mip data is not copied, so
+     * data_u8_vec_ptr is left null for all mips - use get_mip_data() to access it in place. Returns false if the
+     * section is corrupt. */
+    bool get_gl_id_to_texture_props_map(GLIDToTexturePropsMap* out_gl_id_to_texture_props_map_ptr) const;
+
+    /* Returns a pointer to the mapped data of a mip, or null if the mip does not exist, carries no data, or the data is
+     * corrupt. */
+    const uint8_t* get_mip_data(const uint32_t& in_gl_id,
+                                const uint32_t& in_n_mip,
+                                uint32_t*       out_n_bytes_ptr) const;
+
+    /* Returns a pointer to the mapped data uploaded by a glTexImage2D() or glTexSubImage2D() command, or null if the
+     * command carries no data, or the data is corrupt. Holds the whole mip, as it looks after the command. See
+     * ReplayerSnapshotCommandView for details. */
+    const uint8_t* get_texture_upload_data(const uint32_t& in_n_api_command,
+                                           uint32_t*       out_n_bytes_ptr) const;
+
+private:
+    /* Private type defs */
+    enum Section : uint32_t
+    {
+        SECTION_START_CONTEXT_STATE,
+        SECTION_COMMANDS,
+        SECTION_ARGS,
+        SECTION_VERTICES,
+        SECTION_TEXTURE_PROPS,
+        SECTION_BLOBS,
+        SECTION_BLOB_DATA,
+        SECTION_ANALYSIS,
+
+        SECTION_COUNT
+    };
+
+    enum class VerificationStatus : uint8_t
+    {
+        NOT_VERIFIED,
+        VALID,
+        CORRUPT,
+    };
+
+    enum : uint32_t
+    {
+        SECTION_FLAG_COMPRESSED = 1 << 0,
+    };
+
+    struct SectionInfo
+    {
+        uint64_t n_start_byte;
+        uint64_t n_bytes;         // as stored
+        uint64_t n_decoded_bytes; // equal to n_bytes, unless the section is compressed
+        uint64_t checksum;        // ReplayerTextureStore::hash() of the stored bytes
+        uint32_t flags;
+        uint32_t n_blocks;        // only used by compressed sections
+    };
+
+    struct BlockInfo
+    {
+        uint64_t n_start_byte;   // relative to the start of the section
+        uint32_t n_stored_bytes; // equal to the decoded size if the block is not compressed
+        uint32_t reserved;
+    };
+
+    /* Memory compressed sections are decoded into. Left uninitialized until blocks get decoded, so that large sections
+     * only take up the pages which are actually used. */
+    struct DecodedSection
+    {
+        std::unique_ptr<uint8_t[]>      data_u8_ptr;
+        std::vector<VerificationStatus> block_status_vec;
+    };
+
+    /* Stored at the start of the file. */
+    struct Header
+    {
+        uint32_t    magic;
+        uint32_t    version;
+        uint64_t    n_file_bytes;
+        uint32_t    n_api_commands;
+        uint32_t    n_api_args;
+        uint32_t    n_blobs;
+        uint32_t    n_mip_records;
+        uint32_t    n_vertices;
+        uint32_t    reserved;
+        SectionInfo section_info_vec[SECTION_COUNT];
+    };
+
+    enum : uint32_t
+    {
+        COMMAND_FLAG_VERTEX_BATCH   = 1 << 0,
+        COMMAND_FLAG_TEXTURE_UPLOAD = 1 << 1,
+    };
+
+    struct Command
+    {
+        uint32_t api_func;
+        uint32_t flags;
+        uint32_t n_args;
+        uint32_t n_first_arg;
+        uint32_t n_first_vertex;
+        uint32_t n_vertices;
+        uint32_t n_texture_upload_blob;
+        uint32_t texture_upload_n_row_pixels;
+        uint32_t cpu_ticks;
+        uint32_t reserved;
+    };
+
+    struct MipRecord
+    {
+        uint32_t                gl_id;
+        int32_t                 border;
+        uint32_t                texture_type;
+        uint32_t                n_mip;            // NO_MIPS for textures which have no mips defined, < MAX_N_MIPS otherwise
+        uint32_t                format;
+        uint32_t                internal_format;
+        std::array<uint32_t, 3> mip_size_u32vec3;
+        uint32_t                type;
+        uint32_t                n_blob;           // UINT32_MAX if the mip carries no data
+        uint32_t                reserved;
+        uint64_t                data_hash;
+    };
+
+    /* Each blob carries its own checksum, so that opening a large file never requires all of its texture data to be
+     * read. */
+    struct Blob
+    {
+        uint64_t n_start_byte; // relative to the start of the decoded BLOB_DATA section
+        uint64_t n_bytes;
+        uint64_t checksum;
+    };
+
+    struct Analysis
+    {
+        uint32_t                has_cpu_ticks;
+        uint32_t                has_segment_cpu_times;
+        uint32_t                has_segment_table;
+        uint32_t                n_ao_command_ranges;
+        uint32_t                n_shade_model_command_ranges;
+        uint32_t                n_first_glrotate_command;
+        uint32_t                n_screen_space_geom_api_first_command;
+        uint32_t                n_screen_space_geom_api_last_command;
+        uint32_t                n_weapon_draw_first_command;
+        uint32_t                n_weapon_draw_last_command;
+        double                  n_cpu_ticks_per_second;
+        ReplayerSegmentCPUTimes segment_cpu_times;
+    };
+
+    /* Private consts */
+    static const uint32_t MAX_N_DECODE_THREADS       = 8;
+    static const uint32_t MAX_N_MIPS                 = 16; // enough for 32768x32768 textures
+    static const uint32_t NO_MIPS                    = UINT32_MAX - 1;
+    static const uint32_t PARALLEL_DECODE_MIN_BLOCKS = 16; // below that, spinning threads up costs more than it saves
+    static const uint64_t SECTION_ALIGNMENT          = 64;
+
+    /* Private funcs */
+    ReplayerSnapshotFile(const std::string& in_filename);
+
+    /* Decodes blocks of a compressed section which overlap the given byte range of the decoded data, unless they have
+     * been decoded already. Returns false if any of them is corrupt. m_mutex must be locked. */
+    bool decode_section_range(const Section&  in_section,
+                              const uint64_t& in_n_start_byte,
+                              const uint64_t& in_n_bytes) const;
+
+    /* Splits @param in_data_u8_vec into blocks and compresses them. Returns false, leaving @param out_data_u8_vec_ptr
+     * and @param out_section_info_ptr untouched, if that does not save anything. */
+    static bool compress_section(const std::vector<uint8_t>& in_data_u8_vec,
+                                 std::vector<uint8_t>*       out_data_u8_vec_ptr,
+                                 SectionInfo*                out_section_info_ptr);
+
+    const Analysis* get_analysis       ()                                const; // null if the section is corrupt
+    const uint8_t*  get_blob_data      (const uint32_t& in_n_blob,
+                                        uint32_t*       out_n_bytes_ptr) const;
+    const uint8_t*  get_section_ptr    (const Section&  in_section)      const;
+    bool            init               ();
+    bool            verify_mip_records ()                                const;
+    bool            verify_section     (const Section&  in_section)      const; // m_mutex must be locked
+
+    static bool deserialize_gl_context_state(const uint8_t*        in_data_ptr,
+                                             const uint64_t&       in_n_bytes,
+                                             GLContextState*       out_gl_context_state_ptr);
+    static void serialize_gl_context_state  (const GLContextState* in_gl_context_state_ptr,
+                                             std::vector<uint8_t>* out_data_u8_vec_ptr);
+
+    template<typename T>
+    static void serialize(const T&              in_value,
+                          std::vector<uint8_t>* out_data_u8_vec_ptr)
+    {
+        const auto n_start_byte = out_data_u8_vec_ptr->size();
+
+        out_data_u8_vec_ptr->resize(n_start_byte + sizeof(T) );
+
+        memcpy(out_data_u8_vec_ptr->data() + n_start_byte,
+              &in_value,
+               sizeof(T) );
+    }
+
+    /* Reads a value at *@param inout_data_ptr and advances the pointer. Returns false if @param in_data_end_ptr would
+     * be crossed. */
+    template<typename T>
+    static bool deserialize(const uint8_t** inout_data_ptr,
+                            const uint8_t*  in_data_end_ptr,
+                            T*              out_value_ptr)
+    {
+        if (static_cast<size_t>(in_data_end_ptr - *inout_data_ptr) < sizeof(T) )
+        {
+            return false;
+        }
+
+        memcpy(out_value_ptr,
+              *inout_data_ptr,
+               sizeof(T) );
+
+        *inout_data_ptr += sizeof(T);
+
+        return true;
+    }
+
+    /* Private vars */
+    HANDLE         m_file_handle;
+    HANDLE         m_file_mapping_handle;
+    std::string    m_filename;
+    const Header*  m_header_ptr;
+    const uint8_t* m_mapped_data_ptr;
+
+    const APIInterceptor::APIFunctionArgument* m_arg_ptr;
+    const Blob*                                m_blob_ptr;
+    const Command*                             m_command_ptr;
+    const MipRecord*                           m_mip_record_ptr;
+    const ReplayerVertexBatchVertex*           m_vertex_ptr;
+
+    mutable std::vector<VerificationStatus> m_blob_status_vec;
+    mutable VerificationStatus              m_command_stream_status;
+    mutable DecodedSection                  m_decoded_section_vec[SECTION_COUNT];
+    mutable std::mutex                      m_mutex; // guards verification status, decoded sections and stats
+    mutable VerificationStatus              m_section_status_vec[SECTION_COUNT];
+    mutable ReplayerSnapshotFileStats       m_stats;
+};
+
+#endif /* REPLAYER_SNAPSHOT_FILE_H */
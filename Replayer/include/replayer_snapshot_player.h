@@ -29,7 +29,7 @@ public:
                        const GLIDToTexturePropsMap* in_snapshot_gl_id_to_texture_props_map_ptr);
     void play_snapshot();
 
-    void analyze_snapshot          ();
+    void analyze_snapshot          (); // only needed if the snapshot has not been analyzed while being recorded
     bool is_snapshot_available     ();
     void lock_for_snapshot_access  ();
     void unlock_for_snapshot_access();
@@ -41,6 +41,8 @@ private:
     ReplayerSnapshotPlayer(const Replayer*    in_replayer_ptr,
                            const IUISettings* in_ui_settings_ptr);
 
+    void play_vertex_batch(const ReplayerVertexBatchView& in_vertex_batch);
+
     /* Private vars */
     std::mutex m_mutex;
 
@@ -48,14 +50,8 @@ private:
     bool               m_snapshot_initialized;
     const IUISettings* m_ui_settings_ptr;
 
-    std::vector<std::array<uint32_t, 2> > m_ao_command_range_vec;
-    std::vector<std::array<uint32_t, 2> > m_shade_model_command_range_vec;
-
-    uint32_t m_n_first_glrotate_command;
-    uint32_t m_n_screen_space_geom_api_first_command;
-    uint32_t m_n_screen_space_geom_api_last_command;
-    uint32_t m_n_weapon_draw_first_command;
-    uint32_t m_n_weapon_draw_last_command;
+    ReplayerSegmentTable        m_analyzed_segment_table; // only used for snapshots which do not come with a segment table
+    const ReplayerSegmentTable* m_segment_table_ptr;
 
     const GLIDToTexturePropsMap* m_snapshot_gl_id_to_texture_props_map_ptr;
     const ReplayerSnapshot*      m_snapshot_ptr;
@@ -5,33 +5,332 @@
  #if !defined(REPLAYER_SNAPSHOTTER_H)
  #define REPLAYER_SNAPSHOTTER_H
 
+#include "replayer_capture_journal.h"
+#include "replayer_capture_writer.h"
+#include "replayer_frame_counter_exporter.h"
+#include "replayer_gl_functions.h"
+#include "replayer_matrix_state.h"
+#include "replayer_segment_analyzer.h"
 #include "replayer_types.h"
 #include "replayer_snapshot.h"
+#include "replayer_texture_ingester.h"
+#include "replayer_texture_store.h"
+#include <atomic>
 
 /* Forward decls */
 class                                        Replayer;
 class                                        ReplayerSnapshotter;
 typedef std::unique_ptr<ReplayerSnapshotter> ReplayerSnapshotterUniquePtr;
 
+/* A completed capture, as handed over by the snapshotter. */
+struct ReplayerCapturedSnapshot
+{
+    std::shared_ptr<const GLIDToTexturePropsMap> gl_id_to_texture_props_map_ptr;
+    ReplayerSnapshotUniquePtr                    snapshot_ptr;
+    GLContextStateUniquePtr                      start_gl_context_state_ptr;
+};
+typedef std::unique_ptr<ReplayerCapturedSnapshot> ReplayerCapturedSnapshotUniquePtr;
+
+/* Time the application's rendering thread spent completing captures, ie. handing a captured frame over at
+ * SwapBuffers() time. Follow-up work (loading the snapshot into the replayer's windows) is not included, as it runs on
+ * a separate thread. */
+struct ReplayerCaptureStallStats
+{
+    uint64_t last_stall_ns = 0;
+    uint64_t max_stall_ns  = 0;
+    uint32_t n_captures    = 0;
+};
 
 class ReplayerSnapshotter
 {
+    friend class ReplayerCallbackBenchmark; // feeds synthetic GL call streams to on_api_func_callback()
+
 public:
     /* Public funcs */
+
+    /* @param in_replayer_ptr is notified whenever a capture becomes available. May be null, in which case captures can
+     * only be polled for with pop_snapshot(). */
     static ReplayerSnapshotterUniquePtr create(const Replayer* in_replayer_ptr);
 
     ~ReplayerSnapshotter();
 
-    void cache_snapshot();
-    bool pop_snapshot  (GLContextStateUniquePtr*        out_start_gl_context_state_ptr_ptr,
-                        ReplayerSnapshotUniquePtr*      out_snapshot_ptr_ptr,
-                        GLIDToTexturePropsMapUniquePtr* out_gl_id_to_texture_props_map_ptr_ptr);
+    /* Requests a capture. Without the flight recorder, the frame which follows the request is recorded. With the
+     * flight recorder enabled, a frame which has already been recorded is handed over instead. @param in_n_frames_ago
+     * tells which one (0 = the most recent complete frame), clamped to the oldest frame still held by the ring. May be
+     * called from any thread. Takes effect at the next frame boundary. */
+    void cache_snapshot(const uint32_t& in_n_frames_ago = 0);
+
+    /* Takes the most recently completed capture, or returns null if there is none. Wait-free, and never holds up the
+     * application's rendering thread. May be called from any thread, but only one at a time. */
+    ReplayerCapturedSnapshotUniquePtr pop_snapshot();
+
+    /* Returns @param in_snapshot_ptr to the pool of recording buffers. May be called from any thread. */
+    void recycle_snapshot(ReplayerSnapshotUniquePtr in_snapshot_ptr);
+
+    ReplayerCaptureStallStats get_capture_stall_stats() const;
+
+    /* Controls whether glBegin() .. glEnd() runs are folded into packed vertex batches when recording. May be called from
+     * any thread. Takes effect at the next frame boundary. */
+    void set_vertex_batching_enabled(const bool& in_enabled);
+
+    /* Selects which GL calls make it into recorded frames. Calls left out by the profile cost little more than a
+     * counter bump, unless the snapshotter needs them to track state. Takes effect at the next frame boundary. */
+    void           set_capture_profile(const CaptureProfile& in_profile);
+    CaptureProfile get_capture_profile() const;
+
+    /* Controls whether recorded frames carry the CPU time the application spent before each command (see
+     * ReplayerSnapshot::get_segment_cpu_times() ). Costs two TSC reads per call while a frame is being recorded. Takes
+     * effect at the next frame boundary. */
+    void set_cpu_timing_enabled(const bool& in_enabled);
+
+    /* Requests a burst capture of @param in_n_frames consecutive frames, starting with the next one. Frames are streamed
+     * to @param in_filename by a background writer. Returns false if a burst capture is still in progress. */
+    bool request_burst_capture  (const std::string&          in_filename,
+                                 const uint32_t&             in_n_frames);
+    bool get_burst_capture_stats(ReplayerCaptureWriterStats* out_stats_ptr) const; // false if no burst has been captured
+
+    /* Enables journaling of recorded frames to @param in_filename, a crash-safe file of @param in_n_max_bytes which
+     * holds the most recent frames (see ReplayerCaptureJournal). Only frames which are recorded make it there, so this is
+     * meant to be used with the flight recorder. Pass an empty filename to disable. Takes effect at the next frame
+     * boundary. */
+    void set_capture_journal_config(const std::string&           in_filename,
+                                    const uint64_t&              in_n_max_bytes);
+    bool get_capture_journal_stats (ReplayerCaptureJournalStats* out_stats_ptr) const; // false if journaling is disabled
+    bool has_capture_journal_failed()                            const; // true if the last requested journal could not be created, in which case journaling stays disabled
+
+    /* Per-frame rendering counters are always gathered and streamed to FRAME_COUNTERS_FILENAME in the background. */
+    bool get_frame_counter_export_stats(ReplayerFrameCounterExporterStats* out_stats_ptr) const; // false if the file could not be created
+
+    /* Enables flight recorder mode, in which the last @param in_n_max_frames complete frames are kept around, as long
+     * as their command streams fit within @param in_max_n_bytes (at least one frame is always retained). Pass 0 frames
+     * to disable. Takes effect at the next frame boundary. */
+    void     set_flight_recorder_config   (const uint32_t& in_n_max_frames,
+                                           const uint64_t& in_max_n_bytes);
+    uint32_t get_n_flight_recorder_frames () const;
+    uint64_t get_n_flight_recorder_bytes  () const;
+
+    /* Controls how often GL errors raised by the application are checked for. @param in_n_calls_per_segment is only
+     * used by GLErrorValidationMode::PER_SEGMENT. Takes effect at the next frame boundary. */
+    void set_gl_error_validation_mode(const GLErrorValidationMode& in_mode,
+                                      const uint32_t&              in_n_calls_per_segment);
+
+    /* Checks the frame which is being rendered for GL errors when it completes, regardless of the validation mode. */
+    void request_gl_error_validation();
+
+    bool get_last_gl_error_report(GLErrorReport* out_report_ptr) const; // false if no error has been detected so far
+
+    /* Arms a capture whenever a completed frame meets any of the conditions in @param in_config. With the flight
+     * recorder enabled, the frame which met them is captured; otherwise, the one which follows it. Takes effect at the
+     * next frame boundary. */
+    void set_auto_capture_config     (const AutoCaptureConfig& in_config);
+    bool get_last_auto_capture_report(AutoCaptureReport*       out_report_ptr) const; // false if none has been armed so far
+
+    /* Holds mip data of all textures defined by the application. Only its stats getters may be used off the game thread. */
+    const ReplayerTextureStore* get_texture_store() const;
+
+    /* Returns the number of GL calls which went through the callback during the last completed frame. */
+    uint32_t get_n_api_calls_last_frame() const;
+
+    /* Time spent in the callback during the last frame which was only tracked (idle) and the last frame which was
+     * recorded. Estimated from a sample of timed calls. Comparing the two tells what recording a frame costs. */
+    uint64_t get_callback_time_ns_last_idle_frame     () const;
+    uint64_t get_callback_time_ns_last_recording_frame() const;
 
 private:
+    /* Private type defs */
+    typedef void (ReplayerSnapshotter::*PFNAPIFUNCHANDLERPROC)(const APIInterceptor::APIFunction&         in_api_func,
+                                                                const uint32_t&                            in_n_args,
+                                                                const APIInterceptor::APIFunctionArgument* in_args_ptr);
+
+    /* Maps each GL entrypoint to a handler, indexed with (api_func - APIFUNCTION_GL_FIRST). */
+    struct APIFuncHandlerTable
+    {
+        PFNAPIFUNCHANDLERPROC handler_func_ptr_vec[GLFunctionInfoTable::N_ENTRIES];
+    };
+
+    /* A single complete frame held by the flight recorder. Texture props maps are shared between consecutive frames
+     * for as long as no texture is modified. Maps are copy-on-write and mip data is refcounted, so even a new map
+     * copy only duplicates the props of the textures which have changed.
+     *
+     * Frames are deliberately kept uncompressed. They are built in place while recording and handed to the player and
+     * the analyzers as-is, which read the commands directly. Compressing them would add ReplayerBlockCodec's encode
+     * cost to every SwapBuffers() on the game thread (see ReplayerBlockCodecBenchmark), only to decode them again
+     * whenever a frame is looked at. Memory is bounded by the byte budget instead
+     * (Replayer::MAX_N_FLIGHT_RECORDER_BYTES, sized for a 32-bit process): the oldest frames are evicted once it is
+     * exceeded. Compression only pays off once frames leave memory, which is why it is applied when writing .q1snap
+     * files. */
+    struct FlightRecorderFrame
+    {
+        std::shared_ptr<const GLIDToTexturePropsMap> gl_id_to_texture_props_map_ptr;
+        uint64_t                                     n_bytes;
+        ReplayerSnapshotUniquePtr                    snapshot_ptr;
+        GLContextStateUniquePtr                      start_gl_context_state_ptr;
+
+        FlightRecorderFrame()
+            :n_bytes(0)
+        {
+            /* Stub */
+        }
+    };
+
+    enum class GLErrorBisectStage : uint8_t
+    {
+        LAST,   // check the upper half of the suspected range
+        MID,    // check the lower half of the suspected range
+        NONE,   // done for this frame
+        PREFIX, // flush errors raised by calls preceding the suspected range
+    };
+
+    /* Private consts */
+    static const char*    FRAME_COUNTERS_FILENAME;
+
+    static const uint32_t CALLBACK_TIMING_SAMPLING_PERIOD = 16; // must be a power of two
+    static const uint32_t MAX_N_GL_ERROR_BISECT_ATTEMPTS  = 8;
+    static const uint32_t MAX_N_GL_ERRORS_TO_DRAIN        = 8;
+    static const uint32_t MAX_N_POOLED_SNAPSHOTS          = 4;
+    static const uint32_t MAX_N_QUEUED_BURST_FRAMES       = 4;
+    static const uint32_t NO_SNAPSHOT_REQUESTED           = UINT32_MAX; // see m_n_snapshot_frames_ago_requested
+    static const uint32_t N_TSC_CALIBRATION_SAMPLES       = 1024;
+    static const uint32_t N_FRAME_COUNTER_RING_FRAMES     = 512;
+    static const uint32_t N_PREALLOCATED_SNAPSHOTS        = 2;
+    static const uint32_t N_PREALLOCATED_API_ARGS         = 192 * 1024;
+    static const uint32_t N_PREALLOCATED_API_COMMANDS     = 64  * 1024;
+    static const uint32_t N_PREALLOCATED_VERTICES         = 64  * 1024;
+
     /* Private funcs */
     ReplayerSnapshotter(const Replayer* in_replayer_ptr);
 
-    bool init();
+    ReplayerSnapshotUniquePtr acquire_snapshot();
+    bool                      init            ();
+    void                      on_swap_buffers ();
+    void                      start_recording ();
+
+    void check_gl_errors               (const uint32_t& in_n_call);
+    void report_gl_error               (const uint32_t& in_gl_error,
+                                        const uint32_t& in_n_first_call,
+                                        const uint32_t& in_n_last_call,
+                                        const uint32_t& in_n_call);
+    void schedule_next_gl_error_check  (const uint32_t& in_n_call);
+    void start_gl_error_validation_frame();
+
+    void                                         apply_burst_capture_request         ();
+    void                                         apply_capture_journal_config        ();
+    void                                         apply_capture_profile               ();
+    void                                         apply_snapshot_request              ();
+    void                                         check_auto_capture_triggers         ();
+    void                                         fold_frame_counters                 ();
+
+    uint32_t get_n_vertex_calls_this_frame() const
+    {
+        const auto& n_calls_per_func = m_frame_counters.n_api_calls_per_func;
+
+        return n_calls_per_func[APIInterceptor::APIFUNCTION_GL_GLVERTEX2F  - APIInterceptor::APIFUNCTION_GL_FIRST] +
+               n_calls_per_func[APIInterceptor::APIFUNCTION_GL_GLVERTEX3F  - APIInterceptor::APIFUNCTION_GL_FIRST] +
+               n_calls_per_func[APIInterceptor::APIFUNCTION_GL_GLVERTEX3FV - APIInterceptor::APIFUNCTION_GL_FIRST] +
+               n_calls_per_func[APIInterceptor::APIFUNCTION_GL_GLVERTEX4F  - APIInterceptor::APIFUNCTION_GL_FIRST];
+    }
+    std::shared_ptr<const GLIDToTexturePropsMap> get_shared_gl_id_to_texture_props_map();
+
+    void on_texture_ingested(const uint32_t&                              in_gl_texture_id,
+                             const uint32_t&                              in_n_mip,
+                             const std::shared_ptr<const PendingMipData>& in_pending_data_ptr);
+
+    void apply_flight_recorder_config      ();
+    void cache_frame                       (ReplayerSnapshotUniquePtr                    in_snapshot_ptr,
+                                            GLContextStateUniquePtr                      in_start_gl_context_state_ptr,
+                                            std::shared_ptr<const GLIDToTexturePropsMap> in_gl_id_to_texture_props_map_ptr);
+    void evict_oldest_flight_recorder_frame();
+    void pop_flight_recorder_frame         (const uint32_t&                in_n_frames_ago);
+    void push_flight_recorder_frame        ();
+
+    bool                      should_record_api_call        (const APIInterceptor::APIFunction& in_api_func) const;
+    void                      update_callback_overhead_stats();
+
+    static constexpr APIFuncHandlerTable create_api_func_handler_table();
+
+    // GL entrypoint handlers -->
+    void handle_alpha_func      (const APIInterceptor::APIFunction&         in_api_func,
+                                 const uint32_t&                            in_n_args,
+                                 const APIInterceptor::APIFunctionArgument* in_args_ptr);
+    void handle_begin           (const APIInterceptor::APIFunction&         in_api_func,
+                                 const uint32_t&                            in_n_args,
+                                 const APIInterceptor::APIFunctionArgument* in_args_ptr);
+    void handle_bind_texture    (const APIInterceptor::APIFunction&         in_api_func,
+                                 const uint32_t&                            in_n_args,
+                                 const APIInterceptor::APIFunctionArgument* in_args_ptr);
+    void handle_blend_func      (const APIInterceptor::APIFunction&         in_api_func,
+                                 const uint32_t&                            in_n_args,
+                                 const APIInterceptor::APIFunctionArgument* in_args_ptr);
+    void handle_clear_color     (const APIInterceptor::APIFunction&         in_api_func,
+                                 const uint32_t&                            in_n_args,
+                                 const APIInterceptor::APIFunctionArgument* in_args_ptr);
+    void handle_clear_depth     (const APIInterceptor::APIFunction&         in_api_func,
+                                 const uint32_t&                            in_n_args,
+                                 const APIInterceptor::APIFunctionArgument* in_args_ptr);
+    void handle_color_3ubv      (const APIInterceptor::APIFunction&         in_api_func,
+                                 const uint32_t&                            in_n_args,
+                                 const APIInterceptor::APIFunctionArgument* in_args_ptr);
+    void handle_color_4fv       (const APIInterceptor::APIFunction&         in_api_func,
+                                 const uint32_t&                            in_n_args,
+                                 const APIInterceptor::APIFunctionArgument* in_args_ptr);
+    void handle_cull_face       (const APIInterceptor::APIFunction&         in_api_func,
+                                 const uint32_t&                            in_n_args,
+                                 const APIInterceptor::APIFunctionArgument* in_args_ptr);
+    void handle_delete_textures (const APIInterceptor::APIFunction&         in_api_func,
+                                 const uint32_t&                            in_n_args,
+                                 const APIInterceptor::APIFunctionArgument* in_args_ptr);
+    void handle_depth_func      (const APIInterceptor::APIFunction&         in_api_func,
+                                 const uint32_t&                            in_n_args,
+                                 const APIInterceptor::APIFunctionArgument* in_args_ptr);
+    void handle_depth_mask      (const APIInterceptor::APIFunction&         in_api_func,
+                                 const uint32_t&                            in_n_args,
+                                 const APIInterceptor::APIFunctionArgument* in_args_ptr);
+    void handle_depth_range     (const APIInterceptor::APIFunction&         in_api_func,
+                                 const uint32_t&                            in_n_args,
+                                 const APIInterceptor::APIFunctionArgument* in_args_ptr);
+    void handle_draw_buffer     (const APIInterceptor::APIFunction&         in_api_func,
+                                 const uint32_t&                            in_n_args,
+                                 const APIInterceptor::APIFunctionArgument* in_args_ptr);
+    void handle_enable_disable  (const APIInterceptor::APIFunction&         in_api_func,
+                                 const uint32_t&                            in_n_args,
+                                 const APIInterceptor::APIFunctionArgument* in_args_ptr);
+    void handle_end             (const APIInterceptor::APIFunction&         in_api_func,
+                                 const uint32_t&                            in_n_args,
+                                 const APIInterceptor::APIFunctionArgument* in_args_ptr);
+    void handle_front_face      (const APIInterceptor::APIFunction&         in_api_func,
+                                 const uint32_t&                            in_n_args,
+                                 const APIInterceptor::APIFunctionArgument* in_args_ptr);
+    void handle_matrix_mode     (const APIInterceptor::APIFunction&         in_api_func,
+                                 const uint32_t&                            in_n_args,
+                                 const APIInterceptor::APIFunctionArgument* in_args_ptr);
+    void handle_matrix_op       (const APIInterceptor::APIFunction&         in_api_func,
+                                 const uint32_t&                            in_n_args,
+                                 const APIInterceptor::APIFunctionArgument* in_args_ptr);
+    void handle_record_only     (const APIInterceptor::APIFunction&         in_api_func,
+                                 const uint32_t&                            in_n_args,
+                                 const APIInterceptor::APIFunctionArgument* in_args_ptr);
+    void handle_shade_model     (const APIInterceptor::APIFunction&         in_api_func,
+                                 const uint32_t&                            in_n_args,
+                                 const APIInterceptor::APIFunctionArgument* in_args_ptr);
+    void handle_tex_env_f       (const APIInterceptor::APIFunction&         in_api_func,
+                                 const uint32_t&                            in_n_args,
+                                 const APIInterceptor::APIFunctionArgument* in_args_ptr);
+    void handle_tex_image_2d    (const APIInterceptor::APIFunction&         in_api_func,
+                                 const uint32_t&                            in_n_args,
+                                 const APIInterceptor::APIFunctionArgument* in_args_ptr);
+    void handle_tex_parameter_f (const APIInterceptor::APIFunction&         in_api_func,
+                                 const uint32_t&                            in_n_args,
+                                 const APIInterceptor::APIFunctionArgument* in_args_ptr);
+    void handle_tex_sub_image_2d(const APIInterceptor::APIFunction&         in_api_func,
+                                 const uint32_t&                            in_n_args,
+                                 const APIInterceptor::APIFunctionArgument* in_args_ptr);
+    void handle_vertex_3fv      (const APIInterceptor::APIFunction&         in_api_func,
+                                 const uint32_t&                            in_n_args,
+                                 const APIInterceptor::APIFunctionArgument* in_args_ptr);
+    void handle_viewport        (const APIInterceptor::APIFunction&         in_api_func,
+                                 const uint32_t&                            in_n_args,
+                                 const APIInterceptor::APIFunctionArgument* in_args_ptr);
+    // <--
 
     static void on_api_func_callback(APIInterceptor::APIFunction                in_api_func,
                                      uint32_t                                   in_n_args,
@@ -42,19 +341,117 @@ private:
     const Replayer* m_replayer_ptr;
 
     GLContextStateUniquePtr                             m_current_context_state_ptr;
+    ReplayerMatrixState                                 m_current_matrix_state; // saves us glGetDoublev() calls
     GLIDToTexturePropsMapUniquePtr                      m_gl_id_to_texture_props_map_ptr;
+    ReplayerSegmentAnalyzerUniquePtr                    m_segment_analyzer_ptr; // runs alongside recording
+    ReplayerTextureIngesterUniquePtr                    m_texture_ingester_ptr;
+    ReplayerTextureStoreUniquePtr                       m_texture_store_ptr;
     GLContextStateUniquePtr                             m_start_gl_context_state_ptr;
     std::unordered_map<uint32_t /* GLenum */, uint32_t> m_texture_target_to_bound_texture_id_map;
 
-    GLIDToTexturePropsMapUniquePtr m_cached_gl_id_to_texture_props_map_ptr;
-    ReplayerSnapshotUniquePtr      m_cached_snapshot_ptr;
-    GLContextStateUniquePtr        m_cached_start_gl_context_state_ptr;
+    std::atomic<ReplayerCapturedSnapshot*> m_published_snapshot_ptr; // owned; see cache_frame() and pop_snapshot()
+
+    std::atomic<uint64_t> m_last_capture_stall_ns;
+    std::atomic<uint64_t> m_max_capture_stall_ns;
+    std::atomic<uint32_t> m_n_captures;
 
     bool                      m_is_glbegin_active;
-    std::mutex                m_mutex;
+    bool                      m_is_recording;       // only set for the frame that follows the one where capture was armed
+    mutable std::mutex        m_mutex;
     ReplayerSnapshotUniquePtr m_recording_snapshot_ptr;
-    bool                      m_snapshot_requested;
+    bool                      m_snapshot_requested; // set for captures which are on their way, incl. automatic ones
+    uint32_t                  m_n_requested_frames_ago;
+    std::atomic<uint32_t>     m_n_snapshot_frames_ago_requested; // set by the UI, picked up at the next frame boundary
+
+    ReplayerCaptureWriterUniquePtr m_burst_capture_writer_ptr;
+    std::string                    m_burst_capture_filename_requested;
+    uint32_t                       m_n_burst_frames_left;
+    uint32_t                       m_n_burst_frames_requested;
+    uint32_t                       m_n_next_burst_frame;
+
+    std::shared_ptr<const GLIDToTexturePropsMap> m_shared_gl_id_to_texture_props_map_ptr; // see get_shared_gl_id_to_texture_props_map()
+    bool                                         m_is_texture_props_map_dirty;
+    std::vector<std::array<uint32_t, 2> >        m_dirty_mip_vec;           // (GL texture ID, mip) pairs whose dirty rect is set
+    uint64_t                                     m_n_last_mip_data_version; // see MipProps::data_version
+
+    std::vector<FlightRecorderFrame>             m_flight_recorder_frame_vec; // ring, sized to the max number of frames
+    std::atomic<uint64_t>                        m_max_n_flight_recorder_bytes;
+    std::atomic<uint32_t>                        m_n_max_flight_recorder_frames_requested;
+    std::atomic<uint64_t>                        m_n_flight_recorder_bytes;
+    std::atomic<uint32_t>                        m_n_flight_recorder_frames;
+    uint32_t                                     m_n_first_flight_recorder_frame;
+    GLContextStateUniquePtr                      m_spare_gl_context_state_ptr; // recycled from evicted frames
+
+    bool                                   m_is_cpu_timing_active;  // set for frames being recorded with CPU timing enabled
+    std::atomic<bool>                      m_is_cpu_timing_enabled;
+    std::atomic<bool>                      m_is_vertex_batching_enabled;
+    uint64_t                               m_last_callback_exit_tsc;
+    uint32_t                               m_n_max_api_args_per_frame;
+    uint32_t                               m_n_max_api_commands_per_frame;
+    uint32_t                               m_n_max_vertices_per_frame;
+    std::mutex                             m_snapshot_pool_mutex;
+    std::vector<ReplayerSnapshotUniquePtr> m_snapshot_pool_vec;
+
+    std::atomic<uint32_t> m_n_api_calls_last_frame;
+    uint32_t              m_n_api_calls_this_frame;
+
+    uint32_t                    m_n_frame;
+    APIInterceptor::APIFunction m_previous_api_func;
+
+    ReplayerCaptureJournalUniquePtr m_capture_journal_ptr;                   // guarded by m_mutex when accessed off the game thread
+    std::atomic<bool>               m_capture_journal_config_dirty;
+    std::string                     m_capture_journal_filename_requested;    // guarded by m_mutex
+    uint64_t                        m_capture_journal_n_max_bytes_requested; // guarded by m_mutex
+    bool                            m_has_capture_journal_failed;            // guarded by m_mutex
+
+    CaptureProfile              m_capture_profile;
+    std::atomic<CaptureProfile> m_capture_profile_requested;
+    bool                        m_is_api_func_recorded_vec[GLFunctionInfoTable::N_ENTRIES]; // indexed with (api_func - APIFUNCTION_GL_FIRST)
+
+    GLErrorValidationMode              m_gl_error_validation_mode;
+    std::atomic<GLErrorValidationMode> m_gl_error_validation_mode_requested;
+    std::atomic<bool>                  m_gl_error_validation_requested;
+    GLErrorReport                      m_last_gl_error_report; // guarded by m_mutex
+    bool                               m_has_gl_error_report;
+    uint32_t                           m_n_calls_per_gl_error_segment;
+    std::atomic<uint32_t>              m_n_calls_per_gl_error_segment_requested;
+    uint32_t                           m_n_first_unchecked_call;
+    uint32_t                           m_n_next_gl_error_check_call; // index of the call whose callback checks for errors next
+
+    bool                                     m_is_bisecting_gl_error;
+    std::vector<APIInterceptor::APIFunction> m_gl_error_bisect_api_func_vec; // indexed with call index, only set for this frame's calls within the bisected range
+    GLErrorBisectStage                       m_gl_error_bisect_stage;
+    bool                                     m_gl_error_bisect_mid_failed;
+    uint32_t                                 m_n_gl_error_bisect_attempts_left;
+    uint32_t                                 m_n_gl_error_bisect_first_call;
+    uint32_t                                 m_n_gl_error_bisect_last_call;
+    uint32_t                                 m_n_gl_error_bisect_mid_call;   // last call covered by this frame's MID check
+    uint32_t                                 m_n_gl_error_bisect_split_call; // last call the MID check is meant to cover
+
+    AutoCaptureConfig m_auto_capture_config;
+    AutoCaptureConfig m_auto_capture_config_requested; // guarded by m_mutex
+    std::atomic<bool> m_auto_capture_config_dirty;
+    AutoCaptureReport m_last_auto_capture_report;      // guarded by m_mutex
+    int64_t           m_last_auto_capture_qpc;
+    bool              m_is_front_buffer_used_this_frame;
+    bool              m_is_level_loading;
+
+    FrameCounters                         m_frame_counters;                  // frame being rendered
+    ReplayerFrameCounterExporterUniquePtr m_frame_counter_exporter_ptr;
+    uint32_t                              m_current_primitive_type;
+    uint32_t                              m_n_vertex_calls_at_glbegin;
+
+    std::atomic<uint64_t> m_callback_time_ns_last_idle_frame;
+    std::atomic<uint64_t> m_callback_time_ns_last_recording_frame;
+    int64_t               m_last_frame_qpc;
+    uint64_t              m_last_frame_time_us;
+    int64_t               m_qpc_frequency;
+    uint64_t              m_last_frame_tsc;
+    uint64_t              m_n_sampled_callback_tsc_ticks_this_frame;
+    double                m_n_tsc_ticks_per_second;
+    double                m_n_tsc_ticks_per_timestamp;
 
+    static const APIFuncHandlerTable m_api_func_handler_table;
 };
 
 #endif /* REPLAYER_SNAPSHOTTER_H */
\ No newline at end of file
@@ -0,0 +1,161 @@
+/* API Interceptor (c) 2024 Dominik Witczak
+ *
+ * This code is licensed under MIT license (see LICENSE.txt for details)
+ */
+#if !defined(REPLAYER_TEXTURE_INGESTER_H)
+#define REPLAYER_TEXTURE_INGESTER_H
+
+#include "replayer_texture_store.h"
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+
+/* Forward decls */
+class                                            ReplayerTextureIngester;
+typedef std::unique_ptr<ReplayerTextureIngester> ReplayerTextureIngesterUniquePtr;
+
+/* Moves texture store work off the game thread.
+ *
+ * The game thread copies each upload into a staging ring, once, and gets a PendingMipData instance back. A worker
+ * thread picks uploads up in submission order, hands them over to the texture store (hashing + deduplication) and
+ * fills the pending data in. Whoever needs the data before that happens waits for it (see
+ * MipProps::get_data_u8_vec_ptr()), so the game thread never has to. It collects finished uploads whenever it sees
+ * fit, so that the texture props map can refer to the blobs directly.
+ *
+ * Sub-image updates are batched per mip until the end of the frame (see flush()), so that a mip which is updated
+ * several times a frame (lightmaps) is only copied once.
+ *
+ * The staging ring and the job slots are single-producer / single-consumer and lock-free. The mutex is only there so
+ * that an idle worker can sleep.
+ *
+ * NOTE: All public functions must be called from the same (game) thread. Once an ingester has been created, its
+ *       texture store must not be used by anyone else, apart from the store's stats getters.
+ */
+class ReplayerTextureIngester
+{
+public:
+    /* Public type defs */
+    typedef std::function<void(const uint32_t&                              in_gl_texture_id,
+                               const uint32_t&                              in_n_mip,
+                               const std::shared_ptr<const PendingMipData>& in_pending_data_ptr)> CompletionFunc;
+
+    /* Public funcs */
+    /* @param in_completion_func is called from collect() and submit() for each ingested upload, in submission order. */
+    static ReplayerTextureIngesterUniquePtr create(ReplayerTextureStore* in_texture_store_ptr,
+                                                   const CompletionFunc& in_completion_func);
+
+    ~ReplayerTextureIngester();
+
+    /* Hands over uploads which have been ingested since the last call. Never waits. */
+    void collect();
+
+    /* Schedules sub-image updates batched since the last call for ingestion. To be called once per frame.
+     *
+     * NOTE: Pending data returned by submit_sub_image() is not going to become ready before this is called. */
+    void flush();
+
+    /* Copies @param in_data_ptr and schedules it for ingestion. */
+    std::shared_ptr<const PendingMipData> submit(const void*     in_data_ptr,
+                                                 const uint32_t& in_n_bytes,
+                                                 const uint32_t& in_gl_texture_id,
+                                                 const uint32_t& in_n_mip);
+
+    /* Copies @param in_data_ptr, which holds a tightly packed sub-rectangle of a mip, and adds it to the mip's batch.
+     * The resulting blob is a copy of the mip's current contents (@param in_base_mip_props) with all of the batch's
+     * sub-rectangles patched in. Only the hash blocks overlapped by the sub-rectangles are re-hashed.
+     *
+     * A sub-rectangle which overlaps one already in the batch starts a new batch, so that each sub-rectangle can still
+     * be read back from the blob returned for it.
+     *
+     * @param in_rect_x1y1x2y2 Sub-rectangle to update. x2 and y2 are exclusive. */
+    std::shared_ptr<const PendingMipData> submit_sub_image(const void*                    in_data_ptr,
+                                                           const MipProps&                in_base_mip_props,
+                                                           const std::array<uint32_t, 4>& in_rect_x1y1x2y2,
+                                                           const uint32_t&                in_n_components,
+                                                           const uint32_t&                in_gl_texture_id,
+                                                           const uint32_t&                in_n_mip);
+
+    bool has_uploads_in_flight() const
+    {
+        return (m_n_last_collected_ticket != m_n_last_submitted_ticket ||
+                !m_open_batch_ptr_vec.empty() );
+    }
+
+private:
+    /* Private consts */
+    static const uint32_t N_JOB_SLOTS          = 4096;
+    static const uint64_t STAGING_RING_N_BYTES = 32ull << 20;
+
+    /* Private type defs */
+    struct SubImageBatch
+    {
+        uint64_t                              base_data_hash;
+        U8VecSharedPtr                        base_data_u8_vec_ptr;
+        std::shared_ptr<const PendingMipData> base_pending_data_ptr; // set instead of the above if the base is still being ingested
+        uint32_t                              gl_texture_id;
+        uint32_t                              n_components;
+        uint32_t                              n_mip;
+        uint32_t                              n_row_pixels;
+        std::shared_ptr<PendingMipData>       pending_data_ptr;
+
+        std::vector<uint8_t>                  data_u8_vec;   // sub-rectangles' texels, tightly packed, in rect_vec order
+        std::vector<std::array<uint32_t, 4> > rect_vec;
+    };
+
+    typedef std::unique_ptr<SubImageBatch> SubImageBatchUniquePtr;
+
+    struct Job
+    {
+        uint32_t gl_texture_id;
+        uint32_t n_bytes;
+        uint32_t n_mip;
+        uint64_t n_ring_end_byte;   // staging ring may be released up to here once the job is done
+        uint64_t n_ring_start_byte;
+
+        std::unique_ptr<std::vector<uint8_t> > heap_data_ptr; // only used if the staging ring had no room for the data
+        std::shared_ptr<PendingMipData>        pending_data_ptr;
+        SubImageBatchUniquePtr                 sub_image_batch_ptr; // sub-image uploads only. Nothing is staged for these.
+    };
+
+    /* Private funcs */
+    ReplayerTextureIngester(ReplayerTextureStore* in_texture_store_ptr,
+                            const CompletionFunc& in_completion_func);
+
+    Job& acquire_job     (const uint64_t& in_n_ticket,
+                          const uint32_t& in_gl_texture_id,
+                          const uint32_t& in_n_mip);
+    void collect_up_to   (const uint64_t& in_n_last_ticket);
+    void execute         ();
+    void ingest_sub_image(SubImageBatch&  in_batch);
+    bool init            ();
+    void kick            (const uint64_t& in_n_ticket);
+    void stage           (Job&            in_job,
+                          const void*     in_data_ptr,
+                          const uint32_t& in_n_bytes);
+
+    /* Private vars */
+    CompletionFunc        m_completion_func;
+    std::vector<Job>      m_job_vec;           // indexed with (ticket % N_JOB_SLOTS), tickets are assigned in submission order
+    std::vector<uint8_t>  m_staging_ring_u8_vec;
+    ReplayerTextureStore* m_texture_store_ptr;
+
+    std::atomic<uint64_t> m_n_last_completed_ticket;   // written by the worker
+    std::atomic<uint64_t> m_n_staging_ring_read_byte;  // written by the worker
+    std::atomic<uint64_t> m_n_last_submitted_ticket;   // written by the game thread
+    uint64_t              m_n_last_collected_ticket;
+    uint64_t              m_n_staging_ring_write_byte;
+
+    std::vector<SubImageBatchUniquePtr> m_free_batch_ptr_vec; // recycled, so that batches keep their capacity
+    std::vector<SubImageBatchUniquePtr> m_open_batch_ptr_vec; // in submission order
+    std::vector<bool>                   m_is_block_dirty_vec; // only used by the worker
+
+    std::condition_variable m_job_submitted_cv;
+    std::atomic<bool>       m_is_worker_idle;
+    std::mutex              m_mutex;
+
+    std::thread   m_worker_thread;
+    volatile bool m_worker_thread_must_die;
+};
+
+#endif /* REPLAYER_TEXTURE_INGESTER_H */
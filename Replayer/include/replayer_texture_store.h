@@ -0,0 +1,82 @@
+/* API Interceptor (c) 2024 Dominik Witczak
+ *
+ * This code is licensed under MIT license (see LICENSE.txt for details)
+ */
+#if !defined(REPLAYER_TEXTURE_STORE_H)
+#define REPLAYER_TEXTURE_STORE_H
+
+#include "replayer_types.h"
+#include <atomic>
+
+/* Forward decls */
+class                                         ReplayerTextureStore;
+typedef std::unique_ptr<ReplayerTextureStore> ReplayerTextureStoreUniquePtr;
+
+/* Content-addressed store for texture mip data.
+ *
+ * Blobs are immutable and refcounted. Storing data which is identical to a blob that is still alive returns that blob
+ * instead of a new copy, so textures which get uploaded more than once (eg. on map reloads, or lightmaps which keep
+ * flipping between the same states) are only held in memory once, no matter how many snapshots refer to them.
+ *
+ * The store itself only keeps weak references. A blob is released as soon as the last texture props map referring to
+ * it goes away.
+ *
+ * NOTE: store() must only be called from one thread at a time. Returned blobs may be used from any thread.
+ */
+class ReplayerTextureStore
+{
+public:
+    /* Public consts */
+    static const uint32_t HASH_BLOCK_SIZE = 256;
+
+    /* Public funcs */
+    static ReplayerTextureStoreUniquePtr create();
+
+    /* Returns a blob holding a copy of @param in_data_ptr. @param out_opt_hash_ptr, if not null, receives the
+     * content hash of the data. */
+    U8VecSharedPtr store(const void*     in_data_ptr,
+                         const uint32_t& in_n_bytes,
+                         uint64_t*       out_opt_hash_ptr = nullptr);
+
+    /* Same as above, but takes over @param in_data_u8_vec instead of copying it. @param in_hash must be the content
+     * hash of the data, eg. as updated with hash_block() after patching a copy of an existing blob. */
+    U8VecSharedPtr store(std::vector<uint8_t>&& in_data_u8_vec,
+                         const uint64_t&        in_hash);
+
+    uint64_t get_n_bytes_deduplicated() const; // total size of store() calls satisfied by an existing blob
+    uint32_t get_n_blobs_tracked     () const; // may include blobs which have been released since the last sweep
+
+    /* Content hash of a buffer is the sum of hashes of its HASH_BLOCK_SIZE-sized blocks, so that it can be updated
+     * after a partial modification by only looking at the blocks which have changed:
+     *
+     *     new_hash = old_hash - hash_block(old block n) + hash_block(new block n), for each modified block n.
+     *
+     * The last block of a buffer may be shorter than HASH_BLOCK_SIZE. */
+    static uint64_t hash      (const void*     in_data_ptr,
+                               const uint32_t& in_n_bytes);
+    static uint64_t hash_block(const void*     in_block_data_ptr,
+                               const uint32_t& in_n_block_bytes,
+                               const uint32_t& in_n_block);
+
+private:
+    /* Private type defs */
+    typedef std::weak_ptr<const std::vector<uint8_t> > U8VecWeakPtr;
+
+    /* Private funcs */
+    ReplayerTextureStore();
+
+    U8VecSharedPtr find  (const uint64_t&        in_hash,
+                          const void*            in_data_ptr,
+                          const uint32_t&        in_n_bytes);
+    void           insert(const uint64_t&        in_hash,
+                          const U8VecSharedPtr&  in_blob_ptr);
+    void           sweep ();
+
+    /* Private vars */
+    std::unordered_map<uint64_t, std::vector<U8VecWeakPtr> > m_hash_to_blob_vec_map; // vector, in case of collisions
+    std::atomic<uint32_t>                                    m_n_blobs;
+    uint32_t                                                 m_n_blobs_at_last_sweep;
+    std::atomic<uint64_t>                                    m_n_bytes_deduplicated;
+};
+
+#endif /* REPLAYER_TEXTURE_STORE_H */
@@ -6,6 +6,8 @@
  #define REPLAYER_TYPES_H
 
 #include <array>
+#include <atomic>
+#include <bitset>
 #include <cassert>
 #include <memory>
 #include <thread>
@@ -32,6 +34,191 @@ struct GLContextTextureState
     GLContextTextureState();
 };
 
+/* Persistent table, keyed by GL object ID.
+ *
+ * Implemented as a fixed-depth radix tree whose nodes are shared between copies of the table. Copying the table is
+ * O(1). A write only clones the nodes on the path to the modified entry which are still shared with other copies, so
+ * the cost of keeping older copies around (eg. snapshot start states) does not depend on how many objects exist.
+ *
+ * NOTE: A table instance must not be accessed from more than one thread at a time. Separate copies may be. */
+template<typename EntryType>
+class GLIDTable
+{
+public:
+    /* Public funcs */
+    GLIDTable()
+        :m_n_entries(0)
+    {
+        /* Stub */
+    }
+
+    void             clear        ();
+    void             erase        (const uint32_t& in_gl_id);
+    const EntryType* find         (const uint32_t& in_gl_id) const;
+    EntryType*       get_for_write(const uint32_t& in_gl_id); // creates a default entry if needed
+    uint32_t         size         ()                         const { return m_n_entries; }
+
+    /* Calls @param in_func for each entry in the table, in ascending ID order. */
+    template<typename FuncType>
+    void for_each(FuncType in_func) const
+    {
+        if (m_root_node_ptr == nullptr)
+        {
+            return;
+        }
+
+        for (uint32_t n_l1 = 0; n_l1 < FANOUT; ++n_l1)
+        {
+            const auto l1_node_ptr = m_root_node_ptr->child_node_ptr_vec[n_l1].get();
+
+            if (l1_node_ptr == nullptr)
+            {
+                continue;
+            }
+
+            for (uint32_t n_l2 = 0; n_l2 < FANOUT; ++n_l2)
+            {
+                const auto l2_node_ptr = l1_node_ptr->child_node_ptr_vec[n_l2].get();
+
+                if (l2_node_ptr == nullptr)
+                {
+                    continue;
+                }
+
+                for (uint32_t n_leaf = 0; n_leaf < FANOUT; ++n_leaf)
+                {
+                    const auto leaf_node_ptr = l2_node_ptr->child_node_ptr_vec[n_leaf].get();
+
+                    if (leaf_node_ptr == nullptr)
+                    {
+                        continue;
+                    }
+
+                    for (uint32_t n_slot = 0; n_slot < FANOUT; ++n_slot)
+                    {
+                        if (leaf_node_ptr->is_slot_used_bitset[n_slot])
+                        {
+                            in_func( (n_l1 << 24) | (n_l2 << 16) | (n_leaf << 8) | n_slot,
+                                    leaf_node_ptr->entry_vec[n_slot]);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+private:
+    /* Private consts */
+    static const uint32_t FANOUT = 256; // one level per byte of the ID
+
+    /* Private type defs */
+    struct LeafNode
+    {
+        std::array<EntryType, FANOUT> entry_vec;
+        std::bitset<FANOUT>           is_slot_used_bitset;
+    };
+
+    template<typename ChildNodeType>
+    struct InnerNode
+    {
+        std::array<std::shared_ptr<ChildNodeType>, FANOUT> child_node_ptr_vec;
+    };
+
+    typedef InnerNode<LeafNode>    L2Node;
+    typedef InnerNode<L2Node>      L1Node;
+    typedef InnerNode<L1Node>      RootNode;
+
+    /* Private funcs */
+    template<typename NodeType>
+    static NodeType* get_writable_node(std::shared_ptr<NodeType>* inout_node_ptr_ptr)
+    {
+        /* Other copies of the table may still refer to the node, in which case we need our own. */
+        if (*inout_node_ptr_ptr == nullptr)
+        {
+            inout_node_ptr_ptr->reset(new NodeType() );
+        }
+        else
+        if (inout_node_ptr_ptr->use_count() > 1)
+        {
+            inout_node_ptr_ptr->reset(new NodeType(**inout_node_ptr_ptr) );
+        }
+
+        return inout_node_ptr_ptr->get();
+    }
+
+    /* Private vars */
+    uint32_t                  m_n_entries;
+    std::shared_ptr<RootNode> m_root_node_ptr;
+};
+
+template<typename EntryType>
+void GLIDTable<EntryType>::clear()
+{
+    m_n_entries = 0;
+
+    m_root_node_ptr.reset();
+}
+
+template<typename EntryType>
+void GLIDTable<EntryType>::erase(const uint32_t& in_gl_id)
+{
+    if (find(in_gl_id) == nullptr)
+    {
+        return;
+    }
+
+    auto root_node_ptr = get_writable_node(&m_root_node_ptr);
+    auto l1_node_ptr   = get_writable_node(&root_node_ptr->child_node_ptr_vec[ in_gl_id >> 24]);
+    auto l2_node_ptr   = get_writable_node(&l1_node_ptr->child_node_ptr_vec  [(in_gl_id >> 16) & 0xFF]);
+    auto leaf_node_ptr = get_writable_node(&l2_node_ptr->child_node_ptr_vec  [(in_gl_id >> 8)  & 0xFF]);
+
+    leaf_node_ptr->is_slot_used_bitset[in_gl_id & 0xFF] = false;
+    leaf_node_ptr->entry_vec          [in_gl_id & 0xFF] = EntryType();
+
+    assert(m_n_entries > 0);
+    m_n_entries--;
+}
+
+template<typename EntryType>
+const EntryType* GLIDTable<EntryType>::find(const uint32_t& in_gl_id) const
+{
+    const L1Node*   l1_node_ptr   = (m_root_node_ptr != nullptr) ? m_root_node_ptr->child_node_ptr_vec[in_gl_id >> 24].get()
+                                                                 : nullptr;
+    const L2Node*   l2_node_ptr   = (l1_node_ptr     != nullptr) ? l1_node_ptr->child_node_ptr_vec[(in_gl_id >> 16) & 0xFF].get()
+                                                                 : nullptr;
+    const LeafNode* leaf_node_ptr = (l2_node_ptr     != nullptr) ? l2_node_ptr->child_node_ptr_vec[(in_gl_id >> 8) & 0xFF].get()
+                                                                 : nullptr;
+
+    if ( leaf_node_ptr == nullptr ||
+        !leaf_node_ptr->is_slot_used_bitset[in_gl_id & 0xFF])
+    {
+        return nullptr;
+    }
+
+    return &leaf_node_ptr->entry_vec[in_gl_id & 0xFF];
+}
+
+template<typename EntryType>
+EntryType* GLIDTable<EntryType>::get_for_write(const uint32_t& in_gl_id)
+{
+    auto root_node_ptr = get_writable_node(&m_root_node_ptr);
+    auto l1_node_ptr   = get_writable_node(&root_node_ptr->child_node_ptr_vec[ in_gl_id >> 24]);
+    auto l2_node_ptr   = get_writable_node(&l1_node_ptr->child_node_ptr_vec  [(in_gl_id >> 16) & 0xFF]);
+    auto leaf_node_ptr = get_writable_node(&l2_node_ptr->child_node_ptr_vec  [(in_gl_id >> 8)  & 0xFF]);
+
+    if (!leaf_node_ptr->is_slot_used_bitset[in_gl_id & 0xFF])
+    {
+        leaf_node_ptr->is_slot_used_bitset[in_gl_id & 0xFF] = true;
+
+        m_n_entries++;
+    }
+
+    return &leaf_node_ptr->entry_vec[in_gl_id & 0xFF];
+}
+
+/* Texture state table, keyed by GL texture ID. */
+typedef GLIDTable<GLContextTextureState> GLContextTextureStateTable;
+
 struct GLContextState
 {
     bool alpha_test_enabled   = false;
@@ -63,8 +250,10 @@ struct GLContextState
     double   modelview_matrix [16];
     double   projection_matrix[16];
 
-    uint32_t                                            bound_2d_texture_gl_id;
-    std::unordered_map<uint32_t, GLContextTextureState> gl_texture_id_to_texture_state_map;
+    /* NOTE: Everything above is plain data, so copying the state costs the same no matter how many textures the
+     *       application has created. */
+    uint32_t                   bound_2d_texture_gl_id;
+    GLContextTextureStateTable gl_texture_id_to_texture_state_map;
 
     GLContextState(const uint32_t& in_q1_window_width,
                    const uint32_t& in_q1_window_height);
@@ -88,6 +277,74 @@ public:
 
 };
 
+/* Tells how often the snapshotter checks for GL errors raised by the application. Whenever an error shows up, the
+ * range of calls it may have come from is narrowed down over the following frames. */
+enum class GLErrorValidationMode : uint8_t
+{
+    DISABLED,
+    ON_DEMAND,   // only when explicitly requested
+    PER_FRAME,
+    PER_SEGMENT, // every N calls
+    PER_CALL,    // debug mode, costs a driver round-trip per call
+
+    UNKNOWN
+};
+
+/* Tells which GL calls the snapshotter records. Calls which are left out are still tracked, so that the context
+ * state, texture objects and frame counters stay up to date, but do not make it into recorded frames. Useful for
+ * long-running burst or flight recorder captures which only need a subset of the command stream. */
+enum class CaptureProfile : uint8_t
+{
+    FULL,                   // everything
+    DRAWS_WITHOUT_VERTICES, // everything but the calls issued in-between glBegin() and glEnd()
+    STATE_ONLY,             // state setters, matrix ops and texture binds
+    TEXTURES_ONLY,          // texture binds, parameters and uploads
+
+    UNKNOWN
+};
+
+/* Describes the most recent GL error detected by the snapshotter. Call indices are relative to the start of the frame. */
+struct GLErrorReport
+{
+    APIInterceptor::APIFunction api_func     = APIInterceptor::APIFUNCTION_GL_FIRST; // only valid if is_exact is true
+    uint32_t                    gl_error     = 0;                                    // GLenum
+    bool                        is_exact     = false;                                // true if the offending call has been pinpointed
+    uint32_t                    n_first_call = 0;
+    uint32_t                    n_frame      = 0;
+    uint32_t                    n_last_call  = 0;
+};
+
+/* Conditions under which the snapshotter arms a capture on its own. Thresholds set to 0 are disabled. */
+struct AutoCaptureConfig
+{
+    float    max_frame_time_ms            = 0.0f;
+    uint32_t max_n_api_calls              = 0;
+    uint64_t max_n_texture_upload_bytes   = 0;
+    bool     should_trigger_on_level_load = false; // first frame drawn after the loading plaque goes away
+    uint32_t cooldown_ms                  = 0;     // minimum time between two automatic captures
+};
+
+enum class AutoCaptureTrigger : uint8_t
+{
+    FRAME_TIME,
+    LEVEL_LOAD,
+    N_API_CALLS,
+    N_TEXTURE_UPLOAD_BYTES,
+
+    UNKNOWN
+};
+
+/* Describes the most recent capture armed by the snapshotter on its own, and the frame which caused it. */
+struct AutoCaptureReport
+{
+    uint32_t           n_api_calls            = 0;
+    uint32_t           n_captures             = 0; // automatic captures armed so far
+    uint32_t           n_frame                = 0;
+    uint64_t           n_texture_upload_bytes = 0;
+    float              frame_time_ms          = 0.0f;
+    AutoCaptureTrigger trigger                = AutoCaptureTrigger::UNKNOWN;
+};
+
 enum class TextureType : uint8_t
 {
     _1D,
@@ -97,14 +354,52 @@ enum class TextureType : uint8_t
     UNKNOWN
 };
 
+/* Immutable mip data blob. See ReplayerTextureStore. */
+typedef std::shared_ptr<const std::vector<uint8_t> > U8VecSharedPtr;
+
+/* Mip data which is still being ingested. Filled in by ReplayerTextureIngester's worker thread, which sets is_ready
+ * once the other fields are final. */
+struct PendingMipData
+{
+    uint64_t          data_hash = 0;
+    U8VecSharedPtr    data_u8_vec_ptr;
+    std::atomic<bool> is_ready;
+
+    PendingMipData()
+        :is_ready(false)
+    {
+        /* Stub */
+    }
+
+    /* Returns the data, waiting for it to be ingested first if needed. Safe to call from any thread. */
+    U8VecSharedPtr get_data_u8_vec_ptr() const;
+};
+
 struct MipProps
 {
+    uint64_t                data_hash        = 0; // content hash of *data_u8_vec_ptr
     uint32_t                format           = 0; // GLenum
     uint32_t                internal_format  = 0; // GLenum
     std::array<uint32_t, 3> mip_size_u32vec3 = {};
     uint32_t                type             = 0; // GLenum
 
-    std::vector<uint8_t> data_u8_vec;
+    /* Each (re)definition or sub-image update of a mip gives it a new data version, unique across all mips.
+     *
+     * dirty_rect_x1y1x2y2 covers all texels modified with glTexSubImage2D() since the version given by
+     * dirty_base_version, which is the one the mip had when the texture props map was last published (at most once
+     * per frame). x2 and y2 are exclusive. An empty rect means the mip has either not been modified since, or has been
+     * redefined as a whole. */
+    uint64_t                data_version        = 0;
+    uint64_t                dirty_base_version  = 0;
+    std::array<uint32_t, 4> dirty_rect_x1y1x2y2 = {};
+
+    /* NOTE: Mip data is immutable and shared between all copies of the texture props map, as well as between all mips
+     *       with identical contents. Redefining a mip swaps the blob rather than modifying it.
+     *
+     * NOTE: While mip data is being ingested, data_u8_vec_ptr is null and pending_data_ptr is set instead. Consumers
+     *       should use get_data_u8_vec_ptr(), which takes care of both cases. */
+    U8VecSharedPtr                        data_u8_vec_ptr;
+    std::shared_ptr<const PendingMipData> pending_data_ptr;
 
     MipProps()
     {
@@ -116,15 +411,26 @@ struct MipProps
              const uint32_t&                in_internal_format,
              const uint32_t&                in_format,
              const uint32_t&                in_type,
-             const std::vector<uint8_t>&    in_data_u8_vec)
-        :data_u8_vec     (in_data_u8_vec),
-         format          (in_format),
+             const U8VecSharedPtr&          in_data_u8_vec_ptr)
+        :format          (in_format),
          internal_format (in_internal_format),
          mip_size_u32vec3(in_mip_size_u32vec3),
-         type            (in_type)
+         type            (in_type),
+         data_u8_vec_ptr (in_data_u8_vec_ptr)
     {
         /* Stub */
     }
+
+    /* Returns mip data, waiting for it to be ingested first if needed. Safe to call from any thread. */
+    U8VecSharedPtr get_data_u8_vec_ptr() const;
+
+    /* Returns the mip data's content hash, waiting for it to be ingested first if needed. */
+    uint64_t get_data_hash() const;
+
+    bool has_dirty_rect() const
+    {
+        return (dirty_rect_x1y1x2y2.at(0) != dirty_rect_x1y1x2y2.at(2) );
+    }
 };
 
 struct TextureProps
@@ -148,8 +454,78 @@ struct TextureProps
     }
 };
 
+/* Texture props, keyed by GL texture ID.
+ *
+ * Published once per frame at most (see ReplayerSnapshotter), and kept around by every frame held by the flight
+ * recorder, so copies need to be cheap. On top of the table's nodes, texture props are shared between copies too, and
+ * only cloned by the first write to a texture after the map has been copied. Publishing a frame's worth of lightmap
+ * updates therefore only costs as much as the number of textures touched.
+ *
+ * NOTE: Same threading rules as GLIDTable. */
+class GLIDToTexturePropsMap
+{
+public:
+    /* Public funcs */
+    void clear()
+    {
+        m_texture_props_ptr_table.clear();
+    }
+
+    void erase(const uint32_t& in_gl_id)
+    {
+        m_texture_props_ptr_table.erase(in_gl_id);
+    }
+
+    const TextureProps* find(const uint32_t& in_gl_id) const
+    {
+        const auto texture_props_ptr_ptr = m_texture_props_ptr_table.find(in_gl_id);
+
+        return (texture_props_ptr_ptr != nullptr) ? texture_props_ptr_ptr->get()
+                                                  : nullptr;
+    }
+
+    /* Creates a default entry if needed. The returned pointer is invalidated by the next copy of the map. */
+    TextureProps* get_for_write(const uint32_t& in_gl_id)
+    {
+        auto texture_props_ptr_ptr = m_texture_props_ptr_table.get_for_write(in_gl_id);
+
+        if (*texture_props_ptr_ptr == nullptr)
+        {
+            texture_props_ptr_ptr->reset(new TextureProps() );
+        }
+        else
+        if (texture_props_ptr_ptr->use_count() > 1)
+        {
+            texture_props_ptr_ptr->reset(new TextureProps(**texture_props_ptr_ptr) );
+        }
+
+        return texture_props_ptr_ptr->get();
+    }
+
+    uint32_t size() const
+    {
+        return m_texture_props_ptr_table.size();
+    }
+
+    /* Calls @param in_func for each texture in the map, in ascending ID order. */
+    template<typename FuncType>
+    void for_each(FuncType in_func) const
+    {
+        m_texture_props_ptr_table.for_each(
+            [&in_func](const uint32_t&                      in_gl_id,
+                       const std::shared_ptr<TextureProps>& in_texture_props_ptr)
+            {
+                in_func(in_gl_id,
+                       *in_texture_props_ptr);
+            });
+    }
+
+private:
+    /* Private vars */
+    GLIDTable<std::shared_ptr<TextureProps> > m_texture_props_ptr_table;
+};
+
 typedef std::unique_ptr<GLContextState>        GLContextStateUniquePtr;
-typedef std::map<uint32_t, TextureProps>       GLIDToTexturePropsMap;
 typedef std::unique_ptr<GLIDToTexturePropsMap> GLIDToTexturePropsMapUniquePtr;
 typedef std::unique_ptr<std::vector<uint8_t> > U8VecUniquePtr;
 
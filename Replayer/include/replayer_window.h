@@ -10,6 +10,7 @@
 
 /* Forward decls */
 struct                                  GLFWwindow;
+struct                                  ReplayerCapturedSnapshot;
 class                                   ReplayerSnapshotPlayer;
 class                                   ReplayerSnapshotter;
 class                                   ReplayerWindow;
@@ -43,12 +44,13 @@ private:
     /* Private vars */
     const std::array<uint32_t, 2> m_extents;
 
-    uint32_t                m_n_current_snapshot;
-    Replayer*               m_replayer_ptr;
-    ReplayerSnapshotPlayer* m_snapshot_player_ptr;
-    GLFWwindow*             m_window_ptr;
-    std::thread             m_worker_thread;
-    volatile bool           m_worker_thread_must_die;
+    uint32_t                                        m_n_current_snapshot;
+    Replayer*                                       m_replayer_ptr;
+    std::shared_ptr<const ReplayerCapturedSnapshot> m_snapshot_ptr; // keeps the snapshot being played alive
+    ReplayerSnapshotPlayer*                         m_snapshot_player_ptr;
+    GLFWwindow*                                     m_window_ptr;
+    std::thread                                     m_worker_thread;
+    volatile bool                                   m_worker_thread_must_die;
 };
 
 #endif /* REPLAYER_WINDOW_H */
\ No newline at end of file
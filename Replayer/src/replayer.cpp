@@ -3,6 +3,7 @@
  * This code is licensed under MIT license (see LICENSE.txt for details)
  */
 #include "APIInterceptor/include/Common/callbacks.h"
+#include "APIInterceptor/include/Common/logger.h"
 #include "replayer.h"
 #include "replayer_apicall_window.h"
 #include "replayer_snapshotter.h"
@@ -20,6 +21,8 @@ Replayer*  g_replayer_ptr  = nullptr;
     #undef min
 #endif
 
+const char* Replayer::CAPTURE_JOURNAL_FILENAME = "q1_capture_journal.q1cj";
+
 LRESULT CALLBACK on_keyboard_event(int    code,
                                    WPARAM wParam,
                                    LPARAM lParam)
@@ -34,6 +37,30 @@ LRESULT CALLBACK on_keyboard_event(int    code,
                 g_replayer_ptr->on_snapshot_requested();
             }
         }
+        else
+        if (wParam == VK_F8)
+        {
+            if (lParam & (1 << 31) )
+            {
+                g_replayer_ptr->on_flight_recorder_toggled();
+            }
+        }
+        else
+        if (wParam == VK_F9)
+        {
+            if (lParam & (1 << 31) )
+            {
+                g_replayer_ptr->on_burst_capture_requested();
+            }
+        }
+        else
+        if (wParam == VK_F11)
+        {
+            if (lParam & (1 << 31) )
+            {
+                g_replayer_ptr->on_auto_capture_toggled();
+            }
+        }
     }
 
     return CallNextHookEx(g_keyboard_hook,
@@ -44,14 +71,32 @@ LRESULT CALLBACK on_keyboard_event(int    code,
 
 
 Replayer::Replayer()
-    :m_n_snapshot(UINT32_MAX),
-     m_q1_hwnd   (0)
+    :m_is_auto_capture_enabled        (false),
+     m_is_capture_journal_enabled     (false),
+     m_is_flight_recorder_enabled     (false),
+     m_n_burst_captures               (0),
+     m_n_snapshot                     (UINT32_MAX),
+     m_q1_hwnd                        (0),
+     m_is_snapshot_available          (false),
+     m_snapshot_loader_thread_must_die(false)
 {
     /* Stub */
 }
 
 Replayer::~Replayer()
 {
+    if (m_snapshot_loader_thread.joinable() )
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_snapshot_loader_mutex);
+
+            m_snapshot_loader_thread_must_die = true;
+        }
+
+        m_snapshot_available_cv.notify_one();
+        m_snapshot_loader_thread.join     ();
+    }
+
     g_replayer_ptr = nullptr;
 
     if (g_keyboard_hook != 0)
@@ -62,6 +107,25 @@ Replayer::~Replayer()
     }
 
     m_replayer_window_ptr.reset();
+
+    /* The window's snapshot reference is gone now. Any snapshots released from here on are no longer worth recycling. */
+    m_replayer_snapshotter_ptr.reset();
+}
+
+void Replayer::apply_flight_recorder_config()
+{
+    /* NOTE: The flags are changed from both the game and the UI threads. Each of them updates its flag before getting
+     *       here, so whichever thread takes the lock last is guaranteed to see both changes. */
+    std::lock_guard<std::mutex> lock(m_flight_recorder_config_mutex);
+
+    /* Automatic captures need the frame which has triggered them to be kept around. The capture journal needs all frames
+     * to be recorded. */
+    const uint32_t n_max_frames = (m_is_flight_recorder_enabled)                              ? N_FLIGHT_RECORDER_FRAMES
+                                : (m_is_auto_capture_enabled || m_is_capture_journal_enabled) ? 1
+                                                                                              : 0;
+
+    m_replayer_snapshotter_ptr->set_flight_recorder_config(n_max_frames,
+                                                           MAX_N_FLIGHT_RECORDER_BYTES);
 }
 
 ReplayerUniquePtr Replayer::create()
@@ -85,13 +149,72 @@ ReplayerUniquePtr Replayer::create()
     return result_ptr;
 }
 
-void Replayer::get_current_snapshot(const GLIDToTexturePropsMap** out_snapshot_gl_id_to_texture_props_map_ptr_ptr,
-                                    const ReplayerSnapshot**      out_snapshot_ptr_ptr,
-                                    const GLContextState**        out_snapshot_start_gl_context_state_ptr_ptr) const
+void Replayer::execute_snapshot_loader()
+{
+    APIInterceptor::disable_callbacks_for_this_thread            ();
+    APIInterceptor::g_logger_ptr->disable_logging_for_this_thread();
+
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_snapshot_loader_mutex);
+
+            m_snapshot_available_cv.wait(lock,
+                                         [this]()
+                                         {
+                                             return m_is_snapshot_available || m_snapshot_loader_thread_must_die;
+                                         });
+
+            if (m_snapshot_loader_thread_must_die)
+            {
+                break;
+            }
+
+            m_is_snapshot_available = false;
+        }
+
+        load_snapshot();
+    }
+}
+
+std::shared_ptr<const ReplayerCapturedSnapshot> Replayer::get_current_snapshot() const
+{
+    return std::atomic_load(&m_snapshot_ptr);
+}
+
+bool Replayer::get_burst_capture_stats(ReplayerCaptureWriterStats* out_stats_ptr) const
+{
+    return m_replayer_snapshotter_ptr->get_burst_capture_stats(out_stats_ptr);
+}
+
+ReplayerCaptureStallStats Replayer::get_capture_stall_stats() const
+{
+    return m_replayer_snapshotter_ptr->get_capture_stall_stats();
+}
+
+bool Replayer::get_capture_journal_stats(ReplayerCaptureJournalStats* out_stats_ptr) const
+{
+    return m_replayer_snapshotter_ptr->get_capture_journal_stats(out_stats_ptr);
+}
+
+bool Replayer::get_frame_counter_export_stats(ReplayerFrameCounterExporterStats* out_stats_ptr) const
+{
+    return m_replayer_snapshotter_ptr->get_frame_counter_export_stats(out_stats_ptr);
+}
+
+bool Replayer::get_last_auto_capture_report(AutoCaptureReport* out_report_ptr) const
+{
+    return m_replayer_snapshotter_ptr->get_last_auto_capture_report(out_report_ptr);
+}
+
+bool Replayer::get_last_gl_error_report(GLErrorReport* out_report_ptr) const
+{
+    return m_replayer_snapshotter_ptr->get_last_gl_error_report(out_report_ptr);
+}
+
+const ReplayerTextureStore* Replayer::get_texture_store() const
 {
-    *out_snapshot_gl_id_to_texture_props_map_ptr_ptr   = m_snapshot_gl_id_to_texture_props_map_ptr.get  ();
-    *out_snapshot_ptr_ptr                              = m_snapshot_ptr.get                             ();
-    *out_snapshot_start_gl_context_state_ptr_ptr       = m_snapshot_start_gl_context_state_ptr.get      ();
+    return m_replayer_snapshotter_ptr->get_texture_store();
 }
 
 std::vector<uint8_t>* Replayer::get_current_snapshot_command_enabled_bool_as_u8_vec_ptr() const
@@ -104,11 +227,16 @@ const uint32_t& Replayer::get_n_current_snapshot() const
     return m_n_snapshot;
 }
 
-std::array<uint32_t, 2> Replayer::get_q1_window_extents() const
+std::array<uint32_t, 2> Replayer::get_q1_window_extents()
 {
     return {640, 480};
 }
 
+bool Replayer::has_capture_journal_failed() const
+{
+    return m_replayer_snapshotter_ptr->has_capture_journal_failed();
+}
+
 bool Replayer::init()
 {
     m_replayer_apicall_window_ptr  = ReplayerAPICallWindow::create (this);
@@ -123,6 +251,18 @@ bool Replayer::init()
     assert(m_replayer_snapshotter_ptr != nullptr);
     assert(m_replayer_window_ptr      != nullptr);
 
+    m_snapshot_loader_thread = std::thread(&Replayer::execute_snapshot_loader,
+                                           this);
+
+    /* GL errors raised by the game are checked for once per frame. Checking after every single call costs a driver
+     * round-trip per call, so it needs to be explicitly asked for. */
+    #if defined(REPLAYER_VALIDATE_EVERY_GL_CALL)
+    {
+        m_replayer_snapshotter_ptr->set_gl_error_validation_mode(GLErrorValidationMode::PER_CALL,
+                                                                 0); /* in_n_calls_per_segment */
+    }
+    #endif
+
     /* Register for callbacks */
     APIInterceptor::register_for_callback(APIInterceptor::APIFUNCTION_WGL_WGLMAKECURRENT,
                                          &on_q1_wglmakecurrent,
@@ -131,6 +271,85 @@ bool Replayer::init()
     return true;
 }
 
+void Replayer::load_snapshot()
+{
+    /* A snapshot has been captured. Publish it and wake up the replayer window, so that it can consume it next. */
+    std::shared_ptr<const ReplayerCapturedSnapshot> captured_snapshot_ptr;
+
+    {
+        ReplayerCapturedSnapshotUniquePtr popped_snapshot_ptr = m_replayer_snapshotter_ptr->pop_snapshot();
+
+        if (popped_snapshot_ptr == nullptr)
+        {
+            /* Already picked up by an earlier wake-up. */
+            return;
+        }
+
+        /* Readers may hold on to the snapshot for a while after a newer one has been published. Its recording buffers
+         * are handed back to the snapshotter once the last of them lets go. */
+        captured_snapshot_ptr.reset(popped_snapshot_ptr.release(),
+                                    [this](const ReplayerCapturedSnapshot* in_snapshot_ptr)
+                                    {
+                                        auto snapshot_ptr = const_cast<ReplayerCapturedSnapshot*>(in_snapshot_ptr);
+
+                                        if (m_replayer_snapshotter_ptr != nullptr)
+                                        {
+                                            m_replayer_snapshotter_ptr->recycle_snapshot(std::move(snapshot_ptr->snapshot_ptr) );
+                                        }
+
+                                        delete snapshot_ptr;
+                                    });
+    }
+
+    m_replayer_apicall_window_ptr->lock_for_snapshot_access ();
+    m_replayer_snapshot_player_ptr->lock_for_snapshot_access();
+    {
+        /* NOTE: The snapshot itself is immutable, so readers never need to lock it. The "command enabled" vector and
+         *       the API call window's command list are not, and the replayer's rendering thread may be using them in
+         *       parallel. Make sure this is not the case by locking the access.
+         */
+        std::atomic_store(&m_snapshot_ptr,
+                          captured_snapshot_ptr);
+
+        /* Refresh the "command enabled" vector. Assume all commands are enabled by default.
+         *
+         * NOTE: We can't do a bare memset here because bool is a compiler-specific type (sic) and imgui explicitly
+         *       requires bool-typed input
+         */
+        {
+            bool*      bool_ptr       = nullptr;
+            const auto n_api_commands = captured_snapshot_ptr->snapshot_ptr->get_n_api_commands();
+
+            m_snapshot_command_enabled_bool_as_u8_vec.resize(sizeof(bool) * n_api_commands);
+
+            bool_ptr = reinterpret_cast<bool*>(m_snapshot_command_enabled_bool_as_u8_vec.data() );
+
+            for (uint32_t n_api_command = 0;
+                          n_api_command < n_api_commands;
+                        ++n_api_command, bool_ptr++)
+            {
+                *bool_ptr = true;
+            }
+        }
+
+        /* Reinitialize API call window with the new snapshot */
+        m_replayer_apicall_window_ptr->load_snapshot(captured_snapshot_ptr->snapshot_ptr.get() );
+
+#if 0
+        /* While we're at it, log the snapshot's contents to a dump file.. */
+        m_replayer_snapshot_logger_ptr->log_snapshot(captured_snapshot_ptr->start_gl_context_state_ptr.get    (),
+                                                     captured_snapshot_ptr->snapshot_ptr.get                   (),
+                                                     captured_snapshot_ptr->gl_id_to_texture_props_map_ptr.get() );
+#endif
+
+        ++m_n_snapshot;
+    }
+    m_replayer_snapshot_player_ptr->unlock_for_snapshot_access();
+    m_replayer_apicall_window_ptr->unlock_for_snapshot_access ();
+
+    m_replayer_window_ptr->refresh();
+}
+
 void Replayer::on_q1_wglmakecurrent(APIInterceptor::APIFunction                in_api_func,
                                     uint32_t                                   in_n_args,
                                     const APIInterceptor::APIFunctionArgument* in_args_ptr,
@@ -174,64 +393,59 @@ void Replayer::on_q1_wglmakecurrent(APIInterceptor::APIFunction                i
 
 void Replayer::on_snapshot_available() const
 {
-    /* If a snapshot has been captured, cache it and wake up the replayer window, so that it can consume it next. */
+    /* NOTE: We're on the application's rendering thread. Anything more than a wake-up would show up as a hitch. */
     {
-        Replayer* this_ptr = const_cast<Replayer*>(this);
+        std::lock_guard<std::mutex> lock(m_snapshot_loader_mutex);
 
-        m_replayer_apicall_window_ptr->lock_for_snapshot_access ();
-        m_replayer_snapshot_player_ptr->lock_for_snapshot_access();
-        {
-            /* NOTE: Since this function is likely called from within apllication's rendering thread, we need to remember
-             *       that the replayer's rendering thread lives elsewhere, possibly consuming the snapshot in parallel.
-             *       Make sure this is not the case by locking the access.
-             */
-            m_replayer_snapshotter_ptr->pop_snapshot(&this_ptr->m_snapshot_start_gl_context_state_ptr,
-                                                     &this_ptr->m_snapshot_ptr,
-                                                     &this_ptr->m_snapshot_gl_id_to_texture_props_map_ptr);
-
-            /* Refresh the "command enabled" vector. Assume all commands are enabled by default.
-             *
-             * NOTE: We can't do a bare memset here because bool is a compiler-specific type (sic) and imgui explicitly
-             *       requires bool-typed input
-             */
-            {
-                bool*      bool_ptr       = nullptr;
-                const auto n_api_commands = this_ptr->m_snapshot_ptr->get_n_api_commands();
+        m_is_snapshot_available = true;
+    }
 
-                this_ptr->m_snapshot_command_enabled_bool_as_u8_vec.resize(sizeof(bool) * n_api_commands);
+    m_snapshot_available_cv.notify_one();
+}
 
-                bool_ptr = reinterpret_cast<bool*>(this_ptr->m_snapshot_command_enabled_bool_as_u8_vec.data() );
+void Replayer::on_burst_capture_requested()
+{
+    const std::string filename = "q1_burst" + std::to_string(m_n_burst_captures) + ".q1cap";
 
-                for (uint32_t n_api_command = 0;
-                              n_api_command < n_api_commands;
-                            ++n_api_command, bool_ptr++)
-                {
-                    *bool_ptr = true;
-                }
-            }
+    if (m_replayer_snapshotter_ptr->request_burst_capture(filename,
+                                                          static_cast<uint32_t>(N_BURST_CAPTURE_FRAMES) ) ) // not odr-used
+    {
+        m_n_burst_captures++;
+    }
+}
 
-            /* Reinitialize API call window with the new snapshot */
-            m_replayer_apicall_window_ptr->load_snapshot(this_ptr->m_snapshot_ptr.get() );
+void Replayer::on_auto_capture_toggled()
+{
+    AutoCaptureConfig config;
+    const bool        is_auto_capture_enabled = !m_is_auto_capture_enabled;
 
-#if 0
-            /* While we're at it, log the snapshot's contents to a dump file.. */
-            m_replayer_snapshot_logger_ptr->log_snapshot(this_ptr->m_snapshot_start_gl_context_state_ptr.get    (),
-                                                         this_ptr->m_snapshot_ptr.get                           (),
-                                                         this_ptr->m_snapshot_gl_id_to_texture_props_map_ptr.get() );
-#endif
+    m_is_auto_capture_enabled = is_auto_capture_enabled;
 
-            ++this_ptr->m_n_snapshot;
-        }
-        m_replayer_snapshot_player_ptr->unlock_for_snapshot_access();
-        m_replayer_apicall_window_ptr->unlock_for_snapshot_access ();
+    if (is_auto_capture_enabled)
+    {
+        config.cooldown_ms                  = AUTO_CAPTURE_COOLDOWN_MS;
+        config.max_frame_time_ms            = static_cast<float>(AUTO_CAPTURE_MAX_FRAME_TIME_MS);
+        config.max_n_api_calls              = AUTO_CAPTURE_MAX_N_API_CALLS;
+        config.max_n_texture_upload_bytes   = AUTO_CAPTURE_MAX_N_TEXTURE_UPLOAD_BYTES;
+        config.should_trigger_on_level_load = true;
     }
 
-    m_replayer_window_ptr->refresh();
+    m_replayer_snapshotter_ptr->set_auto_capture_config(config);
+
+    apply_flight_recorder_config();
+}
+
+void Replayer::on_flight_recorder_toggled()
+{
+    m_is_flight_recorder_enabled = !m_is_flight_recorder_enabled;
+
+    apply_flight_recorder_config();
 }
 
 void Replayer::on_snapshot_requested()
 {
-    m_replayer_snapshotter_ptr->cache_snapshot();
+    /* With the flight recorder on, the key press has most likely been triggered by the frame preceding the last one. */
+    m_replayer_snapshotter_ptr->cache_snapshot((m_is_flight_recorder_enabled) ? 1 : 0);
 }
 
 void Replayer::refresh_windows()
@@ -239,6 +453,49 @@ void Replayer::refresh_windows()
     m_replayer_window_ptr->refresh();
 }
 
+bool Replayer::save_current_snapshot(const std::string&             in_filename,
+                                     ReplayerSnapshotFileSaveStats* out_opt_stats_ptr) const
+{
+    const auto snapshot_ptr = get_current_snapshot();
+
+    if (snapshot_ptr == nullptr)
+    {
+        return false;
+    }
+
+    return ReplayerSnapshotFile::save(in_filename,
+                                      snapshot_ptr->start_gl_context_state_ptr.get    (),
+                                      snapshot_ptr->snapshot_ptr.get                  (),
+                                      snapshot_ptr->gl_id_to_texture_props_map_ptr.get(),
+                                      true, /* in_should_compress */
+                                      out_opt_stats_ptr);
+}
+
+void Replayer::set_capture_journal_enabled(const bool& in_enabled)
+{
+    m_is_capture_journal_enabled = in_enabled;
+
+    m_replayer_snapshotter_ptr->set_capture_journal_config((in_enabled) ? CAPTURE_JOURNAL_FILENAME : "",
+                                                           CAPTURE_JOURNAL_N_MAX_BYTES);
+
+    apply_flight_recorder_config();
+}
+
+void Replayer::set_capture_profile(const CaptureProfile& in_profile)
+{
+    m_replayer_snapshotter_ptr->set_capture_profile(in_profile);
+}
+
+void Replayer::set_cpu_timing_enabled(const bool& in_enabled)
+{
+    m_replayer_snapshotter_ptr->set_cpu_timing_enabled(in_enabled);
+}
+
+void Replayer::set_vertex_batching_enabled(const bool& in_enabled)
+{
+    m_replayer_snapshotter_ptr->set_vertex_batching_enabled(in_enabled);
+}
+
 void Replayer::reposition_windows()
 {
     RECT q1_window_rect = {};
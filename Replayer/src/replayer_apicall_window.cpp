@@ -4,9 +4,11 @@
  */
 #include "replayer.h"
 #include "replayer_apicall_window.h"
+#include "replayer_gl_functions.h"
 #include "Common/callbacks.h"
 #include "Common/logger.h"
 #include "Common/utils.h"
+#include "OpenGL/utils_enum.h"
 #include "glfw/glfw3.h"
 #include "glfw/glfw3native.h"
 #include "imgui/backends/imgui_impl_glfw.h"
@@ -21,14 +23,20 @@ static void glfw_error_callback(int         error,
 }
 
 ReplayerAPICallWindow::ReplayerAPICallWindow(Replayer* in_replayer_ptr)
-    :m_eye_translation                 (0.0f),
-     m_replayer_ptr                    (in_replayer_ptr),
+    :m_capture_profile                 (static_cast<int>(CaptureProfile::FULL) ),
+     m_eye_translation                 (0.0f),
+     m_is_capture_journal_enabled      (false),
+     m_is_cpu_timing_enabled           (false),
+     m_is_vertex_batching_enabled      (true),
      m_should_disable_lightmaps        (false),
      m_should_draw_screenspace_geometry(true),
      m_should_draw_weapon              (true),
+     m_should_expand_vertex_batches    (false),
      m_should_hide_draw_calls          (false),
      m_should_shade_3d_models          (true),
+     m_replayer_ptr                    (in_replayer_ptr),
      m_snapshot_ptr                    (nullptr),
+     m_has_segment_cpu_times           (false),
      m_window_ptr                      (nullptr),
      m_worker_thread_must_die          (false)
 {
@@ -212,6 +220,12 @@ void ReplayerAPICallWindow::execute()
                                 needs_api_command_list_vec_update = true;
                             }
 
+                            if (ImGui::Checkbox("Expand vertex batches",
+                                                &m_should_expand_vertex_batches) )
+                            {
+                                needs_api_command_list_vec_update = true;
+                            }
+
                             if (ImGui::Checkbox("Draw screen-space geometry",
                                                 &m_should_draw_screenspace_geometry) )
                             {
@@ -238,6 +252,58 @@ void ReplayerAPICallWindow::execute()
                                 needs_window_refresh = true;
                             }
 
+                            ImGui::NewLine();
+
+                            if (ImGui::Button("Save snapshot") )
+                            {
+                                char                          filename   [32];
+                                ReplayerSnapshotFileSaveStats save_stats;
+                                char                          stats_string[96];
+
+                                snprintf(filename,
+                                         sizeof(filename),
+                                         "q1_snapshot%u.q1snap",
+                                         m_replayer_ptr->get_n_current_snapshot() );
+
+                                if (m_replayer_ptr->save_current_snapshot(filename,
+                                                                         &save_stats) )
+                                {
+                                    snprintf(stats_string,
+                                             sizeof(stats_string),
+                                             " (%.2f:1 compression, %.1f ms)",
+                                             (save_stats.n_stored_bytes != 0) ? static_cast<double>(save_stats.n_raw_bytes) / static_cast<double>(save_stats.n_stored_bytes)
+                                                                              : 1.0,
+                                             static_cast<double>(save_stats.encode_time_ns) / 1e6);
+
+                                    m_snapshot_save_status_string = std::string("Saved to ") + filename + stats_string;
+                                }
+                                else
+                                {
+                                    m_snapshot_save_status_string = std::string("Could not write ") + filename;
+                                }
+                            }
+
+                            if (!m_snapshot_save_status_string.empty() )
+                            {
+                                ImGui::SameLine();
+                                ImGui::Text    ("%s", m_snapshot_save_status_string.c_str() );
+                            }
+
+                            if (m_has_segment_cpu_times)
+                            {
+                                ImGui::NewLine();
+                                ImGui::Text   ("CPU time between submissions:");
+                                ImGui::Text   ("  Frame start: %.3f ms", static_cast<double>(m_segment_cpu_times.frame_start_ns) / 1e6);
+                                ImGui::Text   ("  World:       %.3f ms", static_cast<double>(m_segment_cpu_times.world_ns)       / 1e6);
+                                ImGui::Text   ("  Lightmaps:   %.3f ms", static_cast<double>(m_segment_cpu_times.lightmaps_ns)   / 1e6);
+                                ImGui::Text   ("  3D models:   %.3f ms", static_cast<double>(m_segment_cpu_times.models_ns)      / 1e6);
+                                ImGui::Text   ("  Weapon:      %.3f ms", static_cast<double>(m_segment_cpu_times.weapon_ns)      / 1e6);
+                                ImGui::Text   ("  HUD:         %.3f ms", static_cast<double>(m_segment_cpu_times.hud_ns)         / 1e6);
+                                ImGui::Text   ("  Trailing:    %.3f ms", static_cast<double>(m_segment_cpu_times.trailing_ns)    / 1e6);
+                                ImGui::Text   ("Timestamp overhead: %.3f ms (estimated)",
+                                               static_cast<double>(m_segment_cpu_times.timestamp_overhead_ns) / 1e6);
+                            }
+
                             if (needs_window_refresh)
                             {
                                 m_replayer_ptr->refresh_windows();
@@ -250,6 +316,180 @@ void ReplayerAPICallWindow::execute()
                         ImGui::Begin("Hello.", nullptr, ImGuiWindowFlags_NoCollapse | ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoTitleBar);
                         {
                             ImGui::Text("Press F7 to capture a frame..");
+                            ImGui::Text("Press F8 to toggle the flight recorder, which lets F7 capture the frame it was pressed on.");
+                            ImGui::Text("Press F9 to capture a burst of consecutive frames to a file.");
+                            ImGui::Text("Press F11 to toggle automatic captures of slow and heavy frames.");
+
+                            if (ImGui::Checkbox("Record CPU time between API calls",
+                                                &m_is_cpu_timing_enabled) )
+                            {
+                                m_replayer_ptr->set_cpu_timing_enabled(m_is_cpu_timing_enabled);
+                            }
+
+                            if (ImGui::Checkbox("Fold glBegin() .. glEnd() runs into vertex batches when recording",
+                                                &m_is_vertex_batching_enabled) )
+                            {
+                                m_replayer_ptr->set_vertex_batching_enabled(m_is_vertex_batching_enabled);
+                            }
+
+                            if (ImGui::Checkbox("Journal recorded frames to q1_capture_journal.q1cj (survives crashes)",
+                                                &m_is_capture_journal_enabled) )
+                            {
+                                m_replayer_ptr->set_capture_journal_enabled(m_is_capture_journal_enabled);
+                            }
+
+                            {
+                                ReplayerCaptureJournalStats capture_journal_stats;
+
+                                if (m_replayer_ptr->has_capture_journal_failed() )
+                                {
+                                    /* NOTE: The journal is created at the next frame boundary, so the failure can only
+                                     *       be picked up after the checkbox has already been ticked. */
+                                    if (m_is_capture_journal_enabled)
+                                    {
+                                        m_is_capture_journal_enabled = false;
+
+                                        m_replayer_ptr->set_capture_journal_enabled(false);
+                                    }
+
+                                    ImGui::Text("Capture journal: could not create q1_capture_journal.q1cj, journaling has been disabled.");
+                                }
+                                else
+                                if (m_replayer_ptr->get_capture_journal_stats(&capture_journal_stats) )
+                                {
+                                    ImGui::Text("Capture journal: %u frames committed (%.1f MB), %u dropped, wrapped around %u times.",
+                                                capture_journal_stats.n_frames_committed,
+                                                static_cast<float>(capture_journal_stats.n_bytes_committed) / (1024.0f * 1024.0f),
+                                                capture_journal_stats.n_frames_dropped,
+                                                capture_journal_stats.n_laps);
+                                }
+                            }
+
+                            {
+                                /* NOTE: Order must match CaptureProfile. */
+                                static const char* capture_profile_name_ptr_vec[] =
+                                {
+                                    "Full",
+                                    "Draws without vertices",
+                                    "State only",
+                                    "Textures only"
+                                };
+
+                                if (ImGui::Combo("Capture profile",
+                                                 &m_capture_profile,
+                                                 capture_profile_name_ptr_vec,
+                                                 static_cast<int>(sizeof(capture_profile_name_ptr_vec) / sizeof(capture_profile_name_ptr_vec[0]) ) ) )
+                                {
+                                    m_replayer_ptr->set_capture_profile(static_cast<CaptureProfile>(m_capture_profile) );
+                                }
+                            }
+
+                            {
+                                ReplayerFrameCounterExporterStats frame_counter_export_stats;
+
+                                if (m_replayer_ptr->get_frame_counter_export_stats(&frame_counter_export_stats) )
+                                {
+                                    ImGui::Text("Frame counters: %u frames exported to q1_frame_counters.csv, %u dropped.",
+                                                frame_counter_export_stats.n_frames_exported,
+                                                frame_counter_export_stats.n_frames_dropped);
+                                }
+                            }
+
+                            {
+                                AutoCaptureReport auto_capture_report;
+
+                                if (m_replayer_ptr->get_last_auto_capture_report(&auto_capture_report) )
+                                {
+                                    const char* trigger_name_ptr = nullptr;
+
+                                    switch (auto_capture_report.trigger)
+                                    {
+                                        case AutoCaptureTrigger::FRAME_TIME:             trigger_name_ptr = "frame time";            break;
+                                        case AutoCaptureTrigger::LEVEL_LOAD:             trigger_name_ptr = "level load";            break;
+                                        case AutoCaptureTrigger::N_API_CALLS:            trigger_name_ptr = "number of API calls";   break;
+                                        case AutoCaptureTrigger::N_TEXTURE_UPLOAD_BYTES: trigger_name_ptr = "texture upload volume"; break;
+
+                                        default:
+                                        {
+                                            trigger_name_ptr = "?";
+                                        }
+                                    }
+
+                                    ImGui::Text("Automatic captures: %u, last one triggered by %s on frame %u (%.2f ms, %u API calls, %.1f KB uploaded).",
+                                                auto_capture_report.n_captures,
+                                                trigger_name_ptr,
+                                                auto_capture_report.n_frame,
+                                                auto_capture_report.frame_time_ms,
+                                                auto_capture_report.n_api_calls,
+                                                static_cast<float>(auto_capture_report.n_texture_upload_bytes) / 1024.0f);
+                                }
+                            }
+
+                            {
+                                GLErrorReport gl_error_report;
+
+                                if (m_replayer_ptr->get_last_gl_error_report(&gl_error_report) )
+                                {
+                                    if (gl_error_report.is_exact)
+                                    {
+                                        ImGui::Text("Last GL error: %s, raised by %s (call %u of frame %u).",
+                                                    OpenGL::Utils::get_raw_string_for_gl_enum(gl_error_report.gl_error),
+                                                    get_gl_function_info                     (gl_error_report.api_func).name,
+                                                    gl_error_report.n_first_call,
+                                                    gl_error_report.n_frame);
+                                    }
+                                    else
+                                    {
+                                        ImGui::Text("Last GL error: %s, raised by one of calls %u..%u of frame %u.",
+                                                    OpenGL::Utils::get_raw_string_for_gl_enum(gl_error_report.gl_error),
+                                                    gl_error_report.n_first_call,
+                                                    gl_error_report.n_last_call,
+                                                    gl_error_report.n_frame);
+                                    }
+                                }
+                            }
+
+                            {
+                                ReplayerCaptureWriterStats burst_capture_stats;
+
+                                if (m_replayer_ptr->get_burst_capture_stats(&burst_capture_stats) )
+                                {
+                                    const double write_time_s = static_cast<double>(burst_capture_stats.write_time_ns) / 1e9;
+
+                                    ImGui::Text("Burst capture: %u / %u frames written, %u dropped.",
+                                                burst_capture_stats.n_frames_written,
+                                                burst_capture_stats.n_frames,
+                                                burst_capture_stats.n_frames_dropped);
+                                    ImGui::Text("Writer queue depth: %u (max: %u), throughput: %.1f MB/s.",
+                                                burst_capture_stats.n_frames_queued,
+                                                burst_capture_stats.n_max_frames_queued,
+                                                (write_time_s > 0.0) ? static_cast<double>(burst_capture_stats.n_bytes_written) / (1024.0 * 1024.0) / write_time_s
+                                                                     : 0.0);
+                                }
+                            }
+
+                            {
+                                const auto capture_stall_stats = m_replayer_ptr->get_capture_stall_stats();
+
+                                if (capture_stall_stats.n_captures > 0)
+                                {
+                                    ImGui::Text("Capture stall: %.3f ms (max: %.3f ms over %u captures).",
+                                                static_cast<double>(capture_stall_stats.last_stall_ns) / 1e6,
+                                                static_cast<double>(capture_stall_stats.max_stall_ns)  / 1e6,
+                                                capture_stall_stats.n_captures);
+                                }
+                            }
+
+                            {
+                                const auto texture_store_ptr = m_replayer_ptr->get_texture_store();
+
+                                if (texture_store_ptr != nullptr)
+                                {
+                                    ImGui::Text("Texture store: %u blobs, %.1f MB of uploads deduplicated.",
+                                                texture_store_ptr->get_n_blobs_tracked(),
+                                                static_cast<double>(texture_store_ptr->get_n_bytes_deduplicated() ) / (1024.0 * 1024.0) );
+                                }
+                            }
                         }
                         ImGui::End();
 
@@ -283,13 +523,14 @@ end:
     ;
 }
 
-void ReplayerAPICallWindow::load_snapshot(ReplayerSnapshot* in_snapshot_ptr)
+void ReplayerAPICallWindow::load_snapshot(const ReplayerSnapshot* in_snapshot_ptr)
 {
     assert(m_mutex.try_lock() == false);
     assert(in_snapshot_ptr    != nullptr);
 
     /* Cache the snapshot instance */
-    m_snapshot_ptr = in_snapshot_ptr;
+    m_snapshot_ptr          = in_snapshot_ptr;
+    m_has_segment_cpu_times = m_snapshot_ptr->get_segment_cpu_times(&m_segment_cpu_times);
 
     /* Generate API command list from the snapshot in a format that is friendly for consumption
      * at frame rendering time.
@@ -335,8 +576,9 @@ void ReplayerAPICallWindow::update_api_command_list_vec()
     const auto  n_api_commands    = m_snapshot_ptr->get_n_api_commands();
     const auto  n_digits_required = static_cast<uint32_t>             (std::log10(n_api_commands) );
 
-    std::string filler_string;
-    std::string temp_string;
+    std::string                filler_string;
+    APIInterceptor::APICommand temp_api_command;
+    std::string                temp_string;
 
     m_api_command_vec.clear                        ();
     m_api_command_vec.reserve                      (n_api_commands);
@@ -350,14 +592,7 @@ void ReplayerAPICallWindow::update_api_command_list_vec()
 
         if (m_should_hide_draw_calls)
         {
-            if ( (current_command_ptr->api_func == APIInterceptor::APIFUNCTION_GL_GLBEGIN)      ||
-                 (current_command_ptr->api_func == APIInterceptor::APIFUNCTION_GL_GLCOLOR3F)    ||
-                 (current_command_ptr->api_func == APIInterceptor::APIFUNCTION_GL_GLCOLOR4F)    ||
-                 (current_command_ptr->api_func == APIInterceptor::APIFUNCTION_GL_GLEND)        ||
-                 (current_command_ptr->api_func == APIInterceptor::APIFUNCTION_GL_GLTEXCOORD2F) ||
-                 (current_command_ptr->api_func == APIInterceptor::APIFUNCTION_GL_GLVERTEX2F)   ||
-                 (current_command_ptr->api_func == APIInterceptor::APIFUNCTION_GL_GLVERTEX3F)   ||
-                 (current_command_ptr->api_func == APIInterceptor::APIFUNCTION_GL_GLVERTEX4F)   )
+            if (get_gl_function_info(current_command_ptr->api_func).function_class == GLFunctionClass::DRAW)
             {
                 continue;
             }
@@ -376,11 +611,66 @@ void ReplayerAPICallWindow::update_api_command_list_vec()
             }
         }
 
-        APIInterceptor::convert_api_command_to_string(*current_command_ptr,
+        current_command_ptr->to_api_command(&temp_api_command);
+
+        APIInterceptor::convert_api_command_to_string(temp_api_command,
                                                       &temp_string);
 
         m_listed_api_command_to_n_api_command_map[m_api_command_vec.size()] = n_api_command;
 
-        m_api_command_vec.emplace_back(filler_string + std::to_string(n_api_command) + ". " + temp_string);
+        if (!current_command_ptr->vertex_batch.is_valid() )
+        {
+            m_api_command_vec.emplace_back(filler_string + std::to_string(n_api_command) + ". " + temp_string);
+        }
+        else
+        if (!m_should_expand_vertex_batches)
+        {
+            m_api_command_vec.emplace_back(filler_string + std::to_string(n_api_command) + ". [" + std::to_string(current_command_ptr->vertex_batch.size() ) + " vertices] " + temp_string);
+        }
+        else
+        {
+            /* Expand the vertex batch back into individual calls. All of them map to the batch command. */
+            ReplayerExpandedAPICommand expanded_command_vec[3];
+            uint32_t                   n_expanded_line = 0;
+            const auto                 n_vertices      = current_command_ptr->vertex_batch.size();
+
+            m_api_command_vec.emplace_back(filler_string + std::to_string(n_api_command) + ". " + temp_string);
+
+            for (uint32_t n_vertex = 0;
+                          n_vertex < n_vertices;
+                        ++n_vertex)
+            {
+                const auto n_expanded_commands = ReplayerVertexBatchView::expand(current_command_ptr->vertex_batch.at(n_vertex),
+                                                                                 expanded_command_vec);
+
+                for (uint32_t n_expanded_command = 0;
+                              n_expanded_command < n_expanded_commands;
+                            ++n_expanded_command)
+                {
+                    const auto& expanded_command = expanded_command_vec[n_expanded_command];
+
+                    temp_api_command.api_func = expanded_command.api_func;
+                    temp_api_command.api_arg_vec.assign(expanded_command.api_arg_vec.begin(),
+                                                        expanded_command.api_arg_vec.begin() + expanded_command.n_api_args);
+
+                    APIInterceptor::convert_api_command_to_string(temp_api_command,
+                                                                  &temp_string);
+
+                    m_listed_api_command_to_n_api_command_map[m_api_command_vec.size()] = n_api_command;
+
+                    m_api_command_vec.emplace_back(filler_string + std::to_string(n_api_command) + "." + std::to_string(++n_expanded_line) + " " + temp_string);
+                }
+            }
+
+            temp_api_command.api_func = APIInterceptor::APIFUNCTION_GL_GLEND;
+            temp_api_command.api_arg_vec.clear();
+
+            APIInterceptor::convert_api_command_to_string(temp_api_command,
+                                                          &temp_string);
+
+            m_listed_api_command_to_n_api_command_map[m_api_command_vec.size()] = n_api_command;
+
+            m_api_command_vec.emplace_back(filler_string + std::to_string(n_api_command) + "." + std::to_string(++n_expanded_line) + " " + temp_string);
+        }
     }
 }
@@ -0,0 +1,238 @@
+/* API Interceptor (c) 2024 Dominik Witczak
+ *
+ * This code is licensed under MIT license (see LICENSE.txt for details)
+ */
+#include "replayer_block_codec.h"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <vector>
+
+#ifdef max
+    #undef max
+#endif
+#ifdef min
+    #undef min
+#endif
+
+
+uint32_t ReplayerBlockCodec::compress(const void*     in_data_ptr,
+                                      const uint32_t& in_n_bytes,
+                                      void*           out_data_ptr)
+{
+    const auto            data_u8_ptr      = static_cast<const uint8_t*>(in_data_ptr);
+    std::vector<uint32_t> hash_table_vec   (1u << HASH_TABLE_SIZE_LOG2, UINT32_MAX);
+    uint32_t              n_anchor_byte    = 0;
+    uint32_t              n_byte           = 0;
+    uint32_t              n_written_bytes  = 0;
+    const auto            result_u8_ptr    = static_cast<uint8_t*>(out_data_ptr);
+
+    assert(in_n_bytes <= BLOCK_SIZE);
+
+    auto write_length = [&](uint32_t in_n_remaining)
+    {
+        while (in_n_remaining >= 255)
+        {
+            result_u8_ptr[n_written_bytes++]  = 255;
+            in_n_remaining                   -= 255;
+        }
+
+        result_u8_ptr[n_written_bytes++] = static_cast<uint8_t>(in_n_remaining);
+    };
+
+    auto write_sequence = [&](const uint32_t& in_n_literals,
+                              const uint32_t& in_match_offset,
+                              const uint32_t& in_n_match_bytes)
+    {
+        const uint32_t n_match_length = (in_n_match_bytes != 0) ? in_n_match_bytes - MIN_MATCH_LENGTH
+                                                                : 0;
+
+        result_u8_ptr[n_written_bytes++] = static_cast<uint8_t>( ((in_n_literals < 15) ? in_n_literals  : 15) << 4 |
+                                                                  ((n_match_length < 15) ? n_match_length : 15) );
+
+        if (in_n_literals >= 15)
+        {
+            write_length(in_n_literals - 15);
+        }
+
+        if (in_n_literals != 0)
+        {
+            memcpy(result_u8_ptr + n_written_bytes,
+                   data_u8_ptr   + n_anchor_byte,
+                   in_n_literals);
+
+            n_written_bytes += in_n_literals;
+        }
+
+        if (in_n_match_bytes != 0)
+        {
+            result_u8_ptr[n_written_bytes++] = static_cast<uint8_t>(in_match_offset & 0xFF);
+            result_u8_ptr[n_written_bytes++] = static_cast<uint8_t>(in_match_offset >> 8);
+
+            if (n_match_length >= 15)
+            {
+                write_length(n_match_length - 15);
+            }
+        }
+    };
+
+    /* Greedy parse. Misses make the search step grow, so that incompressible data is skipped over quickly. */
+    while (n_byte + MIN_MATCH_LENGTH <= in_n_bytes)
+    {
+        uint32_t sequence;
+
+        memcpy(&sequence,
+               data_u8_ptr + n_byte,
+               sizeof(sequence) );
+
+        const uint32_t n_hash           = (sequence * 2654435761u) >> (32 - HASH_TABLE_SIZE_LOG2);
+        const uint32_t n_candidate_byte = hash_table_vec[n_hash];
+
+        hash_table_vec[n_hash] = n_byte;
+
+        if (n_candidate_byte                      != UINT32_MAX       &&
+            n_byte - n_candidate_byte             <= MAX_MATCH_OFFSET &&
+            memcmp(data_u8_ptr + n_candidate_byte,
+                   data_u8_ptr + n_byte,
+                   MIN_MATCH_LENGTH)              == 0)
+        {
+            uint32_t n_match_bytes = MIN_MATCH_LENGTH;
+
+            while (n_byte + n_match_bytes                           <  in_n_bytes &&
+                   data_u8_ptr[n_candidate_byte + n_match_bytes] == data_u8_ptr[n_byte + n_match_bytes])
+            {
+                ++n_match_bytes;
+            }
+
+            write_sequence(n_byte - n_anchor_byte,
+                           n_byte - n_candidate_byte,
+                           n_match_bytes);
+
+            n_byte        += n_match_bytes;
+            n_anchor_byte  = n_byte;
+        }
+        else
+        {
+            n_byte += 1 + ((n_byte - n_anchor_byte) >> 6);
+        }
+    }
+
+    write_sequence(in_n_bytes - n_anchor_byte,
+                   0,  /* in_match_offset  */
+                   0); /* in_n_match_bytes */
+
+    assert(n_written_bytes <= get_max_n_compressed_bytes(in_n_bytes) );
+
+    return n_written_bytes;
+}
+
+bool ReplayerBlockCodec::decompress(const void*     in_data_ptr,
+                                    const uint32_t& in_n_bytes,
+                                    void*           out_data_ptr,
+                                    const uint32_t& in_n_decompressed_bytes)
+{
+    const auto data_u8_ptr     = static_cast<const uint8_t*>(in_data_ptr);
+    uint32_t   n_byte          = 0;
+    uint32_t   n_written_bytes = 0;
+    const auto result_u8_ptr   = static_cast<uint8_t*>(out_data_ptr);
+
+    auto read_length = [&](uint64_t* inout_length_ptr)
+    {
+        uint8_t value;
+
+        do
+        {
+            if (n_byte >= in_n_bytes)
+            {
+                return false;
+            }
+
+            value              = data_u8_ptr[n_byte++];
+            *inout_length_ptr += value;
+        }
+        while (value == 255);
+
+        return true;
+    };
+
+    while (n_byte < in_n_bytes)
+    {
+        const uint8_t token          = data_u8_ptr[n_byte++];
+        uint64_t      n_literals     = token >> 4;
+        uint64_t      n_match_bytes  = token &  15;
+        uint32_t      match_offset   = 0;
+
+        if (n_literals == 15 &&
+            !read_length(&n_literals) )
+        {
+            return false;
+        }
+
+        if (n_literals > in_n_bytes              - n_byte ||
+            n_literals > in_n_decompressed_bytes - n_written_bytes)
+        {
+            return false;
+        }
+
+        memcpy(result_u8_ptr + n_written_bytes,
+               data_u8_ptr   + n_byte,
+               static_cast<size_t>(n_literals) );
+
+        n_byte          += static_cast<uint32_t>(n_literals);
+        n_written_bytes += static_cast<uint32_t>(n_literals);
+
+        /* The last sequence carries no match. */
+        if (n_byte == in_n_bytes)
+        {
+            break;
+        }
+
+        if (in_n_bytes - n_byte < 2)
+        {
+            return false;
+        }
+
+        match_offset  = data_u8_ptr[n_byte] | (data_u8_ptr[n_byte + 1] << 8);
+        n_byte       += 2;
+
+        if (n_match_bytes == 15 &&
+            !read_length(&n_match_bytes) )
+        {
+            return false;
+        }
+
+        n_match_bytes += MIN_MATCH_LENGTH;
+
+        if (match_offset  == 0                                         ||
+            match_offset  >  n_written_bytes                           ||
+            n_match_bytes >  in_n_decompressed_bytes - n_written_bytes)
+        {
+            return false;
+        }
+
+        /* Overlapping matches repeat the last match_offset bytes. Whatever has been copied so far is a whole number of
+         * repetitions, so it can serve as the source of the next, twice as large, non-overlapping copy. */
+        {
+            const auto     match_dst_ptr = result_u8_ptr + n_written_bytes;
+            const auto     match_src_ptr = match_dst_ptr - match_offset;
+            const auto     n_bytes       = static_cast<uint32_t>(n_match_bytes);
+            uint32_t       n_copied      = 0;
+
+            while (n_copied < n_bytes)
+            {
+                const uint32_t n_chunk_bytes = std::min(n_copied + match_offset,
+                                                        n_bytes  - n_copied);
+
+                memcpy(match_dst_ptr + n_copied,
+                       match_src_ptr,
+                       n_chunk_bytes);
+
+                n_copied += n_chunk_bytes;
+            }
+        }
+
+        n_written_bytes += static_cast<uint32_t>(n_match_bytes);
+    }
+
+    return (n_written_bytes == in_n_decompressed_bytes);
+}
@@ -0,0 +1,491 @@
+/* API Interceptor (c) 2024 Dominik Witczak
+ *
+ * This code is licensed under MIT license (see LICENSE.txt for details)
+ */
+#include "OpenGL/globals.h"
+#include "replayer_capture_journal.h"
+#include "replayer_gl_functions.h"
+#include <algorithm>
+
+#ifdef max
+    #undef max
+#endif
+#ifdef min
+    #undef min
+#endif
+
+
+ReplayerCaptureJournal::ReplayerCaptureJournal(const std::string& in_filename,
+                                               const uint64_t&    in_n_max_bytes)
+    :m_file_handle        (INVALID_HANDLE_VALUE),
+     m_file_mapping_handle(nullptr),
+     m_filename           (in_filename),
+     m_header_ptr         (nullptr),
+     m_mapped_data_ptr    (nullptr),
+     m_n_max_bytes        (in_n_max_bytes),
+     m_is_frame_dropped   (false),
+     m_is_frame_open      (false),
+     m_n_frame            (0),
+     m_n_next_command     (0),
+     m_n_frame_start_byte (DATA_START_BYTE),
+     m_n_write_byte       (DATA_START_BYTE)
+{
+    /* Stub */
+}
+
+ReplayerCaptureJournal::~ReplayerCaptureJournal()
+{
+    /* NOTE: A frame which has not been committed stays invisible to readers. */
+    if (m_mapped_data_ptr != nullptr)
+    {
+        ::UnmapViewOfFile(m_mapped_data_ptr);
+    }
+
+    if (m_file_mapping_handle != nullptr)
+    {
+        ::CloseHandle(m_file_mapping_handle);
+    }
+
+    if (m_file_handle != INVALID_HANDLE_VALUE)
+    {
+        ::CloseHandle(m_file_handle);
+    }
+}
+
+void ReplayerCaptureJournal::append(const void*     in_data_ptr,
+                                    const uint32_t& in_n_bytes)
+{
+    if (m_is_frame_dropped)
+    {
+        return;
+    }
+
+    if (m_n_write_byte + in_n_bytes > m_n_max_bytes)
+    {
+        const uint64_t n_frame_bytes = m_n_write_byte - m_n_frame_start_byte;
+
+        if (m_n_frame_start_byte                      == DATA_START_BYTE ||
+            DATA_START_BYTE + n_frame_bytes + in_n_bytes > m_n_max_bytes)
+        {
+            /* The frame is larger than the whole journal. */
+            m_is_frame_dropped = true;
+
+            return;
+        }
+
+        /* Wrap around, carrying the frame over to the start of the journal. Frames committed during the previous lap
+         * remain valid up to the point where they are overwritten.
+         *
+         * NOTE: The header is updated before any of the bytes it describes are overwritten. */
+        m_header_ptr->n_lap_end_byte         = m_header_ptr->n_last_commit_end_byte;
+        m_header_ptr->n_overwritten_end_byte = DATA_START_BYTE + n_frame_bytes + in_n_bytes;
+
+        std::atomic_thread_fence(std::memory_order_release);
+
+        m_header_ptr->n_last_commit_end_byte = DATA_START_BYTE;
+
+        std::atomic_thread_fence(std::memory_order_release);
+
+        memmove(m_mapped_data_ptr + DATA_START_BYTE,
+                m_mapped_data_ptr + m_n_frame_start_byte,
+                static_cast<size_t>(n_frame_bytes) );
+
+        m_n_frame_start_byte = DATA_START_BYTE;
+        m_n_write_byte       = DATA_START_BYTE + n_frame_bytes;
+
+        {
+            std::lock_guard<std::mutex> lock(m_stats_mutex);
+
+            m_stats.n_laps++;
+        }
+    }
+    else
+    if (m_header_ptr->n_lap_end_byte         != 0 &&
+        m_header_ptr->n_overwritten_end_byte <  m_n_write_byte + in_n_bytes)
+    {
+        /* About to overwrite more of the previous lap. */
+        m_header_ptr->n_overwritten_end_byte = std::min(m_n_max_bytes,
+                                                        (m_n_write_byte + in_n_bytes + OVERWRITTEN_END_GRANULARITY - 1) / OVERWRITTEN_END_GRANULARITY * OVERWRITTEN_END_GRANULARITY);
+
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+
+    memcpy(m_mapped_data_ptr + m_n_write_byte,
+           in_data_ptr,
+           in_n_bytes);
+
+    m_n_write_byte += in_n_bytes;
+}
+
+void ReplayerCaptureJournal::append_command(const ReplayerSnapshotCommandView& in_command)
+{
+    const uint32_t n_args           = in_command.api_arg_vec.size();
+    const uint32_t n_batch_vertices = (in_command.vertex_batch.is_valid() ) ? in_command.vertex_batch.size()
+                                                                             : 0;
+
+    append(static_cast<uint32_t>(in_command.api_func) );
+    append(n_args);
+    append(in_command.api_arg_vec.data(),
+           static_cast<uint32_t>(sizeof(APIInterceptor::APIFunctionArgument) * n_args) );
+    append(n_batch_vertices);
+
+    for (uint32_t n_vertex = 0;
+                  n_vertex < n_batch_vertices;
+                ++n_vertex)
+    {
+        append(in_command.vertex_batch.at(n_vertex) );
+    }
+
+    /* Uploaded texels are taken straight from the application's buffer, which is still valid at this point. Waiting
+     * for the ingester to hash and store them would hold up the application. */
+    if (in_command.api_func == APIInterceptor::APIFUNCTION_GL_GLTEXIMAGE2D)
+    {
+        const CommandView<APIInterceptor::APIFUNCTION_GL_GLTEXIMAGE2D> command(in_command);
+
+        const uint32_t n_components = (command.get<6>() == GL_RGBA) ? 4u
+                                                                    : 1u;
+        const uint32_t n_bytes      = (command.get<8>() != nullptr) ? static_cast<uint32_t>(command.get<3>() ) * static_cast<uint32_t>(command.get<4>() ) * n_components
+                                                                    : 0u;
+
+        append(n_bytes);
+        append(command.get<8>(),
+               n_bytes);
+    }
+    else
+    if (in_command.api_func == APIInterceptor::APIFUNCTION_GL_GLTEXSUBIMAGE2D)
+    {
+        const CommandView<APIInterceptor::APIFUNCTION_GL_GLTEXSUBIMAGE2D> command(in_command);
+
+        const uint32_t n_components = (command.get<6>() == GL_RGBA) ? 4u
+                                                                    : 1u;
+        const uint32_t n_bytes      = static_cast<uint32_t>(command.get<4>() ) * static_cast<uint32_t>(command.get<5>() ) * n_components;
+
+        append(n_bytes);
+        append(command.get<8>(),
+               n_bytes);
+    }
+}
+
+void ReplayerCaptureJournal::begin_frame(const uint32_t& in_n_frame)
+{
+    /* Anything written after the last commit is garbage as far as readers are concerned, so it can simply be
+     * overwritten. */
+    m_is_frame_dropped   = false;
+    m_is_frame_open      = true;
+    m_n_frame            = in_n_frame;
+    m_n_frame_start_byte = m_header_ptr->n_last_commit_end_byte;
+    m_n_next_command     = 0;
+    m_n_write_byte       = m_n_frame_start_byte;
+
+    append(static_cast<uint32_t>(FRAME_MAGIC) ); // not odr-used
+    append(in_n_frame);
+}
+
+void ReplayerCaptureJournal::commit_frame(const ReplayerSnapshot& in_snapshot)
+{
+    if (!m_is_frame_open)
+    {
+        return;
+    }
+
+    assert(in_snapshot.get_n_completed_api_commands() == in_snapshot.get_n_api_commands() );
+
+    consume(in_snapshot);
+
+    m_is_frame_open = false;
+
+    {
+        CommitMarker commit_marker;
+
+        commit_marker.magic          = COMMIT_MAGIC;
+        commit_marker.n_api_commands = in_snapshot.get_n_api_commands();
+        commit_marker.n_frame        = m_n_frame;
+        commit_marker.n_frame_bytes  = m_n_write_byte - m_n_frame_start_byte + sizeof(CommitMarker);
+        commit_marker.reserved       = 0;
+
+        append(commit_marker);
+    }
+
+    if (m_is_frame_dropped)
+    {
+        std::lock_guard<std::mutex> lock(m_stats_mutex);
+
+        m_stats.n_frames_dropped++;
+
+        return;
+    }
+
+    /* The frame becomes visible to readers once the commit marker is in place. */
+    std::atomic_thread_fence(std::memory_order_release);
+
+    m_header_ptr->n_last_commit_end_byte = m_n_write_byte;
+
+    {
+        std::lock_guard<std::mutex> lock(m_stats_mutex);
+
+        m_stats.n_bytes_committed += m_n_write_byte - m_n_frame_start_byte;
+        m_stats.n_frames_committed++;
+    }
+}
+
+void ReplayerCaptureJournal::consume(const ReplayerSnapshot& in_snapshot)
+{
+    if (!m_is_frame_open)
+    {
+        return;
+    }
+
+    const auto n_completed_commands = in_snapshot.get_n_completed_api_commands();
+
+    while (m_n_next_command < n_completed_commands)
+    {
+        append_command(in_snapshot.get_api_command_ptr(m_n_next_command) );
+
+        m_n_next_command++;
+    }
+}
+
+ReplayerCaptureJournalUniquePtr ReplayerCaptureJournal::create(const std::string& in_filename,
+                                                               const uint64_t&    in_n_max_bytes)
+{
+    ReplayerCaptureJournalUniquePtr result_ptr(new ReplayerCaptureJournal(in_filename,
+                                                                          in_n_max_bytes) );
+
+    if (result_ptr != nullptr)
+    {
+        if (!result_ptr->init() )
+        {
+            result_ptr.reset();
+        }
+    }
+
+    return result_ptr;
+}
+
+bool ReplayerCaptureJournal::get_committed_frames(const std::string&                        in_filename,
+                                                  std::vector<ReplayerCaptureJournalFrame>* out_frame_vec_ptr)
+{
+    HANDLE         file_handle         = INVALID_HANDLE_VALUE;
+    HANDLE         file_mapping_handle = nullptr;
+    const uint8_t* file_data_ptr       = nullptr;
+    LARGE_INTEGER  file_size           = {};
+    bool           result              = false;
+
+    out_frame_vec_ptr->clear();
+
+    file_handle = ::CreateFileA(in_filename.c_str(),
+                                GENERIC_READ,
+                                FILE_SHARE_READ | FILE_SHARE_WRITE,
+                                nullptr, /* lpSecurityAttributes */
+                                OPEN_EXISTING,
+                                FILE_ATTRIBUTE_NORMAL,
+                                nullptr); /* hTemplateFile */
+
+    if (file_handle == INVALID_HANDLE_VALUE)
+    {
+        goto end;
+    }
+
+    if (!::GetFileSizeEx(file_handle,
+                         &file_size)                             ||
+        static_cast<uint64_t>(file_size.QuadPart) < DATA_START_BYTE)
+    {
+        goto end;
+    }
+
+    file_mapping_handle = ::CreateFileMappingA(file_handle,
+                                               nullptr, /* lpFileMappingAttributes */
+                                               PAGE_READONLY,
+                                               0,       /* dwMaximumSizeHigh */
+                                               0,       /* dwMaximumSizeLow  */
+                                               nullptr); /* lpName           */
+
+    if (file_mapping_handle == nullptr)
+    {
+        goto end;
+    }
+
+    file_data_ptr = reinterpret_cast<const uint8_t*>(::MapViewOfFile(file_mapping_handle,
+                                                                     FILE_MAP_READ,
+                                                                     0,    /* dwFileOffsetHigh     */
+                                                                     0,    /* dwFileOffsetLow      */
+                                                                     0) ); /* dwNumberOfBytesToMap */
+
+    if (file_data_ptr == nullptr)
+    {
+        goto end;
+    }
+
+    {
+        /* Take a snapshot of the header, in case the journal is still being written to. */
+        Header header;
+
+        memcpy(&header,
+               file_data_ptr,
+               sizeof(Header) );
+
+        if (header.magic                  != FILE_MAGIC                                 ||
+            header.version                != FILE_VERSION                               ||
+            header.n_file_bytes           != static_cast<uint64_t>(file_size.QuadPart) ||
+            header.n_last_commit_end_byte >  header.n_file_bytes                        ||
+            header.n_lap_end_byte         >  header.n_file_bytes)
+        {
+            goto end;
+        }
+
+        /* Frames left over from the previous lap are older than the ones committed since, so they go first. */
+        if (header.n_lap_end_byte != 0)
+        {
+            walk_frames(file_data_ptr,
+                        header.n_lap_end_byte,
+                        header.n_overwritten_end_byte,
+                        out_frame_vec_ptr);
+        }
+
+        walk_frames(file_data_ptr,
+                    header.n_last_commit_end_byte,
+                    static_cast<uint64_t>(DATA_START_BYTE), // not odr-used
+                    out_frame_vec_ptr);
+    }
+
+    result = true;
+end:
+    if (file_data_ptr != nullptr)
+    {
+        ::UnmapViewOfFile(file_data_ptr);
+    }
+
+    if (file_mapping_handle != nullptr)
+    {
+        ::CloseHandle(file_mapping_handle);
+    }
+
+    if (file_handle != INVALID_HANDLE_VALUE)
+    {
+        ::CloseHandle(file_handle);
+    }
+
+    return result;
+}
+
+ReplayerCaptureJournalStats ReplayerCaptureJournal::get_stats() const
+{
+    std::lock_guard<std::mutex> lock(m_stats_mutex);
+
+    return m_stats;
+}
+
+bool ReplayerCaptureJournal::init()
+{
+    AI_ASSERT(m_n_max_bytes > DATA_START_BYTE);
+    static_assert(sizeof(Header) <= DATA_START_BYTE, "Header does not fit");
+
+    /* NOTE: Readers may open the journal while it is being written to. */
+    m_file_handle = ::CreateFileA(m_filename.c_str(),
+                                  GENERIC_READ | GENERIC_WRITE,
+                                  FILE_SHARE_READ,
+                                  nullptr, /* lpSecurityAttributes */
+                                  CREATE_ALWAYS,
+                                  FILE_ATTRIBUTE_NORMAL,
+                                  nullptr); /* hTemplateFile */
+
+    if (m_file_handle == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    /* Mapping the file also grows it to its final size. */
+    m_file_mapping_handle = ::CreateFileMappingA(m_file_handle,
+                                                 nullptr, /* lpFileMappingAttributes */
+                                                 PAGE_READWRITE,
+                                                 static_cast<DWORD>(m_n_max_bytes >> 32),
+                                                 static_cast<DWORD>(m_n_max_bytes & 0xFFFFFFFF),
+                                                 nullptr); /* lpName */
+
+    if (m_file_mapping_handle == nullptr)
+    {
+        return false;
+    }
+
+    m_mapped_data_ptr = reinterpret_cast<uint8_t*>(::MapViewOfFile(m_file_mapping_handle,
+                                                                   FILE_MAP_WRITE,
+                                                                   0,  /* dwFileOffsetHigh */
+                                                                   0,  /* dwFileOffsetLow  */
+                                                                   static_cast<size_t>(m_n_max_bytes) ) );
+
+    if (m_mapped_data_ptr == nullptr)
+    {
+        return false;
+    }
+
+    m_header_ptr = reinterpret_cast<Header*>(m_mapped_data_ptr);
+
+    m_header_ptr->magic                  = FILE_MAGIC;
+    m_header_ptr->version                = FILE_VERSION;
+    m_header_ptr->n_file_bytes           = m_n_max_bytes;
+    m_header_ptr->n_last_commit_end_byte = DATA_START_BYTE;
+    m_header_ptr->n_lap_end_byte         = 0;
+    m_header_ptr->n_overwritten_end_byte = 0;
+
+    return true;
+}
+
+void ReplayerCaptureJournal::walk_frames(const uint8_t*                            in_file_data_ptr,
+                                         const uint64_t&                           in_n_end_byte,
+                                         const uint64_t&                           in_n_min_start_byte,
+                                         std::vector<ReplayerCaptureJournalFrame>* out_frame_vec_ptr)
+{
+    const auto n_first_new_frame = out_frame_vec_ptr->size();
+    uint64_t   n_end_byte        = in_n_end_byte;
+
+    /* Each commit marker tells where its frame starts, which is where the previous frame ends. */
+    while (n_end_byte >= in_n_min_start_byte + sizeof(CommitMarker) )
+    {
+        CommitMarker commit_marker;
+        uint32_t     frame_magic  = 0;
+        uint32_t     n_frame      = 0;
+        uint64_t     n_start_byte = 0;
+
+        memcpy(&commit_marker,
+               in_file_data_ptr + n_end_byte - sizeof(CommitMarker),
+               sizeof(CommitMarker) );
+
+        if (commit_marker.magic         != COMMIT_MAGIC                                ||
+            commit_marker.n_frame_bytes <  sizeof(CommitMarker) + sizeof(uint32_t) * 2 ||
+            commit_marker.n_frame_bytes >  n_end_byte - in_n_min_start_byte)
+        {
+            break;
+        }
+
+        n_start_byte = n_end_byte - commit_marker.n_frame_bytes;
+
+        memcpy(&frame_magic,
+               in_file_data_ptr + n_start_byte,
+               sizeof(uint32_t) );
+        memcpy(&n_frame,
+               in_file_data_ptr + n_start_byte + sizeof(uint32_t),
+               sizeof(uint32_t) );
+
+        if (frame_magic != FRAME_MAGIC            ||
+            n_frame     != commit_marker.n_frame)
+        {
+            break;
+        }
+
+        {
+            ReplayerCaptureJournalFrame frame;
+
+            frame.n_api_commands = commit_marker.n_api_commands;
+            frame.n_bytes        = commit_marker.n_frame_bytes;
+            frame.n_frame        = n_frame;
+            frame.n_start_byte   = n_start_byte;
+
+            out_frame_vec_ptr->push_back(frame);
+        }
+
+        n_end_byte = n_start_byte;
+    }
+
+    std::reverse(out_frame_vec_ptr->begin() + n_first_new_frame,
+                 out_frame_vec_ptr->end  () );
+}
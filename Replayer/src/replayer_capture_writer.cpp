@@ -0,0 +1,464 @@
+/* API Interceptor (c) 2024 Dominik Witczak
+ *
+ * This code is licensed under MIT license (see LICENSE.txt for details)
+ */
+
+// Shoo shoo VS warnings, this is a hobby project.
+#define _CRT_SECURE_NO_WARNINGS
+
+#include "Common/callbacks.h"
+#include "Common/logger.h"
+#include "OpenGL/globals.h"
+#include "replayer_capture_writer.h"
+#include "replayer_snapshotter.h"
+
+#ifdef max
+    #undef max
+#endif
+
+
+ReplayerCaptureWriter::ReplayerCaptureWriter(const std::string&   in_filename,
+                                             const uint32_t&      in_n_frames,
+                                             const uint32_t&      in_max_n_queued_frames,
+                                             ReplayerSnapshotter* in_snapshotter_ptr)
+    :m_file_ptr              (nullptr),
+     m_filename              (in_filename),
+     m_snapshotter_ptr       (in_snapshotter_ptr),
+     m_frame_queue_vec       (in_max_n_queued_frames),
+     m_n_first_queued_frame  (0),
+     m_worker_thread_must_die(false)
+{
+    m_stats.n_frames = in_n_frames;
+}
+
+ReplayerCaptureWriter::~ReplayerCaptureWriter()
+{
+    /* NOTE: Frames which have already been queued are still written out before the thread quits. */
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        m_worker_thread_must_die = true;
+    }
+
+    m_frame_queued_cv.notify_one();
+    m_worker_thread.join        ();
+}
+
+ReplayerCaptureWriterUniquePtr ReplayerCaptureWriter::create(const std::string&   in_filename,
+                                                             const uint32_t&      in_n_frames,
+                                                             const uint32_t&      in_max_n_queued_frames,
+                                                             ReplayerSnapshotter* in_snapshotter_ptr)
+{
+    ReplayerCaptureWriterUniquePtr result_ptr(new ReplayerCaptureWriter(in_filename,
+                                                                        in_n_frames,
+                                                                        in_max_n_queued_frames,
+                                                                        in_snapshotter_ptr) );
+
+    if (result_ptr != nullptr)
+    {
+        if (!result_ptr->init() )
+        {
+            result_ptr.reset();
+        }
+    }
+
+    return result_ptr;
+}
+
+bool ReplayerCaptureWriter::enqueue_frame(ReplayerCaptureFrame in_frame)
+{
+    const auto queue_size = static_cast<uint32_t>(m_frame_queue_vec.size() );
+    bool       result     = false;
+
+    assert(in_frame.snapshot_ptr != nullptr);
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        if (m_stats.n_frames_queued < queue_size)
+        {
+            m_frame_queue_vec.at((m_n_first_queued_frame + m_stats.n_frames_queued) % queue_size) = std::move(in_frame);
+
+            m_stats.n_frames_queued++;
+            m_stats.n_max_frames_queued = std::max(m_stats.n_max_frames_queued,
+                                                   m_stats.n_frames_queued);
+
+            result = true;
+        }
+        else
+        {
+            m_stats.n_frames_dropped++;
+        }
+    }
+
+    /* NOTE: The writer also needs to be woken up for dropped frames, since it may have been waiting for the last one. */
+    m_frame_queued_cv.notify_one();
+
+    if (!result)
+    {
+        m_snapshotter_ptr->recycle_snapshot(std::move(in_frame.snapshot_ptr) );
+    }
+
+    return result;
+}
+
+void ReplayerCaptureWriter::execute()
+{
+    LARGE_INTEGER qpc_frequency = {};
+
+    APIInterceptor::disable_callbacks_for_this_thread            ();
+    APIInterceptor::g_logger_ptr->disable_logging_for_this_thread();
+
+    ::QueryPerformanceFrequency(&qpc_frequency);
+
+    m_file_ptr = ::fopen(m_filename.c_str(), "wb");
+
+    AI_ASSERT(m_file_ptr != nullptr);
+
+    /* Store the file header */
+    {
+        const uint32_t header_u32vec[] =
+        {
+            FILE_MAGIC,
+            FILE_VERSION,
+            m_stats.n_frames
+        };
+
+        serialize(header_u32vec);
+
+        if (m_file_ptr != nullptr)
+        {
+            ::fwrite(m_frame_data_u8_vec.data(),
+                     m_frame_data_u8_vec.size(),
+                     1, /* count */
+                     m_file_ptr);
+        }
+    }
+
+    while (true)
+    {
+        ReplayerCaptureFrame frame;
+        LARGE_INTEGER        end_qpc   = {};
+        LARGE_INTEGER        start_qpc = {};
+
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+
+            m_frame_queued_cv.wait(lock,
+                                   [this]()
+                                   {
+                                       return (m_stats.n_frames_queued                          >  0)                ||
+                                              (m_stats.n_frames_written + m_stats.n_frames_dropped == m_stats.n_frames) ||
+                                              m_worker_thread_must_die;
+                                   });
+
+            if (m_stats.n_frames_queued == 0)
+            {
+                break;
+            }
+
+            frame = std::move(m_frame_queue_vec.at(m_n_first_queued_frame) );
+
+            m_n_first_queued_frame = (m_n_first_queued_frame + 1) % m_frame_queue_vec.size();
+            m_stats.n_frames_queued--;
+        }
+
+        ::QueryPerformanceCounter(&start_qpc);
+        {
+            write_frame(frame);
+        }
+        ::QueryPerformanceCounter(&end_qpc);
+
+        /* Let the snapshotter reuse the buffers. */
+        m_snapshotter_ptr->recycle_snapshot(std::move(frame.snapshot_ptr) );
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            m_stats.n_bytes_written += m_frame_data_u8_vec.size();
+            m_stats.n_frames_written++;
+            m_stats.write_time_ns   += static_cast<uint64_t>(static_cast<double>(end_qpc.QuadPart - start_qpc.QuadPart) * 1e9 / static_cast<double>(qpc_frequency.QuadPart) );
+        }
+    }
+
+    if (m_file_ptr != nullptr)
+    {
+        ::fclose(m_file_ptr);
+
+        m_file_ptr = nullptr;
+    }
+
+    /* Release stored mip data as soon as possible. */
+    m_last_gl_id_to_texture_props_map_ptr.reset();
+    m_mip_data_blob_vec.clear                  ();
+    m_mip_data_ptr_to_n_blob_map.clear         ();
+}
+
+ReplayerCaptureWriterStats ReplayerCaptureWriter::get_stats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    return m_stats;
+}
+
+bool ReplayerCaptureWriter::init()
+{
+    AI_ASSERT(m_frame_queue_vec.size() > 0);
+
+    m_worker_thread = std::thread(&ReplayerCaptureWriter::execute,
+                                   this);
+
+    return true;
+}
+
+bool ReplayerCaptureWriter::is_done() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    return (m_stats.n_frames_written + m_stats.n_frames_dropped == m_stats.n_frames);
+}
+
+void ReplayerCaptureWriter::serialize(const void*     in_data_ptr,
+                                      const uint32_t& in_n_bytes)
+{
+    const auto n_start_byte = m_frame_data_u8_vec.size();
+
+    m_frame_data_u8_vec.resize(n_start_byte + in_n_bytes);
+
+    memcpy(m_frame_data_u8_vec.data() + n_start_byte,
+           in_data_ptr,
+           in_n_bytes);
+}
+
+void ReplayerCaptureWriter::serialize_commands(const ReplayerSnapshot* in_snapshot_ptr)
+{
+    const auto n_api_commands = in_snapshot_ptr->get_n_api_commands();
+
+    serialize(n_api_commands);
+
+    for (uint32_t n_api_command = 0;
+                  n_api_command < n_api_commands;
+                ++n_api_command)
+    {
+        const auto     api_command      = in_snapshot_ptr->get_api_command_ptr(n_api_command);
+        const uint32_t n_args           = api_command.api_arg_vec.size();
+        const uint32_t n_batch_vertices = (api_command.vertex_batch.is_valid() ) ? api_command.vertex_batch.size()
+                                                                                  : 0;
+
+        /* NOTE: Pointer arguments are stored as-is. They are only meaningful for as long as the process lives. */
+        serialize(static_cast<uint32_t>(api_command.api_func) );
+        serialize(n_args);
+        serialize(api_command.api_arg_vec.data(),
+                  static_cast<uint32_t>(sizeof(APIInterceptor::APIFunctionArgument) * n_args) );
+        serialize(n_batch_vertices);
+
+        for (uint32_t n_vertex = 0;
+                      n_vertex < n_batch_vertices;
+                    ++n_vertex)
+        {
+            serialize(api_command.vertex_batch.at(n_vertex) );
+        }
+
+        /* Texture uploads carry their data, which supersedes the pixels pointer argument. */
+        if (api_command.api_func == APIInterceptor::APIFUNCTION_GL_GLTEXIMAGE2D)
+        {
+            serialize_mip_data((api_command.texture_upload_data_ptr != nullptr) ? api_command.texture_upload_data_ptr->get_data_u8_vec_ptr()
+                                                                                : U8VecSharedPtr(),
+                               nullptr); /* in_opt_mip_props_ptr */
+        }
+        else
+        if (api_command.api_func == APIInterceptor::APIFUNCTION_GL_GLTEXSUBIMAGE2D)
+        {
+            const CommandView<APIInterceptor::APIFUNCTION_GL_GLTEXSUBIMAGE2D> command(api_command);
+
+            const auto     data_u8_vec_ptr  = api_command.texture_upload_data_ptr->get_data_u8_vec_ptr();
+            const uint32_t n_components     = (command.get<6>() == GL_RGBA) ? 4u
+                                                                            : 1u;
+            const uint32_t n_rect_row_bytes = static_cast<uint32_t>(command.get<4>() ) * n_components;
+            const uint32_t n_row_bytes      = api_command.texture_upload_n_row_pixels  * n_components;
+
+            for (uint32_t n_row = 0;
+                          n_row < static_cast<uint32_t>(command.get<5>() );
+                        ++n_row)
+            {
+                serialize(data_u8_vec_ptr->data() + (command.get<3>() + n_row) * n_row_bytes + command.get<2>() * n_components,
+                          n_rect_row_bytes);
+            }
+        }
+    }
+}
+
+void ReplayerCaptureWriter::serialize_gl_context_state(const GLContextState* in_gl_context_state_ptr)
+{
+    serialize(in_gl_context_state_ptr->alpha_test_enabled);
+    serialize(in_gl_context_state_ptr->blend_enabled);
+    serialize(in_gl_context_state_ptr->cull_face_enabled);
+    serialize(in_gl_context_state_ptr->depth_test_enabled);
+    serialize(in_gl_context_state_ptr->scissor_test_enabled);
+    serialize(in_gl_context_state_ptr->texture_2d_enabled);
+
+    serialize(in_gl_context_state_ptr->alpha_func_func);
+    serialize(in_gl_context_state_ptr->alpha_func_ref);
+    serialize(in_gl_context_state_ptr->blend_func_dfactor);
+    serialize(in_gl_context_state_ptr->blend_func_sfactor);
+    serialize(in_gl_context_state_ptr->clear_color);
+    serialize(in_gl_context_state_ptr->clear_depth);
+    serialize(in_gl_context_state_ptr->cull_face_mode);
+    serialize(in_gl_context_state_ptr->depth_func);
+    serialize(in_gl_context_state_ptr->depth_mask);
+    serialize(in_gl_context_state_ptr->depth_range);
+    serialize(in_gl_context_state_ptr->draw_buffer_mode);
+    serialize(in_gl_context_state_ptr->front_face_mode);
+    serialize(in_gl_context_state_ptr->matrix_mode);
+    serialize(in_gl_context_state_ptr->shade_model);
+    serialize(in_gl_context_state_ptr->texture_env_mode);
+    serialize(in_gl_context_state_ptr->viewport_extents);
+    serialize(in_gl_context_state_ptr->viewport_x1y1);
+    serialize(in_gl_context_state_ptr->modelview_matrix);
+    serialize(in_gl_context_state_ptr->projection_matrix);
+    serialize(in_gl_context_state_ptr->bound_2d_texture_gl_id);
+
+    serialize(static_cast<uint32_t>(in_gl_context_state_ptr->gl_texture_id_to_texture_state_map.size() ) );
+
+    in_gl_context_state_ptr->gl_texture_id_to_texture_state_map.for_each(
+        [this](const uint32_t&              in_gl_texture_id,
+               const GLContextTextureState& in_texture_state)
+    {
+        serialize(in_gl_texture_id);
+        serialize(in_texture_state);
+    });
+}
+
+void ReplayerCaptureWriter::serialize_mip_data(const U8VecSharedPtr& in_data_u8_vec_ptr,
+                                               const MipProps*       in_opt_mip_props_ptr)
+{
+    uint32_t   n_blob            = UINT32_MAX;
+    const auto blob_map_iterator = m_mip_data_ptr_to_n_blob_map.find(in_data_u8_vec_ptr.get() );
+
+    /* Mip data buffers are immutable once shared, so each one only needs to be stored once. A blob index equal to
+     * the number of blobs stored so far means the data follows. */
+    if (in_data_u8_vec_ptr == nullptr)
+    {
+        serialize(n_blob);
+    }
+    else
+    if (blob_map_iterator != m_mip_data_ptr_to_n_blob_map.end() )
+    {
+        n_blob = blob_map_iterator->second;
+
+        serialize(n_blob);
+    }
+    else
+    {
+        const auto n_bytes     = static_cast<uint32_t>(in_data_u8_vec_ptr->size() );
+        uint32_t   n_base_blob = UINT32_MAX;
+
+        n_blob = static_cast<uint32_t>(m_mip_data_blob_vec.size() );
+
+        /* If the mip has only been updated with glTexSubImage2D() since a version which has already been stored, only
+         * the dirty rectangle needs to be. */
+        if (in_opt_mip_props_ptr != nullptr &&
+            in_opt_mip_props_ptr->has_dirty_rect() )
+        {
+            const auto base_map_iterator = m_mip_data_version_to_n_blob_map.find(in_opt_mip_props_ptr->dirty_base_version);
+
+            if (base_map_iterator                                           != m_mip_data_version_to_n_blob_map.end() &&
+                m_mip_data_blob_vec.at(base_map_iterator->second)->size() == n_bytes)
+            {
+                n_base_blob = base_map_iterator->second;
+            }
+        }
+
+        m_mip_data_blob_vec.push_back       (in_data_u8_vec_ptr);
+        m_mip_data_ptr_to_n_blob_map.emplace(in_data_u8_vec_ptr.get(),
+                                             n_blob);
+
+        serialize(n_blob);
+        serialize(n_bytes);
+        serialize(n_base_blob);
+
+        if (n_base_blob == UINT32_MAX)
+        {
+            serialize(in_data_u8_vec_ptr->data(),
+                      n_bytes);
+        }
+        else
+        {
+            const auto&    mip_size         = in_opt_mip_props_ptr->mip_size_u32vec3;
+            const auto&    rect             = in_opt_mip_props_ptr->dirty_rect_x1y1x2y2;
+            const uint32_t n_components     = n_bytes / (mip_size.at(0) * mip_size.at(1) );
+            const uint32_t n_rect_row_bytes = (rect.at(2) - rect.at(0) ) * n_components;
+            const uint32_t n_row_bytes      = mip_size.at(0)             * n_components;
+
+            serialize(rect);
+
+            for (uint32_t n_row = rect.at(1);
+                          n_row < rect.at(3);
+                        ++n_row)
+            {
+                serialize(in_data_u8_vec_ptr->data() + n_row * n_row_bytes + rect.at(0) * n_components,
+                          n_rect_row_bytes);
+            }
+        }
+    }
+
+    if (in_opt_mip_props_ptr != nullptr &&
+        n_blob               != UINT32_MAX)
+    {
+        m_mip_data_version_to_n_blob_map[in_opt_mip_props_ptr->data_version] = n_blob;
+    }
+}
+
+void ReplayerCaptureWriter::serialize_texture_props_map(const GLIDToTexturePropsMap* in_gl_id_to_texture_props_map_ptr)
+{
+    serialize(static_cast<uint32_t>(in_gl_id_to_texture_props_map_ptr->size() ) );
+
+    in_gl_id_to_texture_props_map_ptr->for_each(
+        [this](const uint32_t&     in_gl_texture_id,
+               const TextureProps& in_texture_props)
+    {
+        serialize(in_gl_texture_id);
+        serialize(in_texture_props.border);
+        serialize(in_texture_props.type);
+        serialize(static_cast<uint32_t>(in_texture_props.mip_props_vec.size() ) );
+
+        for (const auto& current_mip_props : in_texture_props.mip_props_vec)
+        {
+            serialize(current_mip_props.format);
+            serialize(current_mip_props.internal_format);
+            serialize(current_mip_props.mip_size_u32vec3);
+            serialize(current_mip_props.type);
+
+            serialize_mip_data(current_mip_props.get_data_u8_vec_ptr(), // may wait for the texture ingester
+                              &current_mip_props);
+        }
+    });
+}
+
+void ReplayerCaptureWriter::write_frame(const ReplayerCaptureFrame& in_frame)
+{
+    const bool should_store_texture_props_map = (in_frame.gl_id_to_texture_props_map_ptr != m_last_gl_id_to_texture_props_map_ptr);
+
+    m_frame_data_u8_vec.clear();
+
+    serialize(in_frame.n_frame);
+    serialize((should_store_texture_props_map) ? FRAME_FLAG_HAS_TEXTURE_PROPS_MAP : 0u);
+
+    if (should_store_texture_props_map)
+    {
+        serialize_texture_props_map(in_frame.gl_id_to_texture_props_map_ptr.get() );
+
+        m_last_gl_id_to_texture_props_map_ptr = in_frame.gl_id_to_texture_props_map_ptr;
+    }
+
+    serialize_gl_context_state(in_frame.start_gl_context_state_ptr.get() );
+    serialize_commands        (in_frame.snapshot_ptr.get              () );
+
+    if (m_file_ptr != nullptr)
+    {
+        ::fwrite(m_frame_data_u8_vec.data(),
+                 m_frame_data_u8_vec.size(),
+                 1, /* count */
+                 m_file_ptr);
+    }
+}
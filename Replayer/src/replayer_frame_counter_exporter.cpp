@@ -0,0 +1,245 @@
+/* API Interceptor (c) 2024 Dominik Witczak
+ *
+ * This code is licensed under MIT license (see LICENSE.txt for details)
+ */
+
+// Shoo shoo VS warnings, this is a hobby project.
+#define _CRT_SECURE_NO_WARNINGS
+
+#include "Common/callbacks.h"
+#include "Common/logger.h"
+#include "replayer_frame_counter_exporter.h"
+#include <chrono>
+
+
+ReplayerFrameCounterExporter::ReplayerFrameCounterExporter(const std::string& in_filename,
+                                                           const uint32_t&    in_n_ring_frames)
+    :m_file_ptr              (nullptr),
+     m_filename              (in_filename),
+     m_ring_vec              (in_n_ring_frames),
+     m_n_frames_dropped      (0),
+     m_n_frames_exported     (0),
+     m_n_frames_pushed       (0),
+     m_worker_thread_must_die(false)
+{
+    /* Stub */
+}
+
+ReplayerFrameCounterExporter::~ReplayerFrameCounterExporter()
+{
+    /* NOTE: Frames which have already been pushed are still exported before the thread quits. */
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        m_worker_thread_must_die = true;
+    }
+
+    m_must_die_cv.notify_one();
+    m_worker_thread.join    ();
+
+    if (m_file_ptr != nullptr)
+    {
+        ::fclose(m_file_ptr);
+    }
+}
+
+ReplayerFrameCounterExporterUniquePtr ReplayerFrameCounterExporter::create(const std::string& in_filename,
+                                                                           const uint32_t&    in_n_ring_frames)
+{
+    ReplayerFrameCounterExporterUniquePtr result_ptr(new ReplayerFrameCounterExporter(in_filename,
+                                                                                      in_n_ring_frames) );
+
+    if (result_ptr != nullptr)
+    {
+        if (!result_ptr->init() )
+        {
+            result_ptr.reset();
+        }
+    }
+
+    return result_ptr;
+}
+
+void ReplayerFrameCounterExporter::execute()
+{
+    const auto ring_size = static_cast<uint32_t>(m_ring_vec.size() );
+    bool       must_die  = false;
+
+    APIInterceptor::disable_callbacks_for_this_thread            ();
+    APIInterceptor::g_logger_ptr->disable_logging_for_this_thread();
+
+    write_header();
+
+    while (!must_die)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+
+            m_must_die_cv.wait_for(lock,
+                                   std::chrono::milliseconds(EXPORT_PERIOD_MS),
+                                   [this]()
+                                   {
+                                       return m_worker_thread_must_die;
+                                   });
+
+            must_die = m_worker_thread_must_die;
+        }
+
+        /* Drain whatever has piled up since the last time. */
+        {
+            const uint32_t n_frames_pushed = m_n_frames_pushed.load();
+
+            for (uint32_t n_frame = m_n_frames_exported.load();
+                          n_frame != n_frames_pushed;
+                        ++n_frame)
+            {
+                write_frame(m_ring_vec.at(n_frame % ring_size) );
+
+                /* Release the slot. */
+                m_n_frames_exported = n_frame + 1;
+            }
+        }
+
+        ::fflush(m_file_ptr);
+    }
+}
+
+ReplayerFrameCounterExporterStats ReplayerFrameCounterExporter::get_stats() const
+{
+    ReplayerFrameCounterExporterStats result;
+
+    result.n_frames_dropped  = m_n_frames_dropped;
+    result.n_frames_exported = m_n_frames_exported;
+
+    return result;
+}
+
+bool ReplayerFrameCounterExporter::init()
+{
+    AI_ASSERT(m_ring_vec.size() > 0);
+
+    m_file_ptr = ::fopen(m_filename.c_str(), "wt");
+
+    if (m_file_ptr == nullptr)
+    {
+        return false;
+    }
+
+    m_worker_thread = std::thread(&ReplayerFrameCounterExporter::execute,
+                                   this);
+
+    return true;
+}
+
+bool ReplayerFrameCounterExporter::push(const FrameCounters& in_frame_counters)
+{
+    const uint32_t n_frames_pushed = m_n_frames_pushed.load();
+
+    /* NOTE: Counters wrap around, but their difference never exceeds the ring's size. */
+    if (n_frames_pushed - m_n_frames_exported.load() >= static_cast<uint32_t>(m_ring_vec.size() ) )
+    {
+        m_n_frames_dropped++;
+
+        return false;
+    }
+
+    m_ring_vec.at(n_frames_pushed % m_ring_vec.size() ) = in_frame_counters;
+    m_n_frames_pushed                                     = n_frames_pushed + 1;
+
+    return true;
+}
+
+void ReplayerFrameCounterExporter::write_frame(const FrameCounters& in_frame_counters)
+{
+    char value_string[32];
+
+    m_row_string.clear();
+
+    snprintf(value_string,
+             sizeof(value_string),
+             "%u,%u,%u,%llu",
+             in_frame_counters.n_frame,
+             in_frame_counters.frame_time_us,
+             in_frame_counters.n_texture_binds,
+             static_cast<unsigned long long>(in_frame_counters.n_texture_upload_bytes) );
+
+    m_row_string += value_string;
+
+    for (uint32_t n_primitive_type = 0;
+                  n_primitive_type < FrameCounters::N_PRIMITIVE_TYPES;
+                ++n_primitive_type)
+    {
+        snprintf(value_string,
+                 sizeof(value_string),
+                 ",%u",
+                 in_frame_counters.n_vertices_per_primitive_type[n_primitive_type]);
+
+        m_row_string += value_string;
+    }
+
+    /* Only entrypoints used by GLQuake get a column. */
+    for (uint32_t n_entry = 0;
+                  n_entry < GLFunctionInfoTable::N_ENTRIES;
+                ++n_entry)
+    {
+        if (g_gl_function_info_table.info_vec[n_entry].name != nullptr)
+        {
+            snprintf(value_string,
+                     sizeof(value_string),
+                     ",%u",
+                     in_frame_counters.n_api_calls_per_func[n_entry]);
+
+            m_row_string += value_string;
+        }
+    }
+
+    m_row_string += "\n";
+
+    ::fwrite(m_row_string.data(),
+             m_row_string.size(),
+             1, /* count */
+             m_file_ptr);
+}
+
+void ReplayerFrameCounterExporter::write_header()
+{
+    static const char* primitive_type_name_ptr_vec[FrameCounters::N_PRIMITIVE_TYPES] =
+    {
+        "GL_POINTS",
+        "GL_LINES",
+        "GL_LINE_LOOP",
+        "GL_LINE_STRIP",
+        "GL_TRIANGLES",
+        "GL_TRIANGLE_STRIP",
+        "GL_TRIANGLE_FAN",
+        "GL_QUADS",
+        "GL_QUAD_STRIP",
+        "GL_POLYGON"
+    };
+
+    m_row_string = "frame,frame_time_us,n_texture_binds,n_texture_upload_bytes";
+
+    for (const auto& current_primitive_type_name_ptr : primitive_type_name_ptr_vec)
+    {
+        m_row_string += ",n_vertices_";
+        m_row_string += current_primitive_type_name_ptr;
+    }
+
+    for (uint32_t n_entry = 0;
+                  n_entry < GLFunctionInfoTable::N_ENTRIES;
+                ++n_entry)
+    {
+        if (g_gl_function_info_table.info_vec[n_entry].name != nullptr)
+        {
+            m_row_string += ",n_calls_";
+            m_row_string += g_gl_function_info_table.info_vec[n_entry].name;
+        }
+    }
+
+    m_row_string += "\n";
+
+    ::fwrite(m_row_string.data(),
+             m_row_string.size(),
+             1, /* count */
+             m_file_ptr);
+}
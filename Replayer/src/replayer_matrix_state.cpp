@@ -0,0 +1,334 @@
+/* API Interceptor (c) 2024 Dominik Witczak
+ *
+ * This code is licensed under MIT license (see LICENSE.txt for details)
+ */
+#include "OpenGL/globals.h"
+#include "replayer_gl_functions.h"
+#include "replayer_matrix_state.h"
+#include "replayer_snapshot.h"
+#include <cmath>
+
+static const double g_identity_matrix[16] =
+{
+    1.0, 0.0, 0.0, 0.0,
+    0.0, 1.0, 0.0, 0.0,
+    0.0, 0.0, 1.0, 0.0,
+    0.0, 0.0, 0.0, 1.0
+};
+
+
+ReplayerMatrixState::ReplayerMatrixState()
+{
+    reset(GL_MODELVIEW,
+          g_identity_matrix,
+          g_identity_matrix);
+}
+
+bool ReplayerMatrixState::apply(const APIInterceptor::APIFunction&         in_api_func,
+                                const APIInterceptor::APIFunctionArgument* in_args_ptr)
+{
+    bool result = true;
+
+    switch (in_api_func)
+    {
+        case APIInterceptor::APIFUNCTION_GL_GLFRUSTUM:
+        {
+            const CommandView<APIInterceptor::APIFUNCTION_GL_GLFRUSTUM> command(in_args_ptr);
+
+            const double left   = command.get<0>();
+            const double right  = command.get<1>();
+            const double bottom = command.get<2>();
+            const double top    = command.get<3>();
+            const double z_near = command.get<4>();
+            const double z_far  = command.get<5>();
+            const double matrix[16] =
+            {
+                2.0 * z_near / (right - left),     0.0,                               0.0,                                       0.0,
+                0.0,                               2.0 * z_near / (top - bottom),     0.0,                                       0.0,
+                (right + left) / (right - left),   (top + bottom) / (top - bottom),   -(z_far + z_near) / (z_far - z_near),     -1.0,
+                0.0,                               0.0,                               -2.0 * z_far * z_near / (z_far - z_near),  0.0
+            };
+
+            multiply(matrix);
+
+            break;
+        }
+
+        case APIInterceptor::APIFUNCTION_GL_GLLOADIDENTITY:
+        {
+            auto stack_ptr = get_current_stack();
+
+            memcpy(stack_ptr->matrix_vec.at(stack_ptr->n_top_matrix).data(),
+                   g_identity_matrix,
+                   sizeof(g_identity_matrix) );
+
+            break;
+        }
+
+        case APIInterceptor::APIFUNCTION_GL_GLMATRIXMODE:
+        {
+            const CommandView<APIInterceptor::APIFUNCTION_GL_GLMATRIXMODE> command(in_args_ptr);
+
+            m_matrix_mode = command.get<0>();
+
+            break;
+        }
+
+        case APIInterceptor::APIFUNCTION_GL_GLORTHO:
+        {
+            const CommandView<APIInterceptor::APIFUNCTION_GL_GLORTHO> command(in_args_ptr);
+
+            const double left   = command.get<0>();
+            const double right  = command.get<1>();
+            const double bottom = command.get<2>();
+            const double top    = command.get<3>();
+            const double z_near = command.get<4>();
+            const double z_far  = command.get<5>();
+            const double matrix[16] =
+            {
+                2.0 / (right - left),               0.0,                                0.0,                                  0.0,
+                0.0,                                2.0 / (top - bottom),               0.0,                                  0.0,
+                0.0,                                0.0,                                -2.0 / (z_far - z_near),              0.0,
+                -(right + left) / (right - left),   -(top + bottom) / (top - bottom),   -(z_far + z_near) / (z_far - z_near), 1.0
+            };
+
+            multiply(matrix);
+
+            break;
+        }
+
+        case APIInterceptor::APIFUNCTION_GL_GLPOPMATRIX:
+        {
+            auto stack_ptr = get_current_stack();
+
+            if (stack_ptr->n_top_matrix > 0)
+            {
+                stack_ptr->n_top_matrix--;
+            }
+
+            break;
+        }
+
+        case APIInterceptor::APIFUNCTION_GL_GLPUSHMATRIX:
+        {
+            auto stack_ptr = get_current_stack();
+
+            /* NOTE: Overflows raise GL_STACK_OVERFLOW and leave the stack untouched. */
+            if (stack_ptr->n_top_matrix + 1 < MAX_STACK_DEPTH)
+            {
+                stack_ptr->matrix_vec.at(stack_ptr->n_top_matrix + 1) = stack_ptr->matrix_vec.at(stack_ptr->n_top_matrix);
+                stack_ptr->n_top_matrix++;
+            }
+
+            break;
+        }
+
+        case APIInterceptor::APIFUNCTION_GL_GLROTATEF:
+        {
+            const CommandView<APIInterceptor::APIFUNCTION_GL_GLROTATEF> command(in_args_ptr);
+
+            const double angle_radians = static_cast<double>(command.get<0>() ) * 3.14159265358979323846 / 180.0;
+            double       x             = command.get<1>();
+            double       y             = command.get<2>();
+            double       z             = command.get<3>();
+            const double length        = sqrt(x * x + y * y + z * z);
+
+            if (length > 0.0)
+            {
+                x /= length;
+                y /= length;
+                z /= length;
+            }
+
+            {
+                const double c           = cos(angle_radians);
+                const double s           = sin(angle_radians);
+                const double one_minus_c = 1.0 - c;
+                const double matrix[16]  =
+                {
+                    x * x * one_minus_c + c,     y * x * one_minus_c + z * s, x * z * one_minus_c - y * s, 0.0,
+                    x * y * one_minus_c - z * s, y * y * one_minus_c + c,     y * z * one_minus_c + x * s, 0.0,
+                    x * z * one_minus_c + y * s, y * z * one_minus_c - x * s, z * z * one_minus_c + c,     0.0,
+                    0.0,                         0.0,                         0.0,                         1.0
+                };
+
+                multiply(matrix);
+            }
+
+            break;
+        }
+
+        case APIInterceptor::APIFUNCTION_GL_GLSCALEF:
+        {
+            const CommandView<APIInterceptor::APIFUNCTION_GL_GLSCALEF> command(in_args_ptr);
+
+            const double matrix[16] =
+            {
+                command.get<0>(), 0.0,              0.0,              0.0,
+                0.0,              command.get<1>(), 0.0,              0.0,
+                0.0,              0.0,              command.get<2>(), 0.0,
+                0.0,              0.0,              0.0,              1.0
+            };
+
+            multiply(matrix);
+
+            break;
+        }
+
+        case APIInterceptor::APIFUNCTION_GL_GLTRANSLATEF:
+        {
+            const CommandView<APIInterceptor::APIFUNCTION_GL_GLTRANSLATEF> command(in_args_ptr);
+
+            const double matrix[16] =
+            {
+                1.0,              0.0,              0.0,              0.0,
+                0.0,              1.0,              0.0,              0.0,
+                0.0,              0.0,              1.0,              0.0,
+                command.get<0>(), command.get<1>(), command.get<2>(), 1.0
+            };
+
+            multiply(matrix);
+
+            break;
+        }
+
+        default:
+        {
+            result = false;
+        }
+    }
+
+    return result;
+}
+
+ReplayerMatrixState::MatrixStack* ReplayerMatrixState::get_current_stack()
+{
+    switch (m_matrix_mode)
+    {
+        case GL_PROJECTION: return &m_projection_stack;
+        case GL_TEXTURE:    return &m_texture_stack;
+
+        default:
+        {
+            assert(m_matrix_mode == GL_MODELVIEW);
+
+            return &m_modelview_stack;
+        }
+    }
+}
+
+void ReplayerMatrixState::get_draw_mvp_matrices(const GLContextState*         in_start_gl_context_state_ptr,
+                                                const ReplayerSnapshot*       in_snapshot_ptr,
+                                                std::vector<ReplayerDrawMVP>* out_draw_mvp_vec_ptr)
+{
+    const auto          n_api_commands = in_snapshot_ptr->get_n_api_commands();
+    ReplayerMatrixState matrix_state;
+
+    matrix_state.reset(in_start_gl_context_state_ptr->matrix_mode,
+                       in_start_gl_context_state_ptr->modelview_matrix,
+                       in_start_gl_context_state_ptr->projection_matrix);
+
+    out_draw_mvp_vec_ptr->clear();
+
+    for (uint32_t n_api_command = 0;
+                  n_api_command < n_api_commands;
+                ++n_api_command)
+    {
+        const auto api_command_ptr = in_snapshot_ptr->get_api_command_ptr(n_api_command);
+
+        if (api_command_ptr->api_func == APIInterceptor::APIFUNCTION_GL_GLBEGIN)
+        {
+            ReplayerDrawMVP draw_mvp;
+
+            matrix_state.get_modelview_projection_matrix(draw_mvp.mvp_matrix.data() );
+
+            draw_mvp.n_api_command = n_api_command;
+
+            out_draw_mvp_vec_ptr->push_back(draw_mvp);
+        }
+        else
+        if (get_gl_function_info(api_command_ptr->api_func).function_class == GLFunctionClass::MATRIX)
+        {
+            matrix_state.apply(api_command_ptr->api_func,
+                               api_command_ptr->api_arg_vec.data() );
+        }
+    }
+}
+
+void ReplayerMatrixState::get_modelview_projection_matrix(double* out_mvp_matrix_ptr) const
+{
+    multiply_matrices(get_projection_matrix(),
+                      get_modelview_matrix (),
+                      out_mvp_matrix_ptr);
+}
+
+const double* ReplayerMatrixState::get_modelview_matrix() const
+{
+    return m_modelview_stack.matrix_vec.at(m_modelview_stack.n_top_matrix).data();
+}
+
+const double* ReplayerMatrixState::get_projection_matrix() const
+{
+    return m_projection_stack.matrix_vec.at(m_projection_stack.n_top_matrix).data();
+}
+
+void ReplayerMatrixState::multiply(const double* in_matrix_ptr)
+{
+    auto   stack_ptr  = get_current_stack();
+    auto   top_ptr    = stack_ptr->matrix_vec.at(stack_ptr->n_top_matrix).data();
+    double result[16];
+
+    multiply_matrices(top_ptr,
+                      in_matrix_ptr,
+                      result);
+
+    memcpy(top_ptr,
+           result,
+           sizeof(result) );
+}
+
+void ReplayerMatrixState::multiply_matrices(const double* in_a_ptr,
+                                            const double* in_b_ptr,
+                                            double*       out_result_ptr)
+{
+    for (uint32_t n_column = 0;
+                  n_column < 4;
+                ++n_column)
+    {
+        for (uint32_t n_row = 0;
+                      n_row < 4;
+                    ++n_row)
+        {
+            double value = 0.0;
+
+            for (uint32_t n = 0;
+                          n < 4;
+                        ++n)
+            {
+                value += in_a_ptr[n * 4 + n_row] * in_b_ptr[n_column * 4 + n];
+            }
+
+            out_result_ptr[n_column * 4 + n_row] = value;
+        }
+    }
+}
+
+void ReplayerMatrixState::reset(const uint32_t& in_matrix_mode,
+                                const double*   in_modelview_matrix_ptr,
+                                const double*   in_projection_matrix_ptr)
+{
+    m_matrix_mode                   = in_matrix_mode;
+    m_modelview_stack.n_top_matrix  = 0;
+    m_projection_stack.n_top_matrix = 0;
+    m_texture_stack.n_top_matrix    = 0;
+
+    memcpy(m_modelview_stack.matrix_vec.at(0).data(),
+           in_modelview_matrix_ptr,
+           sizeof(double) * 16);
+    memcpy(m_projection_stack.matrix_vec.at(0).data(),
+           in_projection_matrix_ptr,
+           sizeof(double) * 16);
+    memcpy(m_texture_stack.matrix_vec.at(0).data(),
+           g_identity_matrix,
+           sizeof(g_identity_matrix) );
+}
@@ -0,0 +1,292 @@
+/* API Interceptor (c) 2024 Dominik Witczak
+ *
+ * This code is licensed under MIT license (see LICENSE.txt for details)
+ */
+#include "OpenGL/globals.h"
+#include "replayer_gl_functions.h"
+#include "replayer_segment_analyzer.h"
+
+
+ReplayerSegmentAnalyzer::ReplayerSegmentAnalyzer(const std::array<uint32_t, 2>& in_q1_window_extents)
+    :m_q1_window_extents(in_q1_window_extents)
+{
+    reset();
+}
+
+void ReplayerSegmentAnalyzer::consume(const ReplayerSnapshot& in_snapshot)
+{
+    const auto n_completed_commands = in_snapshot.get_n_completed_api_commands();
+
+    while (m_n_next_command < n_completed_commands)
+    {
+        on_command(m_n_next_command,
+                   in_snapshot.get_api_command_ptr(m_n_next_command) );
+
+        m_n_next_command++;
+    }
+}
+
+ReplayerSegmentAnalyzerUniquePtr ReplayerSegmentAnalyzer::create(const std::array<uint32_t, 2>& in_q1_window_extents)
+{
+    return ReplayerSegmentAnalyzerUniquePtr(new ReplayerSegmentAnalyzer(in_q1_window_extents) );
+}
+
+void ReplayerSegmentAnalyzer::finish(const ReplayerSnapshot& in_snapshot,
+                                     ReplayerSegmentTable*   out_segment_table_ptr)
+{
+    const auto n_commands = in_snapshot.get_n_api_commands();
+
+    assert(in_snapshot.get_n_completed_api_commands() == n_commands);
+
+    consume(in_snapshot);
+
+    if (m_is_screen_space_geom_reached)
+    {
+        m_segment_table.n_screen_space_geom_api_last_command = n_commands - 1;
+    }
+
+    if (m_env_mode_modulate_command_range_vec.size() > 0)
+    {
+        // Identify API call ranges used to shade 3D models.
+        {
+            const auto n_last_valid_command_api = m_env_mode_modulate_command_range_vec.back().at(0) - 1;
+
+            for (const auto& current_draw_api_command_range : m_draws_with_env_mode_modulate_command_range_vec)
+            {
+                if (current_draw_api_command_range.at(1) <= n_last_valid_command_api)
+                {
+                    m_segment_table.shade_model_command_range_vec.emplace_back(current_draw_api_command_range);
+                }
+                else
+                {
+                    break;
+                }
+            }
+        }
+
+        // Identify API call range used to draw the weapon.
+        {
+            const auto n_env_mode_modulate_start_command = m_env_mode_modulate_command_range_vec.back().at(0);
+
+            for (const auto& current_range : m_draws_with_env_mode_modulate_command_range_vec)
+            {
+                if (current_range.at(0) >= n_env_mode_modulate_start_command)
+                {
+                    m_segment_table.n_weapon_draw_first_command = current_range.at(0);
+                    m_segment_table.n_weapon_draw_last_command  = m_env_mode_modulate_command_range_vec.back().at(1);
+
+                    break;
+                }
+            }
+        }
+    }
+
+    /* Hand the segments over. Whatever the table held before is recycled for the next snapshot. */
+    std::swap(*out_segment_table_ptr,
+              m_segment_table);
+
+    reset();
+}
+
+void ReplayerSegmentAnalyzer::on_command(const uint32_t&                    in_n_command,
+                                         const ReplayerSnapshotCommandView& in_command)
+{
+    if (m_is_screen_space_geom_reached)
+    {
+        return;
+    }
+
+    /* An AO segment starts with a glBlendFunc() call which is directly followed by glEnable(). */
+    if (m_n_ao_segment_candidate_command != UINT32_MAX)
+    {
+        if (in_command.api_func == APIInterceptor::APIFunction::APIFUNCTION_GL_GLENABLE)
+        {
+            if (m_n_ao_segment_start_command == UINT32_MAX)
+            {
+                m_n_ao_segment_start_command = m_n_ao_segment_candidate_command;
+            }
+            else
+            {
+                assert(false);
+            }
+        }
+
+        m_n_ao_segment_candidate_command = UINT32_MAX;
+    }
+
+    // All models are "AO-shaded" exclusively by rendering the geometry in question with ENV_MODE set to GL_MODULATE
+    // and with blending disabled.
+    //
+    // Particles are also shaded this method, the excpetion being blending is enabled in this case and there is no
+    // "pre-pass".
+    //
+    // To determine the range used to render the weapon, we:
+    //
+    // 1) Collect snapshot ranges when ENV_MODE is set to GL_MODULATE.
+    // 2) Collect snapshot ranges of glBegin()/glEnd() calls when blending is disabled.
+    //
+    // All draw calls generated while ENV_MODE is set to GL_MODULATE for the last time are used to draw the weapon.
+    //
+    // To determine draw calls used to shade monsters and other 3D models, we simply look at the remaining snapshot ranges.
+    if (in_command.api_func == APIInterceptor::APIFunction::APIFUNCTION_GL_GLTEXENVF)
+    {
+        const CommandView<APIInterceptor::APIFUNCTION_GL_GLTEXENVF> command(in_command);
+
+        const auto mode = static_cast<uint32_t>(command.get<2>() );
+
+        if (mode == GL_MODULATE)
+        {
+            if (m_env_mode_modulate_command_range_vec.size()       == 0          ||
+                m_env_mode_modulate_command_range_vec.back().at(1) != UINT32_MAX)
+            {
+                m_env_mode_modulate_command_range_vec.push_back(std::array<uint32_t, 2>{in_n_command, UINT32_MAX});
+            }
+        }
+        else
+        {
+            if (m_env_mode_modulate_command_range_vec.size()       >  0 &&
+                m_env_mode_modulate_command_range_vec.back().at(1) == UINT32_MAX)
+            {
+                m_env_mode_modulate_command_range_vec.back().at(1) = in_n_command - 1;
+            }
+        }
+
+        if (m_is_blending_enabled == false &&
+            mode                  == GL_MODULATE)
+        {
+            assert(m_n_weapon_draw_segment_start_command == UINT32_MAX);
+
+            m_is_modulate_env_mode_enabled = true;
+        }
+        else
+        {
+            m_is_modulate_env_mode_enabled = false;
+        }
+    }
+
+    if (m_is_modulate_env_mode_enabled == true)
+    {
+        if (in_command.api_func == APIInterceptor::APIFunction::APIFUNCTION_GL_GLBEGIN &&
+            in_command.vertex_batch.is_valid() )
+        {
+            /* Vertex batches cover the whole glBegin() .. glEnd() run with a single command. */
+            assert(m_n_weapon_draw_segment_start_command == UINT32_MAX);
+
+            m_draws_with_env_mode_modulate_command_range_vec.emplace_back(
+                std::array<uint32_t, 2>{in_n_command,
+                                        in_n_command}
+            );
+        }
+        else
+        if (in_command.api_func == APIInterceptor::APIFunction::APIFUNCTION_GL_GLBEGIN)
+        {
+            assert(m_n_weapon_draw_segment_start_command == UINT32_MAX);
+
+            m_n_weapon_draw_segment_start_command = in_n_command;
+        }
+        else
+        if (in_command.api_func == APIInterceptor::APIFunction::APIFUNCTION_GL_GLEND)
+        {
+            assert(m_n_weapon_draw_segment_start_command != UINT32_MAX);
+
+            m_draws_with_env_mode_modulate_command_range_vec.emplace_back(
+                std::array<uint32_t, 2>{m_n_weapon_draw_segment_start_command,
+                                        in_n_command}
+            );
+
+            m_n_weapon_draw_segment_start_command = UINT32_MAX;
+        }
+    }
+
+    if (in_command.api_func == APIInterceptor::APIFunction::APIFUNCTION_GL_GLBLENDFUNC)
+    {
+        // For scene geometry, Q1 appears to first render diffuse-only textures first, and then follow up with AO
+        // achieved by re-rendering the geometry rendered in the earlier pass(es) with a lightmap texture enabled +
+        // special blending settings applied. This can be done multiple times in a single frame.
+        //
+        // This segment ends with the first glDisable(GL_BLEND) call encountered.
+        const CommandView<APIInterceptor::APIFUNCTION_GL_GLBLENDFUNC> command(in_command);
+
+        const auto sfactor = command.get<0>();
+        const auto dfactor = command.get<1>();
+
+        if (sfactor == GL_ZERO                  &&
+            dfactor == GL_ONE_MINUS_SRC_COLOR)
+        {
+            /* Whether this starts a segment depends on the next command. */
+            m_n_ao_segment_candidate_command = in_n_command;
+        }
+    }
+
+    if (in_command.api_func == APIInterceptor::APIFunction::APIFUNCTION_GL_GLDISABLE)
+    {
+        const auto cap = CommandView<APIInterceptor::APIFUNCTION_GL_GLDISABLE>(in_command).get<0>();
+
+        if (cap == GL_BLEND)
+        {
+            m_is_blending_enabled = false;
+        }
+
+        if (m_n_ao_segment_start_command != UINT32_MAX &&
+            cap                          == GL_BLEND)
+        {
+            m_segment_table.ao_command_range_vec.push_back(std::array<uint32_t, 2>{m_n_ao_segment_start_command,
+                                                                                   in_n_command});
+
+            m_n_ao_segment_start_command = UINT32_MAX;
+        }
+    }
+    else
+    if (in_command.api_func == APIInterceptor::APIFunction::APIFUNCTION_GL_GLENABLE)
+    {
+        const auto cap = CommandView<APIInterceptor::APIFUNCTION_GL_GLENABLE>(in_command).get<0>();
+
+        if (cap == GL_BLEND)
+        {
+            m_is_blending_enabled = true;
+        }
+    }
+
+    if (in_command.api_func == APIInterceptor::APIFunction::APIFUNCTION_GL_GLORTHO)
+    {
+        const CommandView<APIInterceptor::APIFUNCTION_GL_GLORTHO> command(in_command);
+
+        const auto left   = static_cast<uint32_t>(command.get<0>() );
+        const auto right  = static_cast<uint32_t>(command.get<1>() );
+        const auto bottom = static_cast<uint32_t>(command.get<2>() );
+        const auto top    = static_cast<uint32_t>(command.get<3>() );
+
+        if (left   == 0                         &&
+            top    == 0                         &&
+            right  == m_q1_window_extents.at(0) &&
+            bottom == m_q1_window_extents.at(1) )
+        {
+            /* Screen-space geometry (console, status bar) spans the remainder of the frame. */
+            m_segment_table.n_screen_space_geom_api_first_command = in_n_command;
+            m_is_screen_space_geom_reached                        = true;
+
+            return;
+        }
+    }
+
+    if (in_command.api_func                      == APIInterceptor::APIFunction::APIFUNCTION_GL_GLROTATEF &&
+        m_segment_table.n_first_glrotate_command == UINT32_MAX)
+    {
+        m_segment_table.n_first_glrotate_command = in_n_command;
+    }
+}
+
+void ReplayerSegmentAnalyzer::reset()
+{
+    m_is_blending_enabled                 = false;
+    m_is_modulate_env_mode_enabled        = false;
+    m_is_screen_space_geom_reached        = false;
+    m_n_ao_segment_candidate_command      = UINT32_MAX;
+    m_n_ao_segment_start_command          = UINT32_MAX;
+    m_n_next_command                      = 0;
+    m_n_weapon_draw_segment_start_command = UINT32_MAX;
+
+    m_draws_with_env_mode_modulate_command_range_vec.clear();
+    m_env_mode_modulate_command_range_vec.clear           ();
+    m_segment_table.reset                                 ();
+}
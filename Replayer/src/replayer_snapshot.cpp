@@ -2,13 +2,122 @@
  *
  * This code is licensed under MIT license (see LICENSE.txt for details)
  */
+#include <algorithm>
 #include <cassert>
 #include <functional>
 #include "replayer_snapshot.h"
 
+#ifdef min
+    #undef min
+#endif
+
+std::atomic<uint32_t> ReplayerSnapshot::m_n_total_heap_allocations(0);
+
+void ReplayerSnapshotCommandView::to_api_command(APIInterceptor::APICommand* out_api_command_ptr) const
+{
+    out_api_command_ptr->api_func = api_func;
+
+    out_api_command_ptr->api_arg_vec.assign(api_arg_vec.begin(),
+                                            api_arg_vec.end  () );
+}
+
+uint32_t ReplayerVertexBatchView::expand(const ReplayerVertexBatchVertex& in_vertex,
+                                         ReplayerExpandedAPICommand*      out_api_command_ptr)
+{
+    uint32_t n_api_commands = 0;
+
+    if ((in_vertex.attribute_mask & ReplayerVertexBatchVertex::ATTRIBUTE_COLOR_MASK) != 0)
+    {
+        auto command_ptr = out_api_command_ptr + n_api_commands++;
+
+        if ((in_vertex.attribute_mask & ReplayerVertexBatchVertex::ATTRIBUTE_COLOR_3UB) != 0)
+        {
+            command_ptr->api_func       = APIInterceptor::APIFUNCTION_GL_GLCOLOR3UB;
+            command_ptr->n_api_args     = 3;
+            command_ptr->api_arg_vec[0] = APIInterceptor::APIFunctionArgument::create_u8(static_cast<uint8_t>(in_vertex.color[0]) );
+            command_ptr->api_arg_vec[1] = APIInterceptor::APIFunctionArgument::create_u8(static_cast<uint8_t>(in_vertex.color[1]) );
+            command_ptr->api_arg_vec[2] = APIInterceptor::APIFunctionArgument::create_u8(static_cast<uint8_t>(in_vertex.color[2]) );
+        }
+        else
+        {
+            const bool is_color_4f = ((in_vertex.attribute_mask & ReplayerVertexBatchVertex::ATTRIBUTE_COLOR_4F) != 0);
+
+            command_ptr->api_func   = (is_color_4f) ? APIInterceptor::APIFUNCTION_GL_GLCOLOR4F
+                                                    : APIInterceptor::APIFUNCTION_GL_GLCOLOR3F;
+            command_ptr->n_api_args = (is_color_4f) ? 4
+                                                    : 3;
+
+            for (uint32_t n_component = 0;
+                          n_component < command_ptr->n_api_args;
+                        ++n_component)
+            {
+                command_ptr->api_arg_vec[n_component] = APIInterceptor::APIFunctionArgument::create_fp32(in_vertex.color[n_component]);
+            }
+        }
+    }
+
+    if ((in_vertex.attribute_mask & ReplayerVertexBatchVertex::ATTRIBUTE_TEXCOORD_2F) != 0)
+    {
+        auto command_ptr = out_api_command_ptr + n_api_commands++;
+
+        command_ptr->api_func       = APIInterceptor::APIFUNCTION_GL_GLTEXCOORD2F;
+        command_ptr->n_api_args     = 2;
+        command_ptr->api_arg_vec[0] = APIInterceptor::APIFunctionArgument::create_fp32(in_vertex.texcoord[0]);
+        command_ptr->api_arg_vec[1] = APIInterceptor::APIFunctionArgument::create_fp32(in_vertex.texcoord[1]);
+    }
+
+    if ((in_vertex.attribute_mask & ReplayerVertexBatchVertex::ATTRIBUTE_POSITION_MASK) != 0)
+    {
+        auto command_ptr = out_api_command_ptr + n_api_commands++;
+
+        if ((in_vertex.attribute_mask & ReplayerVertexBatchVertex::ATTRIBUTE_POSITION_2F) != 0)
+        {
+            command_ptr->api_func   = APIInterceptor::APIFUNCTION_GL_GLVERTEX2F;
+            command_ptr->n_api_args = 2;
+        }
+        else
+        if ((in_vertex.attribute_mask & ReplayerVertexBatchVertex::ATTRIBUTE_POSITION_3F) != 0)
+        {
+            command_ptr->api_func   = APIInterceptor::APIFUNCTION_GL_GLVERTEX3F;
+            command_ptr->n_api_args = 3;
+        }
+        else
+        {
+            command_ptr->api_func   = APIInterceptor::APIFUNCTION_GL_GLVERTEX4F;
+            command_ptr->n_api_args = 4;
+        }
+
+        for (uint32_t n_component = 0;
+                      n_component < command_ptr->n_api_args;
+                    ++n_component)
+        {
+            command_ptr->api_arg_vec[n_component] = APIInterceptor::APIFunctionArgument::create_fp32(in_vertex.position[n_component]);
+        }
+    }
+
+    return n_api_commands;
+}
+
 ReplayerSnapshot::ReplayerSnapshot()
+    :m_n_api_args                    (0),
+     m_n_api_commands                (0),
+     m_n_current_arg_chunk           (0),
+     m_n_vertices                    (0),
+     m_is_vertex_batching_enabled    (false),
+     m_n_active_vertex_batch_command (UINT32_MAX),
+     m_pending_vertex                (),
+     m_has_segment_table             (false),
+     m_is_cpu_timing_enabled         (false),
+     m_n_cpu_ticks_per_second        (0.0),
+     m_n_cpu_timestamp_overhead_ticks(0),
+     m_n_pending_cpu_ticks           (0),
+     m_n_trailing_cpu_ticks          (0)
 {
-    /* Stub */
+    ++m_n_total_heap_allocations;
+
+    allocate_arg_chunk    ();
+    allocate_command_chunk();
+    allocate_vertex_chunk ();
 }
 
 ReplayerSnapshot::~ReplayerSnapshot()
@@ -16,46 +125,686 @@ ReplayerSnapshot::~ReplayerSnapshot()
     /* Stub */
 }
 
-ReplayerSnapshotUniquePtr ReplayerSnapshot::create()
+void ReplayerSnapshot::allocate_arg_chunk()
+{
+    m_arg_chunk_vec.emplace_back();
+    m_arg_chunk_vec.back().reserve(ARG_CHUNK_SIZE);
+
+    ++m_n_total_heap_allocations;
+}
+
+void ReplayerSnapshot::allocate_command_chunk()
+{
+    m_command_chunk_vec.emplace_back();
+    m_command_chunk_vec.back().reserve(COMMAND_CHUNK_SIZE);
+
+    ++m_n_total_heap_allocations;
+
+    if (m_is_cpu_timing_enabled)
+    {
+        allocate_cpu_ticks_chunk();
+    }
+}
+
+void ReplayerSnapshot::allocate_cpu_ticks_chunk()
+{
+    m_cpu_ticks_chunk_vec.emplace_back();
+    m_cpu_ticks_chunk_vec.back().reserve(COMMAND_CHUNK_SIZE);
+
+    ++m_n_total_heap_allocations;
+}
+
+void ReplayerSnapshot::allocate_vertex_chunk()
+{
+    m_vertex_chunk_vec.emplace_back();
+    m_vertex_chunk_vec.back().reserve(ReplayerVertexBatchView::CHUNK_SIZE);
+
+    ++m_n_total_heap_allocations;
+}
+
+ReplayerSnapshotUniquePtr ReplayerSnapshot::create(const uint32_t& in_n_api_commands_to_reserve,
+                                                   const uint32_t& in_n_api_args_to_reserve,
+                                                   const uint32_t& in_n_vertices_to_reserve)
 {
     ReplayerSnapshotUniquePtr result_ptr(new ReplayerSnapshot() );
 
     assert(result_ptr != nullptr);
+
+    result_ptr->reserve(in_n_api_commands_to_reserve,
+                        in_n_api_args_to_reserve,
+                        in_n_vertices_to_reserve);
+
     return result_ptr;
 }
 
+void ReplayerSnapshot::finish_cpu_timing(const double&   in_n_cpu_ticks_per_second,
+                                         const uint64_t& in_n_timestamp_overhead_ticks)
+{
+    assert(m_is_cpu_timing_enabled);
+
+    m_n_cpu_ticks_per_second         = in_n_cpu_ticks_per_second;
+    m_n_cpu_timestamp_overhead_ticks = in_n_timestamp_overhead_ticks;
+    m_n_trailing_cpu_ticks           = m_n_pending_cpu_ticks;
+    m_n_pending_cpu_ticks            = 0;
+}
+
+uint32_t ReplayerSnapshot::get_cpu_ticks(const uint32_t& in_n_api_command) const
+{
+    assert(m_is_cpu_timing_enabled);
+    assert(in_n_api_command < m_n_api_commands);
+
+    return m_cpu_ticks_chunk_vec[in_n_api_command >> COMMAND_CHUNK_SIZE_LOG2][in_n_api_command & (COMMAND_CHUNK_SIZE - 1)];
+}
+
+uint32_t ReplayerSnapshot::get_n_api_args() const
+{
+    return m_n_api_args;
+}
+
 uint32_t ReplayerSnapshot::get_n_api_commands() const
 {
-    return static_cast<uint32_t>(m_api_command_vec.size() );
+    return m_n_api_commands;
+}
+
+uint32_t ReplayerSnapshot::get_n_completed_api_commands() const
+{
+    return (m_n_active_vertex_batch_command != UINT32_MAX) ? m_n_active_vertex_batch_command
+                                                           : m_n_api_commands;
+}
+
+uint64_t ReplayerSnapshot::get_n_allocated_bytes() const
+{
+    return static_cast<uint64_t>(m_arg_chunk_vec.size      () ) * ARG_CHUNK_SIZE                      * sizeof(APIInterceptor::APIFunctionArgument) +
+           static_cast<uint64_t>(m_command_chunk_vec.size  () ) * COMMAND_CHUNK_SIZE                  * sizeof(Command)                             +
+           static_cast<uint64_t>(m_cpu_ticks_chunk_vec.size() ) * COMMAND_CHUNK_SIZE                  * sizeof(uint32_t)                            +
+           static_cast<uint64_t>(m_vertex_chunk_vec.size   () ) * ReplayerVertexBatchView::CHUNK_SIZE * sizeof(ReplayerVertexBatchVertex);
+}
+
+double ReplayerSnapshot::get_n_cpu_ticks_per_second() const
+{
+    return m_n_cpu_ticks_per_second;
+}
+
+uint32_t ReplayerSnapshot::get_n_total_heap_allocations()
+{
+    return m_n_total_heap_allocations;
+}
+
+uint32_t ReplayerSnapshot::get_n_vertices() const
+{
+    return m_n_vertices;
+}
+
+ReplayerSnapshotCommandView ReplayerSnapshot::get_api_command_ptr(const uint32_t& in_n_api_command) const
+{
+    assert(in_n_api_command < m_n_api_commands);
+
+    const auto& command       = m_command_chunk_vec[in_n_api_command >> COMMAND_CHUNK_SIZE_LOG2][in_n_api_command & (COMMAND_CHUNK_SIZE - 1)];
+    const auto  first_arg_ptr = m_arg_chunk_vec    [command.n_first_arg >> ARG_CHUNK_SIZE_LOG2].data() + (command.n_first_arg & (ARG_CHUNK_SIZE - 1) );
+
+    if ((command.flags & COMMAND_FLAG_VERTEX_BATCH) != 0)
+    {
+        return ReplayerSnapshotCommandView{command.api_func,
+                                           ReplayerSnapshotArgView(first_arg_ptr,
+                                                                   command.n_args),
+                                           ReplayerVertexBatchView(&m_vertex_chunk_vec,
+                                                                   first_arg_ptr[command.n_args + 0].get_u32(),
+                                                                   first_arg_ptr[command.n_args + 1].get_u32() )};
+    }
+
+    if ((command.flags & COMMAND_FLAG_TEXTURE_UPLOAD) != 0)
+    {
+        return ReplayerSnapshotCommandView{command.api_func,
+                                           ReplayerSnapshotArgView(first_arg_ptr,
+                                                                   command.n_args),
+                                           ReplayerVertexBatchView(),
+                                           m_texture_upload_data_vec[first_arg_ptr[command.n_args + 0].get_u32()].get(),
+                                           first_arg_ptr[command.n_args + 1].get_u32()};
+    }
+
+    return ReplayerSnapshotCommandView{command.api_func,
+                                       ReplayerSnapshotArgView(first_arg_ptr,
+                                                               command.n_args),
+                                       ReplayerVertexBatchView()};
+}
+
+bool ReplayerSnapshot::get_segment_cpu_times(ReplayerSegmentCPUTimes* out_cpu_times_ptr) const
+{
+    if (!has_cpu_ticks()      ||
+        !m_has_segment_table)
+    {
+        return false;
+    }
+
+    const double ns_per_tick         = 1e9 / m_n_cpu_ticks_per_second;
+    uint32_t     n_ao_range          = 0;
+    uint32_t     n_model_range       = 0;
+    uint64_t     n_ticks_frame_start = 0;
+    uint64_t     n_ticks_hud         = 0;
+    uint64_t     n_ticks_lightmaps   = 0;
+    uint64_t     n_ticks_models      = 0;
+    uint64_t     n_ticks_weapon      = 0;
+    uint64_t     n_ticks_world       = 0;
+
+    const auto& ao_range_vec    = m_segment_table.ao_command_range_vec;
+    const auto& model_range_vec = m_segment_table.shade_model_command_range_vec;
+
+    /* Ranges are sorted, so a single pass with a cursor per range list does the job. */
+    for (uint32_t n_command = 0;
+                  n_command < m_n_api_commands;
+                ++n_command)
+    {
+        const uint64_t n_ticks = get_cpu_ticks(n_command);
+
+        while (n_ao_range                        <  static_cast<uint32_t>(ao_range_vec.size() ) &&
+               ao_range_vec.at(n_ao_range).at(1) <  n_command)
+        {
+            n_ao_range++;
+        }
+
+        while (n_model_range                           <  static_cast<uint32_t>(model_range_vec.size() ) &&
+               model_range_vec.at(n_model_range).at(1) <  n_command)
+        {
+            n_model_range++;
+        }
+
+        if (n_command == 0)
+        {
+            n_ticks_frame_start += n_ticks;
+        }
+        else
+        if (m_segment_table.n_screen_space_geom_api_first_command != UINT32_MAX                         &&
+            n_command                                             >= m_segment_table.n_screen_space_geom_api_first_command)
+        {
+            n_ticks_hud += n_ticks;
+        }
+        else
+        if (m_segment_table.n_weapon_draw_first_command != UINT32_MAX                                  &&
+            n_command                                   >= m_segment_table.n_weapon_draw_first_command &&
+            n_command                                   <= m_segment_table.n_weapon_draw_last_command)
+        {
+            n_ticks_weapon += n_ticks;
+        }
+        else
+        if (n_ao_range                        < static_cast<uint32_t>(ao_range_vec.size() ) &&
+            ao_range_vec.at(n_ao_range).at(0) <= n_command)
+        {
+            n_ticks_lightmaps += n_ticks;
+        }
+        else
+        if (n_model_range                           < static_cast<uint32_t>(model_range_vec.size() ) &&
+            model_range_vec.at(n_model_range).at(0) <= n_command)
+        {
+            n_ticks_models += n_ticks;
+        }
+        else
+        {
+            n_ticks_world += n_ticks;
+        }
+    }
+
+    out_cpu_times_ptr->frame_start_ns        = static_cast<uint64_t>(static_cast<double>(n_ticks_frame_start)              * ns_per_tick);
+    out_cpu_times_ptr->hud_ns                = static_cast<uint64_t>(static_cast<double>(n_ticks_hud)                      * ns_per_tick);
+    out_cpu_times_ptr->lightmaps_ns          = static_cast<uint64_t>(static_cast<double>(n_ticks_lightmaps)                * ns_per_tick);
+    out_cpu_times_ptr->models_ns             = static_cast<uint64_t>(static_cast<double>(n_ticks_models)                   * ns_per_tick);
+    out_cpu_times_ptr->timestamp_overhead_ns = static_cast<uint64_t>(static_cast<double>(m_n_cpu_timestamp_overhead_ticks) * ns_per_tick);
+    out_cpu_times_ptr->trailing_ns           = static_cast<uint64_t>(static_cast<double>(m_n_trailing_cpu_ticks)           * ns_per_tick);
+    out_cpu_times_ptr->weapon_ns             = static_cast<uint64_t>(static_cast<double>(n_ticks_weapon)                   * ns_per_tick);
+    out_cpu_times_ptr->world_ns              = static_cast<uint64_t>(static_cast<double>(n_ticks_world)                    * ns_per_tick);
+
+    return true;
 }
 
-const APIInterceptor::APICommand* ReplayerSnapshot::get_api_command_ptr(const uint32_t& in_n_api_command) const
+const ReplayerSegmentTable* ReplayerSnapshot::get_segment_table() const
 {
-    return &m_api_command_vec.at(in_n_api_command);
+    return (m_has_segment_table) ? &m_segment_table
+                                 : nullptr;
+}
+
+ReplayerSegmentTable* ReplayerSnapshot::get_segment_table_for_write()
+{
+    m_has_segment_table = true;
+
+    return &m_segment_table;
+}
+
+bool ReplayerSnapshot::has_cpu_ticks() const
+{
+    return (m_is_cpu_timing_enabled         &&
+            m_n_cpu_ticks_per_second > 0.0);
 }
 
 void ReplayerSnapshot::record_api_call(const APIInterceptor::APIFunction&         in_api_func,
                                        const uint32_t&                            in_n_args,
                                        const APIInterceptor::APIFunctionArgument* in_args_ptr)
 {
-    APIInterceptor::APICommand* cached_api_command_ptr = nullptr;
+    if (m_n_active_vertex_batch_command != UINT32_MAX)
+    {
+        const auto n_batch_command = m_n_active_vertex_batch_command;
+
+        if (record_batched_api_call(in_api_func,
+                                    in_args_ptr) )
+        {
+            if (m_is_cpu_timing_enabled)
+            {
+                auto& n_batch_ticks = m_cpu_ticks_chunk_vec[n_batch_command >> COMMAND_CHUNK_SIZE_LOG2][n_batch_command & (COMMAND_CHUNK_SIZE - 1)];
+
+                n_batch_ticks         = static_cast<uint32_t>(std::min(n_batch_ticks + m_n_pending_cpu_ticks,
+                                                                       static_cast<uint64_t>(UINT32_MAX) ) );
+                m_n_pending_cpu_ticks = 0;
+            }
+
+            return;
+        }
+
+        /* This call cannot be represented in a vertex batch. Fall back to recording the run call by call. */
+        spill_active_vertex_batch();
+    }
+    else
+    if (in_api_func                  == APIInterceptor::APIFUNCTION_GL_GLBEGIN &&
+        m_is_vertex_batching_enabled)
+    {
+        const APIInterceptor::APIFunctionArgument batch_args[] =
+        {
+            in_args_ptr[0],
+            APIInterceptor::APIFunctionArgument::create_u32(m_n_vertices),
+            APIInterceptor::APIFunctionArgument::create_u32(0),
+        };
+
+        m_n_active_vertex_batch_command = m_n_api_commands;
+        m_pending_vertex.attribute_mask = 0;
+
+        record_command(in_api_func,
+                       1, /* in_n_visible_args */
+                       sizeof(batch_args) / sizeof(batch_args[0]),
+                       batch_args,
+                       COMMAND_FLAG_VERTEX_BATCH);
+
+        return;
+    }
+
+    record_command(in_api_func,
+                   in_n_args,
+                   in_n_args,
+                   in_args_ptr,
+                   0); /* in_flags */
+}
+
+bool ReplayerSnapshot::record_batched_api_call(const APIInterceptor::APIFunction&         in_api_func,
+                                               const APIInterceptor::APIFunctionArgument* in_args_ptr)
+{
+    auto& vertex = m_pending_vertex;
+    bool  result = true;
+
+    switch (in_api_func)
+    {
+        case APIInterceptor::APIFUNCTION_GL_GLCOLOR3F:
+        {
+            vertex.attribute_mask = (vertex.attribute_mask & ~ReplayerVertexBatchVertex::ATTRIBUTE_COLOR_MASK) | ReplayerVertexBatchVertex::ATTRIBUTE_COLOR_3F;
+            vertex.color[0]       = in_args_ptr[0].get_fp32();
+            vertex.color[1]       = in_args_ptr[1].get_fp32();
+            vertex.color[2]       = in_args_ptr[2].get_fp32();
+            vertex.color[3]       = 1.0f;
+
+            break;
+        }
+
+        case APIInterceptor::APIFUNCTION_GL_GLCOLOR3UB:
+        {
+            vertex.attribute_mask = (vertex.attribute_mask & ~ReplayerVertexBatchVertex::ATTRIBUTE_COLOR_MASK) | ReplayerVertexBatchVertex::ATTRIBUTE_COLOR_3UB;
+            vertex.color[0]       = static_cast<float>(in_args_ptr[0].get_u8() );
+            vertex.color[1]       = static_cast<float>(in_args_ptr[1].get_u8() );
+            vertex.color[2]       = static_cast<float>(in_args_ptr[2].get_u8() );
+            vertex.color[3]       = 255.0f;
+
+            break;
+        }
+
+        case APIInterceptor::APIFUNCTION_GL_GLCOLOR4F:
+        {
+            vertex.attribute_mask = (vertex.attribute_mask & ~ReplayerVertexBatchVertex::ATTRIBUTE_COLOR_MASK) | ReplayerVertexBatchVertex::ATTRIBUTE_COLOR_4F;
+            vertex.color[0]       = in_args_ptr[0].get_fp32();
+            vertex.color[1]       = in_args_ptr[1].get_fp32();
+            vertex.color[2]       = in_args_ptr[2].get_fp32();
+            vertex.color[3]       = in_args_ptr[3].get_fp32();
+
+            break;
+        }
+
+        case APIInterceptor::APIFUNCTION_GL_GLTEXCOORD2F:
+        {
+            vertex.attribute_mask |= ReplayerVertexBatchVertex::ATTRIBUTE_TEXCOORD_2F;
+            vertex.texcoord[0]     = in_args_ptr[0].get_fp32();
+            vertex.texcoord[1]     = in_args_ptr[1].get_fp32();
+
+            break;
+        }
+
+        case APIInterceptor::APIFUNCTION_GL_GLVERTEX2F:
+        case APIInterceptor::APIFUNCTION_GL_GLVERTEX3F:
+        case APIInterceptor::APIFUNCTION_GL_GLVERTEX4F:
+        {
+            vertex.position[0] = in_args_ptr[0].get_fp32();
+            vertex.position[1] = in_args_ptr[1].get_fp32();
+            vertex.position[2] = 0.0f;
+            vertex.position[3] = 1.0f;
+
+            if (in_api_func == APIInterceptor::APIFUNCTION_GL_GLVERTEX2F)
+            {
+                vertex.attribute_mask |= ReplayerVertexBatchVertex::ATTRIBUTE_POSITION_2F;
+            }
+            else
+            {
+                vertex.position[2] = in_args_ptr[2].get_fp32();
+
+                if (in_api_func == APIInterceptor::APIFUNCTION_GL_GLVERTEX3F)
+                {
+                    vertex.attribute_mask |= ReplayerVertexBatchVertex::ATTRIBUTE_POSITION_3F;
+                }
+                else
+                {
+                    vertex.attribute_mask |= ReplayerVertexBatchVertex::ATTRIBUTE_POSITION_4F;
+                    vertex.position[3]     = in_args_ptr[3].get_fp32();
+                }
+            }
+
+            record_vertex(vertex);
+
+            vertex.attribute_mask = 0;
+            break;
+        }
+
+        case APIInterceptor::APIFUNCTION_GL_GLEND:
+        {
+            /* Attributes specified after the last vertex are preserved as an attribute-only element. */
+            if (vertex.attribute_mask != 0)
+            {
+                record_vertex(vertex);
+
+                vertex.attribute_mask = 0;
+            }
+
+            {
+                const auto& command   = m_command_chunk_vec[m_n_active_vertex_batch_command >> COMMAND_CHUNK_SIZE_LOG2][m_n_active_vertex_batch_command & (COMMAND_CHUNK_SIZE - 1)];
+                auto        args_ptr  = m_arg_chunk_vec    [command.n_first_arg >> ARG_CHUNK_SIZE_LOG2].data() + (command.n_first_arg & (ARG_CHUNK_SIZE - 1) );
+                const auto  n_first_vertex = args_ptr[command.n_args + 0].get_u32();
+
+                args_ptr[command.n_args + 1] = APIInterceptor::APIFunctionArgument::create_u32(m_n_vertices - n_first_vertex);
+            }
+
+            m_n_active_vertex_batch_command = UINT32_MAX;
+            break;
+        }
+
+        default:
+        {
+            result = false;
+        }
+    }
+
+    return result;
+}
+
+void ReplayerSnapshot::record_command(const APIInterceptor::APIFunction&         in_api_func,
+                                      const uint32_t&                            in_n_visible_args,
+                                      const uint32_t&                            in_n_args,
+                                      const APIInterceptor::APIFunctionArgument* in_args_ptr,
+                                      const uint16_t&                            in_flags)
+{
+    assert(in_n_args <= ARG_CHUNK_SIZE);
+
+    /* Arguments of a single command must never straddle two arena chunks. Move on to the next chunk if the current one
+     * cannot hold all of them. */
+    if (m_arg_chunk_vec[m_n_current_arg_chunk].size() + in_n_args > ARG_CHUNK_SIZE)
+    {
+        if (++m_n_current_arg_chunk == static_cast<uint32_t>(m_arg_chunk_vec.size() ) )
+        {
+            allocate_arg_chunk();
+        }
+    }
+
+    {
+        const auto n_command_chunk = m_n_api_commands >> COMMAND_CHUNK_SIZE_LOG2;
+
+        if (n_command_chunk == static_cast<uint32_t>(m_command_chunk_vec.size() ) )
+        {
+            allocate_command_chunk();
+        }
+
+        auto& arg_chunk = m_arg_chunk_vec[m_n_current_arg_chunk];
+
+        m_command_chunk_vec[n_command_chunk].push_back(
+            Command{in_api_func,
+                    static_cast<uint16_t>(in_n_visible_args),
+                    in_flags,
+                    (m_n_current_arg_chunk << ARG_CHUNK_SIZE_LOG2) | static_cast<uint32_t>(arg_chunk.size() )}
+        );
+
+        arg_chunk.insert(arg_chunk.end(),
+                         in_args_ptr,
+                         in_args_ptr + in_n_args);
+
+        if (m_is_cpu_timing_enabled)
+        {
+            m_cpu_ticks_chunk_vec[n_command_chunk].push_back(static_cast<uint32_t>(std::min(m_n_pending_cpu_ticks,
+                                                                                             static_cast<uint64_t>(UINT32_MAX) ) ) );
+
+            m_n_pending_cpu_ticks = 0;
+        }
+    }
+
+    m_n_api_args += in_n_args;
+
+    ++m_n_api_commands;
+}
+
+void ReplayerSnapshot::record_texture_upload(const APIInterceptor::APIFunction&            in_api_func,
+                                             const uint32_t&                               in_n_args,
+                                             const APIInterceptor::APIFunctionArgument*    in_args_ptr,
+                                             const std::shared_ptr<const PendingMipData>& in_data_ptr,
+                                             const uint32_t&                               in_n_row_pixels)
+{
+    APIInterceptor::APIFunctionArgument upload_args[11];
+
+    assert(in_api_func                     == APIInterceptor::APIFUNCTION_GL_GLTEXIMAGE2D ||
+           in_api_func                     == APIInterceptor::APIFUNCTION_GL_GLTEXSUBIMAGE2D);
+    assert(in_data_ptr                     != nullptr);
+    assert(in_n_args                       == 9);
+    assert(m_n_active_vertex_batch_command == UINT32_MAX);
+
+    std::copy(in_args_ptr,
+              in_args_ptr + in_n_args,
+              upload_args);
+
+    upload_args[in_n_args + 0] = APIInterceptor::APIFunctionArgument::create_u32(static_cast<uint32_t>(m_texture_upload_data_vec.size() ) );
+    upload_args[in_n_args + 1] = APIInterceptor::APIFunctionArgument::create_u32(in_n_row_pixels);
+
+    m_texture_upload_data_vec.push_back(in_data_ptr);
+
+    record_command(in_api_func,
+                   in_n_args,
+                   in_n_args + 2,
+                   upload_args,
+                   COMMAND_FLAG_TEXTURE_UPLOAD);
+}
+
+void ReplayerSnapshot::record_vertex(const ReplayerVertexBatchVertex& in_vertex)
+{
+    const auto n_vertex_chunk = m_n_vertices >> ReplayerVertexBatchView::CHUNK_SIZE_LOG2;
+
+    if (n_vertex_chunk == static_cast<uint32_t>(m_vertex_chunk_vec.size() ) )
+    {
+        allocate_vertex_chunk();
+    }
+
+    m_vertex_chunk_vec[n_vertex_chunk].push_back(in_vertex);
 
-    m_api_command_vec.push_back(APIInterceptor::APICommand() );
+    ++m_n_vertices;
+}
 
-    cached_api_command_ptr           = &m_api_command_vec.back();
-    cached_api_command_ptr->api_func = in_api_func;
+void ReplayerSnapshot::reserve(const uint32_t& in_n_api_commands,
+                               const uint32_t& in_n_api_args,
+                               const uint32_t& in_n_vertices)
+{
+    /* NOTE: Arguments never straddle chunk boundaries, so some of the arena space may go unused. Reserve one
+     *       extra chunk to account for that. */
+    const auto n_arg_chunks_needed     = in_n_api_args / ARG_CHUNK_SIZE + 1;
+    const auto n_command_chunks_needed = (in_n_api_commands + COMMAND_CHUNK_SIZE                  - 1) / COMMAND_CHUNK_SIZE;
+    const auto n_vertex_chunks_needed  = (in_n_vertices     + ReplayerVertexBatchView::CHUNK_SIZE - 1) / ReplayerVertexBatchView::CHUNK_SIZE;
 
-    cached_api_command_ptr->api_arg_vec.reserve(in_n_args);
+    while (static_cast<uint32_t>(m_arg_chunk_vec.size() ) < n_arg_chunks_needed)
+    {
+        allocate_arg_chunk();
+    }
 
-    for (uint32_t n_current_arg = 0;
-                  n_current_arg < in_n_args;
-                ++n_current_arg)
+    while (static_cast<uint32_t>(m_command_chunk_vec.size() ) < n_command_chunks_needed)
     {
-        cached_api_command_ptr->api_arg_vec.emplace_back(in_args_ptr[n_current_arg]);
+        allocate_command_chunk();
+    }
+
+    while (static_cast<uint32_t>(m_vertex_chunk_vec.size() ) < n_vertex_chunks_needed)
+    {
+        allocate_vertex_chunk();
     }
 }
 
 void ReplayerSnapshot::reset()
 {
-    m_api_command_vec.clear();
-}
\ No newline at end of file
+    /* NOTE: Chunks are retained, so that the next frame can be recorded without any reallocations. */
+    for (auto& current_arg_chunk : m_arg_chunk_vec)
+    {
+        current_arg_chunk.clear();
+    }
+
+    for (auto& current_command_chunk : m_command_chunk_vec)
+    {
+        current_command_chunk.clear();
+    }
+
+    for (auto& current_vertex_chunk : m_vertex_chunk_vec)
+    {
+        current_vertex_chunk.clear();
+    }
+
+    m_n_active_vertex_batch_command = UINT32_MAX;
+    m_n_api_args                    = 0;
+    m_n_api_commands                = 0;
+    m_n_current_arg_chunk           = 0;
+    m_n_vertices                    = 0;
+
+    m_has_segment_table = false;
+    m_segment_table.reset();
+
+    /* Releases the snapshot's references to texture data. Whatever is not referenced by the texture store anymore
+     * gets freed. */
+    m_texture_upload_data_vec.clear();
+
+    for (auto& current_cpu_ticks_chunk : m_cpu_ticks_chunk_vec)
+    {
+        current_cpu_ticks_chunk.clear();
+    }
+
+    m_n_cpu_ticks_per_second         = 0.0;
+    m_n_cpu_timestamp_overhead_ticks = 0;
+    m_n_pending_cpu_ticks            = 0;
+    m_n_trailing_cpu_ticks           = 0;
+}
+
+void ReplayerSnapshot::set_cpu_timing_enabled(const bool& in_enabled)
+{
+    assert(m_n_api_commands == 0);
+
+    m_is_cpu_timing_enabled = in_enabled;
+
+    /* Keep one ticks chunk per command chunk, so that recording does not need to allocate any. */
+    if (in_enabled)
+    {
+        while (m_cpu_ticks_chunk_vec.size() < m_command_chunk_vec.size() )
+        {
+            allocate_cpu_ticks_chunk();
+        }
+    }
+}
+
+void ReplayerSnapshot::set_vertex_batching_enabled(const bool& in_enabled)
+{
+    m_is_vertex_batching_enabled = in_enabled;
+}
+
+void ReplayerSnapshot::spill_active_vertex_batch()
+{
+    /* The batch command is guaranteed to be the last command recorded, and its args are the last args stored in the
+     * arena. Pop it and re-record the run as individual commands. */
+    const auto                                n_batch_command = m_n_active_vertex_batch_command;
+    const auto                                batch_command   = m_command_chunk_vec[n_batch_command >> COMMAND_CHUNK_SIZE_LOG2].back();
+    auto&                                     batch_arg_chunk = m_arg_chunk_vec    [batch_command.n_first_arg >> ARG_CHUNK_SIZE_LOG2];
+    const uint32_t                            n_batch_args    = batch_command.n_args + 2;
+    const APIInterceptor::APIFunctionArgument begin_arg       = batch_arg_chunk[batch_command.n_first_arg & (ARG_CHUNK_SIZE - 1)];
+    const auto                                n_first_vertex  = batch_arg_chunk[(batch_command.n_first_arg & (ARG_CHUNK_SIZE - 1) ) + 1].get_u32();
+    const auto                                pending_vertex  = m_pending_vertex;
+
+    assert(n_batch_command + 1 == m_n_api_commands);
+
+    m_command_chunk_vec[n_batch_command >> COMMAND_CHUNK_SIZE_LOG2].pop_back();
+    batch_arg_chunk.resize(batch_arg_chunk.size() - n_batch_args);
+
+    /* CPU time accumulated by the batch goes to the re-recorded glBegin(). Whatever is pending belongs to the call which
+     * has caused the spill. */
+    const uint64_t n_pending_cpu_ticks = m_n_pending_cpu_ticks;
+
+    if (m_is_cpu_timing_enabled)
+    {
+        m_n_pending_cpu_ticks = m_cpu_ticks_chunk_vec[n_batch_command >> COMMAND_CHUNK_SIZE_LOG2].back();
+
+        m_cpu_ticks_chunk_vec[n_batch_command >> COMMAND_CHUNK_SIZE_LOG2].pop_back();
+    }
+
+    m_n_active_vertex_batch_command  = UINT32_MAX;
+    m_n_api_args                    -= n_batch_args;
+    m_n_api_commands                -= 1;
+
+    record_command(APIInterceptor::APIFUNCTION_GL_GLBEGIN,
+                   1, /* in_n_visible_args */
+                   1, /* in_n_args         */
+                  &begin_arg,
+                   0); /* in_flags */
+
+    {
+        ReplayerExpandedAPICommand expanded_command_vec[3];
+        const auto                 n_last_vertex = m_n_vertices;
+
+        for (uint32_t n_vertex = n_first_vertex;
+                      n_vertex < n_last_vertex + 1;
+                    ++n_vertex)
+        {
+            /* NOTE: Last iteration handles attributes which have not been followed by a glVertex*() call yet. */
+            const auto& vertex = (n_vertex < n_last_vertex) ? m_vertex_chunk_vec[n_vertex >> ReplayerVertexBatchView::CHUNK_SIZE_LOG2][n_vertex & (ReplayerVertexBatchView::CHUNK_SIZE - 1)]
+                                                            : pending_vertex;
+            const auto  n_expanded_commands = ReplayerVertexBatchView::expand(vertex,
+                                                                              expanded_command_vec);
+
+            for (uint32_t n_expanded_command = 0;
+                          n_expanded_command < n_expanded_commands;
+                        ++n_expanded_command)
+            {
+                const auto& expanded_command = expanded_command_vec[n_expanded_command];
+
+                record_command(expanded_command.api_func,
+                               expanded_command.n_api_args,
+                               expanded_command.n_api_args,
+                               expanded_command.api_arg_vec.data(),
+                               0); /* in_flags */
+            }
+        }
+    }
+
+    m_n_pending_cpu_ticks = n_pending_cpu_ticks;
+
+    /* Drop the batch's vertices. They have been re-recorded above. */
+    while (m_n_vertices > n_first_vertex)
+    {
+        m_vertex_chunk_vec[(m_n_vertices - 1) >> ReplayerVertexBatchView::CHUNK_SIZE_LOG2].pop_back();
+
+        --m_n_vertices;
+    }
+}
@@ -0,0 +1,1270 @@
+/* API Interceptor (c) 2024 Dominik Witczak
+ *
+ * This code is licensed under MIT license (see LICENSE.txt for details)
+ */
+
+// Shoo shoo VS warnings, this is a hobby project.
+#define _CRT_SECURE_NO_WARNINGS
+
+#include "replayer_block_codec.h"
+#include "replayer_snapshot_file.h"
+#include "replayer_texture_store.h"
+#include <algorithm>
+#include <cstdio>
+#include <new>
+#include <thread>
+
+#ifdef max
+    #undef max
+#endif
+#ifdef min
+    #undef min
+#endif
+
+
+ReplayerSnapshotFile::ReplayerSnapshotFile(const std::string& in_filename)
+    :m_file_handle          (INVALID_HANDLE_VALUE),
+     m_file_mapping_handle  (nullptr),
+     m_filename             (in_filename),
+     m_header_ptr           (nullptr),
+     m_mapped_data_ptr      (nullptr),
+     m_arg_ptr              (nullptr),
+     m_blob_ptr             (nullptr),
+     m_command_ptr          (nullptr),
+     m_mip_record_ptr       (nullptr),
+     m_vertex_ptr           (nullptr),
+     m_command_stream_status(VerificationStatus::NOT_VERIFIED)
+{
+    for (auto& current_section_status : m_section_status_vec)
+    {
+        current_section_status = VerificationStatus::NOT_VERIFIED;
+    }
+}
+
+ReplayerSnapshotFile::~ReplayerSnapshotFile()
+{
+    if (m_mapped_data_ptr != nullptr)
+    {
+        ::UnmapViewOfFile(m_mapped_data_ptr);
+    }
+
+    if (m_file_mapping_handle != nullptr)
+    {
+        ::CloseHandle(m_file_mapping_handle);
+    }
+
+    if (m_file_handle != INVALID_HANDLE_VALUE)
+    {
+        ::CloseHandle(m_file_handle);
+    }
+}
+
+ReplayerSnapshotFileUniquePtr ReplayerSnapshotFile::create(const std::string& in_filename)
+{
+    ReplayerSnapshotFileUniquePtr result_ptr(new ReplayerSnapshotFile(in_filename) );
+
+    if (result_ptr != nullptr)
+    {
+        if (!result_ptr->init() )
+        {
+            result_ptr.reset();
+        }
+    }
+
+    return result_ptr;
+}
+
+bool ReplayerSnapshotFile::compress_section(const std::vector<uint8_t>& in_data_u8_vec,
+                                            std::vector<uint8_t>*       out_data_u8_vec_ptr,
+                                            SectionInfo*                out_section_info_ptr)
+{
+    const auto           n_blocks            = static_cast<uint32_t>( (in_data_u8_vec.size() + ReplayerBlockCodec::BLOCK_SIZE - 1) / ReplayerBlockCodec::BLOCK_SIZE);
+    std::vector<uint8_t> block_data_u8_vec   (ReplayerBlockCodec::get_max_n_compressed_bytes(ReplayerBlockCodec::BLOCK_SIZE) );
+    std::vector<uint8_t> section_data_u8_vec (sizeof(BlockInfo) * n_blocks);
+
+    for (uint32_t n_block = 0;
+                  n_block < n_blocks;
+                ++n_block)
+    {
+        const uint64_t n_block_start_byte = static_cast<uint64_t>(n_block) * ReplayerBlockCodec::BLOCK_SIZE;
+        const auto     n_block_bytes      = static_cast<uint32_t>(std::min(in_data_u8_vec.size() - n_block_start_byte,
+                                                                           static_cast<uint64_t>(ReplayerBlockCodec::BLOCK_SIZE) ) ); // not odr-used
+        const uint8_t* block_data_ptr     = in_data_u8_vec.data() + n_block_start_byte;
+        BlockInfo      block_info         = {};
+        uint32_t       n_stored_bytes     = ReplayerBlockCodec::compress(block_data_ptr,
+                                                                         n_block_bytes,
+                                                                         block_data_u8_vec.data() );
+
+        /* Blocks which did not compress are stored as-is, so that decoding them is a plain copy. */
+        if (n_stored_bytes >= n_block_bytes)
+        {
+            n_stored_bytes = n_block_bytes;
+        }
+        else
+        {
+            block_data_ptr = block_data_u8_vec.data();
+        }
+
+        block_info.n_start_byte   = section_data_u8_vec.size();
+        block_info.n_stored_bytes = n_stored_bytes;
+
+        memcpy(section_data_u8_vec.data() + sizeof(BlockInfo) * n_block,
+              &block_info,
+               sizeof(BlockInfo) );
+
+        section_data_u8_vec.insert(section_data_u8_vec.end(),
+                                   block_data_ptr,
+                                   block_data_ptr + n_stored_bytes);
+    }
+
+    if (section_data_u8_vec.size() >= in_data_u8_vec.size() )
+    {
+        return false;
+    }
+
+    out_section_info_ptr->flags           = SECTION_FLAG_COMPRESSED;
+    out_section_info_ptr->n_blocks        = n_blocks;
+    out_section_info_ptr->n_decoded_bytes = in_data_u8_vec.size();
+
+    *out_data_u8_vec_ptr = std::move(section_data_u8_vec);
+
+    return true;
+}
+
+bool ReplayerSnapshotFile::decode_section_range(const Section&  in_section,
+                                                const uint64_t& in_n_start_byte,
+                                                const uint64_t& in_n_bytes) const
+{
+    const auto&           section_info         = m_header_ptr->section_info_vec[in_section];
+    auto&                 decoded_section      = m_decoded_section_vec[in_section];
+    const auto            block_info_ptr       = reinterpret_cast<const BlockInfo*>(m_mapped_data_ptr + section_info.n_start_byte);
+    LARGE_INTEGER         end_qpc              = {};
+    std::vector<uint32_t> n_pending_block_vec;
+    LARGE_INTEGER         qpc_frequency        = {};
+    bool                  result               = true;
+    LARGE_INTEGER         start_qpc            = {};
+
+    if ((section_info.flags & SECTION_FLAG_COMPRESSED) == 0 ||
+        in_n_bytes                                     == 0)
+    {
+        return true;
+    }
+
+    {
+        const auto n_first_block = static_cast<uint32_t>(in_n_start_byte                                                        / ReplayerBlockCodec::BLOCK_SIZE);
+        const auto n_end_block   = static_cast<uint32_t>( (in_n_start_byte + in_n_bytes + ReplayerBlockCodec::BLOCK_SIZE - 1) / ReplayerBlockCodec::BLOCK_SIZE);
+
+        for (uint32_t n_block = n_first_block;
+                      n_block < n_end_block;
+                    ++n_block)
+        {
+            const auto block_status = decoded_section.block_status_vec.at(n_block);
+
+            if (block_status == VerificationStatus::NOT_VERIFIED)
+            {
+                n_pending_block_vec.push_back(n_block);
+            }
+            else
+            if (block_status == VerificationStatus::CORRUPT)
+            {
+                result = false;
+            }
+        }
+    }
+
+    if (n_pending_block_vec.empty() )
+    {
+        return result;
+    }
+
+    /* Each thread only touches its own blocks, so no synchronization is needed beyond joining the threads. */
+    auto decode_blocks = [&](const uint32_t in_n_first_pending_block,
+                             const uint32_t in_n_end_pending_block)
+    {
+        for (uint32_t n_pending_block = in_n_first_pending_block;
+                      n_pending_block < in_n_end_pending_block;
+                    ++n_pending_block)
+        {
+            const uint32_t   n_block            = n_pending_block_vec.at(n_pending_block);
+            const uint64_t   n_block_start_byte = static_cast<uint64_t>(n_block) * ReplayerBlockCodec::BLOCK_SIZE;
+            const auto       n_block_bytes      = static_cast<uint32_t>(std::min(section_info.n_decoded_bytes - n_block_start_byte,
+                                                                                 static_cast<uint64_t>(ReplayerBlockCodec::BLOCK_SIZE) ) ); // not odr-used
+            const auto&      block_info         = block_info_ptr[n_block];
+            const uint64_t   n_min_start_byte   = sizeof(BlockInfo) * static_cast<uint64_t>(section_info.n_blocks);
+            bool             is_valid           = false;
+
+            if (block_info.n_start_byte   >= n_min_start_byte                                       &&
+                block_info.n_start_byte   <= section_info.n_bytes                                   &&
+                block_info.n_stored_bytes <= section_info.n_bytes - block_info.n_start_byte)
+            {
+                const auto block_data_ptr = m_mapped_data_ptr + section_info.n_start_byte + block_info.n_start_byte;
+
+                if (block_info.n_stored_bytes == n_block_bytes)
+                {
+                    memcpy(decoded_section.data_u8_ptr.get() + n_block_start_byte,
+                           block_data_ptr,
+                           n_block_bytes);
+
+                    is_valid = true;
+                }
+                else
+                {
+                    is_valid = ReplayerBlockCodec::decompress(block_data_ptr,
+                                                              block_info.n_stored_bytes,
+                                                              decoded_section.data_u8_ptr.get() + n_block_start_byte,
+                                                              n_block_bytes);
+                }
+            }
+
+            decoded_section.block_status_vec.at(n_block) = (is_valid) ? VerificationStatus::VALID
+                                                                      : VerificationStatus::CORRUPT;
+        }
+    };
+
+    ::QueryPerformanceCounter  (&start_qpc);
+    ::QueryPerformanceFrequency(&qpc_frequency);
+    {
+        const auto n_pending_blocks = static_cast<uint32_t>(n_pending_block_vec.size() );
+        const auto n_threads        = std::max(1u,
+                                               std::min(std::min(std::thread::hardware_concurrency(),
+                                                                 static_cast<uint32_t>(MAX_N_DECODE_THREADS) ), // not odr-used
+                                                        n_pending_blocks / PARALLEL_DECODE_MIN_BLOCKS) );
+        std::vector<std::thread> decode_thread_vec;
+
+        for (uint32_t n_thread = 1;
+                      n_thread < n_threads;
+                    ++n_thread)
+        {
+            decode_thread_vec.emplace_back(decode_blocks,
+                                           n_pending_blocks *  n_thread      / n_threads,
+                                           n_pending_blocks * (n_thread + 1) / n_threads);
+        }
+
+        decode_blocks(0, /* in_n_first_pending_block */
+                      n_pending_blocks / n_threads);
+
+        for (auto& current_decode_thread : decode_thread_vec)
+        {
+            current_decode_thread.join();
+        }
+    }
+    ::QueryPerformanceCounter(&end_qpc);
+
+    for (const auto& current_n_block : n_pending_block_vec)
+    {
+        if (decoded_section.block_status_vec.at(current_n_block) != VerificationStatus::VALID)
+        {
+            result = false;
+
+            continue;
+        }
+
+        m_stats.n_blocks_decoded++;
+        m_stats.n_decoded_bytes        += std::min(section_info.n_decoded_bytes - static_cast<uint64_t>(current_n_block) * ReplayerBlockCodec::BLOCK_SIZE,
+                                                   static_cast<uint64_t>(ReplayerBlockCodec::BLOCK_SIZE) ); // not odr-used
+        m_stats.n_decoded_stored_bytes += block_info_ptr[current_n_block].n_stored_bytes;
+    }
+
+    m_stats.decode_time_ns += static_cast<uint64_t>(static_cast<double>(end_qpc.QuadPart - start_qpc.QuadPart) * 1e9 / static_cast<double>(qpc_frequency.QuadPart) );
+
+    return result;
+}
+
+bool ReplayerSnapshotFile::deserialize_gl_context_state(const uint8_t*  in_data_ptr,
+                                                        const uint64_t& in_n_bytes,
+                                                        GLContextState* out_gl_context_state_ptr)
+{
+    const uint8_t* data_end_ptr = in_data_ptr + in_n_bytes;
+    const uint8_t* data_ptr     = in_data_ptr;
+    uint32_t       n_textures   = 0;
+    bool           result       = true;
+
+    result &= deserialize(&data_ptr, data_end_ptr, &out_gl_context_state_ptr->alpha_test_enabled);
+    result &= deserialize(&data_ptr, data_end_ptr, &out_gl_context_state_ptr->blend_enabled);
+    result &= deserialize(&data_ptr, data_end_ptr, &out_gl_context_state_ptr->cull_face_enabled);
+    result &= deserialize(&data_ptr, data_end_ptr, &out_gl_context_state_ptr->depth_test_enabled);
+    result &= deserialize(&data_ptr, data_end_ptr, &out_gl_context_state_ptr->scissor_test_enabled);
+    result &= deserialize(&data_ptr, data_end_ptr, &out_gl_context_state_ptr->texture_2d_enabled);
+
+    result &= deserialize(&data_ptr, data_end_ptr, &out_gl_context_state_ptr->alpha_func_func);
+    result &= deserialize(&data_ptr, data_end_ptr, &out_gl_context_state_ptr->alpha_func_ref);
+    result &= deserialize(&data_ptr, data_end_ptr, &out_gl_context_state_ptr->blend_func_dfactor);
+    result &= deserialize(&data_ptr, data_end_ptr, &out_gl_context_state_ptr->blend_func_sfactor);
+    result &= deserialize(&data_ptr, data_end_ptr, &out_gl_context_state_ptr->clear_color);
+    result &= deserialize(&data_ptr, data_end_ptr, &out_gl_context_state_ptr->clear_depth);
+    result &= deserialize(&data_ptr, data_end_ptr, &out_gl_context_state_ptr->cull_face_mode);
+    result &= deserialize(&data_ptr, data_end_ptr, &out_gl_context_state_ptr->depth_func);
+    result &= deserialize(&data_ptr, data_end_ptr, &out_gl_context_state_ptr->depth_mask);
+    result &= deserialize(&data_ptr, data_end_ptr, &out_gl_context_state_ptr->depth_range);
+    result &= deserialize(&data_ptr, data_end_ptr, &out_gl_context_state_ptr->draw_buffer_mode);
+    result &= deserialize(&data_ptr, data_end_ptr, &out_gl_context_state_ptr->front_face_mode);
+    result &= deserialize(&data_ptr, data_end_ptr, &out_gl_context_state_ptr->matrix_mode);
+    result &= deserialize(&data_ptr, data_end_ptr, &out_gl_context_state_ptr->shade_model);
+    result &= deserialize(&data_ptr, data_end_ptr, &out_gl_context_state_ptr->texture_env_mode);
+    result &= deserialize(&data_ptr, data_end_ptr, &out_gl_context_state_ptr->viewport_extents);
+    result &= deserialize(&data_ptr, data_end_ptr, &out_gl_context_state_ptr->viewport_x1y1);
+    result &= deserialize(&data_ptr, data_end_ptr, &out_gl_context_state_ptr->modelview_matrix);
+    result &= deserialize(&data_ptr, data_end_ptr, &out_gl_context_state_ptr->projection_matrix);
+    result &= deserialize(&data_ptr, data_end_ptr, &out_gl_context_state_ptr->bound_2d_texture_gl_id);
+    result &= deserialize(&data_ptr, data_end_ptr, &n_textures);
+
+    out_gl_context_state_ptr->gl_texture_id_to_texture_state_map = GLContextTextureStateTable();
+
+    for (uint32_t n_texture = 0;
+                  n_texture < n_textures && result;
+                ++n_texture)
+    {
+        uint32_t              gl_texture_id = 0;
+        GLContextTextureState texture_state;
+
+        result &= deserialize(&data_ptr, data_end_ptr, &gl_texture_id);
+        result &= deserialize(&data_ptr, data_end_ptr, &texture_state);
+
+        if (result)
+        {
+            *out_gl_context_state_ptr->gl_texture_id_to_texture_state_map.get_for_write(gl_texture_id) = texture_state;
+        }
+    }
+
+    return result;
+}
+
+const ReplayerSnapshotFile::Analysis* ReplayerSnapshotFile::get_analysis() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    return (verify_section(SECTION_ANALYSIS) ) ? reinterpret_cast<const Analysis*>(get_section_ptr(SECTION_ANALYSIS) )
+                                               : nullptr;
+}
+
+ReplayerSnapshotCommandView ReplayerSnapshotFile::get_api_command_ptr(const uint32_t& in_n_api_command) const
+{
+    assert(m_command_stream_status == VerificationStatus::VALID);
+    assert(in_n_api_command        <  m_header_ptr->n_api_commands);
+
+    const auto&                 command = m_command_ptr[in_n_api_command];
+    ReplayerSnapshotCommandView result  =
+    {
+        static_cast<APIInterceptor::APIFunction>(command.api_func),
+        ReplayerSnapshotArgView                 (m_arg_ptr + command.n_first_arg,
+                                                 command.n_args)
+    };
+
+    if ((command.flags & COMMAND_FLAG_VERTEX_BATCH) != 0)
+    {
+        result.vertex_batch = ReplayerVertexBatchView(m_vertex_ptr + command.n_first_vertex,
+                                                      command.n_vertices);
+    }
+
+    /* NOTE: texture_upload_data_ptr refers to an in-memory PendingMipData instance, so cannot point into the mapping.
+     *       Uploaded data is exposed via get_texture_upload_data() instead. */
+    if ((command.flags & COMMAND_FLAG_TEXTURE_UPLOAD) != 0)
+    {
+        result.texture_upload_n_row_pixels = command.texture_upload_n_row_pixels;
+    }
+
+    return result;
+}
+
+const uint8_t* ReplayerSnapshotFile::get_blob_data(const uint32_t& in_n_blob,
+                                                   uint32_t*       out_n_bytes_ptr) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (!verify_section(SECTION_BLOBS)              ||
+        in_n_blob >= m_header_ptr->n_blobs)
+    {
+        return nullptr;
+    }
+
+    const auto&    blob          = m_blob_ptr[in_n_blob];
+    const uint8_t* blob_data_ptr = get_section_ptr(SECTION_BLOB_DATA) + blob.n_start_byte;
+    auto&          blob_status   = m_blob_status_vec.at(in_n_blob);
+
+    if (blob_status == VerificationStatus::NOT_VERIFIED)
+    {
+        const auto n_section_bytes = m_header_ptr->section_info_vec[SECTION_BLOB_DATA].n_decoded_bytes;
+
+        /* Only blocks the blob overlaps get decoded. */
+        blob_status = (blob.n_bytes      <= n_section_bytes                              &&
+                       blob.n_start_byte <= n_section_bytes - blob.n_bytes               &&
+                       blob.n_bytes      <= UINT32_MAX                                   &&
+                       decode_section_range(SECTION_BLOB_DATA,
+                                            blob.n_start_byte,
+                                            blob.n_bytes)                                &&
+                       blob.checksum     == ReplayerTextureStore::hash(blob_data_ptr,
+                                                                       static_cast<uint32_t>(blob.n_bytes) ) ) ? VerificationStatus::VALID
+                                                                                                               : VerificationStatus::CORRUPT;
+    }
+
+    if (blob_status != VerificationStatus::VALID)
+    {
+        return nullptr;
+    }
+
+    *out_n_bytes_ptr = static_cast<uint32_t>(blob.n_bytes);
+
+    return blob_data_ptr;
+}
+
+uint32_t ReplayerSnapshotFile::get_cpu_ticks(const uint32_t& in_n_api_command) const
+{
+    assert(m_command_stream_status == VerificationStatus::VALID);
+    assert(in_n_api_command        <  m_header_ptr->n_api_commands);
+
+    return m_command_ptr[in_n_api_command].cpu_ticks;
+}
+
+bool ReplayerSnapshotFile::get_gl_id_to_texture_props_map(GLIDToTexturePropsMap* out_gl_id_to_texture_props_map_ptr) const
+{
+    out_gl_id_to_texture_props_map_ptr->clear();
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        if (!verify_section(SECTION_TEXTURE_PROPS) )
+        {
+            return false;
+        }
+    }
+
+    for (uint32_t n_mip_record = 0;
+                  n_mip_record < m_header_ptr->n_mip_records;
+                ++n_mip_record)
+    {
+        const auto& mip_record    = m_mip_record_ptr[n_mip_record];
+        auto&       texture_props = *out_gl_id_to_texture_props_map_ptr->get_for_write(mip_record.gl_id);
+
+        texture_props.border = mip_record.border;
+        texture_props.type   = static_cast<TextureType>(mip_record.texture_type);
+
+        if (mip_record.n_mip == NO_MIPS)
+        {
+            continue;
+        }
+
+        /* NOTE: n_mip is known to be below MAX_N_MIPS at this point. See verify_mip_records(). */
+        if (texture_props.mip_props_vec.size() <= mip_record.n_mip)
+        {
+            texture_props.mip_props_vec.resize(mip_record.n_mip + 1);
+        }
+
+        {
+            auto& mip_props = texture_props.mip_props_vec.at(mip_record.n_mip);
+
+            mip_props.data_hash        = mip_record.data_hash;
+            mip_props.format           = mip_record.format;
+            mip_props.internal_format  = mip_record.internal_format;
+            mip_props.mip_size_u32vec3 = mip_record.mip_size_u32vec3;
+            mip_props.type             = mip_record.type;
+        }
+    }
+
+    return true;
+}
+
+const uint8_t* ReplayerSnapshotFile::get_mip_data(const uint32_t& in_gl_id,
+                                                  const uint32_t& in_n_mip,
+                                                  uint32_t*       out_n_bytes_ptr) const
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        if (!verify_section(SECTION_TEXTURE_PROPS) )
+        {
+            return nullptr;
+        }
+    }
+
+    /* Records are sorted (see verify_mip_records() ), so no index needs to be built. */
+    const auto mip_record_end_ptr = m_mip_record_ptr + m_header_ptr->n_mip_records;
+    const auto mip_record_ptr     = std::lower_bound(m_mip_record_ptr,
+                                                     mip_record_end_ptr,
+                                                     std::make_pair(in_gl_id, in_n_mip),
+                                                     [](const MipRecord&                     in_mip_record,
+                                                        const std::pair<uint32_t, uint32_t>& in_key)
+                                                     {
+                                                         return std::make_pair(in_mip_record.gl_id, in_mip_record.n_mip) < in_key;
+                                                     });
+
+    if (mip_record_ptr         == mip_record_end_ptr ||
+        mip_record_ptr->gl_id  != in_gl_id           ||
+        mip_record_ptr->n_mip  != in_n_mip           ||
+        mip_record_ptr->n_blob == UINT32_MAX)
+    {
+        return nullptr;
+    }
+
+    return get_blob_data(mip_record_ptr->n_blob,
+                         out_n_bytes_ptr);
+}
+
+uint32_t ReplayerSnapshotFile::get_n_api_commands() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (m_command_stream_status == VerificationStatus::NOT_VERIFIED)
+    {
+        bool is_valid = verify_section(SECTION_COMMANDS) &&
+                        verify_section(SECTION_ARGS)     &&
+                        verify_section(SECTION_VERTICES);
+
+        /* Commands are accessed with no further checks, so make sure none of them points outside the file. */
+        for (uint32_t n_api_command = 0;
+                      n_api_command < m_header_ptr->n_api_commands && is_valid;
+                    ++n_api_command)
+        {
+            const auto& command = m_command_ptr[n_api_command];
+
+            is_valid = (static_cast<uint64_t>(command.n_first_arg) + command.n_args <= m_header_ptr->n_api_args);
+
+            if ((command.flags & COMMAND_FLAG_VERTEX_BATCH) != 0)
+            {
+                is_valid &= (static_cast<uint64_t>(command.n_first_vertex) + command.n_vertices <= m_header_ptr->n_vertices);
+            }
+        }
+
+        m_command_stream_status = (is_valid) ? VerificationStatus::VALID
+                                             : VerificationStatus::CORRUPT;
+    }
+
+    return (m_command_stream_status == VerificationStatus::VALID) ? m_header_ptr->n_api_commands
+                                                                  : 0;
+}
+
+double ReplayerSnapshotFile::get_n_cpu_ticks_per_second() const
+{
+    const auto analysis_ptr = get_analysis();
+
+    return (analysis_ptr != nullptr) ? analysis_ptr->n_cpu_ticks_per_second
+                                     : 0.0;
+}
+
+const uint8_t* ReplayerSnapshotFile::get_section_ptr(const Section& in_section) const
+{
+    return ((m_header_ptr->section_info_vec[in_section].flags & SECTION_FLAG_COMPRESSED) != 0) ? m_decoded_section_vec[in_section].data_u8_ptr.get()
+                                                                                               : m_mapped_data_ptr + m_header_ptr->section_info_vec[in_section].n_start_byte;
+}
+
+bool ReplayerSnapshotFile::get_segment_cpu_times(ReplayerSegmentCPUTimes* out_cpu_times_ptr) const
+{
+    const auto analysis_ptr = get_analysis();
+
+    if (analysis_ptr                        == nullptr ||
+        analysis_ptr->has_segment_cpu_times == 0)
+    {
+        return false;
+    }
+
+    *out_cpu_times_ptr = analysis_ptr->segment_cpu_times;
+
+    return true;
+}
+
+bool ReplayerSnapshotFile::get_segment_table(ReplayerSegmentTable* out_segment_table_ptr) const
+{
+    const auto analysis_ptr = get_analysis();
+
+    if (analysis_ptr                    == nullptr ||
+        analysis_ptr->has_segment_table == 0)
+    {
+        return false;
+    }
+
+    const uint8_t* data_end_ptr = get_section_ptr(SECTION_ANALYSIS) + m_header_ptr->section_info_vec[SECTION_ANALYSIS].n_decoded_bytes;
+    const uint8_t* data_ptr     = get_section_ptr(SECTION_ANALYSIS) + sizeof(Analysis);
+    bool           result       = true;
+
+    out_segment_table_ptr->reset();
+
+    out_segment_table_ptr->n_first_glrotate_command              = analysis_ptr->n_first_glrotate_command;
+    out_segment_table_ptr->n_screen_space_geom_api_first_command = analysis_ptr->n_screen_space_geom_api_first_command;
+    out_segment_table_ptr->n_screen_space_geom_api_last_command  = analysis_ptr->n_screen_space_geom_api_last_command;
+    out_segment_table_ptr->n_weapon_draw_first_command           = analysis_ptr->n_weapon_draw_first_command;
+    out_segment_table_ptr->n_weapon_draw_last_command            = analysis_ptr->n_weapon_draw_last_command;
+
+    for (uint32_t n_range = 0;
+                  n_range < analysis_ptr->n_ao_command_ranges && result;
+                ++n_range)
+    {
+        std::array<uint32_t, 2> command_range;
+
+        if ( (result = deserialize(&data_ptr, data_end_ptr, &command_range) ) )
+        {
+            out_segment_table_ptr->ao_command_range_vec.push_back(command_range);
+        }
+    }
+
+    for (uint32_t n_range = 0;
+                  n_range < analysis_ptr->n_shade_model_command_ranges && result;
+                ++n_range)
+    {
+        std::array<uint32_t, 2> command_range;
+
+        if ( (result = deserialize(&data_ptr, data_end_ptr, &command_range) ) )
+        {
+            out_segment_table_ptr->shade_model_command_range_vec.push_back(command_range);
+        }
+    }
+
+    return result;
+}
+
+bool ReplayerSnapshotFile::get_start_gl_context_state(GLContextState* out_gl_context_state_ptr) const
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        if (!verify_section(SECTION_START_CONTEXT_STATE) )
+        {
+            return false;
+        }
+    }
+
+    return deserialize_gl_context_state(get_section_ptr(SECTION_START_CONTEXT_STATE),
+                                        m_header_ptr->section_info_vec[SECTION_START_CONTEXT_STATE].n_decoded_bytes,
+                                        out_gl_context_state_ptr);
+}
+
+ReplayerSnapshotFileStats ReplayerSnapshotFile::get_stats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    return m_stats;
+}
+
+const uint8_t* ReplayerSnapshotFile::get_texture_upload_data(const uint32_t& in_n_api_command,
+                                                             uint32_t*       out_n_bytes_ptr) const
+{
+    assert(m_command_stream_status == VerificationStatus::VALID);
+    assert(in_n_api_command        <  m_header_ptr->n_api_commands);
+
+    const auto& command = m_command_ptr[in_n_api_command];
+
+    if ((command.flags & COMMAND_FLAG_TEXTURE_UPLOAD) == 0)
+    {
+        return nullptr;
+    }
+
+    return get_blob_data(command.n_texture_upload_blob,
+                         out_n_bytes_ptr);
+}
+
+bool ReplayerSnapshotFile::has_cpu_ticks() const
+{
+    const auto analysis_ptr = get_analysis();
+
+    return (analysis_ptr                != nullptr &&
+            analysis_ptr->has_cpu_ticks != 0);
+}
+
+bool ReplayerSnapshotFile::init()
+{
+    LARGE_INTEGER file_size = {};
+
+    m_file_handle = ::CreateFileA(m_filename.c_str(),
+                                  GENERIC_READ,
+                                  FILE_SHARE_READ,
+                                  nullptr, /* lpSecurityAttributes */
+                                  OPEN_EXISTING,
+                                  FILE_ATTRIBUTE_NORMAL,
+                                  nullptr); /* hTemplateFile */
+
+    if (m_file_handle == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    if (!::GetFileSizeEx(m_file_handle,
+                         &file_size)                              ||
+        static_cast<uint64_t>(file_size.QuadPart) < sizeof(Header) )
+    {
+        return false;
+    }
+
+    m_file_mapping_handle = ::CreateFileMappingA(m_file_handle,
+                                                 nullptr, /* lpFileMappingAttributes */
+                                                 PAGE_READONLY,
+                                                 0,       /* dwMaximumSizeHigh */
+                                                 0,       /* dwMaximumSizeLow  */
+                                                 nullptr); /* lpName           */
+
+    if (m_file_mapping_handle == nullptr)
+    {
+        return false;
+    }
+
+    m_mapped_data_ptr = reinterpret_cast<const uint8_t*>(::MapViewOfFile(m_file_mapping_handle,
+                                                                         FILE_MAP_READ,
+                                                                         0,    /* dwFileOffsetHigh     */
+                                                                         0,    /* dwFileOffsetLow      */
+                                                                         0) ); /* dwNumberOfBytesToMap */
+
+    if (m_mapped_data_ptr == nullptr)
+    {
+        return false;
+    }
+
+    m_header_ptr = reinterpret_cast<const Header*>(m_mapped_data_ptr);
+
+    if (m_header_ptr->magic        != FILE_MAGIC                                ||
+        m_header_ptr->version      != FILE_VERSION                              ||
+        m_header_ptr->n_file_bytes != static_cast<uint64_t>(file_size.QuadPart) )
+    {
+        return false;
+    }
+
+    /* Only the header is checked up-front. Section contents are left alone until they are first accessed. */
+    {
+        const uint64_t n_expected_section_bytes_vec[SECTION_COUNT] =
+        {
+            UINT64_MAX, /* SECTION_START_CONTEXT_STATE */
+            static_cast<uint64_t>(m_header_ptr->n_api_commands) * sizeof(Command),
+            static_cast<uint64_t>(m_header_ptr->n_api_args)     * sizeof(APIInterceptor::APIFunctionArgument),
+            static_cast<uint64_t>(m_header_ptr->n_vertices)     * sizeof(ReplayerVertexBatchVertex),
+            static_cast<uint64_t>(m_header_ptr->n_mip_records)  * sizeof(MipRecord),
+            static_cast<uint64_t>(m_header_ptr->n_blobs)        * sizeof(Blob),
+            UINT64_MAX, /* SECTION_BLOB_DATA */
+            UINT64_MAX, /* SECTION_ANALYSIS  */
+        };
+
+        for (uint32_t n_section = 0;
+                      n_section < SECTION_COUNT;
+                    ++n_section)
+        {
+            const auto& section_info = m_header_ptr->section_info_vec[n_section];
+
+            if ((section_info.n_start_byte % SECTION_ALIGNMENT)                != 0                          ||
+                section_info.n_start_byte                                      <  sizeof(Header)             ||
+                section_info.n_bytes                                           >  m_header_ptr->n_file_bytes ||
+                section_info.n_start_byte                                      >  m_header_ptr->n_file_bytes - section_info.n_bytes)
+            {
+                return false;
+            }
+
+            if (n_expected_section_bytes_vec[n_section] != UINT64_MAX &&
+                n_expected_section_bytes_vec[n_section] != section_info.n_decoded_bytes)
+            {
+                return false;
+            }
+
+            if ((section_info.flags & SECTION_FLAG_COMPRESSED) == 0)
+            {
+                if (section_info.n_decoded_bytes != section_info.n_bytes)
+                {
+                    return false;
+                }
+            }
+            else
+            {
+                const uint64_t n_blocks = (section_info.n_decoded_bytes + ReplayerBlockCodec::BLOCK_SIZE - 1) / ReplayerBlockCodec::BLOCK_SIZE;
+
+                if ((n_section != SECTION_COMMANDS &&
+                     n_section != SECTION_ARGS     &&
+                     n_section != SECTION_VERTICES &&
+                     n_section != SECTION_BLOB_DATA)                       ||
+                    section_info.n_blocks        != n_blocks                 ||
+                    section_info.n_bytes         <  n_blocks * sizeof(BlockInfo) ||
+                    section_info.n_decoded_bytes >  SIZE_MAX)
+                {
+                    return false;
+                }
+            }
+        }
+
+        if (m_header_ptr->section_info_vec[SECTION_ANALYSIS].n_decoded_bytes < sizeof(Analysis) )
+        {
+            return false;
+        }
+    }
+
+    /* Compressed sections get decoded into memory of their own. Pages are only committed once blocks are decoded into
+     * them. */
+    for (uint32_t n_section = 0;
+                  n_section < SECTION_COUNT;
+                ++n_section)
+    {
+        const auto& section_info    = m_header_ptr->section_info_vec[n_section];
+        auto&       decoded_section = m_decoded_section_vec[n_section];
+
+        if ((section_info.flags & SECTION_FLAG_COMPRESSED) == 0)
+        {
+            continue;
+        }
+
+        decoded_section.data_u8_ptr.reset(new (std::nothrow) uint8_t[static_cast<size_t>(section_info.n_decoded_bytes)]);
+
+        if (decoded_section.data_u8_ptr == nullptr)
+        {
+            return false;
+        }
+
+        decoded_section.block_status_vec.resize(section_info.n_blocks,
+                                                VerificationStatus::NOT_VERIFIED);
+    }
+
+    m_arg_ptr        = reinterpret_cast<const APIInterceptor::APIFunctionArgument*>(get_section_ptr(SECTION_ARGS) );
+    m_blob_ptr       = reinterpret_cast<const Blob*>                               (get_section_ptr(SECTION_BLOBS) );
+    m_command_ptr    = reinterpret_cast<const Command*>                            (get_section_ptr(SECTION_COMMANDS) );
+    m_mip_record_ptr = reinterpret_cast<const MipRecord*>                          (get_section_ptr(SECTION_TEXTURE_PROPS) );
+    m_vertex_ptr     = reinterpret_cast<const ReplayerVertexBatchVertex*>          (get_section_ptr(SECTION_VERTICES) );
+
+    m_blob_status_vec.resize(m_header_ptr->n_blobs,
+                             VerificationStatus::NOT_VERIFIED);
+
+    return true;
+}
+
+bool ReplayerSnapshotFile::save(const std::string&             in_filename,
+                                const GLContextState*          in_start_context_state_ptr,
+                                const ReplayerSnapshot*        in_snapshot_ptr,
+                                const GLIDToTexturePropsMap*   in_gl_id_to_texture_props_map_ptr,
+                                const bool&                    in_should_compress,
+                                ReplayerSnapshotFileSaveStats* out_opt_stats_ptr)
+{
+    std::unordered_map<const std::vector<uint8_t>*, uint32_t> blob_data_ptr_to_n_blob_map;
+    std::vector<U8VecSharedPtr>                               blob_data_u8_vec_ptr_vec;
+    FILE*                                                     file_ptr                     = nullptr;
+    Header                                                    header                       = {};
+    const auto                                                n_api_commands               = in_snapshot_ptr->get_n_api_commands();
+    uint64_t                                                  n_blob_data_bytes            = 0;
+    uint64_t                                                  n_written_bytes              = 0;
+    bool                                                      result                       = false;
+    std::vector<uint8_t>                                      section_data_u8_vec_vec[SECTION_COUNT];
+    ReplayerSnapshotFileSaveStats                             stats;
+
+    static const uint8_t zero_u8_vec[SECTION_ALIGNMENT] = {};
+
+    /* Mip data buffers are immutable once shared, so each one only needs to be stored once. */
+    auto get_n_blob = [&](const U8VecSharedPtr& in_data_u8_vec_ptr)
+    {
+        const auto blob_map_iterator = blob_data_ptr_to_n_blob_map.find(in_data_u8_vec_ptr.get() );
+
+        if (blob_map_iterator != blob_data_ptr_to_n_blob_map.end() )
+        {
+            return blob_map_iterator->second;
+        }
+
+        const auto n_blob = static_cast<uint32_t>(blob_data_u8_vec_ptr_vec.size() );
+        Blob       blob;
+
+        blob.checksum     = ReplayerTextureStore::hash(in_data_u8_vec_ptr->data(),
+                                                       static_cast<uint32_t>(in_data_u8_vec_ptr->size() ) );
+        blob.n_bytes      = in_data_u8_vec_ptr->size();
+        blob.n_start_byte = n_blob_data_bytes;
+
+        n_blob_data_bytes += blob.n_bytes;
+
+        serialize(blob,
+                 &section_data_u8_vec_vec[SECTION_BLOBS]);
+
+        blob_data_u8_vec_ptr_vec.push_back   (in_data_u8_vec_ptr);
+        blob_data_ptr_to_n_blob_map.emplace  (in_data_u8_vec_ptr.get(),
+                                              n_blob);
+
+        return n_blob;
+    };
+
+    serialize_gl_context_state(in_start_context_state_ptr,
+                              &section_data_u8_vec_vec[SECTION_START_CONTEXT_STATE]);
+
+    /* Commands */
+    for (uint32_t n_api_command = 0;
+                  n_api_command < n_api_commands;
+                ++n_api_command)
+    {
+        const auto api_command = in_snapshot_ptr->get_api_command_ptr(n_api_command);
+        Command    command     = {};
+
+        command.api_func              = static_cast<uint32_t>(api_command.api_func);
+        command.n_args                = api_command.api_arg_vec.size();
+        command.n_first_arg           = header.n_api_args;
+        command.n_texture_upload_blob = UINT32_MAX;
+        command.cpu_ticks             = (in_snapshot_ptr->has_cpu_ticks() ) ? in_snapshot_ptr->get_cpu_ticks(n_api_command)
+                                                                            : 0;
+
+        for (const auto& current_arg : api_command.api_arg_vec)
+        {
+            serialize(current_arg,
+                     &section_data_u8_vec_vec[SECTION_ARGS]);
+        }
+
+        header.n_api_args += command.n_args;
+
+        if (api_command.vertex_batch.is_valid() )
+        {
+            command.flags          |= COMMAND_FLAG_VERTEX_BATCH;
+            command.n_first_vertex  = header.n_vertices;
+            command.n_vertices      = api_command.vertex_batch.size();
+
+            for (uint32_t n_vertex = 0;
+                          n_vertex < command.n_vertices;
+                        ++n_vertex)
+            {
+                serialize(api_command.vertex_batch.at(n_vertex),
+                         &section_data_u8_vec_vec[SECTION_VERTICES]);
+            }
+
+            header.n_vertices += command.n_vertices;
+        }
+
+        if (api_command.texture_upload_data_ptr != nullptr)
+        {
+            const auto data_u8_vec_ptr = api_command.texture_upload_data_ptr->get_data_u8_vec_ptr(); // may wait for the texture ingester
+
+            if (data_u8_vec_ptr != nullptr)
+            {
+                command.flags                       |= COMMAND_FLAG_TEXTURE_UPLOAD;
+                command.n_texture_upload_blob        = get_n_blob(data_u8_vec_ptr);
+                command.texture_upload_n_row_pixels  = api_command.texture_upload_n_row_pixels;
+            }
+        }
+
+        serialize(command,
+                 &section_data_u8_vec_vec[SECTION_COMMANDS]);
+    }
+
+    /* Texture props. The map is visited in ascending GL ID order, which is what get_mip_data() relies on. */
+    in_gl_id_to_texture_props_map_ptr->for_each(
+        [&](const uint32_t&     in_gl_id,
+            const TextureProps& in_texture_props)
+    {
+        MipRecord mip_record = {};
+
+        mip_record.gl_id        = in_gl_id;
+        mip_record.border       = in_texture_props.border;
+        mip_record.texture_type = static_cast<uint32_t>(in_texture_props.type);
+        mip_record.n_blob       = UINT32_MAX;
+        mip_record.n_mip        = NO_MIPS;
+
+        if (in_texture_props.mip_props_vec.empty() )
+        {
+            serialize(mip_record,
+                     &section_data_u8_vec_vec[SECTION_TEXTURE_PROPS]);
+
+            header.n_mip_records++;
+        }
+
+        for (uint32_t n_mip = 0;
+                      n_mip < static_cast<uint32_t>(in_texture_props.mip_props_vec.size() );
+                    ++n_mip)
+        {
+            const auto& mip_props       = in_texture_props.mip_props_vec.at(n_mip);
+            const auto  data_u8_vec_ptr = mip_props.get_data_u8_vec_ptr(); // may wait for the texture ingester
+
+            mip_record.data_hash        = mip_props.get_data_hash();
+            mip_record.format           = mip_props.format;
+            mip_record.internal_format  = mip_props.internal_format;
+            mip_record.mip_size_u32vec3 = mip_props.mip_size_u32vec3;
+            mip_record.n_blob           = (data_u8_vec_ptr != nullptr) ? get_n_blob(data_u8_vec_ptr)
+                                                                       : UINT32_MAX;
+            mip_record.n_mip            = n_mip;
+            mip_record.type             = mip_props.type;
+
+            serialize(mip_record,
+                     &section_data_u8_vec_vec[SECTION_TEXTURE_PROPS]);
+
+            header.n_mip_records++;
+        }
+    });
+
+    /* Analysis results */
+    {
+        Analysis   analysis          = {};
+        const auto segment_table_ptr = in_snapshot_ptr->get_segment_table();
+
+        analysis.has_cpu_ticks          = (in_snapshot_ptr->has_cpu_ticks() )                                      ? 1 : 0;
+        analysis.has_segment_cpu_times  = (in_snapshot_ptr->get_segment_cpu_times(&analysis.segment_cpu_times) ) ? 1 : 0;
+        analysis.n_cpu_ticks_per_second = in_snapshot_ptr->get_n_cpu_ticks_per_second();
+
+        if (segment_table_ptr != nullptr)
+        {
+            analysis.has_segment_table                     = 1;
+            analysis.n_ao_command_ranges                   = static_cast<uint32_t>(segment_table_ptr->ao_command_range_vec.size         () );
+            analysis.n_shade_model_command_ranges          = static_cast<uint32_t>(segment_table_ptr->shade_model_command_range_vec.size() );
+            analysis.n_first_glrotate_command              = segment_table_ptr->n_first_glrotate_command;
+            analysis.n_screen_space_geom_api_first_command = segment_table_ptr->n_screen_space_geom_api_first_command;
+            analysis.n_screen_space_geom_api_last_command  = segment_table_ptr->n_screen_space_geom_api_last_command;
+            analysis.n_weapon_draw_first_command           = segment_table_ptr->n_weapon_draw_first_command;
+            analysis.n_weapon_draw_last_command            = segment_table_ptr->n_weapon_draw_last_command;
+        }
+
+        serialize(analysis,
+                 &section_data_u8_vec_vec[SECTION_ANALYSIS]);
+
+        if (segment_table_ptr != nullptr)
+        {
+            for (const auto& current_command_range : segment_table_ptr->ao_command_range_vec)
+            {
+                serialize(current_command_range,
+                         &section_data_u8_vec_vec[SECTION_ANALYSIS]);
+            }
+
+            for (const auto& current_command_range : segment_table_ptr->shade_model_command_range_vec)
+            {
+                serialize(current_command_range,
+                         &section_data_u8_vec_vec[SECTION_ANALYSIS]);
+            }
+        }
+    }
+
+    /* Compress sections which hold bulk data. Blob data needs to be gathered in a buffer first, so that it can be split
+     * into blocks. */
+    if (in_should_compress)
+    {
+        static const Section compressible_section_vec[] =
+        {
+            SECTION_COMMANDS,
+            SECTION_ARGS,
+            SECTION_VERTICES,
+            SECTION_BLOB_DATA
+        };
+
+        LARGE_INTEGER end_qpc       = {};
+        LARGE_INTEGER qpc_frequency = {};
+        LARGE_INTEGER start_qpc     = {};
+
+        ::QueryPerformanceCounter  (&start_qpc);
+        ::QueryPerformanceFrequency(&qpc_frequency);
+
+        section_data_u8_vec_vec[SECTION_BLOB_DATA].reserve(static_cast<size_t>(n_blob_data_bytes) );
+
+        for (const auto& current_blob_data_u8_vec_ptr : blob_data_u8_vec_ptr_vec)
+        {
+            section_data_u8_vec_vec[SECTION_BLOB_DATA].insert(section_data_u8_vec_vec[SECTION_BLOB_DATA].end(),
+                                                              current_blob_data_u8_vec_ptr->begin(),
+                                                              current_blob_data_u8_vec_ptr->end  () );
+        }
+
+        for (const auto& current_section : compressible_section_vec)
+        {
+            compress_section( section_data_u8_vec_vec[current_section],
+                             &section_data_u8_vec_vec[current_section],
+                             &header.section_info_vec[current_section]);
+        }
+
+        ::QueryPerformanceCounter(&end_qpc);
+
+        stats.encode_time_ns = static_cast<uint64_t>(static_cast<double>(end_qpc.QuadPart - start_qpc.QuadPart) * 1e9 / static_cast<double>(qpc_frequency.QuadPart) );
+    }
+
+    /* Lay the sections out. Uncompressed blob data is written straight from the blobs, so it is not gathered in a
+     * buffer. */
+    {
+        uint64_t n_byte = sizeof(Header);
+
+        for (uint32_t n_section = 0;
+                      n_section < SECTION_COUNT;
+                    ++n_section)
+        {
+            auto&       section_info     = header.section_info_vec[n_section];
+            const auto& section_data_vec = section_data_u8_vec_vec[n_section];
+
+            n_byte = (n_byte + SECTION_ALIGNMENT - 1) & ~(SECTION_ALIGNMENT - 1);
+
+            section_info.n_start_byte = n_byte;
+            section_info.n_bytes      = (n_section == SECTION_BLOB_DATA && !in_should_compress) ? n_blob_data_bytes
+                                                                                                : section_data_vec.size();
+
+            if ((section_info.flags & SECTION_FLAG_COMPRESSED) == 0)
+            {
+                section_info.n_decoded_bytes = section_info.n_bytes;
+            }
+
+            if (n_section == SECTION_BLOB_DATA)
+            {
+                section_info.checksum = 0;
+            }
+            else
+            {
+                AI_ASSERT(section_data_vec.size() <= UINT32_MAX);
+
+                section_info.checksum = ReplayerTextureStore::hash(section_data_vec.data(),
+                                                                   static_cast<uint32_t>(section_data_vec.size() ) );
+            }
+
+            if (n_section == SECTION_COMMANDS ||
+                n_section == SECTION_ARGS     ||
+                n_section == SECTION_VERTICES ||
+                n_section == SECTION_BLOB_DATA)
+            {
+                stats.n_raw_bytes    += section_info.n_decoded_bytes;
+                stats.n_stored_bytes += section_info.n_bytes;
+            }
+
+            n_byte += section_info.n_bytes;
+        }
+
+        header.magic          = FILE_MAGIC;
+        header.version        = FILE_VERSION;
+        header.n_api_commands = n_api_commands;
+        header.n_blobs        = static_cast<uint32_t>(blob_data_u8_vec_ptr_vec.size() );
+        header.n_file_bytes   = n_byte;
+    }
+
+    file_ptr = ::fopen(in_filename.c_str(),
+                       "wb");
+
+    if (file_ptr == nullptr)
+    {
+        goto end;
+    }
+
+    n_written_bytes += ::fwrite(&header,
+                                1, /* size */
+                                sizeof(header),
+                                file_ptr);
+
+    for (uint32_t n_section = 0;
+                  n_section < SECTION_COUNT;
+                ++n_section)
+    {
+        const auto& section_info = header.section_info_vec[n_section];
+
+        n_written_bytes += ::fwrite(zero_u8_vec,
+                                    1, /* size */
+                                    static_cast<size_t>(section_info.n_start_byte - n_written_bytes),
+                                    file_ptr);
+
+        if (n_section == SECTION_BLOB_DATA &&
+            !in_should_compress)
+        {
+            for (const auto& current_blob_data_u8_vec_ptr : blob_data_u8_vec_ptr_vec)
+            {
+                n_written_bytes += ::fwrite(current_blob_data_u8_vec_ptr->data(),
+                                            1, /* size */
+                                            current_blob_data_u8_vec_ptr->size(),
+                                            file_ptr);
+            }
+        }
+        else
+        {
+            n_written_bytes += ::fwrite(section_data_u8_vec_vec[n_section].data(),
+                                        1, /* size */
+                                        section_data_u8_vec_vec[n_section].size(),
+                                        file_ptr);
+        }
+
+        if (n_written_bytes != section_info.n_start_byte + section_info.n_bytes)
+        {
+            goto end;
+        }
+    }
+
+    result = (n_written_bytes == header.n_file_bytes);
+end:
+    if (file_ptr != nullptr)
+    {
+        result &= (::fclose(file_ptr) == 0);
+    }
+
+    if (out_opt_stats_ptr != nullptr)
+    {
+        *out_opt_stats_ptr = stats;
+    }
+
+    return result;
+}
+
+void ReplayerSnapshotFile::serialize_gl_context_state(const GLContextState* in_gl_context_state_ptr,
+                                                      std::vector<uint8_t>* out_data_u8_vec_ptr)
+{
+    serialize(in_gl_context_state_ptr->alpha_test_enabled,     out_data_u8_vec_ptr);
+    serialize(in_gl_context_state_ptr->blend_enabled,          out_data_u8_vec_ptr);
+    serialize(in_gl_context_state_ptr->cull_face_enabled,      out_data_u8_vec_ptr);
+    serialize(in_gl_context_state_ptr->depth_test_enabled,     out_data_u8_vec_ptr);
+    serialize(in_gl_context_state_ptr->scissor_test_enabled,   out_data_u8_vec_ptr);
+    serialize(in_gl_context_state_ptr->texture_2d_enabled,     out_data_u8_vec_ptr);
+
+    serialize(in_gl_context_state_ptr->alpha_func_func,        out_data_u8_vec_ptr);
+    serialize(in_gl_context_state_ptr->alpha_func_ref,         out_data_u8_vec_ptr);
+    serialize(in_gl_context_state_ptr->blend_func_dfactor,     out_data_u8_vec_ptr);
+    serialize(in_gl_context_state_ptr->blend_func_sfactor,     out_data_u8_vec_ptr);
+    serialize(in_gl_context_state_ptr->clear_color,            out_data_u8_vec_ptr);
+    serialize(in_gl_context_state_ptr->clear_depth,            out_data_u8_vec_ptr);
+    serialize(in_gl_context_state_ptr->cull_face_mode,         out_data_u8_vec_ptr);
+    serialize(in_gl_context_state_ptr->depth_func,             out_data_u8_vec_ptr);
+    serialize(in_gl_context_state_ptr->depth_mask,             out_data_u8_vec_ptr);
+    serialize(in_gl_context_state_ptr->depth_range,            out_data_u8_vec_ptr);
+    serialize(in_gl_context_state_ptr->draw_buffer_mode,       out_data_u8_vec_ptr);
+    serialize(in_gl_context_state_ptr->front_face_mode,        out_data_u8_vec_ptr);
+    serialize(in_gl_context_state_ptr->matrix_mode,            out_data_u8_vec_ptr);
+    serialize(in_gl_context_state_ptr->shade_model,            out_data_u8_vec_ptr);
+    serialize(in_gl_context_state_ptr->texture_env_mode,       out_data_u8_vec_ptr);
+    serialize(in_gl_context_state_ptr->viewport_extents,       out_data_u8_vec_ptr);
+    serialize(in_gl_context_state_ptr->viewport_x1y1,          out_data_u8_vec_ptr);
+    serialize(in_gl_context_state_ptr->modelview_matrix,       out_data_u8_vec_ptr);
+    serialize(in_gl_context_state_ptr->projection_matrix,      out_data_u8_vec_ptr);
+    serialize(in_gl_context_state_ptr->bound_2d_texture_gl_id, out_data_u8_vec_ptr);
+
+    serialize(in_gl_context_state_ptr->gl_texture_id_to_texture_state_map.size(),
+              out_data_u8_vec_ptr);
+
+    in_gl_context_state_ptr->gl_texture_id_to_texture_state_map.for_each(
+        [out_data_u8_vec_ptr](const uint32_t&              in_gl_texture_id,
+                              const GLContextTextureState& in_texture_state)
+    {
+        serialize(in_gl_texture_id, out_data_u8_vec_ptr);
+        serialize(in_texture_state, out_data_u8_vec_ptr);
+    });
+}
+
+bool ReplayerSnapshotFile::verify_mip_records() const
+{
+    /* A matching checksum only tells the records have not been damaged since they were written. get_mip_data() relies
+     * on them being sorted, and get_gl_id_to_texture_props_map() sizes mip vectors after n_mip, so check both. */
+    for (uint32_t n_mip_record = 0;
+                  n_mip_record < m_header_ptr->n_mip_records;
+                ++n_mip_record)
+    {
+        const auto& mip_record = m_mip_record_ptr[n_mip_record];
+
+        if (mip_record.n_mip >= MAX_N_MIPS &&
+            mip_record.n_mip != NO_MIPS)
+        {
+            return false;
+        }
+
+        if (n_mip_record > 0)
+        {
+            const auto& prev_mip_record = m_mip_record_ptr[n_mip_record - 1];
+
+            if (std::make_pair(prev_mip_record.gl_id, prev_mip_record.n_mip) >= std::make_pair(mip_record.gl_id, mip_record.n_mip) )
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+bool ReplayerSnapshotFile::verify_section(const Section& in_section) const
+{
+    auto& section_status = m_section_status_vec[in_section];
+
+    if (section_status == VerificationStatus::NOT_VERIFIED)
+    {
+        const auto& section_info = m_header_ptr->section_info_vec[in_section];
+
+        AI_ASSERT(in_section != SECTION_BLOB_DATA);
+
+        /* Compressed sections are decoded as a whole, once their checksum is known to match. */
+        section_status = (section_info.n_bytes  <= UINT32_MAX                                                         &&
+                          section_info.checksum == ReplayerTextureStore::hash(m_mapped_data_ptr + section_info.n_start_byte,
+                                                                              static_cast<uint32_t>(section_info.n_bytes) ) &&
+                          decode_section_range(in_section,
+                                               0, /* in_n_start_byte */
+                                               section_info.n_decoded_bytes) )                                          ? VerificationStatus::VALID
+                                                                                                                        : VerificationStatus::CORRUPT;
+
+        if (section_status == VerificationStatus::VALID &&
+            in_section     == SECTION_TEXTURE_PROPS     &&
+           !verify_mip_records() )
+        {
+            section_status = VerificationStatus::CORRUPT;
+        }
+    }
+
+    return (section_status == VerificationStatus::VALID);
+}
@@ -79,8 +79,9 @@ void ReplayerSnapshotLogger::log_snapshot(const GLContextState*        in_start_
                    "\n";
 
     {
-        std::string api_command_string;
-        const auto  n_api_commands     = in_snapshot_ptr->get_n_api_commands();
+        APIInterceptor::APICommand api_command;
+        std::string                api_command_string;
+        const auto                 n_api_commands     = in_snapshot_ptr->get_n_api_commands();
 
         log_sstream << std::setw(static_cast<std::streamsize>(log10(n_api_commands) ));
 
@@ -92,10 +93,51 @@ void ReplayerSnapshotLogger::log_snapshot(const GLContextState*        in_start_
 
             log_sstream << "#" << n_api_command << ": ";
 
-            APIInterceptor::convert_api_command_to_string(*api_command_ptr,
+            api_command_ptr->to_api_command(&api_command);
+
+            APIInterceptor::convert_api_command_to_string(api_command,
                                                           &api_command_string);
 
             log_sstream << api_command_string;
+
+            /* Vertex batches are logged as the individual calls they were built from. */
+            if (api_command_ptr->vertex_batch.is_valid() )
+            {
+                ReplayerExpandedAPICommand expanded_command_vec[3];
+                const auto                 n_vertices = api_command_ptr->vertex_batch.size();
+
+                for (uint32_t n_vertex = 0;
+                              n_vertex < n_vertices;
+                            ++n_vertex)
+                {
+                    const auto n_expanded_commands = ReplayerVertexBatchView::expand(api_command_ptr->vertex_batch.at(n_vertex),
+                                                                                     expanded_command_vec);
+
+                    for (uint32_t n_expanded_command = 0;
+                                  n_expanded_command < n_expanded_commands;
+                                ++n_expanded_command)
+                    {
+                        const auto& expanded_command = expanded_command_vec[n_expanded_command];
+
+                        api_command.api_func = expanded_command.api_func;
+                        api_command.api_arg_vec.assign(expanded_command.api_arg_vec.begin(),
+                                                       expanded_command.api_arg_vec.begin() + expanded_command.n_api_args);
+
+                        APIInterceptor::convert_api_command_to_string(api_command,
+                                                                      &api_command_string);
+
+                        log_sstream << "#" << n_api_command << ": " << api_command_string;
+                    }
+                }
+
+                api_command.api_func = APIInterceptor::APIFUNCTION_GL_GLEND;
+                api_command.api_arg_vec.clear();
+
+                APIInterceptor::convert_api_command_to_string(api_command,
+                                                              &api_command_string);
+
+                log_sstream << "#" << n_api_command << ": " << api_command_string;
+            }
         }
     }
 
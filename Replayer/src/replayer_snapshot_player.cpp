@@ -5,6 +5,8 @@
 #include "OpenGL/globals.h"
 #include "WGL/globals.h"
 #include "replayer.h"
+#include "replayer_gl_functions.h"
+#include "replayer_segment_analyzer.h"
 #include "replayer_snapshot_logger.h"
 #include "replayer_snapshot_player.h"
 #include <algorithm>
@@ -18,16 +20,12 @@
 ReplayerSnapshotPlayer::ReplayerSnapshotPlayer(const Replayer*    in_replayer_ptr,
                                                const IUISettings* in_ui_settings_ptr)
     :m_replayer_ptr                           (in_replayer_ptr),
-     m_n_first_glrotate_command               (UINT32_MAX),
-     m_n_screen_space_geom_api_first_command  (UINT32_MAX),
-     m_n_screen_space_geom_api_last_command   (UINT32_MAX),
-     m_n_weapon_draw_first_command            (UINT32_MAX),
-     m_n_weapon_draw_last_command             (UINT32_MAX),
-     m_snapshot_gl_id_to_texture_props_map_ptr(nullptr),
      m_snapshot_initialized                   (false),
+     m_ui_settings_ptr                        (in_ui_settings_ptr),
+     m_segment_table_ptr                      (&m_analyzed_segment_table),
+     m_snapshot_gl_id_to_texture_props_map_ptr(nullptr),
      m_snapshot_ptr                           (nullptr),
-     m_snapshot_start_gl_context_state_ptr    (nullptr),
-     m_ui_settings_ptr                        (in_ui_settings_ptr)
+     m_snapshot_start_gl_context_state_ptr    (nullptr)
 {
     /* Stub */
 }
@@ -41,224 +39,12 @@ void ReplayerSnapshotPlayer::analyze_snapshot()
 {
     assert(m_snapshot_ptr != nullptr);
 
-    const auto n_commands        = m_snapshot_ptr->get_n_api_commands   ();
-    const auto q1_window_extents = m_replayer_ptr->get_q1_window_extents();
- 
-    bool     is_blending_enabled                 = false;
-    bool     is_modulate_env_mode_enabled        = false;
-    uint32_t n_ao_segment_start_command          = UINT32_MAX;
-    uint32_t n_weapon_draw_segment_start_command = UINT32_MAX;
-
-    std::vector<std::array<uint32_t, 2> > draws_with_env_mode_modulate_command_range_vec;
-    std::vector<std::array<uint32_t, 2> > env_mode_modulate_command_range_vec;
-
-    m_ao_command_range_vec.clear         ();
-    m_shade_model_command_range_vec.clear();
-
-    m_n_first_glrotate_command = UINT32_MAX;
-
-    for (uint32_t n_command = 0;
-                  n_command < n_commands;
-                ++n_command)
-    {
-        const auto command_ptr = m_snapshot_ptr->get_api_command_ptr(n_command);
-
-        // All models are "AO-shaded" exclusively by rendering the geometry in question with ENV_MODE set to GL_MODULATE
-        // and with blending disabled.
-        //
-        // Particles are also shaded this method, the excpetion being blending is enabled in this case and there is no
-        // "pre-pass".
-        //
-        // To determine the range used to render the weapon, we:
-        //
-        // 1) Collect snapshot ranges when ENV_MODE is set to GL_MODULATE.
-        // 2) Collect snapshot ranges of glBegin()/glEnd() calls when blending is disabled.
-        //
-        // All draw calls generated while ENV_MODE is set to GL_MODULATE for the last time are used to draw the weapon.
-        //
-        // To determine draw calls used to shade monsters and other 3D models, we simply look at the remaining snapshot ranges.
-        if (command_ptr->api_func == APIInterceptor::APIFunction::APIFUNCTION_GL_GLTEXENVF)
-        {
-            const auto mode = static_cast<uint32_t>(command_ptr->api_arg_vec.at(2).get_fp32() );
-
-            if (mode == GL_MODULATE)
-            {
-                if (env_mode_modulate_command_range_vec.size()       == 0          ||
-                    env_mode_modulate_command_range_vec.back().at(1) != UINT32_MAX)
-                {
-                    env_mode_modulate_command_range_vec.push_back(std::array<uint32_t, 2>{n_command, UINT32_MAX});
-                }
-            }
-            else
-            {
-                if (env_mode_modulate_command_range_vec.size()       >  0 &&
-                    env_mode_modulate_command_range_vec.back().at(1) == UINT32_MAX)
-                {
-                    env_mode_modulate_command_range_vec.back().at(1) = n_command - 1;
-                }
-            }
-
-            if (is_blending_enabled == false &&
-                mode                == GL_MODULATE)
-            {
-                assert(n_weapon_draw_segment_start_command == UINT32_MAX);
-
-                is_modulate_env_mode_enabled = true;
-            }
-            else
-            {
-                is_modulate_env_mode_enabled = false;
-            }
-        }
-
-        if (is_modulate_env_mode_enabled == true)
-        {
-            if (command_ptr->api_func == APIInterceptor::APIFunction::APIFUNCTION_GL_GLBEGIN)
-            {
-                assert(n_weapon_draw_segment_start_command == UINT32_MAX);
-
-                n_weapon_draw_segment_start_command = n_command;
-            }
-            else
-            if (command_ptr->api_func == APIInterceptor::APIFunction::APIFUNCTION_GL_GLEND)
-            {
-                assert(n_weapon_draw_segment_start_command != UINT32_MAX);
-
-                draws_with_env_mode_modulate_command_range_vec.emplace_back(
-                    std::array<uint32_t, 2>{n_weapon_draw_segment_start_command,
-                                            n_command}
-                );
-
-                n_weapon_draw_segment_start_command = UINT32_MAX;
-            }
-        }
-
-        if (command_ptr->api_func == APIInterceptor::APIFunction::APIFUNCTION_GL_GLBLENDFUNC)
-        {
-            // For scene geometry, Q1 appears to first render diffuse-only textures first, and then follow up with AO
-            // achieved by re-rendering the geometry rendered in the earlier pass(es) with a lightmap texture enabled +
-            // special blending settings applied. This can be done multiple times in a single frame.
-            //
-            // This segment ends with the first glDisable(GL_BLEND) call encountered.
-            auto       next_command_ptr = m_snapshot_ptr->get_api_command_ptr(n_command + 1);
-            const auto sfactor          = static_cast<uint32_t>(command_ptr->api_arg_vec.at(0).get_u32() );
-            const auto dfactor          = static_cast<uint32_t>(command_ptr->api_arg_vec.at(1).get_u32() );
-
-            if (sfactor                    == GL_ZERO                                               &&
-                dfactor                    == GL_ONE_MINUS_SRC_COLOR                                &&
-                next_command_ptr->api_func == APIInterceptor::APIFunction::APIFUNCTION_GL_GLENABLE)
-            {
-                if (n_ao_segment_start_command == UINT32_MAX)
-                {
-                    n_ao_segment_start_command = n_command;
-                }
-                else
-                {
-                    assert(false);
-                }
-            }
-        }
-
-        if (command_ptr->api_func == APIInterceptor::APIFunction::APIFUNCTION_GL_GLDISABLE)
-        {
-            const auto cap = command_ptr->api_arg_vec.at(0).get_u32();
-
-            if (cap == GL_BLEND)
-            {
-                is_blending_enabled = false;
-            }
-
-            if (n_ao_segment_start_command != UINT32_MAX &&
-                cap                        == GL_BLEND)
-            {
-                m_ao_command_range_vec.push_back(std::array<uint32_t, 2>{n_ao_segment_start_command,
-                                                                         n_command});
-
-                n_ao_segment_start_command = UINT32_MAX;
-            }
-        }
-        else
-        if (command_ptr->api_func == APIInterceptor::APIFunction::APIFUNCTION_GL_GLENABLE)
-        {
-            const auto cap = command_ptr->api_arg_vec.at(0).get_u32();
-
-            if (cap == GL_BLEND)
-            {
-                is_blending_enabled = true;
-            }
-        }
-
-        if (command_ptr->api_func == APIInterceptor::APIFunction::APIFUNCTION_GL_GLORTHO)
-        {
-            const auto left   = static_cast<uint32_t>(command_ptr->api_arg_vec.at(0).get_fp64() );
-            const auto right  = static_cast<uint32_t>(command_ptr->api_arg_vec.at(1).get_fp64() );
-            const auto bottom = static_cast<uint32_t>(command_ptr->api_arg_vec.at(2).get_fp64() );
-            const auto top    = static_cast<uint32_t>(command_ptr->api_arg_vec.at(3).get_fp64() );
-
-            if (left   == 0                       &&
-                top    == 0                       &&
-                right  == q1_window_extents.at(0) &&
-                bottom == q1_window_extents.at(1) )
-            {
-                m_n_screen_space_geom_api_first_command = n_command;
-                m_n_screen_space_geom_api_last_command  = n_commands - 1;
-
-                break;
-            }
-        }
-
-        if (command_ptr->api_func      == APIInterceptor::APIFunction::APIFUNCTION_GL_GLROTATEF &&
-            m_n_first_glrotate_command == UINT32_MAX)
-        {
-            m_n_first_glrotate_command = n_command;
-        }
-    }
-
-    if (env_mode_modulate_command_range_vec.size() > 0)
-    {
-        // Identify API call ranges used to shade 3D models.
-        {
-            const auto n_last_valid_command_api = env_mode_modulate_command_range_vec.back().at(0) - 1;
-
-            m_shade_model_command_range_vec.reserve(draws_with_env_mode_modulate_command_range_vec.size() );
-
-            for (const auto& current_draw_api_command_range : draws_with_env_mode_modulate_command_range_vec)
-            {
-                if (current_draw_api_command_range.at(1) <= n_last_valid_command_api)
-                {
-                    m_shade_model_command_range_vec.emplace_back(current_draw_api_command_range);
-                }
-                else
-                {
-                    break;
-                }
-            }
-        }
-
-        // Identify API call range used to draw the weapon.
-        {
-            const auto n_env_mode_modulate_start_command = env_mode_modulate_command_range_vec.back().at(0);
-            uint32_t   n_first_weapon_draw_command_range = 0;
-
-            do
-            {
-                const auto& current_range = draws_with_env_mode_modulate_command_range_vec.at(n_first_weapon_draw_command_range);
+    auto segment_analyzer_ptr = ReplayerSegmentAnalyzer::create(Replayer::get_q1_window_extents() );
 
-                if (current_range.at(0) < n_env_mode_modulate_start_command)
-                {
-                    n_first_weapon_draw_command_range ++;
-                }
-                else
-                {
-                    break;
-                }
-            }
-            while (true);
+    segment_analyzer_ptr->finish(*m_snapshot_ptr,
+                                 &m_analyzed_segment_table);
 
-            m_n_weapon_draw_first_command = draws_with_env_mode_modulate_command_range_vec.at(n_first_weapon_draw_command_range).at(0);
-            m_n_weapon_draw_last_command  = env_mode_modulate_command_range_vec.back         ().at                                 (1);
-        }
-    }
+    m_segment_table_ptr = &m_analyzed_segment_table;
 }
 
 ReplayerSnapshotPlayerUniquePtr ReplayerSnapshotPlayer::create(const Replayer*    in_replayer_ptr,
@@ -302,8 +88,15 @@ void ReplayerSnapshotPlayer::load_snapshot(const GLContextState*        in_start
         m_snapshot_texture_gl_id_to_texture_gl_id_map.clear();
     }
 
-    // Identify a number of segments important for us.
-    analyze_snapshot();
+    // Identify a number of segments important for us. These are normally found while the snapshot is being recorded.
+    if (m_snapshot_ptr->get_segment_table() != nullptr)
+    {
+        m_segment_table_ptr = m_snapshot_ptr->get_segment_table();
+    }
+    else
+    {
+        analyze_snapshot();
+    }
 }
 
 void ReplayerSnapshotPlayer::lock_for_snapshot_access()
@@ -316,6 +109,74 @@ void ReplayerSnapshotPlayer::unlock_for_snapshot_access()
     m_mutex.unlock();
 }
 
+void ReplayerSnapshotPlayer::play_vertex_batch(const ReplayerVertexBatchView& in_vertex_batch)
+{
+    const auto pfn_gl_color_3f     = reinterpret_cast<PFNGLCOLOR3FPROC>   (OpenGL::g_cached_gl_color_3f);
+    const auto pfn_gl_color_3ub    = reinterpret_cast<PFNGLCOLOR3UBPROC>  (OpenGL::g_cached_gl_color_3ub);
+    const auto pfn_gl_color_4f     = reinterpret_cast<PFNGLCOLOR4FPROC>   (OpenGL::g_cached_gl_color_4f);
+    const auto pfn_gl_tex_coord_2f = reinterpret_cast<PFNGLTEXCOORD2FPROC>(OpenGL::g_cached_gl_tex_coord_2f);
+    const auto pfn_gl_vertex_2f    = reinterpret_cast<PFNGLVERTEX2FPROC>  (OpenGL::g_cached_gl_vertex_2f);
+    const auto pfn_gl_vertex_3f    = reinterpret_cast<PFNGLVERTEX3FPROC>  (OpenGL::g_cached_gl_vertex_3f);
+    const auto pfn_gl_vertex_4f    = reinterpret_cast<PFNGLVERTEX4FPROC>  (OpenGL::g_cached_gl_vertex_4f);
+    const auto n_vertices          = in_vertex_batch.size();
+
+    for (uint32_t n_vertex = 0;
+                  n_vertex < n_vertices;
+                ++n_vertex)
+    {
+        const auto& vertex = in_vertex_batch.at(n_vertex);
+
+        if ((vertex.attribute_mask & ReplayerVertexBatchVertex::ATTRIBUTE_COLOR_3F) != 0)
+        {
+            pfn_gl_color_3f(vertex.color[0],
+                            vertex.color[1],
+                            vertex.color[2]);
+        }
+        else
+        if ((vertex.attribute_mask & ReplayerVertexBatchVertex::ATTRIBUTE_COLOR_3UB) != 0)
+        {
+            pfn_gl_color_3ub(static_cast<GLubyte>(vertex.color[0]),
+                             static_cast<GLubyte>(vertex.color[1]),
+                             static_cast<GLubyte>(vertex.color[2]) );
+        }
+        else
+        if ((vertex.attribute_mask & ReplayerVertexBatchVertex::ATTRIBUTE_COLOR_4F) != 0)
+        {
+            pfn_gl_color_4f(vertex.color[0],
+                            vertex.color[1],
+                            vertex.color[2],
+                            vertex.color[3]);
+        }
+
+        if ((vertex.attribute_mask & ReplayerVertexBatchVertex::ATTRIBUTE_TEXCOORD_2F) != 0)
+        {
+            pfn_gl_tex_coord_2f(vertex.texcoord[0],
+                                vertex.texcoord[1]);
+        }
+
+        if ((vertex.attribute_mask & ReplayerVertexBatchVertex::ATTRIBUTE_POSITION_2F) != 0)
+        {
+            pfn_gl_vertex_2f(vertex.position[0],
+                             vertex.position[1]);
+        }
+        else
+        if ((vertex.attribute_mask & ReplayerVertexBatchVertex::ATTRIBUTE_POSITION_3F) != 0)
+        {
+            pfn_gl_vertex_3f(vertex.position[0],
+                             vertex.position[1],
+                             vertex.position[2]);
+        }
+        else
+        if ((vertex.attribute_mask & ReplayerVertexBatchVertex::ATTRIBUTE_POSITION_4F) != 0)
+        {
+            pfn_gl_vertex_4f(vertex.position[0],
+                             vertex.position[1],
+                             vertex.position[2],
+                             vertex.position[3]);
+        }
+    }
+}
+
 void ReplayerSnapshotPlayer::play_snapshot()
 {
     assert(m_snapshot_ptr != nullptr);
@@ -327,11 +188,12 @@ void ReplayerSnapshotPlayer::play_snapshot()
         assert(m_snapshot_gl_id_to_texture_props_map_ptr != nullptr);
 
         /* Set up textures.. */
-        for (const auto& iterator : *m_snapshot_gl_id_to_texture_props_map_ptr)
+        m_snapshot_gl_id_to_texture_props_map_ptr->for_each(
+            [this](const uint32_t&     reference_texture_id,
+                   const TextureProps& reference_texture_props)
         {
             uint32_t    new_texture_id       =  0;
-            const auto& reference_texture_id =  iterator.first;
-            const auto  texture_props_ptr    = &iterator.second;
+            const auto  texture_props_ptr    = &reference_texture_props;
             const auto  texture_n_mips       =  static_cast<uint32_t>(texture_props_ptr->mip_props_vec.size() );
 
             assert(reference_texture_id    != 0);
@@ -364,10 +226,10 @@ void ReplayerSnapshotPlayer::play_snapshot()
                                                                                             texture_props_ptr->border,
                                                                                             texture_mip_props_ptr->format,
                                                                                             texture_mip_props_ptr->type,
-                                                                                            texture_mip_props_ptr->data_u8_vec.data() );
+                                                                                            texture_mip_props_ptr->get_data_u8_vec_ptr()->data() );
                 }
             }
-        }
+        });
 
         m_snapshot_initialized = true;
     }
@@ -386,7 +248,7 @@ void ReplayerSnapshotPlayer::play_snapshot()
 
             if (api_command_ptr->api_func == APIInterceptor::APIFUNCTION_GL_GLDEPTHFUNC)
             {
-                frame_depth_func = api_command_ptr->api_arg_vec.at(0).get_u32();
+                frame_depth_func = CommandView<APIInterceptor::APIFUNCTION_GL_GLDEPTHFUNC>(api_command_ptr).get<0>();
 
                 break;
             }
@@ -470,11 +332,11 @@ void ReplayerSnapshotPlayer::play_snapshot()
             const auto pfn_gl_bind_texture   = reinterpret_cast<PFNGLBINDTEXTUREPROC>  (OpenGL::g_cached_gl_bind_texture);
             const auto pfn_gl_tex_parameterf = reinterpret_cast<PFNGLTEXPARAMETERFPROC>(OpenGL::g_cached_gl_tex_parameterf);
 
-            for (const auto& iterator : m_snapshot_start_gl_context_state_ptr->gl_texture_id_to_texture_state_map)
+            m_snapshot_start_gl_context_state_ptr->gl_texture_id_to_texture_state_map.for_each(
+                [&](const uint32_t&              snapshot_gl_texture_id,
+                    const GLContextTextureState& texture_state)
             {
-                const auto& snapshot_gl_texture_id = iterator.first;
-                const auto& texture_state          = iterator.second;
-                const auto  gl_texture_id          = m_snapshot_texture_gl_id_to_texture_gl_id_map.at(snapshot_gl_texture_id);
+                const auto gl_texture_id = m_snapshot_texture_gl_id_to_texture_gl_id_map.at(snapshot_gl_texture_id);
 
                 pfn_gl_bind_texture(GL_TEXTURE_2D,
                                     gl_texture_id);
@@ -488,7 +350,7 @@ void ReplayerSnapshotPlayer::play_snapshot()
                 pfn_gl_tex_parameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_R,     static_cast<float>(texture_state.wrap_r)     );
                 pfn_gl_tex_parameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S,     static_cast<float>(texture_state.wrap_s)     );
                 pfn_gl_tex_parameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T,     static_cast<float>(texture_state.wrap_t)     );
-            }
+            });
         }
 
         {
@@ -523,7 +385,7 @@ void ReplayerSnapshotPlayer::play_snapshot()
             {
                 bool should_skip_command = false;
 
-                for (const auto& current_range : m_ao_command_range_vec)
+                for (const auto& current_range : m_segment_table_ptr->ao_command_range_vec)
                 {
                     if (n_api_command >= current_range.at(0) &&
                         n_api_command <= current_range.at(1) )
@@ -545,8 +407,8 @@ void ReplayerSnapshotPlayer::play_snapshot()
             {
                 bool should_skip_command = false;
 
-                if (n_api_command >= m_n_weapon_draw_first_command &&
-                    n_api_command <= m_n_weapon_draw_last_command)
+                if (n_api_command >= m_segment_table_ptr->n_weapon_draw_first_command &&
+                    n_api_command <= m_segment_table_ptr->n_weapon_draw_last_command)
                 {
                     should_skip_command = true;
                 }
@@ -561,8 +423,8 @@ void ReplayerSnapshotPlayer::play_snapshot()
             if (!m_ui_settings_ptr->should_draw_screenspace_geometry() )
             {
                 /* Skip playback of commands responsible for rendering screen-space geom */
-                if (n_api_command >= m_n_screen_space_geom_api_first_command &&
-                    n_api_command <= m_n_screen_space_geom_api_last_command)
+                if (n_api_command >= m_segment_table_ptr->n_screen_space_geom_api_first_command &&
+                    n_api_command <= m_segment_table_ptr->n_screen_space_geom_api_last_command)
                 {
                     continue;
                 }
@@ -571,7 +433,7 @@ void ReplayerSnapshotPlayer::play_snapshot()
             // Should we shade 3D models?
             if (!m_ui_settings_ptr->should_shade_3d_models() )
             {
-                for (const auto& current_range : m_shade_model_command_range_vec)
+                for (const auto& current_range : m_segment_table_ptr->shade_model_command_range_vec)
                 {
                     if (n_api_command == current_range.at(0) )
                     {
@@ -585,7 +447,7 @@ void ReplayerSnapshotPlayer::play_snapshot()
             }
 
             /* Translate the eye as specified in the UI */
-            if (n_api_command == m_n_first_glrotate_command)
+            if (n_api_command == m_segment_table_ptr->n_first_glrotate_command)
             {
                 reinterpret_cast<PFNGLTRANSLATEFPROC>(OpenGL::g_cached_gl_translate_f)(m_ui_settings_ptr->get_eye_translation_x_offset(),
                                                                                        0.0f,
@@ -596,26 +458,42 @@ void ReplayerSnapshotPlayer::play_snapshot()
             {
                 case APIInterceptor::APIFUNCTION_GL_GLALPHAFUNC:
                 {
-                    reinterpret_cast<PFNGLALPHAFUNCPROC>(OpenGL::g_cached_gl_alpha_func)(api_command_ptr->api_arg_vec.at(0).get_u32 (),
-                                                                                         api_command_ptr->api_arg_vec.at(1).get_fp32() );
+                    const CommandView<APIInterceptor::APIFUNCTION_GL_GLALPHAFUNC> command(api_command_ptr);
+
+                    reinterpret_cast<PFNGLALPHAFUNCPROC>(OpenGL::g_cached_gl_alpha_func)(command.get<0>(),
+                                                                                         command.get<1>() );
 
                     break;
                 }
 
                 case APIInterceptor::APIFUNCTION_GL_GLBEGIN:
                 {
-                    reinterpret_cast<PFNGLBEGINPROC>(OpenGL::g_cached_gl_begin)(api_command_ptr->api_arg_vec.at(0).get_u32() );
+                    const CommandView<APIInterceptor::APIFUNCTION_GL_GLBEGIN> command(api_command_ptr);
+
+                    reinterpret_cast<PFNGLBEGINPROC>(OpenGL::g_cached_gl_begin)(command.get<0>() );
+
+                    if (api_command_ptr->vertex_batch.is_valid() )
+                    {
+                        play_vertex_batch(api_command_ptr->vertex_batch);
+
+                        reinterpret_cast<PFNGLENDPROC>(OpenGL::g_cached_gl_end)();
+                    }
+                    else
+                    {
+                        is_begin_active = true;
+                    }
 
-                    is_begin_active = true;
                     break;
                 }
 
                 case APIInterceptor::APIFUNCTION_GL_GLBINDTEXTURE:
                 {
-                    const auto snapshot_texture_id = api_command_ptr->api_arg_vec.at(1).get_u32      ();
+                    const CommandView<APIInterceptor::APIFUNCTION_GL_GLBINDTEXTURE> command(api_command_ptr);
+
+                    const auto snapshot_texture_id = command.get<1>();
                     const auto this_texture_id     = m_snapshot_texture_gl_id_to_texture_gl_id_map.at(snapshot_texture_id);
 
-                    reinterpret_cast<PFNGLBINDTEXTUREPROC>(OpenGL::g_cached_gl_bind_texture)(api_command_ptr->api_arg_vec.at(0).get_u32(),
+                    reinterpret_cast<PFNGLBINDTEXTUREPROC>(OpenGL::g_cached_gl_bind_texture)(command.get<0>(),
                                                                                              this_texture_id);
 
                     break;
@@ -623,110 +501,138 @@ void ReplayerSnapshotPlayer::play_snapshot()
 
                 case APIInterceptor::APIFUNCTION_GL_GLBLENDFUNC:
                 {
-                    reinterpret_cast<PFNGLBLENDFUNCPROC>(OpenGL::g_cached_gl_blend_func)(api_command_ptr->api_arg_vec.at(0).get_u32() ,
-                                                                                         api_command_ptr->api_arg_vec.at(1).get_u32() );
+                    const CommandView<APIInterceptor::APIFUNCTION_GL_GLBLENDFUNC> command(api_command_ptr);
+
+                    reinterpret_cast<PFNGLBLENDFUNCPROC>(OpenGL::g_cached_gl_blend_func)(command.get<0>() ,
+                                                                                         command.get<1>() );
 
                     break;
                 }
 
                 case APIInterceptor::APIFUNCTION_GL_GLCLEAR:
                 {
-                    reinterpret_cast<PFNGLCLEARPROC>(OpenGL::g_cached_gl_clear)(api_command_ptr->api_arg_vec.at(0).get_u32() );
+                    const CommandView<APIInterceptor::APIFUNCTION_GL_GLCLEAR> command(api_command_ptr);
+
+                    reinterpret_cast<PFNGLCLEARPROC>(OpenGL::g_cached_gl_clear)(command.get<0>() );
 
                     break;
                 }
 
                 case APIInterceptor::APIFUNCTION_GL_GLCLEARCOLOR:
                 {
-                    reinterpret_cast<PFNGLCLEARCOLORPROC>(OpenGL::g_cached_gl_clear_color)(api_command_ptr->api_arg_vec.at(0).get_fp32(),
-                                                                                           api_command_ptr->api_arg_vec.at(1).get_fp32(),
-                                                                                           api_command_ptr->api_arg_vec.at(2).get_fp32(),
-                                                                                           api_command_ptr->api_arg_vec.at(3).get_fp32() );
+                    const CommandView<APIInterceptor::APIFUNCTION_GL_GLCLEARCOLOR> command(api_command_ptr);
+
+                    reinterpret_cast<PFNGLCLEARCOLORPROC>(OpenGL::g_cached_gl_clear_color)(command.get<0>(),
+                                                                                           command.get<1>(),
+                                                                                           command.get<2>(),
+                                                                                           command.get<3>() );
 
                     break;
                 }
 
                 case APIInterceptor::APIFUNCTION_GL_GLCLEARDEPTH:
                 {
-                    reinterpret_cast<PFNGLCLEARDEPTHPROC>(OpenGL::g_cached_gl_clear_depth)(api_command_ptr->api_arg_vec.at(0).get_fp64() );
+                    const CommandView<APIInterceptor::APIFUNCTION_GL_GLCLEARDEPTH> command(api_command_ptr);
+
+                    reinterpret_cast<PFNGLCLEARDEPTHPROC>(OpenGL::g_cached_gl_clear_depth)(command.get<0>() );
 
                     break;
                 }
 
                 case APIInterceptor::APIFUNCTION_GL_GLCOLOR3F:
                 {
-                    reinterpret_cast<PFNGLCOLOR3FPROC>(OpenGL::g_cached_gl_color_3f)(api_command_ptr->api_arg_vec.at(0).get_fp32(),
-                                                                                     api_command_ptr->api_arg_vec.at(1).get_fp32(),
-                                                                                     api_command_ptr->api_arg_vec.at(2).get_fp32() );
+                    const CommandView<APIInterceptor::APIFUNCTION_GL_GLCOLOR3F> command(api_command_ptr);
+
+                    reinterpret_cast<PFNGLCOLOR3FPROC>(OpenGL::g_cached_gl_color_3f)(command.get<0>(),
+                                                                                     command.get<1>(),
+                                                                                     command.get<2>() );
 
                     break;
                 }
 
                 case APIInterceptor::APIFUNCTION_GL_GLCOLOR3UB:
                 {
-                    reinterpret_cast<PFNGLCOLOR3UBPROC>(OpenGL::g_cached_gl_color_3ub)(api_command_ptr->api_arg_vec.at(0).get_u8(),
-                                                                                       api_command_ptr->api_arg_vec.at(1).get_u8(),
-                                                                                       api_command_ptr->api_arg_vec.at(2).get_u8() );
+                    const CommandView<APIInterceptor::APIFUNCTION_GL_GLCOLOR3UB> command(api_command_ptr);
+
+                    reinterpret_cast<PFNGLCOLOR3UBPROC>(OpenGL::g_cached_gl_color_3ub)(command.get<0>(),
+                                                                                       command.get<1>(),
+                                                                                       command.get<2>() );
 
                     break;
                 }
 
                 case APIInterceptor::APIFUNCTION_GL_GLCOLOR4F:
                 {
-                    reinterpret_cast<PFNGLCOLOR4FPROC>(OpenGL::g_cached_gl_color_4f)(api_command_ptr->api_arg_vec.at(0).get_fp32(),
-                                                                                     api_command_ptr->api_arg_vec.at(1).get_fp32(),
-                                                                                     api_command_ptr->api_arg_vec.at(2).get_fp32(),
-                                                                                     api_command_ptr->api_arg_vec.at(3).get_fp32() );
+                    const CommandView<APIInterceptor::APIFUNCTION_GL_GLCOLOR4F> command(api_command_ptr);
+
+                    reinterpret_cast<PFNGLCOLOR4FPROC>(OpenGL::g_cached_gl_color_4f)(command.get<0>(),
+                                                                                     command.get<1>(),
+                                                                                     command.get<2>(),
+                                                                                     command.get<3>() );
 
                     break;
                 }
 
                 case APIInterceptor::APIFUNCTION_GL_GLCULLFACE:
                 {
-                    reinterpret_cast<PFNGLCULLFACEPROC>(OpenGL::g_cached_gl_cull_face)(api_command_ptr->api_arg_vec.at(0).get_u32() );
+                    const CommandView<APIInterceptor::APIFUNCTION_GL_GLCULLFACE> command(api_command_ptr);
+
+                    reinterpret_cast<PFNGLCULLFACEPROC>(OpenGL::g_cached_gl_cull_face)(command.get<0>() );
 
                     break;
                 }
 
                 case APIInterceptor::APIFUNCTION_GL_GLDEPTHFUNC:
                 {
-                    reinterpret_cast<PFNGLDEPTHFUNCPROC>(OpenGL::g_cached_gl_depth_func)(api_command_ptr->api_arg_vec.at(0).get_u32() );
+                    const CommandView<APIInterceptor::APIFUNCTION_GL_GLDEPTHFUNC> command(api_command_ptr);
+
+                    reinterpret_cast<PFNGLDEPTHFUNCPROC>(OpenGL::g_cached_gl_depth_func)(command.get<0>() );
 
                     break;
                 }
 
                 case APIInterceptor::APIFUNCTION_GL_GLDEPTHMASK:
                 {
-                    reinterpret_cast<PFNGLDEPTHMASKPROC>(OpenGL::g_cached_gl_depth_mask)(api_command_ptr->api_arg_vec.at(0).get_u32() );
+                    const CommandView<APIInterceptor::APIFUNCTION_GL_GLDEPTHMASK> command(api_command_ptr);
+
+                    reinterpret_cast<PFNGLDEPTHMASKPROC>(OpenGL::g_cached_gl_depth_mask)(command.get<0>() );
 
                     break;
                 }
 
                 case APIInterceptor::APIFUNCTION_GL_GLDEPTHRANGE:
                 {
-                    reinterpret_cast<PFNGLDEPTHRANGEPROC>(OpenGL::g_cached_gl_depth_range)(api_command_ptr->api_arg_vec.at(0).get_fp64(),
-                                                                                           api_command_ptr->api_arg_vec.at(1).get_fp64() );
+                    const CommandView<APIInterceptor::APIFUNCTION_GL_GLDEPTHRANGE> command(api_command_ptr);
+
+                    reinterpret_cast<PFNGLDEPTHRANGEPROC>(OpenGL::g_cached_gl_depth_range)(command.get<0>(),
+                                                                                           command.get<1>() );
 
                     break;
                 }
 
                 case APIInterceptor::APIFUNCTION_GL_GLDISABLE:
                 {
-                    reinterpret_cast<PFNGLDISABLEPROC>(OpenGL::g_cached_gl_disable)(api_command_ptr->api_arg_vec.at(0).get_u32() );
+                    const CommandView<APIInterceptor::APIFUNCTION_GL_GLDISABLE> command(api_command_ptr);
+
+                    reinterpret_cast<PFNGLDISABLEPROC>(OpenGL::g_cached_gl_disable)(command.get<0>() );
 
                     break;
                 }
 
                 case APIInterceptor::APIFUNCTION_GL_GLDRAWBUFFER:
                 {
-                    reinterpret_cast<PFNGLDRAWBUFFERPROC>(OpenGL::g_cached_gl_draw_buffer)(api_command_ptr->api_arg_vec.at(0).get_u32() );
+                    const CommandView<APIInterceptor::APIFUNCTION_GL_GLDRAWBUFFER> command(api_command_ptr);
+
+                    reinterpret_cast<PFNGLDRAWBUFFERPROC>(OpenGL::g_cached_gl_draw_buffer)(command.get<0>() );
 
                     break;
                 }
 
                 case APIInterceptor::APIFUNCTION_GL_GLENABLE:
                 {
-                    const auto cap = api_command_ptr->api_arg_vec.at(0).get_u32();
+                    const CommandView<APIInterceptor::APIFUNCTION_GL_GLENABLE> command(api_command_ptr);
+
+                    const auto cap = command.get<0>();
 
                     reinterpret_cast<PFNGLENABLEPROC>(OpenGL::g_cached_gl_enable)(cap);
 
@@ -757,19 +663,23 @@ void ReplayerSnapshotPlayer::play_snapshot()
 
                 case APIInterceptor::APIFUNCTION_GL_GLFRONTFACE:
                 {
-                    reinterpret_cast<PFNGLFRONTFACEPROC>(OpenGL::g_cached_gl_front_face)(api_command_ptr->api_arg_vec.at(0).get_u32() );
+                    const CommandView<APIInterceptor::APIFUNCTION_GL_GLFRONTFACE> command(api_command_ptr);
+
+                    reinterpret_cast<PFNGLFRONTFACEPROC>(OpenGL::g_cached_gl_front_face)(command.get<0>() );
 
                     break;
                 }
 
                 case APIInterceptor::APIFUNCTION_GL_GLFRUSTUM:
                 {
-                    reinterpret_cast<PFNGLFRUSTUMPROC>(OpenGL::g_cached_gl_frustum)(api_command_ptr->api_arg_vec.at(0).get_fp64(),
-                                                                                    api_command_ptr->api_arg_vec.at(1).get_fp64(),
-                                                                                    api_command_ptr->api_arg_vec.at(2).get_fp64(),
-                                                                                    api_command_ptr->api_arg_vec.at(3).get_fp64(),
-                                                                                    api_command_ptr->api_arg_vec.at(4).get_fp64(),
-                                                                                    api_command_ptr->api_arg_vec.at(5).get_fp64() );
+                    const CommandView<APIInterceptor::APIFUNCTION_GL_GLFRUSTUM> command(api_command_ptr);
+
+                    reinterpret_cast<PFNGLFRUSTUMPROC>(OpenGL::g_cached_gl_frustum)(command.get<0>(),
+                                                                                    command.get<1>(),
+                                                                                    command.get<2>(),
+                                                                                    command.get<3>(),
+                                                                                    command.get<4>(),
+                                                                                    command.get<5>() );
 
                     break;
                 }
@@ -783,19 +693,23 @@ void ReplayerSnapshotPlayer::play_snapshot()
 
                 case APIInterceptor::APIFUNCTION_GL_GLMATRIXMODE:
                 {
-                    reinterpret_cast<PFNGLMATRIXMODEPROC>(OpenGL::g_cached_gl_matrix_mode)(api_command_ptr->api_arg_vec.at(0).get_u32() );
+                    const CommandView<APIInterceptor::APIFUNCTION_GL_GLMATRIXMODE> command(api_command_ptr);
+
+                    reinterpret_cast<PFNGLMATRIXMODEPROC>(OpenGL::g_cached_gl_matrix_mode)(command.get<0>() );
 
                     break;
                 }
 
                 case APIInterceptor::APIFUNCTION_GL_GLORTHO:
                 {
-                    reinterpret_cast<PFNGLORTHOPROC>(OpenGL::g_cached_gl_ortho)(api_command_ptr->api_arg_vec.at(0).get_fp64(),
-                                                                                api_command_ptr->api_arg_vec.at(1).get_fp64(),
-                                                                                api_command_ptr->api_arg_vec.at(2).get_fp64(),
-                                                                                api_command_ptr->api_arg_vec.at(3).get_fp64(),
-                                                                                api_command_ptr->api_arg_vec.at(4).get_fp64(),
-                                                                                api_command_ptr->api_arg_vec.at(5).get_fp64() );
+                    const CommandView<APIInterceptor::APIFUNCTION_GL_GLORTHO> command(api_command_ptr);
+
+                    reinterpret_cast<PFNGLORTHOPROC>(OpenGL::g_cached_gl_ortho)(command.get<0>(),
+                                                                                command.get<1>(),
+                                                                                command.get<2>(),
+                                                                                command.get<3>(),
+                                                                                command.get<4>(),
+                                                                                command.get<5>() );
 
                     break;
                 }
@@ -823,44 +737,54 @@ void ReplayerSnapshotPlayer::play_snapshot()
 
                 case APIInterceptor::APIFUNCTION_GL_GLROTATEF:
                 {
-                    reinterpret_cast<PFNGLROTATEFPROC>(OpenGL::g_cached_gl_rotate_f)(api_command_ptr->api_arg_vec.at(0).get_fp32(),
-                                                                                     api_command_ptr->api_arg_vec.at(1).get_fp32(),
-                                                                                     api_command_ptr->api_arg_vec.at(2).get_fp32(),
-                                                                                     api_command_ptr->api_arg_vec.at(3).get_fp32() );
+                    const CommandView<APIInterceptor::APIFUNCTION_GL_GLROTATEF> command(api_command_ptr);
+
+                    reinterpret_cast<PFNGLROTATEFPROC>(OpenGL::g_cached_gl_rotate_f)(command.get<0>(),
+                                                                                     command.get<1>(),
+                                                                                     command.get<2>(),
+                                                                                     command.get<3>() );
 
                     break;
                 }
 
                 case APIInterceptor::APIFUNCTION_GL_GLSCALEF:
                 {
-                    reinterpret_cast<PFNGLSCALEFPROC>(OpenGL::g_cached_gl_scale_f)(api_command_ptr->api_arg_vec.at(0).get_fp32(),
-                                                                                   api_command_ptr->api_arg_vec.at(1).get_fp32(),
-                                                                                   api_command_ptr->api_arg_vec.at(2).get_fp32() );
+                    const CommandView<APIInterceptor::APIFUNCTION_GL_GLSCALEF> command(api_command_ptr);
+
+                    reinterpret_cast<PFNGLSCALEFPROC>(OpenGL::g_cached_gl_scale_f)(command.get<0>(),
+                                                                                   command.get<1>(),
+                                                                                   command.get<2>() );
 
                     break;
                 }
 
                 case APIInterceptor::APIFUNCTION_GL_GLSHADEMODEL:
                 {
-                    reinterpret_cast<PFNGLSHADEMODELPROC>(OpenGL::g_cached_gl_shade_model)(api_command_ptr->api_arg_vec.at(0).get_u32() );
+                    const CommandView<APIInterceptor::APIFUNCTION_GL_GLSHADEMODEL> command(api_command_ptr);
+
+                    reinterpret_cast<PFNGLSHADEMODELPROC>(OpenGL::g_cached_gl_shade_model)(command.get<0>() );
 
                     break;
                 }
 
                 case APIInterceptor::APIFUNCTION_GL_GLTEXCOORD2F:
                 {
-                    reinterpret_cast<PFNGLTEXCOORD2FPROC>(OpenGL::g_cached_gl_tex_coord_2f)(api_command_ptr->api_arg_vec.at(0).get_fp32(),
-                                                                                            api_command_ptr->api_arg_vec.at(1).get_fp32() );
+                    const CommandView<APIInterceptor::APIFUNCTION_GL_GLTEXCOORD2F> command(api_command_ptr);
+
+                    reinterpret_cast<PFNGLTEXCOORD2FPROC>(OpenGL::g_cached_gl_tex_coord_2f)(command.get<0>(),
+                                                                                            command.get<1>() );
 
                     break;
                 }
 
                 case APIInterceptor::APIFUNCTION_GL_GLTEXENVF:
                 {
-                    auto arg_param = api_command_ptr->api_arg_vec.at(2).get_fp32();
+                    const CommandView<APIInterceptor::APIFUNCTION_GL_GLTEXENVF> command(api_command_ptr);
+
+                    auto arg_param = command.get<2>();
 
-                    reinterpret_cast<PFNGLTEXENVFPROC>(OpenGL::g_cached_gl_tex_env_f)(api_command_ptr->api_arg_vec.at(0).get_u32 (),
-                                                                                      api_command_ptr->api_arg_vec.at(1).get_u32 (),
+                    reinterpret_cast<PFNGLTEXENVFPROC>(OpenGL::g_cached_gl_tex_env_f)(command.get<0>(),
+                                                                                      command.get<1>(),
                                                                                       arg_param);
 
                     break;
@@ -868,33 +792,75 @@ void ReplayerSnapshotPlayer::play_snapshot()
 
                 case APIInterceptor::APIFUNCTION_GL_GLTEXIMAGE2D:
                 {
-                    reinterpret_cast<PFNGLTEXIMAGE2DPROC>(OpenGL::g_cached_gl_tex_image_2D)(api_command_ptr->api_arg_vec.at(0).get_u32(),
-                                                                                            api_command_ptr->api_arg_vec.at(1).get_i32(),
-                                                                                            api_command_ptr->api_arg_vec.at(2).get_i32(),
-                                                                                            api_command_ptr->api_arg_vec.at(3).get_i32(),
-                                                                                            api_command_ptr->api_arg_vec.at(4).get_i32(),
-                                                                                            api_command_ptr->api_arg_vec.at(5).get_i32(),
-                                                                                            api_command_ptr->api_arg_vec.at(6).get_u32(),
-                                                                                            api_command_ptr->api_arg_vec.at(7).get_u32(),
-                                                                                            api_command_ptr->api_arg_vec.at(8).get_ptr() );
+                    const CommandView<APIInterceptor::APIFUNCTION_GL_GLTEXIMAGE2D> command(api_command_ptr);
+
+                    /* NOTE: The recorded pixels pointer refers to the application's memory, which may have been reused
+                     *       since. Use the snapshot's copy of the data instead. */
+                    const void* pixels_ptr = (api_command_ptr.texture_upload_data_ptr != nullptr) ? api_command_ptr.texture_upload_data_ptr->get_data_u8_vec_ptr()->data()
+                                                                                                  : command.get<8>();
+
+                    reinterpret_cast<PFNGLTEXIMAGE2DPROC>(OpenGL::g_cached_gl_tex_image_2D)(command.get<0>(),
+                                                                                            command.get<1>(),
+                                                                                            command.get<2>(),
+                                                                                            command.get<3>(),
+                                                                                            command.get<4>(),
+                                                                                            command.get<5>(),
+                                                                                            command.get<6>(),
+                                                                                            command.get<7>(),
+                                                                                            pixels_ptr);
+
+                    break;
+                }
+
+                case APIInterceptor::APIFUNCTION_GL_GLTEXSUBIMAGE2D:
+                {
+                    const CommandView<APIInterceptor::APIFUNCTION_GL_GLTEXSUBIMAGE2D> command(api_command_ptr);
+
+                    assert(api_command_ptr.texture_upload_data_ptr != nullptr);
+
+                    /* The snapshot holds the whole mip, so point the driver at the sub-rectangle within it. Only the
+                     * sub-rectangle gets uploaded. */
+                    reinterpret_cast<PFNGLPIXELSTOREIPROC>(OpenGL::g_cached_gl_pixel_storei)(GL_UNPACK_ALIGNMENT,   1);
+                    reinterpret_cast<PFNGLPIXELSTOREIPROC>(OpenGL::g_cached_gl_pixel_storei)(GL_UNPACK_ROW_LENGTH,  api_command_ptr.texture_upload_n_row_pixels);
+                    reinterpret_cast<PFNGLPIXELSTOREIPROC>(OpenGL::g_cached_gl_pixel_storei)(GL_UNPACK_SKIP_PIXELS, command.get<2>() );
+                    reinterpret_cast<PFNGLPIXELSTOREIPROC>(OpenGL::g_cached_gl_pixel_storei)(GL_UNPACK_SKIP_ROWS,   command.get<3>() );
+
+                    reinterpret_cast<PFNGLTEXSUBIMAGE2DPROC>(OpenGL::g_cached_gl_tex_sub_image_2D)(command.get<0>(),
+                                                                                                   command.get<1>(),
+                                                                                                   command.get<2>(),
+                                                                                                   command.get<3>(),
+                                                                                                   command.get<4>(),
+                                                                                                   command.get<5>(),
+                                                                                                   command.get<6>(),
+                                                                                                   command.get<7>(),
+                                                                                                   api_command_ptr.texture_upload_data_ptr->get_data_u8_vec_ptr()->data() );
+
+                    reinterpret_cast<PFNGLPIXELSTOREIPROC>(OpenGL::g_cached_gl_pixel_storei)(GL_UNPACK_ALIGNMENT,   4);
+                    reinterpret_cast<PFNGLPIXELSTOREIPROC>(OpenGL::g_cached_gl_pixel_storei)(GL_UNPACK_ROW_LENGTH,  0);
+                    reinterpret_cast<PFNGLPIXELSTOREIPROC>(OpenGL::g_cached_gl_pixel_storei)(GL_UNPACK_SKIP_PIXELS, 0);
+                    reinterpret_cast<PFNGLPIXELSTOREIPROC>(OpenGL::g_cached_gl_pixel_storei)(GL_UNPACK_SKIP_ROWS,   0);
 
                     break;
                 }
 
                 case APIInterceptor::APIFUNCTION_GL_GLTEXPARAMETERF:
                 {
-                    reinterpret_cast<PFNGLTEXPARAMETERFPROC>(OpenGL::g_cached_gl_tex_parameterf)(api_command_ptr->api_arg_vec.at(0).get_u32 (),
-                                                                                                 api_command_ptr->api_arg_vec.at(1).get_u32 (),
-                                                                                                 api_command_ptr->api_arg_vec.at(2).get_fp32() );
+                    const CommandView<APIInterceptor::APIFUNCTION_GL_GLTEXPARAMETERF> command(api_command_ptr);
+
+                    reinterpret_cast<PFNGLTEXPARAMETERFPROC>(OpenGL::g_cached_gl_tex_parameterf)(command.get<0>(),
+                                                                                                 command.get<1>(),
+                                                                                                 command.get<2>() );
 
                     break;
                 }
 
                 case APIInterceptor::APIFUNCTION_GL_GLTRANSLATEF:
                 {
-                    reinterpret_cast<PFNGLTRANSLATEFPROC>(OpenGL::g_cached_gl_translate_f)(api_command_ptr->api_arg_vec.at(0).get_fp32(),
-                                                                                           api_command_ptr->api_arg_vec.at(1).get_fp32(),
-                                                                                           api_command_ptr->api_arg_vec.at(2).get_fp32() );
+                    const CommandView<APIInterceptor::APIFUNCTION_GL_GLTRANSLATEF> command(api_command_ptr);
+
+                    reinterpret_cast<PFNGLTRANSLATEFPROC>(OpenGL::g_cached_gl_translate_f)(command.get<0>(),
+                                                                                           command.get<1>(),
+                                                                                           command.get<2>() );
 
 
                     break;
@@ -902,37 +868,45 @@ void ReplayerSnapshotPlayer::play_snapshot()
 
                 case APIInterceptor::APIFUNCTION_GL_GLVERTEX2F:
                 {
-                    reinterpret_cast<PFNGLVERTEX2FPROC>(OpenGL::g_cached_gl_vertex_2f)(api_command_ptr->api_arg_vec.at(0).get_fp32(),
-                                                                                       api_command_ptr->api_arg_vec.at(1).get_fp32() );
+                    const CommandView<APIInterceptor::APIFUNCTION_GL_GLVERTEX2F> command(api_command_ptr);
+
+                    reinterpret_cast<PFNGLVERTEX2FPROC>(OpenGL::g_cached_gl_vertex_2f)(command.get<0>(),
+                                                                                       command.get<1>() );
 
                     break;
                 }
 
                 case APIInterceptor::APIFUNCTION_GL_GLVERTEX3F:
                 {
-                    reinterpret_cast<PFNGLVERTEX3FPROC>(OpenGL::g_cached_gl_vertex_3f)(api_command_ptr->api_arg_vec.at(0).get_fp32(),
-                                                                                       api_command_ptr->api_arg_vec.at(1).get_fp32(),
-                                                                                       api_command_ptr->api_arg_vec.at(2).get_fp32() );
+                    const CommandView<APIInterceptor::APIFUNCTION_GL_GLVERTEX3F> command(api_command_ptr);
+
+                    reinterpret_cast<PFNGLVERTEX3FPROC>(OpenGL::g_cached_gl_vertex_3f)(command.get<0>(),
+                                                                                       command.get<1>(),
+                                                                                       command.get<2>() );
 
                     break;
                 }
 
                 case APIInterceptor::APIFUNCTION_GL_GLVERTEX4F:
                 {
-                    reinterpret_cast<PFNGLVERTEX4FPROC>(OpenGL::g_cached_gl_vertex_4f)(api_command_ptr->api_arg_vec.at(0).get_fp32(),
-                                                                                       api_command_ptr->api_arg_vec.at(1).get_fp32(),
-                                                                                       api_command_ptr->api_arg_vec.at(2).get_fp32(),
-                                                                                       api_command_ptr->api_arg_vec.at(3).get_fp32() );
+                    const CommandView<APIInterceptor::APIFUNCTION_GL_GLVERTEX4F> command(api_command_ptr);
+
+                    reinterpret_cast<PFNGLVERTEX4FPROC>(OpenGL::g_cached_gl_vertex_4f)(command.get<0>(),
+                                                                                       command.get<1>(),
+                                                                                       command.get<2>(),
+                                                                                       command.get<3>() );
 
                     break;
                 }
 
                 case APIInterceptor::APIFUNCTION_GL_GLVIEWPORT:
                 {
-                    reinterpret_cast<PFNGLVIEWPORTPROC>(OpenGL::g_cached_gl_viewport)(api_command_ptr->api_arg_vec.at(0).get_i32(),
-                                                                                      api_command_ptr->api_arg_vec.at(1).get_i32(),
-                                                                                      api_command_ptr->api_arg_vec.at(2).get_i32(),
-                                                                                      api_command_ptr->api_arg_vec.at(3).get_i32() );
+                    const CommandView<APIInterceptor::APIFUNCTION_GL_GLVIEWPORT> command(api_command_ptr);
+
+                    reinterpret_cast<PFNGLVIEWPORTPROC>(OpenGL::g_cached_gl_viewport)(command.get<0>(),
+                                                                                      command.get<1>(),
+                                                                                      command.get<2>(),
+                                                                                      command.get<3>() );
 
                     break;
                 }
@@ -5,525 +5,2170 @@
 #include "Common/callbacks.h"
 #include "Common/logger.h"
 #include "OpenGL/globals.h"
+#include <algorithm>
 #include <cassert>
+#include <cmath>
 #include <functional>
+#include <intrin.h>
 #include "replayer_snapshotter.h"
 #include "replayer.h"
 
+#ifdef max
+    #undef max
+#endif
+#ifdef min
+    #undef min
+#endif
+
+
+const char* ReplayerSnapshotter::FRAME_COUNTERS_FILENAME = "q1_frame_counters.csv";
+
 
 ReplayerSnapshotter::ReplayerSnapshotter(const Replayer* in_replayer_ptr)
-    :m_is_glbegin_active (false),
-     m_replayer_ptr      (in_replayer_ptr),
-     m_snapshot_requested(false)
+    :m_replayer_ptr                           (in_replayer_ptr),
+     m_published_snapshot_ptr                 (nullptr),
+     m_last_capture_stall_ns                  (0),
+     m_max_capture_stall_ns                   (0),
+     m_n_captures                             (0),
+     m_is_glbegin_active                      (false),
+     m_is_recording                           (false),
+     m_snapshot_requested                     (false),
+     m_n_requested_frames_ago                 (0),
+     m_n_snapshot_frames_ago_requested        (NO_SNAPSHOT_REQUESTED),
+     m_n_burst_frames_left                    (0),
+     m_n_burst_frames_requested               (0),
+     m_n_next_burst_frame                     (0),
+     m_is_texture_props_map_dirty             (true),
+     m_n_last_mip_data_version                (0),
+     m_max_n_flight_recorder_bytes            (0),
+     m_n_max_flight_recorder_frames_requested (0),
+     m_n_flight_recorder_bytes                (0),
+     m_n_flight_recorder_frames               (0),
+     m_n_first_flight_recorder_frame          (0),
+     m_is_cpu_timing_active                   (false),
+     m_is_cpu_timing_enabled                  (false),
+     m_is_vertex_batching_enabled             (true),
+     m_last_callback_exit_tsc                 (0),
+     m_n_max_api_args_per_frame               (N_PREALLOCATED_API_ARGS),
+     m_n_max_api_commands_per_frame           (N_PREALLOCATED_API_COMMANDS),
+     m_n_max_vertices_per_frame               (N_PREALLOCATED_VERTICES),
+     m_n_api_calls_last_frame                 (0),
+     m_n_api_calls_this_frame                 (0),
+     m_n_frame                                (0),
+     m_previous_api_func                      (APIInterceptor::APIFUNCTION_GL_FIRST),
+     m_capture_journal_config_dirty           (false),
+     m_capture_journal_n_max_bytes_requested  (0),
+     m_has_capture_journal_failed             (false),
+     m_capture_profile                        (CaptureProfile::UNKNOWN),
+     m_capture_profile_requested              (CaptureProfile::FULL),
+     m_gl_error_validation_mode               (GLErrorValidationMode::PER_FRAME),
+     m_gl_error_validation_mode_requested     (GLErrorValidationMode::PER_FRAME),
+     m_gl_error_validation_requested          (false),
+     m_has_gl_error_report                    (false),
+     m_n_calls_per_gl_error_segment           (0),
+     m_n_calls_per_gl_error_segment_requested (0),
+     m_n_first_unchecked_call                 (0),
+     m_n_next_gl_error_check_call             (UINT32_MAX),
+     m_is_bisecting_gl_error                  (false),
+     m_gl_error_bisect_stage                  (GLErrorBisectStage::NONE),
+     m_gl_error_bisect_mid_failed             (false),
+     m_n_gl_error_bisect_attempts_left        (0),
+     m_n_gl_error_bisect_first_call           (0),
+     m_n_gl_error_bisect_last_call            (0),
+     m_n_gl_error_bisect_mid_call             (0),
+     m_n_gl_error_bisect_split_call           (0),
+     m_auto_capture_config_dirty              (false),
+     m_last_auto_capture_qpc                  (0),
+     m_is_front_buffer_used_this_frame        (false),
+     m_is_level_loading                       (false),
+     m_frame_counters                         (),
+     m_current_primitive_type                 (0),
+     m_n_vertex_calls_at_glbegin              (0),
+     m_callback_time_ns_last_idle_frame       (0),
+     m_callback_time_ns_last_recording_frame  (0),
+     m_last_frame_qpc                         (0),
+     m_last_frame_time_us                     (0),
+     m_qpc_frequency                          (0),
+     m_last_frame_tsc                         (0),
+     m_n_sampled_callback_tsc_ticks_this_frame(0),
+     m_n_tsc_ticks_per_second                 (0.0),
+     m_n_tsc_ticks_per_timestamp              (0.0)
 {
     /* Stub */
 }
 
 ReplayerSnapshotter::~ReplayerSnapshotter()
 {
-    /* Stub */
+    /* The writer returns snapshots to the pool, so it needs to go away first. The ingester's worker thread uses the
+     * texture store. */
+    m_burst_capture_writer_ptr.reset  ();
+    m_frame_counter_exporter_ptr.reset();
+    m_texture_ingester_ptr.reset      ();
+
+    delete m_published_snapshot_ptr.exchange(nullptr);
 }
 
-void ReplayerSnapshotter::cache_snapshot()
+constexpr ReplayerSnapshotter::APIFuncHandlerTable ReplayerSnapshotter::create_api_func_handler_table()
 {
-    m_snapshot_requested = true;
+    APIFuncHandlerTable result = {};
+
+    /* Most entrypoints only need to be recorded.. */
+    for (uint32_t n_entry = 0;
+                  n_entry < GLFunctionInfoTable::N_ENTRIES;
+                ++n_entry)
+    {
+        result.handler_func_ptr_vec[n_entry] = &ReplayerSnapshotter::handle_record_only;
+    }
+
+    /* ..but some of them also update the state we track, or need to be converted before they can be recorded. */
+    result.handler_func_ptr_vec[APIInterceptor::APIFUNCTION_GL_GLALPHAFUNC      - APIInterceptor::APIFUNCTION_GL_FIRST] = &ReplayerSnapshotter::handle_alpha_func;
+    result.handler_func_ptr_vec[APIInterceptor::APIFUNCTION_GL_GLBEGIN          - APIInterceptor::APIFUNCTION_GL_FIRST] = &ReplayerSnapshotter::handle_begin;
+    result.handler_func_ptr_vec[APIInterceptor::APIFUNCTION_GL_GLBINDTEXTURE    - APIInterceptor::APIFUNCTION_GL_FIRST] = &ReplayerSnapshotter::handle_bind_texture;
+    result.handler_func_ptr_vec[APIInterceptor::APIFUNCTION_GL_GLBLENDFUNC      - APIInterceptor::APIFUNCTION_GL_FIRST] = &ReplayerSnapshotter::handle_blend_func;
+    result.handler_func_ptr_vec[APIInterceptor::APIFUNCTION_GL_GLCLEARCOLOR     - APIInterceptor::APIFUNCTION_GL_FIRST] = &ReplayerSnapshotter::handle_clear_color;
+    result.handler_func_ptr_vec[APIInterceptor::APIFUNCTION_GL_GLCLEARDEPTH     - APIInterceptor::APIFUNCTION_GL_FIRST] = &ReplayerSnapshotter::handle_clear_depth;
+    result.handler_func_ptr_vec[APIInterceptor::APIFUNCTION_GL_GLCOLOR3UBV      - APIInterceptor::APIFUNCTION_GL_FIRST] = &ReplayerSnapshotter::handle_color_3ubv;
+    result.handler_func_ptr_vec[APIInterceptor::APIFUNCTION_GL_GLCOLOR4FV       - APIInterceptor::APIFUNCTION_GL_FIRST] = &ReplayerSnapshotter::handle_color_4fv;
+    result.handler_func_ptr_vec[APIInterceptor::APIFUNCTION_GL_GLCULLFACE       - APIInterceptor::APIFUNCTION_GL_FIRST] = &ReplayerSnapshotter::handle_cull_face;
+    result.handler_func_ptr_vec[APIInterceptor::APIFUNCTION_GL_GLDELETETEXTURES - APIInterceptor::APIFUNCTION_GL_FIRST] = &ReplayerSnapshotter::handle_delete_textures;
+    result.handler_func_ptr_vec[APIInterceptor::APIFUNCTION_GL_GLDEPTHFUNC      - APIInterceptor::APIFUNCTION_GL_FIRST] = &ReplayerSnapshotter::handle_depth_func;
+    result.handler_func_ptr_vec[APIInterceptor::APIFUNCTION_GL_GLDEPTHMASK      - APIInterceptor::APIFUNCTION_GL_FIRST] = &ReplayerSnapshotter::handle_depth_mask;
+    result.handler_func_ptr_vec[APIInterceptor::APIFUNCTION_GL_GLDEPTHRANGE     - APIInterceptor::APIFUNCTION_GL_FIRST] = &ReplayerSnapshotter::handle_depth_range;
+    result.handler_func_ptr_vec[APIInterceptor::APIFUNCTION_GL_GLDISABLE        - APIInterceptor::APIFUNCTION_GL_FIRST] = &ReplayerSnapshotter::handle_enable_disable;
+    result.handler_func_ptr_vec[APIInterceptor::APIFUNCTION_GL_GLDRAWBUFFER     - APIInterceptor::APIFUNCTION_GL_FIRST] = &ReplayerSnapshotter::handle_draw_buffer;
+    result.handler_func_ptr_vec[APIInterceptor::APIFUNCTION_GL_GLENABLE         - APIInterceptor::APIFUNCTION_GL_FIRST] = &ReplayerSnapshotter::handle_enable_disable;
+    result.handler_func_ptr_vec[APIInterceptor::APIFUNCTION_GL_GLEND            - APIInterceptor::APIFUNCTION_GL_FIRST] = &ReplayerSnapshotter::handle_end;
+    result.handler_func_ptr_vec[APIInterceptor::APIFUNCTION_GL_GLFRONTFACE      - APIInterceptor::APIFUNCTION_GL_FIRST] = &ReplayerSnapshotter::handle_front_face;
+    result.handler_func_ptr_vec[APIInterceptor::APIFUNCTION_GL_GLFRUSTUM        - APIInterceptor::APIFUNCTION_GL_FIRST] = &ReplayerSnapshotter::handle_matrix_op;
+    result.handler_func_ptr_vec[APIInterceptor::APIFUNCTION_GL_GLLOADIDENTITY   - APIInterceptor::APIFUNCTION_GL_FIRST] = &ReplayerSnapshotter::handle_matrix_op;
+    result.handler_func_ptr_vec[APIInterceptor::APIFUNCTION_GL_GLMATRIXMODE     - APIInterceptor::APIFUNCTION_GL_FIRST] = &ReplayerSnapshotter::handle_matrix_mode;
+    result.handler_func_ptr_vec[APIInterceptor::APIFUNCTION_GL_GLORTHO          - APIInterceptor::APIFUNCTION_GL_FIRST] = &ReplayerSnapshotter::handle_matrix_op;
+    result.handler_func_ptr_vec[APIInterceptor::APIFUNCTION_GL_GLPOPMATRIX      - APIInterceptor::APIFUNCTION_GL_FIRST] = &ReplayerSnapshotter::handle_matrix_op;
+    result.handler_func_ptr_vec[APIInterceptor::APIFUNCTION_GL_GLPUSHMATRIX     - APIInterceptor::APIFUNCTION_GL_FIRST] = &ReplayerSnapshotter::handle_matrix_op;
+    result.handler_func_ptr_vec[APIInterceptor::APIFUNCTION_GL_GLROTATEF        - APIInterceptor::APIFUNCTION_GL_FIRST] = &ReplayerSnapshotter::handle_matrix_op;
+    result.handler_func_ptr_vec[APIInterceptor::APIFUNCTION_GL_GLSCALEF         - APIInterceptor::APIFUNCTION_GL_FIRST] = &ReplayerSnapshotter::handle_matrix_op;
+    result.handler_func_ptr_vec[APIInterceptor::APIFUNCTION_GL_GLSHADEMODEL     - APIInterceptor::APIFUNCTION_GL_FIRST] = &ReplayerSnapshotter::handle_shade_model;
+    result.handler_func_ptr_vec[APIInterceptor::APIFUNCTION_GL_GLTEXENVF        - APIInterceptor::APIFUNCTION_GL_FIRST] = &ReplayerSnapshotter::handle_tex_env_f;
+    result.handler_func_ptr_vec[APIInterceptor::APIFUNCTION_GL_GLTEXIMAGE2D     - APIInterceptor::APIFUNCTION_GL_FIRST] = &ReplayerSnapshotter::handle_tex_image_2d;
+    result.handler_func_ptr_vec[APIInterceptor::APIFUNCTION_GL_GLTEXPARAMETERF  - APIInterceptor::APIFUNCTION_GL_FIRST] = &ReplayerSnapshotter::handle_tex_parameter_f;
+    result.handler_func_ptr_vec[APIInterceptor::APIFUNCTION_GL_GLTEXSUBIMAGE2D  - APIInterceptor::APIFUNCTION_GL_FIRST] = &ReplayerSnapshotter::handle_tex_sub_image_2d;
+    result.handler_func_ptr_vec[APIInterceptor::APIFUNCTION_GL_GLTRANSLATEF     - APIInterceptor::APIFUNCTION_GL_FIRST] = &ReplayerSnapshotter::handle_matrix_op;
+    result.handler_func_ptr_vec[APIInterceptor::APIFUNCTION_GL_GLVERTEX3FV      - APIInterceptor::APIFUNCTION_GL_FIRST] = &ReplayerSnapshotter::handle_vertex_3fv;
+    result.handler_func_ptr_vec[APIInterceptor::APIFUNCTION_GL_GLVIEWPORT       - APIInterceptor::APIFUNCTION_GL_FIRST] = &ReplayerSnapshotter::handle_viewport;
+
+    return result;
 }
 
-ReplayerSnapshotterUniquePtr ReplayerSnapshotter::create(const Replayer* in_replayer_ptr)
+const ReplayerSnapshotter::APIFuncHandlerTable ReplayerSnapshotter::m_api_func_handler_table = ReplayerSnapshotter::create_api_func_handler_table();
+
+ReplayerSnapshotUniquePtr ReplayerSnapshotter::acquire_snapshot()
 {
-    ReplayerSnapshotterUniquePtr result_ptr(new ReplayerSnapshotter(in_replayer_ptr) );
+    ReplayerSnapshotUniquePtr result_ptr;
 
-    if (result_ptr != nullptr)
     {
-        if (!result_ptr->init() )
+        std::lock_guard<std::mutex> lock(m_snapshot_pool_mutex);
+
+        if (m_snapshot_pool_vec.size() > 0)
         {
-            result_ptr.reset();
+            result_ptr = std::move(m_snapshot_pool_vec.back() );
+
+            m_snapshot_pool_vec.pop_back();
         }
     }
 
+    if (result_ptr == nullptr)
+    {
+        result_ptr = ReplayerSnapshot::create(m_n_max_api_commands_per_frame,
+                                              m_n_max_api_args_per_frame,
+                                              m_n_max_vertices_per_frame);
+    }
+    else
+    {
+        /* Make sure the buffer can hold the largest frame seen so far without growing while recording. */
+        result_ptr->reserve(m_n_max_api_commands_per_frame,
+                            m_n_max_api_args_per_frame,
+                            m_n_max_vertices_per_frame);
+    }
+
+    assert(result_ptr != nullptr);
+
+    result_ptr->set_vertex_batching_enabled(m_is_vertex_batching_enabled.load(std::memory_order_acquire) );
+
     return result_ptr;
 }
 
-bool ReplayerSnapshotter::init()
+void ReplayerSnapshotter::apply_burst_capture_request()
 {
-    /* Initialize object instances. */
-    const auto q1_window_extents = m_replayer_ptr->get_q1_window_extents();
-
-    m_current_context_state_ptr.reset     (new GLContextState       (q1_window_extents.at(0),
-                                                                     q1_window_extents.at(1) ) );
-    m_gl_id_to_texture_props_map_ptr.reset(new GLIDToTexturePropsMap() );
+    std::lock_guard<std::mutex> lock(m_mutex);
 
-    /* Initialize callback handlers for all GL entrypoints used by Q1. */
-    for (uint32_t current_api_func =  static_cast<uint32_t>(APIInterceptor::APIFUNCTION_GL_FIRST);
-                  current_api_func <= static_cast<uint32_t>(APIInterceptor::APIFUNCTION_GL_LAST);
-                ++current_api_func)
+    if (m_n_burst_frames_requested > 0)
     {
-        APIInterceptor::register_for_callback(static_cast<APIInterceptor::APIFunction>(current_api_func),
-                                              ReplayerSnapshotter::on_api_func_callback,
-                                              this);
+        /* NOTE: request_burst_capture() only accepts new requests once the previous writer is done, so this does not
+         *       block on I/O. */
+        m_burst_capture_writer_ptr = ReplayerCaptureWriter::create(m_burst_capture_filename_requested,
+                                                                   m_n_burst_frames_requested,
+                                                                   static_cast<uint32_t>(MAX_N_QUEUED_BURST_FRAMES), // not odr-used
+                                                                   this);
+
+        AI_ASSERT(m_burst_capture_writer_ptr != nullptr);
+
+        m_n_burst_frames_left      = m_n_burst_frames_requested;
+        m_n_burst_frames_requested = 0;
+        m_n_next_burst_frame       = 0;
     }
-
-    /* We also need to know when we're done with a snapshot. */
-    APIInterceptor::register_for_callback(APIInterceptor::APIFUNCTION_GDI32_SWAPBUFFERS,
-                                          ReplayerSnapshotter::on_api_func_callback,
-                                          this);
-
-    return true;
 }
 
-void ReplayerSnapshotter::on_api_func_callback(APIInterceptor::APIFunction                in_api_func,
-                                               uint32_t                                   in_n_args,
-                                               const APIInterceptor::APIFunctionArgument* in_args_ptr,
-                                               void*                                      in_user_arg_ptr)
+void ReplayerSnapshotter::apply_capture_journal_config()
 {
-    auto this_ptr(reinterpret_cast<ReplayerSnapshotter*>(in_user_arg_ptr) );
+    if (!m_capture_journal_config_dirty.exchange(false) )
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    /* NOTE: The old journal needs to go away first, in case the same file is requested again. Creating a journal maps
+     *       the whole file up front, so this is a one-off cost. */
+    m_capture_journal_ptr.reset();
 
-    if (this_ptr->m_start_gl_context_state_ptr == nullptr)
+    if (!m_capture_journal_filename_requested.empty() )
     {
-        this_ptr->m_start_gl_context_state_ptr.reset(new GLContextState(*this_ptr->m_current_context_state_ptr) );
+        m_capture_journal_ptr = ReplayerCaptureJournal::create(m_capture_journal_filename_requested,
+                                                               m_capture_journal_n_max_bytes_requested);
 
-        assert(this_ptr->m_start_gl_context_state_ptr != nullptr);
+        /* The file may be in use, or there may not be enough disk or address space to map it. Leave journaling
+         * disabled and let the UI know. */
+        if (m_capture_journal_ptr == nullptr)
+        {
+            m_capture_journal_filename_requested.clear();
 
-        /* Query & store matrix state */
-        reinterpret_cast<PFNGLGETDOUBLEVPROC>(OpenGL::g_cached_gl_get_doublev)(GL_MODELVIEW_MATRIX,
-                                                                               this_ptr->m_start_gl_context_state_ptr->modelview_matrix);
-        reinterpret_cast<PFNGLGETDOUBLEVPROC>(OpenGL::g_cached_gl_get_doublev)(GL_PROJECTION_MATRIX,
-                                                                               this_ptr->m_start_gl_context_state_ptr->projection_matrix);
+            m_has_capture_journal_failed = true;
+        }
     }
+}
 
-    if (this_ptr->m_recording_snapshot_ptr == nullptr)
-    {
-        this_ptr->m_recording_snapshot_ptr = ReplayerSnapshot::create();
+void ReplayerSnapshotter::apply_capture_profile()
+{
+    const CaptureProfile profile = m_capture_profile_requested;
 
-        assert(this_ptr->m_recording_snapshot_ptr != nullptr);
+    if (profile == m_capture_profile)
+    {
+        return;
     }
 
-    if (in_api_func != APIInterceptor::APIFUNCTION_GDI32_SWAPBUFFERS)
+    for (uint32_t n_entry = 0;
+                  n_entry < GLFunctionInfoTable::N_ENTRIES;
+                ++n_entry)
     {
-        // NOTE: Drop any calls that update front buffer.
-        //
-        // One case where this happens is on the loading screen, where the front buffer has an extra pentagram drawn
-        // in the top-right corner. No need to capture this.
-        bool should_record_api_call = (this_ptr->m_current_context_state_ptr->draw_buffer_mode == GL_BACK);
+        const auto api_func       = static_cast<APIInterceptor::APIFunction>(APIInterceptor::APIFUNCTION_GL_FIRST + n_entry);
+        const auto function_class = g_gl_function_info_table.info_vec[n_entry].function_class;
+        bool       is_recorded    = false;
 
-        /* IF this is a GL call which disables/enables a GL capability, cache this information */
-        if ( (in_api_func == APIInterceptor::APIFUNCTION_GL_GLDISABLE) || 
-             (in_api_func == APIInterceptor::APIFUNCTION_GL_GLENABLE)   )
+        switch (profile)
         {
-            const bool should_enable = (in_api_func == APIInterceptor::APIFUNCTION_GL_GLENABLE);
+            case CaptureProfile::FULL:
+            {
+                is_recorded = true;
+
+                break;
+            }
 
-            switch (in_args_ptr[0].get_u32() )
+            case CaptureProfile::DRAWS_WITHOUT_VERTICES:
             {
-                case GL_ALPHA_TEST:   this_ptr->m_current_context_state_ptr->alpha_test_enabled   = should_enable; break;
-                case GL_BLEND:        this_ptr->m_current_context_state_ptr->blend_enabled        = should_enable; break;
-                case GL_CULL_FACE:    this_ptr->m_current_context_state_ptr->cull_face_enabled    = should_enable; break;
-                case GL_DEPTH_TEST:   this_ptr->m_current_context_state_ptr->depth_test_enabled   = should_enable; break;
-                case GL_SCISSOR_TEST: this_ptr->m_current_context_state_ptr->scissor_test_enabled = should_enable; break;
-                case GL_TEXTURE_2D:   this_ptr->m_current_context_state_ptr->texture_2d_enabled   = should_enable; break;
-
-                default:
-                {
-                    assert(false);
-                }
+                /* Keep glBegin() & glEnd(), so that draw boundaries can still be told apart. */
+                is_recorded = (function_class != GLFunctionClass::DRAW                 ||
+                               api_func       == APIInterceptor::APIFUNCTION_GL_GLBEGIN ||
+                               api_func       == APIInterceptor::APIFUNCTION_GL_GLEND);
+
+                break;
             }
-        }
-        else
-        /* If this is a GL call which updates global state we care about, cache it too */
-        if (in_api_func == APIInterceptor::APIFUNCTION_GL_GLALPHAFUNC)
-        {
-            const auto func = in_args_ptr[0].get_u32 ();
-            const auto ref  = in_args_ptr[1].get_fp32();
 
-            this_ptr->m_current_context_state_ptr->alpha_func_func = func;
-            this_ptr->m_current_context_state_ptr->alpha_func_ref  = ref;
-        }
-        else
-        if (in_api_func == APIInterceptor::APIFUNCTION_GL_GLBLENDFUNC)
-        {
-            const auto sfactor = in_args_ptr[0].get_u32();
-            const auto dfactor = in_args_ptr[1].get_u32();
+            case CaptureProfile::STATE_ONLY:
+            {
+                /* glBindTexture() is classified as a texture func, but which texture is bound is state, too. */
+                is_recorded = (function_class == GLFunctionClass::MATRIX                      ||
+                               function_class == GLFunctionClass::STATE_SETTER                ||
+                               api_func       == APIInterceptor::APIFUNCTION_GL_GLBINDTEXTURE);
 
-            this_ptr->m_current_context_state_ptr->blend_func_sfactor = sfactor;
-            this_ptr->m_current_context_state_ptr->blend_func_dfactor = dfactor;
-        }
-        else
-        if (in_api_func == APIInterceptor::APIFUNCTION_GL_GLCLEARCOLOR)
-        {
-            const auto red   = in_args_ptr[0].get_fp32();
-            const auto green = in_args_ptr[1].get_fp32();
-            const auto blue  = in_args_ptr[2].get_fp32();
-            const auto alpha = in_args_ptr[3].get_fp32();
+                break;
+            }
 
-            this_ptr->m_current_context_state_ptr->clear_color[0] = red;
-            this_ptr->m_current_context_state_ptr->clear_color[1] = green;
-            this_ptr->m_current_context_state_ptr->clear_color[2] = blue;
-            this_ptr->m_current_context_state_ptr->clear_color[3] = alpha;
-        }
-        else
-        if (in_api_func == APIInterceptor::APIFUNCTION_GL_GLCLEARDEPTH)
-        {
-            const auto depth = in_args_ptr[0].get_fp64();
+            case CaptureProfile::TEXTURES_ONLY:
+            {
+                is_recorded = (function_class == GLFunctionClass::TEXTURE);
 
-            this_ptr->m_current_context_state_ptr->clear_depth = depth;
-        }
-        else
-        if (in_api_func == APIInterceptor::APIFUNCTION_GL_GLCULLFACE)
-        {
-            const auto mode = in_args_ptr[0].get_u32();
+                break;
+            }
 
-            this_ptr->m_current_context_state_ptr->cull_face_mode = mode;
+            default:
+            {
+                AI_ASSERT(false);
+            }
         }
-        else
-        if (in_api_func == APIInterceptor::APIFUNCTION_GL_GLDEPTHFUNC)
-        {
-            const auto func = in_args_ptr[0].get_u32();
 
-            this_ptr->m_current_context_state_ptr->depth_func = func;
-        }
-        else
-        if (in_api_func == APIInterceptor::APIFUNCTION_GL_GLDEPTHMASK)
-        {
-            const auto flag = in_args_ptr[0].get_u32();
+        m_is_api_func_recorded_vec[n_entry] = is_recorded;
+    }
 
-            this_ptr->m_current_context_state_ptr->depth_mask = (flag != 0);
-        }
-        else
-        if (in_api_func == APIInterceptor::APIFUNCTION_GL_GLDEPTHRANGE)
-        {
-            const auto n = in_args_ptr[0].get_fp64();
-            const auto f = in_args_ptr[1].get_fp64();
+    m_capture_profile = profile;
+}
 
-            this_ptr->m_current_context_state_ptr->depth_range[0] = n;
-            this_ptr->m_current_context_state_ptr->depth_range[1] = f;
-        }
-        else
-        if (in_api_func == APIInterceptor::APIFUNCTION_GL_GLDRAWBUFFER)
-        {
-            const auto mode = in_args_ptr[0].get_u32();
+void ReplayerSnapshotter::apply_flight_recorder_config()
+{
+    const uint32_t n_max_frames = m_n_max_flight_recorder_frames_requested;
 
-            should_record_api_call                                  = (mode == GL_BACK);
-            this_ptr->m_current_context_state_ptr->draw_buffer_mode = mode;
-        }
-        else
-        if (in_api_func == APIInterceptor::APIFUNCTION_GL_GLFRONTFACE)
-        {
-            const auto mode = in_args_ptr[0].get_u32();
+    if (n_max_frames == static_cast<uint32_t>(m_flight_recorder_frame_vec.size() ) )
+    {
+        return;
+    }
 
-            this_ptr->m_current_context_state_ptr->front_face_mode = mode;
-        }
-        else
-        if (in_api_func == APIInterceptor::APIFUNCTION_GL_GLMATRIXMODE)
-        {
-            const auto mode = in_args_ptr[0].get_u32();
+    /* Drop the frames which no longer fit, oldest first, and re-pack the remaining ones at the start of the ring. */
+    while (m_n_flight_recorder_frames > n_max_frames)
+    {
+        evict_oldest_flight_recorder_frame();
+    }
 
-            this_ptr->m_current_context_state_ptr->matrix_mode = mode;
-        }
-        else
-        if (in_api_func == APIInterceptor::APIFUNCTION_GL_GLSHADEMODEL)
-        {
-            const auto mode = in_args_ptr[0].get_u32();
+    {
+        std::vector<FlightRecorderFrame> new_frame_vec(n_max_frames);
 
-            this_ptr->m_current_context_state_ptr->shade_model = mode;
-        }
-        else
-        if (in_api_func == APIInterceptor::APIFUNCTION_GL_GLTEXENVF)
+        for (uint32_t n_frame = 0;
+                      n_frame < m_n_flight_recorder_frames;
+                    ++n_frame)
         {
-            AI_ASSERT(in_n_args == 3);
+            new_frame_vec[n_frame] = std::move(m_flight_recorder_frame_vec[(m_n_first_flight_recorder_frame + n_frame) % m_flight_recorder_frame_vec.size()]);
+        }
 
-            const auto target = in_args_ptr[0].get_u32 ();
-            const auto pname  = in_args_ptr[1].get_u32 ();
-            const auto param  = in_args_ptr[2].get_fp32();
+        m_flight_recorder_frame_vec     = std::move(new_frame_vec);
+        m_n_first_flight_recorder_frame = 0;
+    }
 
-            AI_ASSERT(target == GL_TEXTURE_ENV);
-            AI_ASSERT(pname  == GL_TEXTURE_ENV_MODE);
+    if (n_max_frames == 0)
+    {
+        m_spare_gl_context_state_ptr.reset();
+    }
+}
 
-            this_ptr->m_current_context_state_ptr->texture_env_mode = static_cast<uint32_t>(param);
-        }
-        else
-        if (in_api_func == APIInterceptor::APIFUNCTION_GL_GLVIEWPORT)
-        {
-            AI_ASSERT(in_n_args == 4);
+void ReplayerSnapshotter::apply_snapshot_request()
+{
+    const uint32_t n_frames_ago = m_n_snapshot_frames_ago_requested.exchange(NO_SNAPSHOT_REQUESTED);
 
-            const auto x      = in_args_ptr[0].get_i32();
-            const auto y      = in_args_ptr[1].get_i32();
-            const auto width  = in_args_ptr[2].get_i32();
-            const auto height = in_args_ptr[3].get_i32();
+    /* User requests take precedence over automatic captures, which are only armed if no capture is on its way. */
+    if (n_frames_ago != NO_SNAPSHOT_REQUESTED)
+    {
+        m_n_requested_frames_ago = n_frames_ago;
+        m_snapshot_requested     = true;
+    }
+}
 
-            this_ptr->m_current_context_state_ptr->viewport_x1y1   [0] = x;
-            this_ptr->m_current_context_state_ptr->viewport_x1y1   [1] = y;
-            this_ptr->m_current_context_state_ptr->viewport_extents[0] = width;
-            this_ptr->m_current_context_state_ptr->viewport_extents[1] = height;
-        }
-        else
-        /* If this is a GL call which sets up a texture or updates existing texture's mip's contents,
-         * treat this as a state that potentially spans across multiple frames.
-         */
-        if (in_api_func == APIInterceptor::APIFUNCTION_GL_GLBINDTEXTURE)
+void ReplayerSnapshotter::cache_frame(ReplayerSnapshotUniquePtr                    in_snapshot_ptr,
+                                      GLContextStateUniquePtr                      in_start_gl_context_state_ptr,
+                                      std::shared_ptr<const GLIDToTexturePropsMap> in_gl_id_to_texture_props_map_ptr)
+{
+    /* NOTE: This runs on the application's rendering thread, so it must stay a constant-time handoff. Everything the
+     *       snapshot needs lives on our side already, so there is no need to wait for the GPU either. */
+    ReplayerCapturedSnapshotUniquePtr captured_snapshot_ptr(new ReplayerCapturedSnapshot() );
+
+    captured_snapshot_ptr->gl_id_to_texture_props_map_ptr = std::move(in_gl_id_to_texture_props_map_ptr);
+    captured_snapshot_ptr->snapshot_ptr                   = std::move(in_snapshot_ptr);
+    captured_snapshot_ptr->start_gl_context_state_ptr     = std::move(in_start_gl_context_state_ptr);
+
+    /* Publish the capture with a single exchange, so that we never have to wait for the consumer. A capture which has
+     * not been picked up in the meantime has been superseded, so take it back. */
+    {
+        ReplayerCapturedSnapshotUniquePtr stale_snapshot_ptr(m_published_snapshot_ptr.exchange(captured_snapshot_ptr.release() ) );
+
+        if (stale_snapshot_ptr != nullptr)
         {
-            AI_ASSERT(in_n_args == 2);
+            recycle_snapshot(std::move(stale_snapshot_ptr->snapshot_ptr) );
+        }
+    }
+
+    m_snapshot_requested = false;
 
-            const auto target     = in_args_ptr[0].get_u32();
-            const auto texture_id = in_args_ptr[1].get_u32();
+    if (m_replayer_ptr != nullptr)
+    {
+        m_replayer_ptr->on_snapshot_available();
+    }
+}
+
+void ReplayerSnapshotter::cache_snapshot(const uint32_t& in_n_frames_ago)
+{
+    /* NOTE: Everything else related to capture requests is only touched by the application's rendering thread, which
+     *       picks this one up at the next frame boundary. A request which has not been picked up yet is superseded. */
+    m_n_snapshot_frames_ago_requested = std::min(in_n_frames_ago,
+                                                 NO_SNAPSHOT_REQUESTED - 1);
+}
+
+void ReplayerSnapshotter::check_auto_capture_triggers()
+{
+    AutoCaptureTrigger trigger = AutoCaptureTrigger::UNKNOWN;
+
+    if (m_auto_capture_config_dirty.exchange(false) )
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        m_auto_capture_config = m_auto_capture_config_requested;
+    }
+
+    /* Q1 draws the disc icon straight to the front buffer while it reads from disk. The first frame which does not do
+     * that anymore is the first one of the new level. */
+    if (m_is_front_buffer_used_this_frame)
+    {
+        m_is_level_loading = true;
+    }
+    else
+    if (m_is_level_loading)
+    {
+        m_is_level_loading = false;
 
-            AI_ASSERT(target == GL_TEXTURE_2D);
+        if (m_auto_capture_config.should_trigger_on_level_load)
+        {
+            trigger = AutoCaptureTrigger::LEVEL_LOAD;
+        }
+    }
 
-            this_ptr->m_current_context_state_ptr->bound_2d_texture_gl_id = texture_id;
-            this_ptr->m_texture_target_to_bound_texture_id_map[target]    = texture_id;
+    if (trigger == AutoCaptureTrigger::UNKNOWN)
+    {
+        /* NOTE: Loading frames are slow by definition, so they are not considered for the frame time trigger. */
+        if (m_auto_capture_config.max_frame_time_ms > 0.0f                                                           &&
+            !m_is_front_buffer_used_this_frame                                                                      &&
+            static_cast<float>(m_last_frame_time_us) > m_auto_capture_config.max_frame_time_ms * 1000.0f)
+        {
+            trigger = AutoCaptureTrigger::FRAME_TIME;
+        }
+        else
+        if (m_auto_capture_config.max_n_api_calls > 0                           &&
+            m_n_api_calls_last_frame              > m_auto_capture_config.max_n_api_calls)
+        {
+            trigger = AutoCaptureTrigger::N_API_CALLS;
         }
         else
-        if (in_api_func == APIInterceptor::APIFUNCTION_GL_GLDELETETEXTURES)
+        if (m_auto_capture_config.max_n_texture_upload_bytes > 0                                          &&
+            m_frame_counters.n_texture_upload_bytes          > m_auto_capture_config.max_n_texture_upload_bytes)
         {
-            AI_ASSERT(in_n_args == 2);
+            trigger = AutoCaptureTrigger::N_TEXTURE_UPLOAD_BYTES;
+        }
+    }
+
+    /* A capture which is already on its way, or a burst in progress, takes precedence. */
+    if (trigger               != AutoCaptureTrigger::UNKNOWN &&
+        m_snapshot_requested  == false                       &&
+        m_n_burst_frames_left == 0)
+    {
+        const auto cooldown_n_qpc_ticks = static_cast<int64_t>(m_auto_capture_config.cooldown_ms) * m_qpc_frequency / 1000;
 
-            const auto n_texture_ids   = in_args_ptr[0].get_i32    ();
-            const auto texture_ids_ptr = in_args_ptr[1].get_u32_ptr();
+        if (m_last_auto_capture_qpc == 0                                        ||
+            m_last_frame_qpc        -  m_last_auto_capture_qpc >= cooldown_n_qpc_ticks)
+        {
+            /* With the flight recorder on, the frame which has just been recorded is the one we're after. */
+            m_last_auto_capture_qpc  = m_last_frame_qpc;
+            m_n_requested_frames_ago = 0;
+            m_snapshot_requested     = true;
 
-            for (uint32_t n_texture_id = 0;
-                          n_texture_id < static_cast<uint32_t>(n_texture_ids);
-                        ++n_texture_id)
             {
-                this_ptr->m_current_context_state_ptr->gl_texture_id_to_texture_state_map.erase(texture_ids_ptr[n_texture_id]);
-                this_ptr->m_gl_id_to_texture_props_map_ptr->erase                              (texture_ids_ptr[n_texture_id]);
+                std::lock_guard<std::mutex> lock(m_mutex);
+
+                m_last_auto_capture_report.frame_time_ms          = static_cast<float>(m_last_frame_time_us) / 1000.0f;
+                m_last_auto_capture_report.n_api_calls            = m_n_api_calls_last_frame;
+                m_last_auto_capture_report.n_captures++;
+                m_last_auto_capture_report.n_frame                = m_n_frame - 1;
+                m_last_auto_capture_report.n_texture_upload_bytes = m_frame_counters.n_texture_upload_bytes;
+                m_last_auto_capture_report.trigger                = trigger;
             }
-
-            should_record_api_call = false;
         }
-        else
-        if (in_api_func == APIInterceptor::APIFUNCTION_GL_GLTEXIMAGE2D)
-        {
-            uint32_t    call_arg_target         = in_args_ptr[0].get_u32();
-            int32_t     call_arg_level          = in_args_ptr[1].get_i32();
-            int32_t     call_arg_internalformat = in_args_ptr[2].get_i32();
-            int32_t     call_arg_width          = in_args_ptr[3].get_i32();
-            int32_t     call_arg_height         = in_args_ptr[4].get_i32();
-            int32_t     call_arg_border         = in_args_ptr[5].get_i32();
-            uint32_t    call_arg_format         = in_args_ptr[6].get_u32();
-            uint32_t    call_arg_type           = in_args_ptr[7].get_u32();
-            const void* call_arg_pixels_ptr     = in_args_ptr[8].get_ptr();
+    }
 
-            AI_ASSERT(in_n_args                                                                == 9);
-            AI_ASSERT(this_ptr->m_texture_target_to_bound_texture_id_map.find(call_arg_target) != this_ptr->m_texture_target_to_bound_texture_id_map.end() );
+    m_is_front_buffer_used_this_frame = false;
+}
 
-            const auto bound_texture_id     = this_ptr->m_texture_target_to_bound_texture_id_map.at(call_arg_target);
-            auto       texture_map_iterator = this_ptr->m_gl_id_to_texture_props_map_ptr->find     (bound_texture_id);
+void ReplayerSnapshotter::check_gl_errors(const uint32_t& in_n_call)
+{
+    /* NOTE: Callbacks fire before the intercepted call is forwarded to the driver, so the error flag only covers the
+     *       calls which precede the current one. */
+    const uint32_t n_first_call = m_n_first_unchecked_call;
+    const uint32_t n_last_call  = in_n_call - 1;
+    uint32_t       gl_error     = GL_NO_ERROR;
 
-            AI_ASSERT(bound_texture_id != 0);
-            AI_ASSERT(call_arg_format  == GL_LUMINANCE      || call_arg_format  == GL_RGBA);
-            AI_ASSERT(call_arg_type    == GL_UNSIGNED_BYTE);
+    if (in_n_call <= n_first_call)
+    {
+        return;
+    }
 
-            const auto n_components = (call_arg_format == GL_RGBA) ? 4u
-                                                                   : 1u;
+    gl_error = reinterpret_cast<PFNGLGETERRORPROC>(OpenGL::g_cached_gl_get_error)();
 
-            /* Create new map entries for the texture, if necessary. */
-            if (texture_map_iterator == this_ptr->m_gl_id_to_texture_props_map_ptr->end() )
+    /* GL may hold more than one error flag at a time. Drain them, so that they do not get attributed to later calls. */
+    if (gl_error != GL_NO_ERROR)
+    {
+        for (uint32_t n_error = 0;
+                      n_error < MAX_N_GL_ERRORS_TO_DRAIN;
+                    ++n_error)
+        {
+            if (reinterpret_cast<PFNGLGETERRORPROC>(OpenGL::g_cached_gl_get_error)() == GL_NO_ERROR)
             {
-                (*this_ptr->m_gl_id_to_texture_props_map_ptr)[bound_texture_id] = TextureProps(call_arg_border,
-                                                                                               TextureType::_2D);
-
-                texture_map_iterator = this_ptr->m_gl_id_to_texture_props_map_ptr->find(bound_texture_id);
+                break;
             }
+        }
+    }
 
-            {
-                auto texture_state_map_iterator = this_ptr->m_current_context_state_ptr->gl_texture_id_to_texture_state_map.find(bound_texture_id);
-
-                if (texture_state_map_iterator == this_ptr->m_current_context_state_ptr->gl_texture_id_to_texture_state_map.end())
-                {
-                    this_ptr->m_current_context_state_ptr->gl_texture_id_to_texture_state_map[bound_texture_id] = GLContextTextureState();
-                }
-            }
+    m_n_first_unchecked_call = in_n_call;
 
-            /* Cache the specified mip data */
-            texture_map_iterator->second.mip_props_vec.resize(call_arg_level + 1);
+    if (m_gl_error_validation_mode == GLErrorValidationMode::PER_CALL)
+    {
+        AI_ASSERT(gl_error == GL_NO_ERROR);
+    }
 
+    if (gl_error != GL_NO_ERROR                 &&
+        n_first_call == n_last_call)
+    {
+        /* Pinpointed. */
+        report_gl_error(gl_error,
+                        n_first_call,
+                        n_last_call,
+                        in_n_call);
+
+        m_gl_error_bisect_stage = GLErrorBisectStage::NONE;
+        m_is_bisecting_gl_error = false;
+    }
+    else
+    if (m_is_bisecting_gl_error)
+    {
+        /* Narrow down the suspected range. This relies on consecutive frames issuing similar call sequences, which holds
+         * for as long as the game keeps rendering the same scene. */
+        switch (m_gl_error_bisect_stage)
+        {
+            case GLErrorBisectStage::PREFIX:
             {
-                auto       mip_props_ptr            = &texture_map_iterator->second.mip_props_vec.at(call_arg_level);
-                const auto n_bytes_under_pixels_ptr = call_arg_width * call_arg_height * n_components;
-                auto       data_u8_vec_ptr          = &mip_props_ptr->data_u8_vec;
-
-                should_record_api_call = (data_u8_vec_ptr->size() != 0);
+                m_gl_error_bisect_stage = GLErrorBisectStage::MID;
 
-                mip_props_ptr->format           = call_arg_format;
-                mip_props_ptr->internal_format  = call_arg_internalformat;
-                mip_props_ptr->mip_size_u32vec3 = std::array<uint32_t, 3>{static_cast<uint32_t>(call_arg_width), static_cast<uint32_t>(call_arg_height), 1};
-                mip_props_ptr->type             = call_arg_type;
+                break;
+            }
 
-                data_u8_vec_ptr->resize(n_bytes_under_pixels_ptr);
+            case GLErrorBisectStage::MID:
+            {
+                m_gl_error_bisect_mid_failed = (gl_error != GL_NO_ERROR);
+                m_n_gl_error_bisect_mid_call = n_last_call;
+                m_gl_error_bisect_stage      = GLErrorBisectStage::LAST;
 
-                memcpy(data_u8_vec_ptr->data(),
-                       call_arg_pixels_ptr,
-                       n_bytes_under_pixels_ptr);
+                break;
             }
-        }
-        else
-        if (in_api_func == APIInterceptor::APIFUNCTION_GL_GLTEXPARAMETERF)
-        {
-            const auto call_arg_target            = in_args_ptr[0].get_u32 ();
-            const auto call_arg_pname             = in_args_ptr[1].get_u32 ();
-            const auto call_arg_value             = in_args_ptr[2].get_fp32();
-            const auto bound_texture_id_iterator  = this_ptr->m_texture_target_to_bound_texture_id_map.find(call_arg_target);
 
-            if (bound_texture_id_iterator != this_ptr->m_texture_target_to_bound_texture_id_map.end() )
+            case GLErrorBisectStage::LAST:
             {
-                const auto bound_texture_id           = bound_texture_id_iterator->second;
-                auto       texture_state_map_iterator = this_ptr->m_current_context_state_ptr->gl_texture_id_to_texture_state_map.find(bound_texture_id);
+                const auto n_prev_first_call = m_n_gl_error_bisect_first_call;
+                const auto n_prev_last_call  = m_n_gl_error_bisect_last_call;
 
-                if (texture_state_map_iterator == this_ptr->m_current_context_state_ptr->gl_texture_id_to_texture_state_map.end() )
+                if (m_gl_error_bisect_mid_failed)
                 {
-                    this_ptr->m_current_context_state_ptr->gl_texture_id_to_texture_state_map[bound_texture_id] = GLContextTextureState();
-                    texture_state_map_iterator                                                                  = this_ptr->m_current_context_state_ptr->gl_texture_id_to_texture_state_map.find(bound_texture_id);
-
-                    assert(texture_state_map_iterator != this_ptr->m_current_context_state_ptr->gl_texture_id_to_texture_state_map.end() );
+                    m_n_gl_error_bisect_last_call = std::min(m_n_gl_error_bisect_last_call,
+                                                             m_n_gl_error_bisect_mid_call);
                 }
-
-                switch (call_arg_pname)
+                else
+                if (gl_error != GL_NO_ERROR)
                 {
-                    case GL_TEXTURE_BASE_LEVEL: texture_state_map_iterator->second.base_level = static_cast<int32_t>(call_arg_value); break;
-                    case GL_TEXTURE_MAG_FILTER: texture_state_map_iterator->second.mag_filter = static_cast<GLenum> (call_arg_value); break;
-                    case GL_TEXTURE_MAX_LEVEL:  texture_state_map_iterator->second.max_level  = static_cast<int32_t>(call_arg_value); break;
-                    case GL_TEXTURE_MAX_LOD:    texture_state_map_iterator->second.max_lod    = call_arg_value;                       break;
-                    case GL_TEXTURE_MIN_LOD:    texture_state_map_iterator->second.min_lod    = call_arg_value;                       break;
-                    case GL_TEXTURE_MIN_FILTER: texture_state_map_iterator->second.min_filter = static_cast<GLenum> (call_arg_value); break;
-                    case GL_TEXTURE_WRAP_S:     texture_state_map_iterator->second.wrap_s     = static_cast<GLenum> (call_arg_value); break;
-                    case GL_TEXTURE_WRAP_T:     texture_state_map_iterator->second.wrap_t     = static_cast<GLenum> (call_arg_value); break;
-                    case GL_TEXTURE_WRAP_R:     texture_state_map_iterator->second.wrap_r     = static_cast<GLenum> (call_arg_value); break;
+                    m_n_gl_error_bisect_first_call = std::max(m_n_gl_error_bisect_first_call,
+                                                              m_n_gl_error_bisect_mid_call + 1);
                 }
 
-                should_record_api_call = false;
-            }
-        }
-
-        if (should_record_api_call)
-        {
-            /* This is a generic GL call. Record it. */
-            if (in_api_func == APIInterceptor::APIFUNCTION_GL_GLCOLOR3UBV)
-            {
-                /* Convert to non-ptr representation.. */
-                const auto                                               color_data_ptr = reinterpret_cast<const unsigned char*>(in_args_ptr[0].get_u8_ptr() );
-                const std::array<APIInterceptor::APIFunctionArgument, 3> api_arg_vec    =
+                if (m_n_gl_error_bisect_first_call != n_prev_first_call ||
+                    m_n_gl_error_bisect_last_call  != n_prev_last_call)
                 {
-                    APIInterceptor::APIFunctionArgument::create_u8(color_data_ptr[0]),
-                    APIInterceptor::APIFunctionArgument::create_u8(color_data_ptr[1]),
-                    APIInterceptor::APIFunctionArgument::create_u8(color_data_ptr[2]),
-                };
-
-                this_ptr->m_recording_snapshot_ptr->record_api_call(APIInterceptor::APIFUNCTION_GL_GLCOLOR3UB,
-                                                                    static_cast<uint32_t>(api_arg_vec.size() ),
-                                                                    api_arg_vec.data     () );
-            }
-            else
-            if (in_api_func == APIInterceptor::APIFUNCTION_GL_GLCOLOR4FV)
-            {
-                /* Convert to non-ptr representation.. */
-                const auto                                               color_data_ptr = in_args_ptr[0].get_fp32_ptr();
-                const std::array<APIInterceptor::APIFunctionArgument, 4> api_arg_vec    =
+                    m_n_gl_error_bisect_split_call = m_n_gl_error_bisect_first_call + (m_n_gl_error_bisect_last_call - m_n_gl_error_bisect_first_call) / 2;
+
+                    report_gl_error(m_last_gl_error_report.gl_error,
+                                    m_n_gl_error_bisect_first_call,
+                                    m_n_gl_error_bisect_last_call,
+                                    in_n_call);
+                }
+                else
+                if (m_gl_error_bisect_mid_failed                                                 &&
+                    m_n_gl_error_bisect_split_call > m_n_gl_error_bisect_first_call)
                 {
-                    APIInterceptor::APIFunctionArgument::create_fp32(color_data_ptr[0]),
-                    APIInterceptor::APIFunctionArgument::create_fp32(color_data_ptr[1]),
-                    APIInterceptor::APIFunctionArgument::create_fp32(color_data_ptr[2]),
-                    APIInterceptor::APIFunctionArgument::create_fp32(color_data_ptr[3])
-                };
-
-                this_ptr->m_recording_snapshot_ptr->record_api_call(APIInterceptor::APIFUNCTION_GL_GLCOLOR4F,
-                                                                    static_cast<uint32_t>(api_arg_vec.size() ),
-                                                                    api_arg_vec.data     () );
-            }
-            else
-            if (in_api_func == APIInterceptor::APIFUNCTION_GL_GLVERTEX3FV)
-            {
-                /* Convert to non-ptr representation.. */
-                const auto                                               vertex_data_ptr = in_args_ptr[0].get_fp32_ptr();
-                const std::array<APIInterceptor::APIFunctionArgument, 3> api_arg_vec     =
+                    /* The mid check could not be issued in time, most likely because the split point fell within a
+                     * glBegin() .. glEnd() run. Try splitting closer to the start of the range next time. */
+                    m_n_gl_error_bisect_split_call = m_n_gl_error_bisect_first_call + (m_n_gl_error_bisect_split_call - m_n_gl_error_bisect_first_call) / 2;
+                }
+                else
+                if (--m_n_gl_error_bisect_attempts_left == 0)
                 {
-                    APIInterceptor::APIFunctionArgument::create_fp32(vertex_data_ptr[0]),
-                    APIInterceptor::APIFunctionArgument::create_fp32(vertex_data_ptr[1]),
-                    APIInterceptor::APIFunctionArgument::create_fp32(vertex_data_ptr[2])
-                };
-
-                this_ptr->m_recording_snapshot_ptr->record_api_call(APIInterceptor::APIFUNCTION_GL_GLVERTEX3F,
-                                                                    static_cast<uint32_t>(api_arg_vec.size() ),
-                                                                    api_arg_vec.data     () );
+                    /* The error did not reproduce. Give up and keep the last reported range. */
+                    m_is_bisecting_gl_error = false;
+                }
+
+                m_gl_error_bisect_stage = GLErrorBisectStage::NONE;
+
+                break;
             }
-            else
+
+            default:
             {
-                this_ptr->m_recording_snapshot_ptr->record_api_call(in_api_func,
-                                                                    in_n_args,
-                                                                    in_args_ptr);
+                /* Errors raised outside the suspected range are ignored until the bisection completes. */
+                break;
             }
         }
     }
     else
+    if (gl_error != GL_NO_ERROR                                 &&
+        !(m_has_gl_error_report                                 &&
+          m_last_gl_error_report.is_exact                       &&
+          m_last_gl_error_report.gl_error     == gl_error       &&
+          m_last_gl_error_report.n_first_call >= n_first_call   &&
+          m_last_gl_error_report.n_first_call <= n_last_call) )
     {
-        /* This snapshot is complete. Stash if needed. */
-        if (this_ptr->m_snapshot_requested)
-        {
-            /* Make sure glReadPixels() completes before we cache the contents. */
-            reinterpret_cast<PFNGLFINISHPROC>(OpenGL::g_cached_gl_finish)();
-
-            assert(this_ptr->m_gl_id_to_texture_props_map_ptr != nullptr);
-
-            this_ptr->m_cached_gl_id_to_texture_props_map_ptr.reset(new GLIDToTexturePropsMap(*this_ptr->m_gl_id_to_texture_props_map_ptr) );
-
-            this_ptr->m_cached_snapshot_ptr               = std::move(this_ptr->m_recording_snapshot_ptr);
-            this_ptr->m_cached_start_gl_context_state_ptr = std::move(this_ptr->m_start_gl_context_state_ptr);
-            this_ptr->m_snapshot_requested                = false;
-
-            this_ptr->m_replayer_ptr->on_snapshot_available();
-        }
-        else
-        {
-            this_ptr->m_recording_snapshot_ptr->reset   ();
-            this_ptr->m_start_gl_context_state_ptr.reset();
-        }
-
-        /* Cache depth buffer's contents for next frame's reuse. */
-        reinterpret_cast<PFNGLPIXELSTOREIPROC>(OpenGL::g_cached_gl_pixel_storei)(GL_PACK_ALIGNMENT,   1);
-        reinterpret_cast<PFNGLPIXELSTOREIPROC>(OpenGL::g_cached_gl_pixel_storei)(GL_UNPACK_ALIGNMENT, 1);
+        /* Start a bisection, unless the range holds a call which has already been found to raise the same error.
+         * Report the range straight away, in case the error never shows up again. */
+        report_gl_error(gl_error,
+                        n_first_call,
+                        n_last_call,
+                        in_n_call);
+
+        m_gl_error_bisect_stage           = GLErrorBisectStage::NONE;
+        m_is_bisecting_gl_error           = true;
+        m_n_gl_error_bisect_attempts_left = MAX_N_GL_ERROR_BISECT_ATTEMPTS;
+        m_n_gl_error_bisect_first_call    = n_first_call;
+        m_n_gl_error_bisect_last_call     = n_last_call;
+        m_n_gl_error_bisect_split_call    = n_first_call + (n_last_call - n_first_call) / 2;
+
+        /* NOTE: The range only ever narrows down from here on, so this is the only time the vector may need to grow. */
+        m_gl_error_bisect_api_func_vec.resize(n_last_call + 1,
+                                              APIInterceptor::APIFUNCTION_GL_FIRST);
     }
 
-    if (in_api_func == APIInterceptor::APIFUNCTION_GL_GLBEGIN)
-    {
-        this_ptr->m_is_glbegin_active = true;
-    }
-    else
-    if (in_api_func == APIInterceptor::APIFUNCTION_GL_GLEND)
-    {
-        AI_ASSERT(this_ptr->m_is_glbegin_active);
+    schedule_next_gl_error_check(in_n_call);
+}
 
-        this_ptr->m_is_glbegin_active = false;
-    }
-    else
+ReplayerSnapshotterUniquePtr ReplayerSnapshotter::create(const Replayer* in_replayer_ptr)
+{
+    ReplayerSnapshotterUniquePtr result_ptr(new ReplayerSnapshotter(in_replayer_ptr) );
+
+    if (result_ptr != nullptr)
     {
-        if (!this_ptr->m_is_glbegin_active)
+        if (!result_ptr->init() )
         {
-            AI_ASSERT(reinterpret_cast<PFNGLGETERRORPROC>(OpenGL::g_cached_gl_get_error)() == GL_NO_ERROR);
+            result_ptr.reset();
         }
     }
+
+    return result_ptr;
 }
 
-bool ReplayerSnapshotter::pop_snapshot(GLContextStateUniquePtr*        out_start_gl_context_state_ptr_ptr,
-                                       ReplayerSnapshotUniquePtr*      out_snapshot_ptr_ptr,
-                                       GLIDToTexturePropsMapUniquePtr* out_gl_id_to_texture_props_map_ptr_ptr)
+bool ReplayerSnapshotter::get_capture_journal_stats(ReplayerCaptureJournalStats* out_stats_ptr) const
 {
     std::lock_guard<std::mutex> lock  (m_mutex);
     bool                        result(false);
 
-    if (m_snapshot_requested == false)
+    if (m_capture_journal_ptr != nullptr)
     {
-        if (m_cached_gl_id_to_texture_props_map_ptr != nullptr)
-        {
-            assert(m_cached_snapshot_ptr != nullptr);
-
-            *out_gl_id_to_texture_props_map_ptr_ptr   = std::move(m_cached_gl_id_to_texture_props_map_ptr);
-            *out_snapshot_ptr_ptr                     = std::move(m_cached_snapshot_ptr);
-            *out_start_gl_context_state_ptr_ptr       = std::move(m_cached_start_gl_context_state_ptr);
-
-            result = true;
-        }
-        else
-        {
-            assert(m_cached_snapshot_ptr == nullptr);
-        }
+        *out_stats_ptr = m_capture_journal_ptr->get_stats();
+        result         = true;
     }
 
     return result;
+}
+
+CaptureProfile ReplayerSnapshotter::get_capture_profile() const
+{
+    return m_capture_profile_requested;
+}
+
+ReplayerCaptureStallStats ReplayerSnapshotter::get_capture_stall_stats() const
+{
+    ReplayerCaptureStallStats result;
+
+    result.last_stall_ns = m_last_capture_stall_ns.load();
+    result.max_stall_ns  = m_max_capture_stall_ns.load ();
+    result.n_captures    = m_n_captures.load           ();
+
+    return result;
+}
+
+uint64_t ReplayerSnapshotter::get_callback_time_ns_last_idle_frame() const
+{
+    return m_callback_time_ns_last_idle_frame;
+}
+
+uint64_t ReplayerSnapshotter::get_callback_time_ns_last_recording_frame() const
+{
+    return m_callback_time_ns_last_recording_frame;
+}
+
+uint32_t ReplayerSnapshotter::get_n_api_calls_last_frame() const
+{
+    return m_n_api_calls_last_frame;
+}
+
+bool ReplayerSnapshotter::init()
+{
+    /* Initialize object instances. */
+    const auto q1_window_extents = Replayer::get_q1_window_extents();
+
+    m_current_context_state_ptr.reset     (new GLContextState       (q1_window_extents.at(0),
+                                                                     q1_window_extents.at(1) ) );
+    m_gl_id_to_texture_props_map_ptr.reset(new GLIDToTexturePropsMap() );
+    m_frame_counter_exporter_ptr = ReplayerFrameCounterExporter::create(FRAME_COUNTERS_FILENAME,
+                                                                        static_cast<uint32_t>(N_FRAME_COUNTER_RING_FRAMES) ); // not odr-used
+    m_segment_analyzer_ptr = ReplayerSegmentAnalyzer::create(q1_window_extents);
+    m_texture_store_ptr    = ReplayerTextureStore::create   ();
+    m_texture_ingester_ptr = ReplayerTextureIngester::create(m_texture_store_ptr.get(),
+                                                             std::bind(&ReplayerSnapshotter::on_texture_ingested,
+                                                                       this,
+                                                                       std::placeholders::_1,
+                                                                       std::placeholders::_2,
+                                                                       std::placeholders::_3) );
+
+    /* Pre-size recording buffers, so that we do not need to grow them during first frames. */
+    for (uint32_t n_snapshot = 0;
+                  n_snapshot < N_PREALLOCATED_SNAPSHOTS;
+                ++n_snapshot)
+    {
+        m_snapshot_pool_vec.push_back(ReplayerSnapshot::create(m_n_max_api_commands_per_frame,
+                                                               m_n_max_api_args_per_frame,
+                                                               m_n_max_vertices_per_frame) );
+    }
+
+    m_recording_snapshot_ptr = acquire_snapshot();
+
+    apply_capture_profile();
+
+    /* Estimate the cost of a single TSC read, so that the overhead of CPU timing can be reported. */
+    {
+        const uint64_t start_tsc = __rdtsc();
+
+        for (uint32_t n_sample = 0;
+                      n_sample < N_TSC_CALIBRATION_SAMPLES;
+                    ++n_sample)
+        {
+            __rdtsc();
+        }
+
+        m_n_tsc_ticks_per_timestamp = static_cast<double>(__rdtsc() - start_tsc) / static_cast<double>(N_TSC_CALIBRATION_SAMPLES + 1);
+    }
+
+    /* Initialize callback handlers for all GL entrypoints used by Q1. */
+    for (uint32_t current_api_func =  static_cast<uint32_t>(APIInterceptor::APIFUNCTION_GL_FIRST);
+                  current_api_func <= static_cast<uint32_t>(APIInterceptor::APIFUNCTION_GL_LAST);
+                ++current_api_func)
+    {
+        APIInterceptor::register_for_callback(static_cast<APIInterceptor::APIFunction>(current_api_func),
+                                              ReplayerSnapshotter::on_api_func_callback,
+                                              this);
+    }
+
+    /* We also need to know when we're done with a snapshot. */
+    APIInterceptor::register_for_callback(APIInterceptor::APIFUNCTION_GDI32_SWAPBUFFERS,
+                                          ReplayerSnapshotter::on_api_func_callback,
+                                          this);
+
+    return true;
+}
+
+void ReplayerSnapshotter::evict_oldest_flight_recorder_frame()
+{
+    assert(m_n_flight_recorder_frames > 0);
+
+    auto& frame = m_flight_recorder_frame_vec.at(m_n_first_flight_recorder_frame);
+
+    recycle_snapshot(std::move(frame.snapshot_ptr) );
+
+    /* Hang on to one start state instance, so that the next recorded frame can reuse its texture state table. */
+    m_spare_gl_context_state_ptr = std::move(frame.start_gl_context_state_ptr);
+    m_n_flight_recorder_bytes   -= frame.n_bytes;
+
+    frame.gl_id_to_texture_props_map_ptr.reset();
+    frame.n_bytes = 0;
+
+    m_n_first_flight_recorder_frame = (m_n_first_flight_recorder_frame + 1) % m_flight_recorder_frame_vec.size();
+    m_n_flight_recorder_frames--;
+}
+
+void ReplayerSnapshotter::fold_frame_counters()
+{
+    m_frame_counters.frame_time_us = static_cast<uint32_t>(m_last_frame_time_us);
+    m_frame_counters.n_frame       = m_n_frame - 1;
+
+    if (m_frame_counter_exporter_ptr != nullptr)
+    {
+        m_frame_counter_exporter_ptr->push(m_frame_counters);
+    }
+
+    m_frame_counters = FrameCounters();
+}
+
+bool ReplayerSnapshotter::get_burst_capture_stats(ReplayerCaptureWriterStats* out_stats_ptr) const
+{
+    std::lock_guard<std::mutex> lock  (m_mutex);
+    bool                        result(false);
+
+    if (m_burst_capture_writer_ptr != nullptr)
+    {
+        *out_stats_ptr = m_burst_capture_writer_ptr->get_stats();
+        result         = true;
+    }
+
+    return result;
+}
+
+bool ReplayerSnapshotter::get_frame_counter_export_stats(ReplayerFrameCounterExporterStats* out_stats_ptr) const
+{
+    if (m_frame_counter_exporter_ptr != nullptr)
+    {
+        *out_stats_ptr = m_frame_counter_exporter_ptr->get_stats();
+    }
+
+    return (m_frame_counter_exporter_ptr != nullptr);
+}
+
+const ReplayerTextureStore* ReplayerSnapshotter::get_texture_store() const
+{
+    return m_texture_store_ptr.get();
+}
+
+bool ReplayerSnapshotter::get_last_auto_capture_report(AutoCaptureReport* out_report_ptr) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (m_last_auto_capture_report.n_captures > 0)
+    {
+        *out_report_ptr = m_last_auto_capture_report;
+    }
+
+    return (m_last_auto_capture_report.n_captures > 0);
+}
+
+bool ReplayerSnapshotter::get_last_gl_error_report(GLErrorReport* out_report_ptr) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (m_has_gl_error_report)
+    {
+        *out_report_ptr = m_last_gl_error_report;
+    }
+
+    return m_has_gl_error_report;
+}
+
+uint32_t ReplayerSnapshotter::get_n_flight_recorder_frames() const
+{
+    return m_n_flight_recorder_frames;
+}
+
+uint64_t ReplayerSnapshotter::get_n_flight_recorder_bytes() const
+{
+    return m_n_flight_recorder_bytes;
+}
+
+std::shared_ptr<const GLIDToTexturePropsMap> ReplayerSnapshotter::get_shared_gl_id_to_texture_props_map()
+{
+    /* Frames which are kept around for longer share a single copy of the texture props map for as long as no texture
+     * is modified. The copy itself is O(1), as the map is copy-on-write. */
+    if (m_is_texture_props_map_dirty                             ||
+        m_shared_gl_id_to_texture_props_map_ptr == nullptr)
+    {
+        m_shared_gl_id_to_texture_props_map_ptr = std::make_shared<const GLIDToTexturePropsMap>(*m_gl_id_to_texture_props_map_ptr);
+        m_is_texture_props_map_dirty            = false;
+
+        /* Sub-image updates from now on are tracked relative to what has just been published. */
+        for (const auto& current_dirty_mip : m_dirty_mip_vec)
+        {
+            const auto texture_props_ptr = m_gl_id_to_texture_props_map_ptr->find(current_dirty_mip.at(0) );
+
+            if (texture_props_ptr                       != nullptr &&
+                texture_props_ptr->mip_props_vec.size() >  current_dirty_mip.at(1) )
+            {
+                auto& mip_props = m_gl_id_to_texture_props_map_ptr->get_for_write(current_dirty_mip.at(0) )->mip_props_vec.at(current_dirty_mip.at(1) );
+
+                mip_props.dirty_base_version  = mip_props.data_version;
+                mip_props.dirty_rect_x1y1x2y2 = std::array<uint32_t, 4>{};
+            }
+        }
+
+        m_dirty_mip_vec.clear();
+    }
+
+    return m_shared_gl_id_to_texture_props_map_ptr;
+}
+
+bool ReplayerSnapshotter::has_capture_journal_failed() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    return m_has_capture_journal_failed;
+}
+
+void ReplayerSnapshotter::handle_alpha_func(const APIInterceptor::APIFunction&         in_api_func,
+                                            const uint32_t&                            in_n_args,
+                                            const APIInterceptor::APIFunctionArgument* in_args_ptr)
+{
+    const CommandView<APIInterceptor::APIFUNCTION_GL_GLALPHAFUNC> command(in_args_ptr);
+
+    m_current_context_state_ptr->alpha_func_func = command.get<0>();
+    m_current_context_state_ptr->alpha_func_ref  = command.get<1>();
+
+    handle_record_only(in_api_func,
+                       in_n_args,
+                       in_args_ptr);
+}
+
+void ReplayerSnapshotter::handle_begin(const APIInterceptor::APIFunction&         in_api_func,
+                                       const uint32_t&                            in_n_args,
+                                       const APIInterceptor::APIFunctionArgument* in_args_ptr)
+{
+    m_current_primitive_type    = CommandView<APIInterceptor::APIFUNCTION_GL_GLBEGIN>(in_args_ptr).get<0>();
+    m_is_glbegin_active         = true;
+    m_n_vertex_calls_at_glbegin = get_n_vertex_calls_this_frame();
+
+    handle_record_only(in_api_func,
+                       in_n_args,
+                       in_args_ptr);
+}
+
+void ReplayerSnapshotter::handle_bind_texture(const APIInterceptor::APIFunction&         in_api_func,
+                                              const uint32_t&                            in_n_args,
+                                              const APIInterceptor::APIFunctionArgument* in_args_ptr)
+{
+    AI_ASSERT(in_n_args == 2);
+
+    const CommandView<APIInterceptor::APIFUNCTION_GL_GLBINDTEXTURE> command   (in_args_ptr);
+    const auto                                                      target     = command.get<0>();
+    const auto                                                      texture_id = command.get<1>();
+
+    AI_ASSERT(target == GL_TEXTURE_2D);
+
+    if (m_current_context_state_ptr->bound_2d_texture_gl_id != texture_id)
+    {
+        m_frame_counters.n_texture_binds++;
+    }
+
+    m_current_context_state_ptr->bound_2d_texture_gl_id = texture_id;
+    m_texture_target_to_bound_texture_id_map[target]    = texture_id;
+
+    handle_record_only(in_api_func,
+                       in_n_args,
+                       in_args_ptr);
+}
+
+void ReplayerSnapshotter::handle_blend_func(const APIInterceptor::APIFunction&         in_api_func,
+                                            const uint32_t&                            in_n_args,
+                                            const APIInterceptor::APIFunctionArgument* in_args_ptr)
+{
+    const CommandView<APIInterceptor::APIFUNCTION_GL_GLBLENDFUNC> command(in_args_ptr);
+
+    m_current_context_state_ptr->blend_func_sfactor = command.get<0>();
+    m_current_context_state_ptr->blend_func_dfactor = command.get<1>();
+
+    handle_record_only(in_api_func,
+                       in_n_args,
+                       in_args_ptr);
+}
+
+void ReplayerSnapshotter::handle_clear_color(const APIInterceptor::APIFunction&         in_api_func,
+                                             const uint32_t&                            in_n_args,
+                                             const APIInterceptor::APIFunctionArgument* in_args_ptr)
+{
+    const CommandView<APIInterceptor::APIFUNCTION_GL_GLCLEARCOLOR> command(in_args_ptr);
+
+    m_current_context_state_ptr->clear_color[0] = command.get<0>();
+    m_current_context_state_ptr->clear_color[1] = command.get<1>();
+    m_current_context_state_ptr->clear_color[2] = command.get<2>();
+    m_current_context_state_ptr->clear_color[3] = command.get<3>();
+
+    handle_record_only(in_api_func,
+                       in_n_args,
+                       in_args_ptr);
+}
+
+void ReplayerSnapshotter::handle_clear_depth(const APIInterceptor::APIFunction&         in_api_func,
+                                             const uint32_t&                            in_n_args,
+                                             const APIInterceptor::APIFunctionArgument* in_args_ptr)
+{
+    m_current_context_state_ptr->clear_depth = CommandView<APIInterceptor::APIFUNCTION_GL_GLCLEARDEPTH>(in_args_ptr).get<0>();
+
+    handle_record_only(in_api_func,
+                       in_n_args,
+                       in_args_ptr);
+}
+
+void ReplayerSnapshotter::handle_color_3ubv(const APIInterceptor::APIFunction&         in_api_func,
+                                            const uint32_t&                            in_n_args,
+                                            const APIInterceptor::APIFunctionArgument* in_args_ptr)
+{
+    if (should_record_api_call(in_api_func) )
+    {
+        /* Convert to non-ptr representation.. */
+        const auto                                               color_data_ptr = CommandView<APIInterceptor::APIFUNCTION_GL_GLCOLOR3UBV>(in_args_ptr).get<0>();
+        const std::array<APIInterceptor::APIFunctionArgument, 3> api_arg_vec    =
+        {
+            APIInterceptor::APIFunctionArgument::create_u8(color_data_ptr[0]),
+            APIInterceptor::APIFunctionArgument::create_u8(color_data_ptr[1]),
+            APIInterceptor::APIFunctionArgument::create_u8(color_data_ptr[2]),
+        };
+
+        m_recording_snapshot_ptr->record_api_call(APIInterceptor::APIFUNCTION_GL_GLCOLOR3UB,
+                                                  static_cast<uint32_t>(api_arg_vec.size() ),
+                                                  api_arg_vec.data     () );
+    }
+}
+
+void ReplayerSnapshotter::handle_color_4fv(const APIInterceptor::APIFunction&         in_api_func,
+                                           const uint32_t&                            in_n_args,
+                                           const APIInterceptor::APIFunctionArgument* in_args_ptr)
+{
+    if (should_record_api_call(in_api_func) )
+    {
+        /* Convert to non-ptr representation.. */
+        const auto                                               color_data_ptr = CommandView<APIInterceptor::APIFUNCTION_GL_GLCOLOR4FV>(in_args_ptr).get<0>();
+        const std::array<APIInterceptor::APIFunctionArgument, 4> api_arg_vec    =
+        {
+            APIInterceptor::APIFunctionArgument::create_fp32(color_data_ptr[0]),
+            APIInterceptor::APIFunctionArgument::create_fp32(color_data_ptr[1]),
+            APIInterceptor::APIFunctionArgument::create_fp32(color_data_ptr[2]),
+            APIInterceptor::APIFunctionArgument::create_fp32(color_data_ptr[3])
+        };
+
+        m_recording_snapshot_ptr->record_api_call(APIInterceptor::APIFUNCTION_GL_GLCOLOR4F,
+                                                  static_cast<uint32_t>(api_arg_vec.size() ),
+                                                  api_arg_vec.data     () );
+    }
+}
+
+void ReplayerSnapshotter::handle_cull_face(const APIInterceptor::APIFunction&         in_api_func,
+                                           const uint32_t&                            in_n_args,
+                                           const APIInterceptor::APIFunctionArgument* in_args_ptr)
+{
+    m_current_context_state_ptr->cull_face_mode = CommandView<APIInterceptor::APIFUNCTION_GL_GLCULLFACE>(in_args_ptr).get<0>();
+
+    handle_record_only(in_api_func,
+                       in_n_args,
+                       in_args_ptr);
+}
+
+void ReplayerSnapshotter::handle_delete_textures(const APIInterceptor::APIFunction&         in_api_func,
+                                                 const uint32_t&                            in_n_args,
+                                                 const APIInterceptor::APIFunctionArgument* in_args_ptr)
+{
+    AI_ASSERT(in_n_args == 2);
+
+    const CommandView<APIInterceptor::APIFUNCTION_GL_GLDELETETEXTURES> command        (in_args_ptr);
+    const auto                                                         n_texture_ids   = command.get<0>();
+    const auto                                                         texture_ids_ptr = command.get<1>();
+
+    for (uint32_t n_texture_id = 0;
+                  n_texture_id < static_cast<uint32_t>(n_texture_ids);
+                ++n_texture_id)
+    {
+        m_current_context_state_ptr->gl_texture_id_to_texture_state_map.erase(texture_ids_ptr[n_texture_id]);
+        m_gl_id_to_texture_props_map_ptr->erase                             (texture_ids_ptr[n_texture_id]);
+    }
+
+    m_is_texture_props_map_dirty = true;
+
+    /* NOTE: Never recorded. */
+}
+
+void ReplayerSnapshotter::handle_depth_func(const APIInterceptor::APIFunction&         in_api_func,
+                                            const uint32_t&                            in_n_args,
+                                            const APIInterceptor::APIFunctionArgument* in_args_ptr)
+{
+    m_current_context_state_ptr->depth_func = CommandView<APIInterceptor::APIFUNCTION_GL_GLDEPTHFUNC>(in_args_ptr).get<0>();
+
+    handle_record_only(in_api_func,
+                       in_n_args,
+                       in_args_ptr);
+}
+
+void ReplayerSnapshotter::handle_depth_mask(const APIInterceptor::APIFunction&         in_api_func,
+                                            const uint32_t&                            in_n_args,
+                                            const APIInterceptor::APIFunctionArgument* in_args_ptr)
+{
+    m_current_context_state_ptr->depth_mask = (CommandView<APIInterceptor::APIFUNCTION_GL_GLDEPTHMASK>(in_args_ptr).get<0>() != 0);
+
+    handle_record_only(in_api_func,
+                       in_n_args,
+                       in_args_ptr);
+}
+
+void ReplayerSnapshotter::handle_depth_range(const APIInterceptor::APIFunction&         in_api_func,
+                                             const uint32_t&                            in_n_args,
+                                             const APIInterceptor::APIFunctionArgument* in_args_ptr)
+{
+    const CommandView<APIInterceptor::APIFUNCTION_GL_GLDEPTHRANGE> command(in_args_ptr);
+
+    m_current_context_state_ptr->depth_range[0] = command.get<0>();
+    m_current_context_state_ptr->depth_range[1] = command.get<1>();
+
+    handle_record_only(in_api_func,
+                       in_n_args,
+                       in_args_ptr);
+}
+
+void ReplayerSnapshotter::handle_draw_buffer(const APIInterceptor::APIFunction&         in_api_func,
+                                             const uint32_t&                            in_n_args,
+                                             const APIInterceptor::APIFunctionArgument* in_args_ptr)
+{
+    /* NOTE: Since the new mode is applied first, the call itself only gets recorded if it selects the back buffer. */
+    m_current_context_state_ptr->draw_buffer_mode = CommandView<APIInterceptor::APIFUNCTION_GL_GLDRAWBUFFER>(in_args_ptr).get<0>();
+
+    if (m_current_context_state_ptr->draw_buffer_mode != GL_BACK)
+    {
+        m_is_front_buffer_used_this_frame = true;
+    }
+
+    handle_record_only(in_api_func,
+                       in_n_args,
+                       in_args_ptr);
+}
+
+void ReplayerSnapshotter::handle_enable_disable(const APIInterceptor::APIFunction&         in_api_func,
+                                                const uint32_t&                            in_n_args,
+                                                const APIInterceptor::APIFunctionArgument* in_args_ptr)
+{
+    /* NOTE: glEnable() and glDisable() share the signature, so it is fine to use either view here. */
+    const bool should_enable = (in_api_func == APIInterceptor::APIFUNCTION_GL_GLENABLE);
+
+    switch (CommandView<APIInterceptor::APIFUNCTION_GL_GLENABLE>(in_args_ptr).get<0>() )
+    {
+        case GL_ALPHA_TEST:   m_current_context_state_ptr->alpha_test_enabled   = should_enable; break;
+        case GL_BLEND:        m_current_context_state_ptr->blend_enabled        = should_enable; break;
+        case GL_CULL_FACE:    m_current_context_state_ptr->cull_face_enabled    = should_enable; break;
+        case GL_DEPTH_TEST:   m_current_context_state_ptr->depth_test_enabled   = should_enable; break;
+        case GL_SCISSOR_TEST: m_current_context_state_ptr->scissor_test_enabled = should_enable; break;
+        case GL_TEXTURE_2D:   m_current_context_state_ptr->texture_2d_enabled   = should_enable; break;
+
+        default:
+        {
+            assert(false);
+        }
+    }
+
+    handle_record_only(in_api_func,
+                       in_n_args,
+                       in_args_ptr);
+}
+
+void ReplayerSnapshotter::handle_end(const APIInterceptor::APIFunction&         in_api_func,
+                                     const uint32_t&                            in_n_args,
+                                     const APIInterceptor::APIFunctionArgument* in_args_ptr)
+{
+    AI_ASSERT(m_is_glbegin_active);
+
+    m_is_glbegin_active = false;
+
+    if (m_current_primitive_type < FrameCounters::N_PRIMITIVE_TYPES)
+    {
+        m_frame_counters.n_vertices_per_primitive_type[m_current_primitive_type] += get_n_vertex_calls_this_frame() - m_n_vertex_calls_at_glbegin;
+    }
+
+    handle_record_only(in_api_func,
+                       in_n_args,
+                       in_args_ptr);
+}
+
+void ReplayerSnapshotter::handle_front_face(const APIInterceptor::APIFunction&         in_api_func,
+                                            const uint32_t&                            in_n_args,
+                                            const APIInterceptor::APIFunctionArgument* in_args_ptr)
+{
+    m_current_context_state_ptr->front_face_mode = CommandView<APIInterceptor::APIFUNCTION_GL_GLFRONTFACE>(in_args_ptr).get<0>();
+
+    handle_record_only(in_api_func,
+                       in_n_args,
+                       in_args_ptr);
+}
+
+void ReplayerSnapshotter::handle_matrix_mode(const APIInterceptor::APIFunction&         in_api_func,
+                                             const uint32_t&                            in_n_args,
+                                             const APIInterceptor::APIFunctionArgument* in_args_ptr)
+{
+    m_current_context_state_ptr->matrix_mode = CommandView<APIInterceptor::APIFUNCTION_GL_GLMATRIXMODE>(in_args_ptr).get<0>();
+
+    m_current_matrix_state.apply(in_api_func,
+                                 in_args_ptr);
+
+    handle_record_only(in_api_func,
+                       in_n_args,
+                       in_args_ptr);
+}
+
+void ReplayerSnapshotter::handle_matrix_op(const APIInterceptor::APIFunction&         in_api_func,
+                                           const uint32_t&                            in_n_args,
+                                           const APIInterceptor::APIFunctionArgument* in_args_ptr)
+{
+    m_current_matrix_state.apply(in_api_func,
+                                 in_args_ptr);
+
+    handle_record_only(in_api_func,
+                       in_n_args,
+                       in_args_ptr);
+}
+
+void ReplayerSnapshotter::handle_record_only(const APIInterceptor::APIFunction&         in_api_func,
+                                             const uint32_t&                            in_n_args,
+                                             const APIInterceptor::APIFunctionArgument* in_args_ptr)
+{
+    if (should_record_api_call(in_api_func) )
+    {
+        m_recording_snapshot_ptr->record_api_call(in_api_func,
+                                                  in_n_args,
+                                                  in_args_ptr);
+    }
+}
+
+void ReplayerSnapshotter::handle_shade_model(const APIInterceptor::APIFunction&         in_api_func,
+                                             const uint32_t&                            in_n_args,
+                                             const APIInterceptor::APIFunctionArgument* in_args_ptr)
+{
+    m_current_context_state_ptr->shade_model = CommandView<APIInterceptor::APIFUNCTION_GL_GLSHADEMODEL>(in_args_ptr).get<0>();
+
+    handle_record_only(in_api_func,
+                       in_n_args,
+                       in_args_ptr);
+}
+
+void ReplayerSnapshotter::handle_tex_env_f(const APIInterceptor::APIFunction&         in_api_func,
+                                           const uint32_t&                            in_n_args,
+                                           const APIInterceptor::APIFunctionArgument* in_args_ptr)
+{
+    AI_ASSERT(in_n_args == 3);
+
+    const CommandView<APIInterceptor::APIFUNCTION_GL_GLTEXENVF> command(in_args_ptr);
+
+    AI_ASSERT(command.get<0>() == GL_TEXTURE_ENV);
+    AI_ASSERT(command.get<1>() == GL_TEXTURE_ENV_MODE);
+
+    m_current_context_state_ptr->texture_env_mode = static_cast<uint32_t>(command.get<2>() );
+
+    handle_record_only(in_api_func,
+                       in_n_args,
+                       in_args_ptr);
+}
+
+void ReplayerSnapshotter::handle_tex_image_2d(const APIInterceptor::APIFunction&         in_api_func,
+                                              const uint32_t&                            in_n_args,
+                                              const APIInterceptor::APIFunctionArgument* in_args_ptr)
+{
+    const CommandView<APIInterceptor::APIFUNCTION_GL_GLTEXIMAGE2D> command(in_args_ptr);
+
+    uint32_t    call_arg_target         = command.get<0>();
+    int32_t     call_arg_level          = command.get<1>();
+    int32_t     call_arg_internalformat = command.get<2>();
+    int32_t     call_arg_width          = command.get<3>();
+    int32_t     call_arg_height         = command.get<4>();
+    int32_t     call_arg_border         = command.get<5>();
+    uint32_t    call_arg_format         = command.get<6>();
+    uint32_t    call_arg_type           = command.get<7>();
+    const void* call_arg_pixels_ptr     = command.get<8>();
+
+    AI_ASSERT(in_n_args                                                      == 9);
+    AI_ASSERT(m_texture_target_to_bound_texture_id_map.find(call_arg_target) != m_texture_target_to_bound_texture_id_map.end() );
+
+    const auto bound_texture_id   = m_texture_target_to_bound_texture_id_map.at(call_arg_target);
+    bool       should_record_call = false;
+
+    AI_ASSERT(bound_texture_id != 0);
+    AI_ASSERT(call_arg_format  == GL_LUMINANCE      || call_arg_format  == GL_RGBA);
+    AI_ASSERT(call_arg_type    == GL_UNSIGNED_BYTE);
+
+    const auto n_components = (call_arg_format == GL_RGBA) ? 4u
+                                                           : 1u;
+
+    /* Create new map entries for the texture, if necessary. */
+    if (m_gl_id_to_texture_props_map_ptr->find(bound_texture_id) == nullptr)
+    {
+        *m_gl_id_to_texture_props_map_ptr->get_for_write(bound_texture_id) = TextureProps(call_arg_border,
+                                                                                          TextureType::_2D);
+    }
+
+    if (m_current_context_state_ptr->gl_texture_id_to_texture_state_map.find(bound_texture_id) == nullptr)
+    {
+        m_current_context_state_ptr->gl_texture_id_to_texture_state_map.get_for_write(bound_texture_id);
+    }
+
+    /* Cache the specified mip data */
+    auto texture_props_ptr = m_gl_id_to_texture_props_map_ptr->get_for_write(bound_texture_id);
+
+    texture_props_ptr->mip_props_vec.resize(call_arg_level + 1);
+
+    {
+        auto       mip_props_ptr            = &texture_props_ptr->mip_props_vec.at(call_arg_level);
+        const auto n_bytes_under_pixels_ptr = call_arg_width * call_arg_height * n_components;
+
+        should_record_call = (mip_props_ptr->pending_data_ptr        != nullptr ||
+                              (mip_props_ptr->data_u8_vec_ptr         != nullptr &&
+                               mip_props_ptr->data_u8_vec_ptr->size() != 0) );
+
+        /* Hashing & deduplication happen on the ingester's thread. The blob is filled in once it's ready.
+         *
+         * NOTE: Blobs are immutable, so older copies of the texture props map keep seeing the previous contents. */
+        mip_props_ptr->data_hash           = 0;
+        mip_props_ptr->data_u8_vec_ptr.reset();
+        mip_props_ptr->data_version        = ++m_n_last_mip_data_version;
+        mip_props_ptr->dirty_base_version  = mip_props_ptr->data_version;
+        mip_props_ptr->dirty_rect_x1y1x2y2 = std::array<uint32_t, 4>{};
+        mip_props_ptr->format              = call_arg_format;
+        mip_props_ptr->internal_format     = call_arg_internalformat;
+        mip_props_ptr->mip_size_u32vec3    = std::array<uint32_t, 3>{static_cast<uint32_t>(call_arg_width), static_cast<uint32_t>(call_arg_height), 1};
+        mip_props_ptr->pending_data_ptr    = m_texture_ingester_ptr->submit(call_arg_pixels_ptr,
+                                                                             n_bytes_under_pixels_ptr,
+                                                                             bound_texture_id,
+                                                                             call_arg_level);
+        mip_props_ptr->type                = call_arg_type;
+
+        m_is_texture_props_map_dirty             = true;
+        m_frame_counters.n_texture_upload_bytes += n_bytes_under_pixels_ptr;
+    }
+
+    /* NOTE: Only updates of mips that have already been defined need to be recorded. Initial contents are taken
+     *       care of by the texture props map.
+     *
+     * NOTE: The application is free to reuse its buffer as soon as the call returns, so the recorded command refers
+     *       to the ingested blob instead. The blob is shared with the texture props map, so this costs no extra copy. */
+    if (should_record_call &&
+        m_is_recording     &&
+        m_is_api_func_recorded_vec[in_api_func - APIInterceptor::APIFUNCTION_GL_FIRST])
+    {
+        const auto& mip_props = texture_props_ptr->mip_props_vec.at(call_arg_level);
+
+        m_recording_snapshot_ptr->record_texture_upload(in_api_func,
+                                                        in_n_args,
+                                                        in_args_ptr,
+                                                        mip_props.pending_data_ptr,
+                                                        mip_props.mip_size_u32vec3.at(0) );
+    }
+}
+
+void ReplayerSnapshotter::handle_tex_parameter_f(const APIInterceptor::APIFunction&         in_api_func,
+                                                 const uint32_t&                            in_n_args,
+                                                 const APIInterceptor::APIFunctionArgument* in_args_ptr)
+{
+    const CommandView<APIInterceptor::APIFUNCTION_GL_GLTEXPARAMETERF> command                  (in_args_ptr);
+    const auto                                                        call_arg_target           = command.get<0>();
+    const auto                                                        call_arg_pname            = command.get<1>();
+    const auto                                                        call_arg_value            = command.get<2>();
+    const auto                                                        bound_texture_id_iterator = m_texture_target_to_bound_texture_id_map.find(call_arg_target);
+
+    if (bound_texture_id_iterator != m_texture_target_to_bound_texture_id_map.end() )
+    {
+        const auto bound_texture_id  = bound_texture_id_iterator->second;
+        auto       texture_state_ptr = m_current_context_state_ptr->gl_texture_id_to_texture_state_map.get_for_write(bound_texture_id);
+
+        switch (call_arg_pname)
+        {
+            case GL_TEXTURE_BASE_LEVEL: texture_state_ptr->base_level = static_cast<int32_t>(call_arg_value); break;
+            case GL_TEXTURE_MAG_FILTER: texture_state_ptr->mag_filter = static_cast<GLenum> (call_arg_value); break;
+            case GL_TEXTURE_MAX_LEVEL:  texture_state_ptr->max_level  = static_cast<int32_t>(call_arg_value); break;
+            case GL_TEXTURE_MAX_LOD:    texture_state_ptr->max_lod    = call_arg_value;                       break;
+            case GL_TEXTURE_MIN_LOD:    texture_state_ptr->min_lod    = call_arg_value;                       break;
+            case GL_TEXTURE_MIN_FILTER: texture_state_ptr->min_filter = static_cast<GLenum> (call_arg_value); break;
+            case GL_TEXTURE_WRAP_S:     texture_state_ptr->wrap_s     = static_cast<GLenum> (call_arg_value); break;
+            case GL_TEXTURE_WRAP_T:     texture_state_ptr->wrap_t     = static_cast<GLenum> (call_arg_value); break;
+            case GL_TEXTURE_WRAP_R:     texture_state_ptr->wrap_r     = static_cast<GLenum> (call_arg_value); break;
+        }
+    }
+    else
+    {
+        handle_record_only(in_api_func,
+                           in_n_args,
+                           in_args_ptr);
+    }
+}
+
+void ReplayerSnapshotter::handle_tex_sub_image_2d(const APIInterceptor::APIFunction&         in_api_func,
+                                                  const uint32_t&                            in_n_args,
+                                                  const APIInterceptor::APIFunctionArgument* in_args_ptr)
+{
+    const CommandView<APIInterceptor::APIFUNCTION_GL_GLTEXSUBIMAGE2D> command(in_args_ptr);
+
+    const uint32_t    call_arg_target     = command.get<0>();
+    const int32_t     call_arg_level      = command.get<1>();
+    const int32_t     call_arg_xoffset    = command.get<2>();
+    const int32_t     call_arg_yoffset    = command.get<3>();
+    const int32_t     call_arg_width      = command.get<4>();
+    const int32_t     call_arg_height     = command.get<5>();
+    const uint32_t    call_arg_format     = command.get<6>();
+    const uint32_t    call_arg_type       = command.get<7>();
+    const void*       call_arg_pixels_ptr = command.get<8>();
+
+    AI_ASSERT(in_n_args                                                      == 9);
+    AI_ASSERT(m_texture_target_to_bound_texture_id_map.find(call_arg_target) != m_texture_target_to_bound_texture_id_map.end() );
+
+    if (call_arg_width  == 0 ||
+        call_arg_height == 0)
+    {
+        /* Nothing to update. */
+        return;
+    }
+
+    const auto bound_texture_id = m_texture_target_to_bound_texture_id_map.at(call_arg_target);
+
+    AI_ASSERT(m_gl_id_to_texture_props_map_ptr->find(bound_texture_id)                         != nullptr &&
+              m_gl_id_to_texture_props_map_ptr->find(bound_texture_id)->mip_props_vec.size() > static_cast<uint32_t>(call_arg_level) );
+    AI_ASSERT(call_arg_format == GL_LUMINANCE || call_arg_format == GL_RGBA);
+    AI_ASSERT(call_arg_type   == GL_UNSIGNED_BYTE);
+
+    {
+        const auto& mip_size_u32vec3 = m_gl_id_to_texture_props_map_ptr->find(bound_texture_id)->mip_props_vec.at(call_arg_level).mip_size_u32vec3;
+
+        /* GL rejects rectangles which do not fit in the mip with GL_INVALID_VALUE and leaves the texture alone. So do we,
+         * rather than have the ingester patch memory past the end of the mip's data. */
+        if (call_arg_xoffset                                          <  0                       ||
+            call_arg_yoffset                                          <  0                       ||
+            call_arg_width                                            <  0                       ||
+            call_arg_height                                           <  0                       ||
+            static_cast<int64_t>(call_arg_xoffset) + call_arg_width  >  mip_size_u32vec3.at(0)  ||
+            static_cast<int64_t>(call_arg_yoffset) + call_arg_height >  mip_size_u32vec3.at(1) )
+        {
+            return;
+        }
+    }
+
+    {
+        auto       mip_props_ptr = &m_gl_id_to_texture_props_map_ptr->get_for_write(bound_texture_id)->mip_props_vec.at(call_arg_level);
+        const auto n_components  = (call_arg_format == GL_RGBA) ? 4u
+                                                                : 1u;
+        const auto rect_x1y1x2y2 = std::array<uint32_t, 4>{static_cast<uint32_t>(call_arg_xoffset),
+                                                           static_cast<uint32_t>(call_arg_yoffset),
+                                                           static_cast<uint32_t>(call_arg_xoffset + call_arg_width),
+                                                           static_cast<uint32_t>(call_arg_yoffset + call_arg_height)};
+
+        /* NOTE: Only the sub-rectangle is copied here. The ingester patches all of this frame's sub-rectangles into a
+         *       single copy of the mip data, at the end of the frame. */
+        AI_ASSERT(mip_props_ptr->format == call_arg_format);
+
+        mip_props_ptr->pending_data_ptr = m_texture_ingester_ptr->submit_sub_image(call_arg_pixels_ptr,
+                                                                                   *mip_props_ptr,
+                                                                                   rect_x1y1x2y2,
+                                                                                   n_components,
+                                                                                   bound_texture_id,
+                                                                                   call_arg_level);
+        mip_props_ptr->data_hash        = 0;
+        mip_props_ptr->data_u8_vec_ptr.reset();
+        mip_props_ptr->data_version     = ++m_n_last_mip_data_version;
+
+        if (!mip_props_ptr->has_dirty_rect() )
+        {
+            mip_props_ptr->dirty_rect_x1y1x2y2 = rect_x1y1x2y2;
+
+            m_dirty_mip_vec.push_back(std::array<uint32_t, 2>{bound_texture_id,
+                                                              static_cast<uint32_t>(call_arg_level)});
+        }
+        else
+        {
+            auto& dirty_rect = mip_props_ptr->dirty_rect_x1y1x2y2;
+
+            dirty_rect = std::array<uint32_t, 4>{std::min(dirty_rect.at(0), rect_x1y1x2y2.at(0) ),
+                                                 std::min(dirty_rect.at(1), rect_x1y1x2y2.at(1) ),
+                                                 std::max(dirty_rect.at(2), rect_x1y1x2y2.at(2) ),
+                                                 std::max(dirty_rect.at(3), rect_x1y1x2y2.at(3) )};
+        }
+
+        m_is_texture_props_map_dirty             = true;
+        m_frame_counters.n_texture_upload_bytes += static_cast<uint64_t>(call_arg_width) * call_arg_height * n_components;
+
+        /* The recorded command refers to the updated blob as a whole. Replaying it only uploads the sub-rectangle. */
+        if (m_is_recording                                                                  &&
+            m_is_api_func_recorded_vec[in_api_func - APIInterceptor::APIFUNCTION_GL_FIRST])
+        {
+            m_recording_snapshot_ptr->record_texture_upload(in_api_func,
+                                                            in_n_args,
+                                                            in_args_ptr,
+                                                            mip_props_ptr->pending_data_ptr,
+                                                            mip_props_ptr->mip_size_u32vec3.at(0) );
+        }
+    }
+}
+
+void ReplayerSnapshotter::handle_vertex_3fv(const APIInterceptor::APIFunction&         in_api_func,
+                                            const uint32_t&                            in_n_args,
+                                            const APIInterceptor::APIFunctionArgument* in_args_ptr)
+{
+    if (should_record_api_call(in_api_func) )
+    {
+        /* Convert to non-ptr representation.. */
+        const auto                                               vertex_data_ptr = CommandView<APIInterceptor::APIFUNCTION_GL_GLVERTEX3FV>(in_args_ptr).get<0>();
+        const std::array<APIInterceptor::APIFunctionArgument, 3> api_arg_vec     =
+        {
+            APIInterceptor::APIFunctionArgument::create_fp32(vertex_data_ptr[0]),
+            APIInterceptor::APIFunctionArgument::create_fp32(vertex_data_ptr[1]),
+            APIInterceptor::APIFunctionArgument::create_fp32(vertex_data_ptr[2])
+        };
+
+        m_recording_snapshot_ptr->record_api_call(APIInterceptor::APIFUNCTION_GL_GLVERTEX3F,
+                                                  static_cast<uint32_t>(api_arg_vec.size() ),
+                                                  api_arg_vec.data     () );
+    }
+}
+
+void ReplayerSnapshotter::handle_viewport(const APIInterceptor::APIFunction&         in_api_func,
+                                          const uint32_t&                            in_n_args,
+                                          const APIInterceptor::APIFunctionArgument* in_args_ptr)
+{
+    AI_ASSERT(in_n_args == 4);
+
+    const CommandView<APIInterceptor::APIFUNCTION_GL_GLVIEWPORT> command(in_args_ptr);
+
+    m_current_context_state_ptr->viewport_x1y1   [0] = command.get<0>();
+    m_current_context_state_ptr->viewport_x1y1   [1] = command.get<1>();
+    m_current_context_state_ptr->viewport_extents[0] = command.get<2>();
+    m_current_context_state_ptr->viewport_extents[1] = command.get<3>();
+
+    handle_record_only(in_api_func,
+                       in_n_args,
+                       in_args_ptr);
+}
+
+void ReplayerSnapshotter::on_api_func_callback(APIInterceptor::APIFunction                in_api_func,
+                                               uint32_t                                   in_n_args,
+                                               const APIInterceptor::APIFunctionArgument* in_args_ptr,
+                                               void*                                      in_user_arg_ptr)
+{
+    auto this_ptr(reinterpret_cast<ReplayerSnapshotter*>(in_user_arg_ptr) );
+
+    assert(this_ptr->m_recording_snapshot_ptr != nullptr);
+
+    if (in_api_func != APIInterceptor::APIFUNCTION_GDI32_SWAPBUFFERS)
+    {
+        /* Time spent by the application since our previous callback returned is what it took to get to this call. */
+        if (this_ptr->m_is_cpu_timing_active)
+        {
+            this_ptr->m_recording_snapshot_ptr->add_cpu_ticks(__rdtsc() - this_ptr->m_last_callback_exit_tsc);
+        }
+
+        /* Only time every N-th call, so that the measurement itself does not add much overhead. */
+        const bool     should_time_call = ( (this_ptr->m_n_api_calls_this_frame++ & (CALLBACK_TIMING_SAMPLING_PERIOD - 1) ) == 0);
+        const uint64_t start_tsc        = (should_time_call) ? __rdtsc() : 0;
+
+        this_ptr->m_frame_counters.n_api_calls_per_func[in_api_func - APIInterceptor::APIFUNCTION_GL_FIRST]++;
+
+        assert(in_api_func >= APIInterceptor::APIFUNCTION_GL_FIRST &&
+               in_api_func <= APIInterceptor::APIFUNCTION_GL_LAST);
+
+        /* Calls left out by the capture profile can be skipped altogether, unless their handler tracks some state. */
+        {
+            const auto handler_func_ptr = m_api_func_handler_table.handler_func_ptr_vec[in_api_func - APIInterceptor::APIFUNCTION_GL_FIRST];
+
+            if (this_ptr->m_is_api_func_recorded_vec[in_api_func - APIInterceptor::APIFUNCTION_GL_FIRST] ||
+                handler_func_ptr != &ReplayerSnapshotter::handle_record_only)
+            {
+                (this_ptr->*handler_func_ptr)(in_api_func,
+                                              in_n_args,
+                                              in_args_ptr);
+
+                /* Analyze commands as soon as they are recorded, so that a complete frame already comes with its segment table. */
+                if (this_ptr->m_is_recording)
+                {
+                    this_ptr->m_segment_analyzer_ptr->consume(*this_ptr->m_recording_snapshot_ptr);
+
+                    /* NOTE: Texture uploads need to be journaled while the application's buffer is still around. */
+                    if (this_ptr->m_capture_journal_ptr != nullptr)
+                    {
+                        this_ptr->m_capture_journal_ptr->consume(*this_ptr->m_recording_snapshot_ptr);
+                    }
+                }
+            }
+        }
+
+        /* Only issue glGetError() at scheduled points. Each check is a driver round-trip.
+         *
+         * NOTE: glBegin() has not been forwarded to the driver yet, so its callback can still check, even though its
+         *       handler has already marked the run as active. Without it, calls followed by back-to-back glBegin() ..
+         *       glEnd() runs could never be told apart by a bisection. */
+        if (this_ptr->m_n_api_calls_this_frame >  this_ptr->m_n_next_gl_error_check_call &&
+            (!this_ptr->m_is_glbegin_active                                        ||
+              in_api_func                      == APIInterceptor::APIFUNCTION_GL_GLBEGIN) &&
+            in_api_func                        != APIInterceptor::APIFUNCTION_GL_GLEND)
+        {
+            this_ptr->check_gl_errors(this_ptr->m_n_api_calls_this_frame - 1);
+        }
+
+        if (should_time_call)
+        {
+            this_ptr->m_n_sampled_callback_tsc_ticks_this_frame += __rdtsc() - start_tsc;
+        }
+
+        this_ptr->m_previous_api_func = in_api_func;
+
+        /* The bisected range may narrow down to a call other than the previous one, so remember what the calls it
+         * covers are. */
+        if (this_ptr->m_is_bisecting_gl_error)
+        {
+            const uint32_t n_call = this_ptr->m_n_api_calls_this_frame - 1;
+
+            if (n_call >= this_ptr->m_n_gl_error_bisect_first_call &&
+                n_call <= this_ptr->m_n_gl_error_bisect_last_call)
+            {
+                this_ptr->m_gl_error_bisect_api_func_vec.at(n_call) = in_api_func;
+            }
+        }
+
+        if (this_ptr->m_is_cpu_timing_active)
+        {
+            this_ptr->m_last_callback_exit_tsc = __rdtsc();
+        }
+    }
+    else
+    {
+        this_ptr->on_swap_buffers();
+    }
+}
+
+void ReplayerSnapshotter::on_texture_ingested(const uint32_t&                              in_gl_texture_id,
+                                              const uint32_t&                              in_n_mip,
+                                              const std::shared_ptr<const PendingMipData>& in_pending_data_ptr)
+{
+    const auto texture_props_ptr = m_gl_id_to_texture_props_map_ptr->find(in_gl_texture_id);
+
+    /* The texture may have been deleted, or the mip redefined, while the upload was in flight. */
+    if (texture_props_ptr                                              == nullptr  ||
+        texture_props_ptr->mip_props_vec.size()                        <= in_n_mip ||
+        texture_props_ptr->mip_props_vec.at(in_n_mip).pending_data_ptr != in_pending_data_ptr)
+    {
+        return;
+    }
+
+    /* NOTE: Published copies of the map keep referring to the pending data, which has the same contents. There is no
+     *       need to publish the map again. */
+    {
+        auto& mip_props = m_gl_id_to_texture_props_map_ptr->get_for_write(in_gl_texture_id)->mip_props_vec.at(in_n_mip);
+
+        mip_props.data_hash       = in_pending_data_ptr->data_hash;
+        mip_props.data_u8_vec_ptr = in_pending_data_ptr->data_u8_vec_ptr;
+        mip_props.pending_data_ptr.reset();
+    }
+}
+
+void ReplayerSnapshotter::on_swap_buffers()
+{
+    if (m_is_cpu_timing_active)
+    {
+        m_recording_snapshot_ptr->add_cpu_ticks(__rdtsc() - m_last_callback_exit_tsc);
+    }
+
+    /* This snapshot is complete. Keep track of the largest frame we've seen so far, so that recycled buffers
+     * can be pre-sized accordingly. */
+    m_n_max_api_args_per_frame     = std::max(m_n_max_api_args_per_frame,
+                                              m_recording_snapshot_ptr->get_n_api_args    () );
+    m_n_max_api_commands_per_frame = std::max(m_n_max_api_commands_per_frame,
+                                              m_recording_snapshot_ptr->get_n_api_commands() );
+    m_n_max_vertices_per_frame     = std::max(m_n_max_vertices_per_frame,
+                                              m_recording_snapshot_ptr->get_n_vertices    () );
+
+    /* Check the remainder of the frame for GL errors, if needed. */
+    if (m_gl_error_validation_requested.exchange(false)                        ||
+        m_is_bisecting_gl_error                                                ||
+        (m_gl_error_validation_mode != GLErrorValidationMode::DISABLED  &&
+         m_gl_error_validation_mode != GLErrorValidationMode::ON_DEMAND) )
+    {
+        check_gl_errors(m_n_api_calls_this_frame);
+    }
+
+    m_n_api_calls_last_frame = m_n_api_calls_this_frame;
+    m_n_api_calls_this_frame = 0;
+    m_n_frame++;
+
+    start_gl_error_validation_frame();
+
+    update_callback_overhead_stats();
+
+    /* Hand this frame's sub-image updates over, before any of the frames which refer to them leave the game thread.
+     * Then pick up uploads which have been ingested in the meantime, without waiting for the rest. */
+    m_texture_ingester_ptr->flush  ();
+    m_texture_ingester_ptr->collect();
+
+    apply_burst_capture_request ();
+    apply_capture_journal_config();
+    apply_capture_profile       ();
+    apply_flight_recorder_config();
+    apply_snapshot_request      ();
+    check_auto_capture_triggers ();
+    fold_frame_counters         ();
+
+    /* Keep track of how long the handover of a requested capture keeps the application waiting. */
+    const bool    is_capture_pending = m_snapshot_requested;
+    LARGE_INTEGER capture_start_qpc  = {};
+
+    if (is_capture_pending)
+    {
+        ::QueryPerformanceCounter(&capture_start_qpc);
+    }
+
+    /* Hand over the frame we've just recorded.. */
+    if (m_is_recording)
+    {
+        m_is_recording = false;
+
+        m_segment_analyzer_ptr->finish(*m_recording_snapshot_ptr,
+                                        m_recording_snapshot_ptr->get_segment_table_for_write() );
+
+        if (m_capture_journal_ptr != nullptr)
+        {
+            m_capture_journal_ptr->commit_frame(*m_recording_snapshot_ptr);
+        }
+
+        if (m_is_cpu_timing_active)
+        {
+            /* Two TSC reads per callback, SwapBuffers() included. */
+            const auto n_timestamps = 2 * (static_cast<uint64_t>(m_n_api_calls_last_frame) + 1);
+
+            m_recording_snapshot_ptr->finish_cpu_timing(m_n_tsc_ticks_per_second,
+                                                        static_cast<uint64_t>(static_cast<double>(n_timestamps) * m_n_tsc_ticks_per_timestamp) );
+
+            m_is_cpu_timing_active = false;
+        }
+
+        if (m_n_burst_frames_left > 0)
+        {
+            ReplayerCaptureFrame frame;
+
+            frame.gl_id_to_texture_props_map_ptr = get_shared_gl_id_to_texture_props_map();
+            frame.n_frame                        = m_n_next_burst_frame++;
+            frame.snapshot_ptr                   = std::move(m_recording_snapshot_ptr);
+            frame.start_gl_context_state_ptr     = std::move(m_start_gl_context_state_ptr);
+
+            m_burst_capture_writer_ptr->enqueue_frame(std::move(frame) );
+
+            m_n_burst_frames_left--;
+            m_recording_snapshot_ptr = acquire_snapshot();
+        }
+        else
+        if (m_flight_recorder_frame_vec.size() > 0)
+        {
+            push_flight_recorder_frame();
+        }
+        else
+        if (m_snapshot_requested)
+        {
+            assert(m_gl_id_to_texture_props_map_ptr != nullptr);
+
+            cache_frame(std::move(m_recording_snapshot_ptr),
+                        std::move(m_start_gl_context_state_ptr),
+                        get_shared_gl_id_to_texture_props_map() );
+
+            m_recording_snapshot_ptr = acquire_snapshot();
+        }
+        else
+        {
+            /* The flight recorder has been disabled while this frame was being recorded, or the frame was the last one of
+             * a burst. */
+            m_recording_snapshot_ptr->reset();
+        }
+    }
+
+    /* ..or one of the frames held by the flight recorder, if a capture has been requested. */
+    if (m_snapshot_requested             &&
+        m_n_flight_recorder_frames > 0)
+    {
+        pop_flight_recorder_frame(m_n_requested_frames_ago);
+    }
+
+    if (is_capture_pending &&
+        !m_snapshot_requested)
+    {
+        LARGE_INTEGER capture_end_qpc = {};
+        LARGE_INTEGER qpc_frequency   = {};
+        uint64_t      stall_ns        = 0;
+
+        ::QueryPerformanceCounter  (&capture_end_qpc);
+        ::QueryPerformanceFrequency(&qpc_frequency);
+
+        stall_ns = static_cast<uint64_t>(static_cast<double>(capture_end_qpc.QuadPart - capture_start_qpc.QuadPart) * 1e9 / static_cast<double>(qpc_frequency.QuadPart) );
+
+        m_last_capture_stall_ns = stall_ns;
+        m_max_capture_stall_ns  = std::max(m_max_capture_stall_ns.load(),
+                                           stall_ns);
+        m_n_captures++;
+    }
+
+    /* Record the next frame if a burst is in progress, the flight recorder is on, or a capture has been armed since
+     * last frame. */
+    if (m_n_burst_frames_left              > 0 ||
+        m_flight_recorder_frame_vec.size() > 0 ||
+        m_snapshot_requested)
+    {
+        start_recording();
+    }
+
+    /* Cache depth buffer's contents for next frame's reuse. */
+    reinterpret_cast<PFNGLPIXELSTOREIPROC>(OpenGL::g_cached_gl_pixel_storei)(GL_PACK_ALIGNMENT,   1);
+    reinterpret_cast<PFNGLPIXELSTOREIPROC>(OpenGL::g_cached_gl_pixel_storei)(GL_UNPACK_ALIGNMENT, 1);
+
+    if (m_is_cpu_timing_active)
+    {
+        m_last_callback_exit_tsc = __rdtsc();
+    }
+}
+
+void ReplayerSnapshotter::update_callback_overhead_stats()
+{
+    LARGE_INTEGER  current_qpc;
+    const uint64_t current_tsc = __rdtsc();
+
+    ::QueryPerformanceCounter(&current_qpc);
+
+    /* Calibrate TSC against QPC using the time elapsed since previous frame. */
+    if (m_last_frame_qpc > 0                   &&
+        current_qpc.QuadPart > m_last_frame_qpc)
+    {
+        LARGE_INTEGER qpc_frequency;
+
+        ::QueryPerformanceFrequency(&qpc_frequency);
+
+        m_n_tsc_ticks_per_second = static_cast<double>(current_tsc          - m_last_frame_tsc) * static_cast<double>(qpc_frequency.QuadPart) /
+                                   static_cast<double>(current_qpc.QuadPart - m_last_frame_qpc);
+        m_last_frame_time_us     = static_cast<uint64_t>((current_qpc.QuadPart - m_last_frame_qpc) * 1000000 / qpc_frequency.QuadPart);
+        m_qpc_frequency          = qpc_frequency.QuadPart;
+    }
+
+    if (m_n_tsc_ticks_per_second > 0.0)
+    {
+        const auto callback_time_ns = static_cast<uint64_t>(static_cast<double>(m_n_sampled_callback_tsc_ticks_this_frame) * CALLBACK_TIMING_SAMPLING_PERIOD * 1e9 / m_n_tsc_ticks_per_second);
+
+        if (m_is_recording)
+        {
+            m_callback_time_ns_last_recording_frame = callback_time_ns;
+        }
+        else
+        {
+            m_callback_time_ns_last_idle_frame = callback_time_ns;
+        }
+    }
+
+    m_last_frame_qpc                          = current_qpc.QuadPart;
+    m_last_frame_tsc                          = current_tsc;
+    m_n_sampled_callback_tsc_ticks_this_frame = 0;
+}
+
+void ReplayerSnapshotter::start_recording()
+{
+    /* NOTE: Set by the UI thread. Read once, so that the snapshot and the callback agree on it for the whole frame. */
+    const bool is_cpu_timing_enabled      = m_is_cpu_timing_enabled.load     (std::memory_order_acquire);
+    const bool is_vertex_batching_enabled = m_is_vertex_batching_enabled.load(std::memory_order_acquire);
+
+    assert(m_recording_snapshot_ptr->get_n_api_commands() == 0);
+
+    m_recording_snapshot_ptr->set_cpu_timing_enabled     (is_cpu_timing_enabled);
+    m_recording_snapshot_ptr->set_vertex_batching_enabled(is_vertex_batching_enabled);
+    m_segment_analyzer_ptr->reset                        ();
+
+    if (m_capture_journal_ptr != nullptr)
+    {
+        m_capture_journal_ptr->begin_frame(m_n_frame);
+    }
+
+    m_is_cpu_timing_active = is_cpu_timing_enabled;
+
+    if (m_spare_gl_context_state_ptr != nullptr)
+    {
+        /* Copy-assignment is O(1): the texture state table is shared with the current state until either is modified. */
+        m_start_gl_context_state_ptr  = std::move(m_spare_gl_context_state_ptr);
+        *m_start_gl_context_state_ptr = *m_current_context_state_ptr;
+    }
+    else
+    {
+        m_start_gl_context_state_ptr.reset(new GLContextState(*m_current_context_state_ptr) );
+    }
+
+    /* Store matrix state. Shadowed on our side, so no need for a round-trip to the driver. */
+    memcpy(m_start_gl_context_state_ptr->modelview_matrix,
+           m_current_matrix_state.get_modelview_matrix(),
+           sizeof(m_start_gl_context_state_ptr->modelview_matrix) );
+    memcpy(m_start_gl_context_state_ptr->projection_matrix,
+           m_current_matrix_state.get_projection_matrix(),
+           sizeof(m_start_gl_context_state_ptr->projection_matrix) );
+
+    #if defined(_DEBUG)
+    {
+        double gl_matrix[16];
+
+        reinterpret_cast<PFNGLGETDOUBLEVPROC>(OpenGL::g_cached_gl_get_doublev)(GL_MODELVIEW_MATRIX,
+                                                                               gl_matrix);
+
+        for (uint32_t n_element = 0;
+                      n_element < 16;
+                    ++n_element)
+        {
+            AI_ASSERT(fabs(gl_matrix[n_element] - m_start_gl_context_state_ptr->modelview_matrix[n_element]) < 1e-3 * (1.0 + fabs(gl_matrix[n_element]) ) );
+        }
+
+        reinterpret_cast<PFNGLGETDOUBLEVPROC>(OpenGL::g_cached_gl_get_doublev)(GL_PROJECTION_MATRIX,
+                                                                               gl_matrix);
+
+        for (uint32_t n_element = 0;
+                      n_element < 16;
+                    ++n_element)
+        {
+            AI_ASSERT(fabs(gl_matrix[n_element] - m_start_gl_context_state_ptr->projection_matrix[n_element]) < 1e-3 * (1.0 + fabs(gl_matrix[n_element]) ) );
+        }
+    }
+    #endif
+
+    m_is_recording = true;
+}
+
+void ReplayerSnapshotter::start_gl_error_validation_frame()
+{
+    m_gl_error_validation_mode     = m_gl_error_validation_mode_requested;
+    m_n_calls_per_gl_error_segment = m_n_calls_per_gl_error_segment_requested;
+    m_n_first_unchecked_call       = 0;
+
+    if (m_is_bisecting_gl_error)
+    {
+        m_gl_error_bisect_mid_failed = false;
+        m_gl_error_bisect_stage      = (m_n_gl_error_bisect_first_call > 0) ? GLErrorBisectStage::PREFIX
+                                                                           : GLErrorBisectStage::MID;
+    }
+
+    schedule_next_gl_error_check(0);
+}
+
+bool ReplayerSnapshotter::should_record_api_call(const APIInterceptor::APIFunction& in_api_func) const
+{
+    // NOTE: Calls are only recorded while a capture is in progress, and only if the capture profile asks for them.
+    //       Front buffer updates are always dropped, too.
+    //
+    // One case where the latter happens is on the loading screen, where the front buffer has an extra pentagram
+    // drawn in the top-right corner. No need to capture this.
+    return m_is_recording                                                                  &&
+           m_is_api_func_recorded_vec[in_api_func - APIInterceptor::APIFUNCTION_GL_FIRST] &&
+           m_current_context_state_ptr->draw_buffer_mode == GL_BACK;
+}
+
+ReplayerCapturedSnapshotUniquePtr ReplayerSnapshotter::pop_snapshot()
+{
+    return ReplayerCapturedSnapshotUniquePtr(m_published_snapshot_ptr.exchange(nullptr) );
+}
+
+bool ReplayerSnapshotter::request_burst_capture(const std::string& in_filename,
+                                                const uint32_t&    in_n_frames)
+{
+    std::lock_guard<std::mutex> lock  (m_mutex);
+    bool                        result(false);
+
+    AI_ASSERT(in_n_frames > 0);
+
+    if ( m_n_burst_frames_requested == 0                                                    &&
+        (m_burst_capture_writer_ptr == nullptr || m_burst_capture_writer_ptr->is_done() ) )
+    {
+        m_burst_capture_filename_requested = in_filename;
+        m_n_burst_frames_requested         = in_n_frames;
+
+        result = true;
+    }
+
+    return result;
+}
+
+void ReplayerSnapshotter::request_gl_error_validation()
+{
+    m_gl_error_validation_requested = true;
+}
+
+void ReplayerSnapshotter::schedule_next_gl_error_check(const uint32_t& in_n_call)
+{
+    /* NOTE: A check issued from call N's callback covers calls up to N - 1. */
+    if (m_is_bisecting_gl_error)
+    {
+        switch (m_gl_error_bisect_stage)
+        {
+            case GLErrorBisectStage::LAST:   m_n_next_gl_error_check_call = m_n_gl_error_bisect_last_call + 1;                                                            break;
+            case GLErrorBisectStage::MID:    m_n_next_gl_error_check_call = m_n_gl_error_bisect_split_call + 1;                                                           break;
+            case GLErrorBisectStage::PREFIX: m_n_next_gl_error_check_call = m_n_gl_error_bisect_first_call;                                                               break;
+
+            default:
+            {
+                m_n_next_gl_error_check_call = UINT32_MAX;
+            }
+        }
+    }
+    else
+    {
+        switch (m_gl_error_validation_mode)
+        {
+            case GLErrorValidationMode::PER_CALL:    m_n_next_gl_error_check_call = in_n_call + 1;                              break;
+            case GLErrorValidationMode::PER_SEGMENT: m_n_next_gl_error_check_call = in_n_call + m_n_calls_per_gl_error_segment; break;
+
+            default:
+            {
+                /* Frame-level checks are issued at SwapBuffers time. */
+                m_n_next_gl_error_check_call = UINT32_MAX;
+            }
+        }
+    }
+
+    /* Checks may only be issued from callbacks of later calls. */
+    m_n_next_gl_error_check_call = std::max(m_n_next_gl_error_check_call,
+                                            in_n_call + 1);
+}
+
+void ReplayerSnapshotter::set_auto_capture_config(const AutoCaptureConfig& in_config)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    /* NOTE: Takes effect at the next frame boundary. */
+    m_auto_capture_config_requested = in_config;
+    m_auto_capture_config_dirty     = true;
+}
+
+void ReplayerSnapshotter::set_capture_journal_config(const std::string& in_filename,
+                                                     const uint64_t&    in_n_max_bytes)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    /* NOTE: Takes effect at the next frame boundary. A failure to create the previous journal is only forgotten once
+     *       another one is requested, so that it can still be reported after journaling has been disabled. */
+    m_capture_journal_filename_requested    = in_filename;
+    m_capture_journal_n_max_bytes_requested = in_n_max_bytes;
+    m_capture_journal_config_dirty          = true;
+
+    if (!in_filename.empty() )
+    {
+        m_has_capture_journal_failed = false;
+    }
+}
+
+void ReplayerSnapshotter::set_capture_profile(const CaptureProfile& in_profile)
+{
+    AI_ASSERT(in_profile != CaptureProfile::UNKNOWN);
+
+    /* NOTE: Takes effect at the next frame boundary. */
+    m_capture_profile_requested = in_profile;
+}
+
+void ReplayerSnapshotter::set_cpu_timing_enabled(const bool& in_enabled)
+{
+    /* NOTE: Takes effect at the next frame boundary. */
+    m_is_cpu_timing_enabled.store(in_enabled,
+                                  std::memory_order_release);
+}
+
+void ReplayerSnapshotter::set_flight_recorder_config(const uint32_t& in_n_max_frames,
+                                                     const uint64_t& in_max_n_bytes)
+{
+    /* NOTE: Takes effect at the next frame boundary. */
+    m_max_n_flight_recorder_bytes            = in_max_n_bytes;
+    m_n_max_flight_recorder_frames_requested = in_n_max_frames;
+}
+
+void ReplayerSnapshotter::set_gl_error_validation_mode(const GLErrorValidationMode& in_mode,
+                                                       const uint32_t&              in_n_calls_per_segment)
+{
+    AI_ASSERT(in_mode                != GLErrorValidationMode::PER_SEGMENT ||
+              in_n_calls_per_segment >  0);
+
+    /* NOTE: Takes effect at the next frame boundary. */
+    m_gl_error_validation_mode_requested     = in_mode;
+    m_n_calls_per_gl_error_segment_requested = in_n_calls_per_segment;
+}
+
+void ReplayerSnapshotter::set_vertex_batching_enabled(const bool& in_enabled)
+{
+    /* NOTE: Takes effect at the next frame boundary. */
+    m_is_vertex_batching_enabled.store(in_enabled,
+                                       std::memory_order_release);
+}
+
+void ReplayerSnapshotter::pop_flight_recorder_frame(const uint32_t& in_n_frames_ago)
+{
+    assert(m_n_flight_recorder_frames > 0);
+
+    const auto ring_size      = static_cast<uint32_t>(m_flight_recorder_frame_vec.size() );
+    const auto n_frames_ago   = std::min(in_n_frames_ago,
+                                         m_n_flight_recorder_frames - 1);
+    const auto n_ring_frame   = m_n_flight_recorder_frames - 1 - n_frames_ago;
+    FlightRecorderFrame frame = std::move(m_flight_recorder_frame_vec.at((m_n_first_flight_recorder_frame + n_ring_frame) % ring_size) );
+
+    /* Close the gap, so that the ring stays contiguous. Only ever touches a handful of pointers. */
+    for (uint32_t n_frame = n_ring_frame;
+                  n_frame < m_n_flight_recorder_frames - 1;
+                ++n_frame)
+    {
+        m_flight_recorder_frame_vec.at((m_n_first_flight_recorder_frame + n_frame)     % ring_size) =
+            std::move(m_flight_recorder_frame_vec.at((m_n_first_flight_recorder_frame + n_frame + 1) % ring_size) );
+    }
+
+    m_n_flight_recorder_bytes -= frame.n_bytes;
+    m_n_flight_recorder_frames--;
+
+    cache_frame(std::move(frame.snapshot_ptr),
+                std::move(frame.start_gl_context_state_ptr),
+                std::move(frame.gl_id_to_texture_props_map_ptr) );
+}
+
+void ReplayerSnapshotter::push_flight_recorder_frame()
+{
+    const auto ring_size = static_cast<uint32_t>(m_flight_recorder_frame_vec.size() );
+
+    assert(ring_size > 0);
+
+    if (m_n_flight_recorder_frames == ring_size)
+    {
+        evict_oldest_flight_recorder_frame();
+    }
+
+    {
+        auto& frame = m_flight_recorder_frame_vec.at((m_n_first_flight_recorder_frame + m_n_flight_recorder_frames) % ring_size);
+
+        frame.gl_id_to_texture_props_map_ptr = get_shared_gl_id_to_texture_props_map();
+        frame.n_bytes                        = m_recording_snapshot_ptr->get_n_allocated_bytes();
+        frame.snapshot_ptr                   = std::move(m_recording_snapshot_ptr);
+        frame.start_gl_context_state_ptr     = std::move(m_start_gl_context_state_ptr);
+
+        m_n_flight_recorder_bytes += frame.n_bytes;
+        m_n_flight_recorder_frames++;
+    }
+
+    /* Stay within the memory budget, but always keep the most recent frame. */
+    while (m_n_flight_recorder_frames >  1                             &&
+           m_n_flight_recorder_bytes  >  m_max_n_flight_recorder_bytes)
+    {
+        evict_oldest_flight_recorder_frame();
+    }
+
+    m_recording_snapshot_ptr = acquire_snapshot();
+}
+
+void ReplayerSnapshotter::report_gl_error(const uint32_t& in_gl_error,
+                                          const uint32_t& in_n_first_call,
+                                          const uint32_t& in_n_last_call,
+                                          const uint32_t& in_n_call)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_last_gl_error_report.gl_error     = in_gl_error;
+    m_last_gl_error_report.is_exact     = (in_n_first_call == in_n_last_call);
+    m_last_gl_error_report.n_first_call = in_n_first_call;
+    m_last_gl_error_report.n_frame      = m_n_frame;
+    m_last_gl_error_report.n_last_call  = in_n_last_call;
+
+    /* The check issued from call @param in_n_call's callback covers calls up to the previous one. A bisection may have
+     * narrowed the range down to an earlier call though, in which case we need to look it up. */
+    if (!m_last_gl_error_report.is_exact)
+    {
+        m_last_gl_error_report.api_func = APIInterceptor::APIFUNCTION_GL_FIRST;
+    }
+    else
+    if (in_n_first_call + 1 == in_n_call)
+    {
+        m_last_gl_error_report.api_func = m_previous_api_func;
+    }
+    else
+    {
+        AI_ASSERT(in_n_first_call < m_gl_error_bisect_api_func_vec.size() );
+
+        m_last_gl_error_report.api_func = (in_n_first_call < m_gl_error_bisect_api_func_vec.size() ) ? m_gl_error_bisect_api_func_vec.at(in_n_first_call)
+                                                                                                     : APIInterceptor::APIFUNCTION_GL_FIRST;
+    }
+
+    m_has_gl_error_report = true;
+}
+
+void ReplayerSnapshotter::recycle_snapshot(ReplayerSnapshotUniquePtr in_snapshot_ptr)
+{
+    std::lock_guard<std::mutex> lock(m_snapshot_pool_mutex);
+
+    assert(in_snapshot_ptr != nullptr);
+
+    if (m_snapshot_pool_vec.size() < MAX_N_POOLED_SNAPSHOTS)
+    {
+        /* NOTE: reset() retains arena chunks, which is exactly what we want here. */
+        in_snapshot_ptr->reset();
+
+        m_snapshot_pool_vec.push_back(std::move(in_snapshot_ptr) );
+    }
 }
\ No newline at end of file
@@ -0,0 +1,454 @@
+/* API Interceptor (c) 2024 Dominik Witczak
+ *
+ * This code is licensed under MIT license (see LICENSE.txt for details)
+ */
+#include "Common/callbacks.h"
+#include "Common/logger.h"
+#include "replayer_texture_ingester.h"
+#include <algorithm>
+#include <cstring>
+
+#ifdef max
+    #undef max
+#endif
+
+#ifdef min
+    #undef min
+#endif
+
+
+ReplayerTextureIngester::ReplayerTextureIngester(ReplayerTextureStore* in_texture_store_ptr,
+                                                 const CompletionFunc& in_completion_func)
+    :m_completion_func          (in_completion_func),
+     m_job_vec                  (N_JOB_SLOTS),
+     m_staging_ring_u8_vec      (STAGING_RING_N_BYTES),
+     m_texture_store_ptr        (in_texture_store_ptr),
+     m_n_last_completed_ticket  (0),
+     m_n_staging_ring_read_byte (0),
+     m_n_last_submitted_ticket  (0),
+     m_n_last_collected_ticket  (0),
+     m_n_staging_ring_write_byte(0),
+     m_is_worker_idle           (false),
+     m_worker_thread_must_die   (false)
+{
+    /* Stub */
+}
+
+ReplayerTextureIngester::~ReplayerTextureIngester()
+{
+    /* Frames may still refer to this frame's batches. */
+    flush();
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        m_worker_thread_must_die = true;
+    }
+
+    m_job_submitted_cv.notify_one();
+    m_worker_thread.join         ();
+}
+
+ReplayerTextureIngester::Job& ReplayerTextureIngester::acquire_job(const uint64_t& in_n_ticket,
+                                                                   const uint32_t& in_gl_texture_id,
+                                                                   const uint32_t& in_n_mip)
+{
+    /* Job slots are only freed once their results have been collected. */
+    if (in_n_ticket - m_n_last_collected_ticket > N_JOB_SLOTS)
+    {
+        collect_up_to(in_n_ticket - N_JOB_SLOTS);
+    }
+
+    {
+        auto& job = m_job_vec.at(in_n_ticket % N_JOB_SLOTS);
+
+        job.gl_texture_id     = in_gl_texture_id;
+        job.n_bytes           = 0;
+        job.n_mip             = in_n_mip;
+        job.n_ring_end_byte   = 0;
+        job.n_ring_start_byte = 0;
+
+        return job;
+    }
+}
+
+void ReplayerTextureIngester::collect()
+{
+    collect_up_to(m_n_last_completed_ticket.load() );
+}
+
+void ReplayerTextureIngester::collect_up_to(const uint64_t& in_n_last_ticket)
+{
+    while (m_n_last_collected_ticket < in_n_last_ticket)
+    {
+        const uint64_t n_ticket = m_n_last_collected_ticket + 1;
+
+        /* Only spins if we have run out of job slots. */
+        while (m_n_last_completed_ticket.load() < n_ticket)
+        {
+            std::this_thread::yield();
+        }
+
+        {
+            auto& job = m_job_vec.at(n_ticket % N_JOB_SLOTS);
+
+            m_completion_func(job.gl_texture_id,
+                              job.n_mip,
+                              job.pending_data_ptr);
+
+            job.pending_data_ptr.reset();
+
+            if (job.sub_image_batch_ptr != nullptr)
+            {
+                job.sub_image_batch_ptr->pending_data_ptr.reset();
+
+                m_free_batch_ptr_vec.push_back(std::move(job.sub_image_batch_ptr) );
+            }
+        }
+
+        m_n_last_collected_ticket = n_ticket;
+    }
+}
+
+ReplayerTextureIngesterUniquePtr ReplayerTextureIngester::create(ReplayerTextureStore* in_texture_store_ptr,
+                                                                 const CompletionFunc& in_completion_func)
+{
+    ReplayerTextureIngesterUniquePtr result_ptr(new ReplayerTextureIngester(in_texture_store_ptr,
+                                                                            in_completion_func) );
+
+    if (result_ptr != nullptr)
+    {
+        if (!result_ptr->init() )
+        {
+            result_ptr.reset();
+        }
+    }
+
+    return result_ptr;
+}
+
+void ReplayerTextureIngester::execute()
+{
+    APIInterceptor::disable_callbacks_for_this_thread            ();
+    APIInterceptor::g_logger_ptr->disable_logging_for_this_thread();
+
+    while (true)
+    {
+        const uint64_t n_ticket = m_n_last_completed_ticket.load() + 1;
+
+        if (m_n_last_submitted_ticket.load() < n_ticket)
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+
+            /* Announce we're about to sleep first, and only then check for new jobs one more time. Either the game thread
+             * sees the flag and wakes us up, or we see its job. */
+            m_is_worker_idle = true;
+
+            m_job_submitted_cv.wait(lock,
+                                    [this, n_ticket]()
+                                    {
+                                        return (m_n_last_submitted_ticket.load() >= n_ticket) ||
+                                               m_worker_thread_must_die;
+                                    });
+
+            m_is_worker_idle = false;
+
+            if (m_n_last_submitted_ticket.load() < n_ticket)
+            {
+                break;
+            }
+        }
+
+        {
+            auto& job = m_job_vec.at(n_ticket % N_JOB_SLOTS);
+
+            if (job.sub_image_batch_ptr != nullptr)
+            {
+                ingest_sub_image(*job.sub_image_batch_ptr);
+
+                job.sub_image_batch_ptr->base_data_u8_vec_ptr.reset ();
+                job.sub_image_batch_ptr->base_pending_data_ptr.reset();
+            }
+            else
+            {
+                const auto data_ptr = (job.heap_data_ptr != nullptr) ? job.heap_data_ptr->data()
+                                                                     : m_staging_ring_u8_vec.data() + (job.n_ring_start_byte % STAGING_RING_N_BYTES);
+
+                job.pending_data_ptr->data_u8_vec_ptr = m_texture_store_ptr->store(data_ptr,
+                                                                                  job.n_bytes,
+                                                                                 &job.pending_data_ptr->data_hash);
+            }
+
+            job.pending_data_ptr->is_ready = true;
+
+            job.heap_data_ptr.reset();
+
+            if (job.n_ring_end_byte != 0)
+            {
+                m_n_staging_ring_read_byte = job.n_ring_end_byte;
+            }
+        }
+
+        m_n_last_completed_ticket = n_ticket;
+    }
+}
+
+void ReplayerTextureIngester::flush()
+{
+    for (auto& current_batch_ptr : m_open_batch_ptr_vec)
+    {
+        const uint64_t n_ticket = m_n_last_submitted_ticket.load() + 1;
+        auto&          job      = acquire_job(n_ticket,
+                                              current_batch_ptr->gl_texture_id,
+                                              current_batch_ptr->n_mip);
+
+        job.pending_data_ptr    = current_batch_ptr->pending_data_ptr;
+        job.sub_image_batch_ptr = std::move(current_batch_ptr);
+
+        kick(n_ticket);
+    }
+
+    m_open_batch_ptr_vec.clear();
+}
+
+void ReplayerTextureIngester::ingest_sub_image(SubImageBatch& in_batch)
+{
+    const auto     base_data_u8_vec_ptr = (in_batch.base_pending_data_ptr != nullptr) ? in_batch.base_pending_data_ptr->get_data_u8_vec_ptr()
+                                                                                      : in_batch.base_data_u8_vec_ptr;
+    uint64_t       data_hash            = (in_batch.base_pending_data_ptr != nullptr) ? in_batch.base_pending_data_ptr->data_hash
+                                                                                      : in_batch.base_data_hash;
+    const uint32_t n_row_bytes          = in_batch.n_row_pixels * in_batch.n_components;
+    const uint32_t block_size           = ReplayerTextureStore::HASH_BLOCK_SIZE;
+
+    AI_ASSERT(base_data_u8_vec_ptr != nullptr);
+
+    /* Blobs are immutable, so the updates go to a copy of the base. One copy covers the whole batch. */
+    std::vector<uint8_t> data_u8_vec(*base_data_u8_vec_ptr);
+    const auto           n_data_bytes     = static_cast<uint32_t>(data_u8_vec.size() );
+    const auto           n_blocks         = (n_data_bytes + block_size - 1) / block_size;
+    const uint8_t*       rect_data_u8_ptr = in_batch.data_u8_vec.data();
+
+    m_is_block_dirty_vec.assign(n_blocks,
+                                false);
+
+    for (const auto& current_rect : in_batch.rect_vec)
+    {
+        const uint32_t n_rect_row_bytes = (current_rect.at(2) - current_rect.at(0) ) * in_batch.n_components;
+        const uint32_t n_first_row_byte = current_rect.at(0) * in_batch.n_components;
+
+        AI_ASSERT(n_data_bytes >= current_rect.at(3) * n_row_bytes);
+
+        for (uint32_t n_row = current_rect.at(1);
+                      n_row < current_rect.at(3);
+                    ++n_row)
+        {
+            const uint32_t n_first_block = (n_row * n_row_bytes + n_first_row_byte)                        / block_size;
+            const uint32_t n_last_block  = (n_row * n_row_bytes + n_first_row_byte + n_rect_row_bytes - 1) / block_size;
+
+            memcpy(data_u8_vec.data() + n_row * n_row_bytes + n_first_row_byte,
+                   rect_data_u8_ptr,
+                   n_rect_row_bytes);
+
+            for (uint32_t n_block = n_first_block;
+                          n_block <= n_last_block;
+                        ++n_block)
+            {
+                m_is_block_dirty_vec[n_block] = true;
+            }
+
+            rect_data_u8_ptr += n_rect_row_bytes;
+        }
+    }
+
+    /* Swap hashes of the blocks the rectangles overlap. Each block is only visited once, no matter how many
+     * rectangles it is shared by. */
+    for (uint32_t n_block = 0;
+                  n_block < n_blocks;
+                ++n_block)
+    {
+        if (!m_is_block_dirty_vec[n_block])
+        {
+            continue;
+        }
+
+        {
+            const uint32_t n_block_first_byte = n_block * block_size;
+            const uint32_t n_block_bytes      = std::min(block_size,
+                                                         n_data_bytes - n_block_first_byte);
+
+            data_hash -= ReplayerTextureStore::hash_block(base_data_u8_vec_ptr->data() + n_block_first_byte,
+                                                          n_block_bytes,
+                                                          n_block);
+            data_hash += ReplayerTextureStore::hash_block(data_u8_vec.data()           + n_block_first_byte,
+                                                          n_block_bytes,
+                                                          n_block);
+        }
+    }
+
+    in_batch.pending_data_ptr->data_hash       = data_hash;
+    in_batch.pending_data_ptr->data_u8_vec_ptr = m_texture_store_ptr->store(std::move(data_u8_vec),
+                                                                            data_hash);
+}
+
+bool ReplayerTextureIngester::init()
+{
+    m_worker_thread = std::thread(&ReplayerTextureIngester::execute,
+                                  this);
+
+    return true;
+}
+
+void ReplayerTextureIngester::kick(const uint64_t& in_n_ticket)
+{
+    m_n_last_submitted_ticket = in_n_ticket;
+
+    if (m_is_worker_idle.load() )
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        m_job_submitted_cv.notify_one();
+    }
+}
+
+void ReplayerTextureIngester::stage(Job&            in_job,
+                                    const void*     in_data_ptr,
+                                    const uint32_t& in_n_bytes)
+{
+    /* Allocate space in the staging ring. Data must be contiguous, so skip the ring's tail if it's too short. */
+    uint64_t n_start_byte = m_n_staging_ring_write_byte;
+
+    if ((n_start_byte % STAGING_RING_N_BYTES) + in_n_bytes > STAGING_RING_N_BYTES)
+    {
+        n_start_byte += STAGING_RING_N_BYTES - (n_start_byte % STAGING_RING_N_BYTES);
+    }
+
+    in_job.n_bytes = in_n_bytes;
+
+    if (n_start_byte + in_n_bytes - m_n_staging_ring_read_byte.load() <= STAGING_RING_N_BYTES)
+    {
+        memcpy(m_staging_ring_u8_vec.data() + (n_start_byte % STAGING_RING_N_BYTES),
+               in_data_ptr,
+               in_n_bytes);
+
+        in_job.n_ring_start_byte    = n_start_byte;
+        in_job.n_ring_end_byte      = n_start_byte + in_n_bytes;
+        m_n_staging_ring_write_byte = in_job.n_ring_end_byte;
+    }
+    else
+    {
+        /* Ring is full (or the upload is larger than the whole ring). Still a single copy, just a slower one. */
+        auto data_u8_ptr = static_cast<const uint8_t*>(in_data_ptr);
+
+        in_job.heap_data_ptr.reset(new std::vector<uint8_t>(data_u8_ptr,
+                                                            data_u8_ptr + in_n_bytes) );
+    }
+}
+
+std::shared_ptr<const PendingMipData> ReplayerTextureIngester::submit(const void*     in_data_ptr,
+                                                                      const uint32_t& in_n_bytes,
+                                                                      const uint32_t& in_gl_texture_id,
+                                                                      const uint32_t& in_n_mip)
+{
+    const uint64_t n_ticket = m_n_last_submitted_ticket.load() + 1;
+    auto&          job      = acquire_job(n_ticket,
+                                          in_gl_texture_id,
+                                          in_n_mip);
+
+    job.pending_data_ptr = std::make_shared<PendingMipData>();
+
+    stage(job,
+          in_data_ptr,
+          in_n_bytes);
+    kick (n_ticket);
+
+    return job.pending_data_ptr;
+}
+
+std::shared_ptr<const PendingMipData> ReplayerTextureIngester::submit_sub_image(const void*                    in_data_ptr,
+                                                                                const MipProps&                in_base_mip_props,
+                                                                                const std::array<uint32_t, 4>& in_rect_x1y1x2y2,
+                                                                                const uint32_t&                in_n_components,
+                                                                                const uint32_t&                in_gl_texture_id,
+                                                                                const uint32_t&                in_n_mip)
+{
+    SubImageBatch* batch_ptr = nullptr;
+    const auto     n_bytes   = (in_rect_x1y1x2y2.at(2) - in_rect_x1y1x2y2.at(0) ) * (in_rect_x1y1x2y2.at(3) - in_rect_x1y1x2y2.at(1) ) * in_n_components;
+
+    AI_ASSERT(in_base_mip_props.data_u8_vec_ptr  != nullptr ||
+              in_base_mip_props.pending_data_ptr != nullptr);
+    AI_ASSERT(in_rect_x1y1x2y2.at(0) <  in_rect_x1y1x2y2.at(2)                  &&
+              in_rect_x1y1x2y2.at(1) <  in_rect_x1y1x2y2.at(3)                  &&
+              in_rect_x1y1x2y2.at(2) <= in_base_mip_props.mip_size_u32vec3.at(0) &&
+              in_rect_x1y1x2y2.at(3) <= in_base_mip_props.mip_size_u32vec3.at(1) );
+
+    /* Extend this frame's batch for the mip, if the mip still holds what the batch is going to produce. Only a handful
+     * of batches are open at any time, so a linear search will do. */
+    if (in_base_mip_props.pending_data_ptr != nullptr)
+    {
+        for (const auto& current_batch_ptr : m_open_batch_ptr_vec)
+        {
+            if (current_batch_ptr->pending_data_ptr != in_base_mip_props.pending_data_ptr)
+            {
+                continue;
+            }
+
+            batch_ptr = current_batch_ptr.get();
+
+            for (const auto& current_rect : current_batch_ptr->rect_vec)
+            {
+                if (current_rect.at(0) < in_rect_x1y1x2y2.at(2) && in_rect_x1y1x2y2.at(0) < current_rect.at(2) &&
+                    current_rect.at(1) < in_rect_x1y1x2y2.at(3) && in_rect_x1y1x2y2.at(1) < current_rect.at(3) )
+                {
+                    batch_ptr = nullptr;
+
+                    break;
+                }
+            }
+
+            break;
+        }
+    }
+
+    if (batch_ptr == nullptr)
+    {
+        SubImageBatchUniquePtr new_batch_ptr;
+
+        if (m_free_batch_ptr_vec.empty() )
+        {
+            new_batch_ptr.reset(new SubImageBatch() );
+        }
+        else
+        {
+            new_batch_ptr = std::move(m_free_batch_ptr_vec.back() );
+
+            m_free_batch_ptr_vec.pop_back();
+        }
+
+        /* NOTE: Uploads are ingested in submission order, and batches are submitted in the order they have been opened
+         *       in, so a pending base is always ready by the time the batch is ingested. */
+        new_batch_ptr->base_data_hash        = in_base_mip_props.data_hash;
+        new_batch_ptr->base_data_u8_vec_ptr  = in_base_mip_props.data_u8_vec_ptr;
+        new_batch_ptr->base_pending_data_ptr = in_base_mip_props.pending_data_ptr;
+        new_batch_ptr->gl_texture_id         = in_gl_texture_id;
+        new_batch_ptr->n_components          = in_n_components;
+        new_batch_ptr->n_mip                 = in_n_mip;
+        new_batch_ptr->n_row_pixels          = in_base_mip_props.mip_size_u32vec3.at(0);
+        new_batch_ptr->pending_data_ptr      = std::make_shared<PendingMipData>();
+
+        new_batch_ptr->data_u8_vec.clear();
+        new_batch_ptr->rect_vec.clear   ();
+
+        batch_ptr = new_batch_ptr.get();
+
+        m_open_batch_ptr_vec.push_back(std::move(new_batch_ptr) );
+    }
+
+    AI_ASSERT(batch_ptr->n_components == in_n_components);
+
+    batch_ptr->data_u8_vec.insert(batch_ptr->data_u8_vec.end(),
+                                  static_cast<const uint8_t*>(in_data_ptr),
+                                  static_cast<const uint8_t*>(in_data_ptr) + n_bytes);
+    batch_ptr->rect_vec.push_back(in_rect_x1y1x2y2);
+
+    return batch_ptr->pending_data_ptr;
+}
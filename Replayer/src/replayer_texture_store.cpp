@@ -0,0 +1,248 @@
+/* API Interceptor (c) 2024 Dominik Witczak
+ *
+ * This code is licensed under MIT license (see LICENSE.txt for details)
+ */
+#include "replayer_texture_store.h"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+#ifdef max
+    #undef max
+#endif
+
+#ifdef min
+    #undef min
+#endif
+
+
+ReplayerTextureStore::ReplayerTextureStore()
+    :m_n_blobs              (0),
+     m_n_blobs_at_last_sweep(0),
+     m_n_bytes_deduplicated (0)
+{
+    /* Stub */
+}
+
+ReplayerTextureStoreUniquePtr ReplayerTextureStore::create()
+{
+    return ReplayerTextureStoreUniquePtr(new ReplayerTextureStore() );
+}
+
+U8VecSharedPtr ReplayerTextureStore::find(const uint64_t& in_hash,
+                                          const void*     in_data_ptr,
+                                          const uint32_t& in_n_bytes)
+{
+    auto blob_map_iterator = m_hash_to_blob_vec_map.find(in_hash);
+
+    if (blob_map_iterator == m_hash_to_blob_vec_map.end() )
+    {
+        return nullptr;
+    }
+
+    auto& blob_vec = blob_map_iterator->second;
+
+    for (auto blob_iterator  = blob_vec.begin();
+              blob_iterator != blob_vec.end();
+              )
+    {
+        auto blob_ptr = blob_iterator->lock();
+
+        if (blob_ptr == nullptr)
+        {
+            blob_iterator = blob_vec.erase(blob_iterator);
+
+            m_n_blobs--;
+            continue;
+        }
+
+        if ( blob_ptr->size() == in_n_bytes &&
+            (in_n_bytes       == 0          ||
+             memcmp(blob_ptr->data(),
+                    in_data_ptr,
+                    in_n_bytes) == 0) )
+        {
+            m_n_bytes_deduplicated += in_n_bytes;
+
+            return blob_ptr;
+        }
+
+        ++blob_iterator;
+    }
+
+    return nullptr;
+}
+
+uint64_t ReplayerTextureStore::get_n_bytes_deduplicated() const
+{
+    return m_n_bytes_deduplicated.load();
+}
+
+uint32_t ReplayerTextureStore::get_n_blobs_tracked() const
+{
+    return m_n_blobs.load();
+}
+
+uint64_t ReplayerTextureStore::hash(const void*     in_data_ptr,
+                                    const uint32_t& in_n_bytes)
+{
+    const auto data_u8_ptr = static_cast<const uint8_t*>(in_data_ptr);
+    uint64_t   result      = 0x9E3779B97F4A7C15ull * (static_cast<uint64_t>(in_n_bytes) + 1);
+
+    for (uint32_t n_block = 0;
+                  n_block * HASH_BLOCK_SIZE < in_n_bytes;
+                ++n_block)
+    {
+        const uint32_t n_first_byte = n_block * HASH_BLOCK_SIZE;
+
+        result += hash_block(data_u8_ptr + n_first_byte,
+                             std::min(static_cast<uint32_t>(HASH_BLOCK_SIZE), // not odr-used
+                                      in_n_bytes - n_first_byte),
+                             n_block);
+    }
+
+    return result;
+}
+
+uint64_t ReplayerTextureStore::hash_block(const void*     in_block_data_ptr,
+                                          const uint32_t& in_n_block_bytes,
+                                          const uint32_t& in_n_block)
+{
+    /* Word-at-a-time multiply/rotate mix with a murmur3 finalizer. Not cryptographic, but fast enough to be run
+     * over every upload, and collisions are resolved by comparing contents anyway. */
+    const auto data_u8_ptr = static_cast<const uint8_t*>(in_block_data_ptr);
+    uint64_t   result      = 0x9E3779B97F4A7C15ull ^ (static_cast<uint64_t>(in_n_block) << 32) ^ in_n_block_bytes;
+    uint32_t   n_byte      = 0;
+
+    for (;
+         n_byte + sizeof(uint64_t) <= in_n_block_bytes;
+         n_byte += sizeof(uint64_t) )
+    {
+        uint64_t word;
+
+        memcpy(&word,
+               data_u8_ptr + n_byte,
+               sizeof(word) );
+
+        word   *= 0x87C37B91114253D5ull;
+        word    = (word << 31) | (word >> 33);
+        result ^= word * 0x4CF5AD432745937Full;
+        result  = ((result << 27) | (result >> 37) ) * 5 + 0x52DCE729;
+    }
+
+    for (;
+         n_byte < in_n_block_bytes;
+       ++n_byte)
+    {
+        result = (result ^ data_u8_ptr[n_byte]) * 0x100000001B3ull;
+    }
+
+    result ^= result >> 33;
+    result *= 0xFF51AFD7ED558CCDull;
+    result ^= result >> 33;
+    result *= 0xC4CEB9FE1A85EC53ull;
+    result ^= result >> 33;
+
+    return result;
+}
+
+void ReplayerTextureStore::insert(const uint64_t&       in_hash,
+                                  const U8VecSharedPtr& in_blob_ptr)
+{
+    m_hash_to_blob_vec_map[in_hash].push_back(in_blob_ptr);
+    m_n_blobs++;
+
+    /* Entries of released blobs are only dropped when their hash comes up again, so make sure they do not pile up
+     * over a long session. */
+    if (m_n_blobs >= 2 * std::max(m_n_blobs_at_last_sweep, 1024u) )
+    {
+        sweep();
+    }
+}
+
+U8VecSharedPtr ReplayerTextureStore::store(const void*     in_data_ptr,
+                                           const uint32_t& in_n_bytes,
+                                           uint64_t*       out_opt_hash_ptr)
+{
+    const auto data_hash  = hash(in_data_ptr,
+                                 in_n_bytes);
+    auto       result_ptr = find(data_hash,
+                                 in_data_ptr,
+                                 in_n_bytes);
+
+    if (out_opt_hash_ptr != nullptr)
+    {
+        *out_opt_hash_ptr = data_hash;
+    }
+
+    if (result_ptr == nullptr)
+    {
+        auto data_u8_ptr = static_cast<const uint8_t*>(in_data_ptr);
+
+        result_ptr = std::make_shared<const std::vector<uint8_t> >(data_u8_ptr,
+                                                                   data_u8_ptr + in_n_bytes);
+
+        insert(data_hash,
+               result_ptr);
+    }
+
+    return result_ptr;
+}
+
+U8VecSharedPtr ReplayerTextureStore::store(std::vector<uint8_t>&& in_data_u8_vec,
+                                           const uint64_t&        in_hash)
+{
+    auto result_ptr = find(in_hash,
+                           in_data_u8_vec.data(),
+                           static_cast<uint32_t>(in_data_u8_vec.size() ) );
+
+    assert(in_hash == hash(in_data_u8_vec.data(),
+                           static_cast<uint32_t>(in_data_u8_vec.size() ) ));
+
+    if (result_ptr == nullptr)
+    {
+        result_ptr = std::make_shared<const std::vector<uint8_t> >(std::move(in_data_u8_vec) );
+
+        insert(in_hash,
+               result_ptr);
+    }
+
+    return result_ptr;
+}
+
+void ReplayerTextureStore::sweep()
+{
+    for (auto map_iterator  = m_hash_to_blob_vec_map.begin();
+              map_iterator != m_hash_to_blob_vec_map.end();
+              )
+    {
+        auto& blob_vec = map_iterator->second;
+
+        for (auto blob_iterator  = blob_vec.begin();
+                  blob_iterator != blob_vec.end();
+                  )
+        {
+            if (blob_iterator->expired() )
+            {
+                blob_iterator = blob_vec.erase(blob_iterator);
+
+                m_n_blobs--;
+            }
+            else
+            {
+                ++blob_iterator;
+            }
+        }
+
+        if (blob_vec.empty() )
+        {
+            map_iterator = m_hash_to_blob_vec_map.erase(map_iterator);
+        }
+        else
+        {
+            ++map_iterator;
+        }
+    }
+
+    m_n_blobs_at_last_sweep = m_n_blobs;
+}
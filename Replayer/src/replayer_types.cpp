@@ -5,6 +5,7 @@
 #include "OpenGL/globals.h"
 #include "APIInterceptor/include/Common/types.h"
 #include "replayer_types.h"
+#include <thread>
 
 GLContextState::GLContextState(const uint32_t& in_q1_window_width,
                                const uint32_t& in_q1_window_height)
@@ -55,4 +56,37 @@ GLContextTextureState::GLContextTextureState()
     wrap_s     = static_cast<uint32_t>(GL_REPEAT);
     wrap_t     = static_cast<uint32_t>(GL_REPEAT);
     wrap_r     = static_cast<uint32_t>(GL_REPEAT);
-}
\ No newline at end of file
+}
+
+uint64_t MipProps::get_data_hash() const
+{
+    if (pending_data_ptr == nullptr)
+    {
+        return data_hash;
+    }
+
+    get_data_u8_vec_ptr();
+
+    return pending_data_ptr->data_hash;
+}
+
+U8VecSharedPtr MipProps::get_data_u8_vec_ptr() const
+{
+    if (pending_data_ptr == nullptr)
+    {
+        return data_u8_vec_ptr;
+    }
+
+    return pending_data_ptr->get_data_u8_vec_ptr();
+}
+
+U8VecSharedPtr PendingMipData::get_data_u8_vec_ptr() const
+{
+    /* Ingestion only takes as long as hashing the data does, so there is no point in sleeping. */
+    while (!is_ready.load() )
+    {
+        std::this_thread::yield();
+    }
+
+    return data_u8_vec_ptr;
+}
@@ -127,22 +127,19 @@ void ReplayerWindow::execute()
 
             if (n_available_snapshot != m_n_current_snapshot)
             {
-                const GLIDToTexturePropsMap* snapshot_gl_id_to_texture_props_map_ptr = nullptr;
-                const ReplayerSnapshot*      snapshot_ptr                            = nullptr;
-                const GLContextState*        start_context_state_ptr                 = nullptr;
-
                 assert(m_n_current_snapshot == UINT32_MAX            ||
                        n_available_snapshot >  m_n_current_snapshot);
 
-                m_replayer_ptr->get_current_snapshot(&snapshot_gl_id_to_texture_props_map_ptr,
-                                                     &snapshot_ptr,
-                                                     &start_context_state_ptr);
+                /* NOTE: The previous snapshot is released only after the player has moved on to the new one. */
+                auto snapshot_ptr = m_replayer_ptr->get_current_snapshot();
 
                 assert(snapshot_ptr != nullptr);
 
-                m_snapshot_player_ptr->load_snapshot(start_context_state_ptr,
-                                                     snapshot_ptr,
-                                                     snapshot_gl_id_to_texture_props_map_ptr);
+                m_snapshot_player_ptr->load_snapshot(snapshot_ptr->start_gl_context_state_ptr.get    (),
+                                                     snapshot_ptr->snapshot_ptr.get                   (),
+                                                     snapshot_ptr->gl_id_to_texture_props_map_ptr.get() );
+
+                m_snapshot_ptr = std::move(snapshot_ptr);
 
                 m_n_current_snapshot = n_available_snapshot;
             }